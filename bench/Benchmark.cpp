@@ -0,0 +1,269 @@
+#include "../xo/xo.h"
+#include "SyntheticDoc.h"
+#include "RecordingDriver.h"
+
+/* Headless benchmark of the stages of the pipeline, on synthetic documents.
+
+Usage: Benchmark [options]
+	-docs grid,deep,text,classes,canvas   Kinds of document to generate (default all)
+	-sizes 1000,10000,100000,1000000      Number of nodes in each document (default all of these)
+	-reps N                               Number of times to time each stage (default depends on size)
+	-label text                           Stored in the output, so that you can identify the commit that was measured
+	-out filename                         Write JSON here instead of to stdout
+
+Stages are timed separately, each on the same document:
+	parse    Doc::Parse of the generated markup, into a new Doc
+	clone    Doc::CloneSlowInto, into a new Doc (ie a full clone)
+	style    StyleResolver::ResolveAndPush for every node, without a StyleCache
+	layout   Layout::PerformLayout, without any cache from a previous layout
+	render   Renderer::Render, with a driver that only counts draw calls, and without a VertexCache
+
+The result is a JSON object, with one entry per document kind, size, and stage. Times are in milliseconds.
+Progress is written to stderr.
+*/
+
+static const int ViewportWidth  = 1920;
+static const int ViewportHeight = 1080;
+
+enum Stages {
+	StageParse,
+	StageClone,
+	StageStyle,
+	StageLayout,
+	StageRender,
+	StageEND,
+};
+
+static const char* StageNames[StageEND] = {
+    "parse",
+    "clone",
+    "style",
+    "layout",
+    "render",
+};
+
+struct Result {
+	DocKinds Kind;
+	size_t   NumNodes;
+	Stages   Stage;
+	uint32_t NumEls; // Actual number of elements in the document
+	int      Reps;
+	double   Min;
+	double   Median;
+	double   Max;
+	uint64_t DrawCalls; // Only for StageRender
+};
+
+struct Options {
+	xo::cheapvec<DocKinds> Kinds;
+	xo::cheapvec<size_t>   Sizes;
+	int                    Reps = 0;
+	std::string            Label;
+	std::string            Out;
+};
+
+static void SetViewport(xo::Doc* doc) {
+	xo::Event ev;
+	ev.MakeWindowSize(ViewportWidth, ViewportHeight);
+	doc->UI.InternalProcessEvent(ev, nullptr);
+}
+
+static void ResolveTree(xo::RenderStack& stack, const xo::DomNode* node) {
+	xo::StyleResolver::ResolveAndPush(stack, node);
+	for (auto c : node->GetChildren()) {
+		if (c->IsNode())
+			ResolveTree(stack, static_cast<const xo::DomNode*>(c));
+	}
+	stack.StackPop();
+}
+
+static xo::Doc* NewDoc(DocKinds kind, const std::string& markup, double* parseTime) {
+	xo::Doc* doc = new xo::Doc(nullptr);
+	SyntheticDoc::Prepare(kind, doc);
+	double start = xo::TimeAccurateSeconds();
+	auto   err   = doc->Parse(markup.c_str());
+	if (parseTime)
+		*parseTime = xo::TimeAccurateSeconds() - start;
+	if (err != "")
+		fprintf(stderr, "Parse failed: %s\n", err.Z);
+	SyntheticDoc::Finish(kind, doc);
+	SetViewport(doc);
+	return doc;
+}
+
+// Time one stage. The document is left untouched, except by 'parse', which builds its own.
+static double RunStage(Stages stage, DocKinds kind, const std::string& markup, xo::Doc* doc, uint64_t& drawCalls) {
+	double start = 0;
+	switch (stage) {
+	case StageParse: {
+		double   t   = 0;
+		xo::Doc* tmp = NewDoc(kind, markup, &t);
+		delete tmp;
+		return t;
+	}
+	case StageClone: {
+		xo::Doc*        clone = new xo::Doc(nullptr);
+		xo::RenderStats stats;
+		start = xo::TimeAccurateSeconds();
+		doc->CloneSlowInto(*clone, 0, stats);
+		double t = xo::TimeAccurateSeconds() - start;
+		delete clone;
+		return t;
+	}
+	case StageStyle: {
+		xo::Pool        pool;
+		xo::RenderStack stack;
+		stack.Initialize(doc, &pool);
+		start = xo::TimeAccurateSeconds();
+		stack.Reset();
+		ResolveTree(stack, &doc->Root);
+		return xo::TimeAccurateSeconds() - start;
+	}
+	case StageLayout: {
+		xo::LayoutResult res(*doc);
+		xo::Layout       lay;
+		start = xo::TimeAccurateSeconds();
+		lay.PerformLayout(*doc, res.Root, res.Pool);
+		return xo::TimeAccurateSeconds() - start;
+	}
+	case StageRender: {
+		xo::LayoutResult res(*doc);
+		xo::Layout       lay;
+		lay.PerformLayout(*doc, res.Root, res.Pool);
+		xo::VectorCache vcache;
+		xo::RenderStats stats;
+		RecordingDriver driver(ViewportWidth, ViewportHeight);
+		xo::Renderer    rend;
+		start = xo::TimeAccurateSeconds();
+		rend.Render(doc, &vcache, nullptr, &driver, &res.Root, stats);
+		double t  = xo::TimeAccurateSeconds() - start;
+		drawCalls = driver.NumDrawCalls;
+		return t;
+	}
+	default:
+		return 0;
+	}
+}
+
+static int DefaultReps(size_t numNodes) {
+	return (int) xo::Clamp<size_t>(300000 / numNodes, 1, 10);
+}
+
+static std::string ToJSON(const Options& opt, const xo::cheapvec<Result>& results) {
+	std::string out = "{\n";
+	out += tsf::fmt("\t\"label\": \"%v\",\n", opt.Label);
+	out += tsf::fmt("\t\"workerThreads\": %v,\n", xo::Global()->NumWorkerThreads);
+	out += "\t\"results\": [\n";
+	for (size_t i = 0; i < results.size(); i++) {
+		const Result& r = results[i];
+		out += tsf::fmt("\t\t{\"doc\": \"%v\", \"nodes\": %v, \"elements\": %v, \"stage\": \"%v\", \"reps\": %v, \"min_ms\": %.3f, \"median_ms\": %.3f, \"max_ms\": %.3f",
+		                DocKindName(r.Kind), r.NumNodes, r.NumEls, StageNames[r.Stage], r.Reps, r.Min * 1000, r.Median * 1000, r.Max * 1000);
+		if (r.Stage == StageRender)
+			out += tsf::fmt(", \"drawCalls\": %v", r.DrawCalls);
+		out += i == results.size() - 1 ? "}\n" : "},\n";
+	}
+	out += "\t]\n}\n";
+	return out;
+}
+
+static bool ParseArgs(int argc, char** argv, Options& opt) {
+	for (int i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+		const char* val = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (val == nullptr) {
+			fprintf(stderr, "Missing value for %s\n", arg);
+			return false;
+		}
+		i++;
+		if (strcmp(arg, "-docs") == 0) {
+			for (auto& name : xo::String(val).Split(",")) {
+				DocKinds k;
+				if (!ParseDocKind(name.Z, k)) {
+					fprintf(stderr, "Unknown document kind '%s'\n", name.Z);
+					return false;
+				}
+				opt.Kinds += k;
+			}
+		} else if (strcmp(arg, "-sizes") == 0) {
+			for (auto& s : xo::String(val).Split(","))
+				opt.Sizes += (size_t) atoll(s.Z);
+		} else if (strcmp(arg, "-reps") == 0) {
+			opt.Reps = atoi(val);
+		} else if (strcmp(arg, "-label") == 0) {
+			opt.Label = val;
+		} else if (strcmp(arg, "-out") == 0) {
+			opt.Out = val;
+		} else {
+			fprintf(stderr, "Unknown option %s\n", arg);
+			return false;
+		}
+	}
+	if (opt.Kinds.size() == 0) {
+		for (int i = 0; i < DocKindEND; i++)
+			opt.Kinds += (DocKinds) i;
+	}
+	if (opt.Sizes.size() == 0) {
+		opt.Sizes += 1000;
+		opt.Sizes += 10000;
+		opt.Sizes += 100000;
+		opt.Sizes += 1000000;
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	Options opt;
+	if (!ParseArgs(argc, argv, opt))
+		return 1;
+
+	xo::Initialize();
+
+	xo::cheapvec<Result> results;
+	for (DocKinds kind : opt.Kinds) {
+		for (size_t size : opt.Sizes) {
+			std::string markup = SyntheticDoc::Markup(kind, size);
+			xo::Doc*    doc    = NewDoc(kind, markup, nullptr);
+			int         reps   = opt.Reps > 0 ? opt.Reps : DefaultReps(size);
+			for (int s = 0; s < StageEND; s++) {
+				fprintf(stderr, "%-8s %8d %-7s", DocKindName(kind), (int) size, StageNames[s]);
+				xo::cheapvec<double> times;
+				uint64_t             drawCalls = 0;
+				// The first run warms up the glyph cache, and any other state that persists across frames
+				RunStage((Stages) s, kind, markup, doc, drawCalls);
+				for (int i = 0; i < reps; i++)
+					times += RunStage((Stages) s, kind, markup, doc, drawCalls);
+				std::sort(times.data, times.data + times.size());
+
+				Result r;
+				r.Kind      = kind;
+				r.NumNodes  = size;
+				r.Stage     = (Stages) s;
+				r.NumEls    = (uint32_t) doc->InternalIDSize();
+				r.Reps      = reps;
+				r.Min       = times[0];
+				r.Median    = times[times.size() / 2];
+				r.Max       = times.back();
+				r.DrawCalls = drawCalls;
+				results += r;
+				fprintf(stderr, " %10.3f ms\n", r.Median * 1000);
+			}
+			delete doc;
+		}
+	}
+
+	std::string json = ToJSON(opt, results);
+	bool        ok   = true;
+	if (opt.Out != "") {
+		FILE* f = fopen(opt.Out.c_str(), "wb");
+		ok      = f != nullptr && fwrite(json.c_str(), 1, json.size(), f) == json.size();
+		if (f != nullptr)
+			fclose(f);
+		if (!ok)
+			fprintf(stderr, "Failed to write %s\n", opt.Out.c_str());
+	} else {
+		fputs(json.c_str(), stdout);
+	}
+
+	xo::Shutdown();
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+#include "RecordingDriver.h"
+
+RecordingDriver::RecordingDriver(int width, int height) {
+	FBWidth  = width;
+	FBHeight = height;
+}
+
+void RecordingDriver::ResetCounters() {
+	NumDrawCalls   = 0;
+	NumVertices    = 0;
+	NumTextures    = 0;
+	NumUploadBytes = 0;
+}
+
+const char* RecordingDriver::RendererName() {
+	return "Recording";
+}
+
+bool RecordingDriver::InitializeDevice(xo::SysWnd& wnd) {
+	return true;
+}
+
+void RecordingDriver::DestroyDevice(xo::SysWnd& wnd) {
+}
+
+void RecordingDriver::SurfaceLost() {
+}
+
+bool RecordingDriver::BeginRender(xo::SysWnd& wnd) {
+	return true;
+}
+
+void RecordingDriver::EndRender(xo::SysWnd& wnd, uint32_t endRenderFlags) {
+}
+
+void RecordingDriver::PreRender() {
+	xo::Mat4f mvproj;
+	mvproj.Identity();
+	Ortho(mvproj, 0, FBWidth, FBHeight, 0, 1, 0);
+	SetupToScreen(mvproj);
+}
+
+void RecordingDriver::PostRenderCleanup() {
+}
+
+xo::ProgBase* RecordingDriver::GetShader(xo::Shaders shader) {
+	return nullptr;
+}
+
+void RecordingDriver::ActivateShader(xo::Shaders shader) {
+}
+
+void RecordingDriver::Draw(xo::GPUPrimitiveTypes type, int nvertex, const void* v) {
+	NumDrawCalls++;
+	NumVertices += nvertex;
+}
+
+bool RecordingDriver::LoadTexture(xo::Texture* tex, int texUnit) {
+	EnsureTextureProperlyDefined(tex, texUnit);
+
+	if (!IsTextureValid(tex->TexID))
+		tex->TexID = RegisterTexture((uintptr_t) tex);
+
+	if (tex->InvalidRect.IsAreaPositive())
+		NumTextures++;
+	return true;
+}
+
+bool RecordingDriver::ReadBackbuffer(xo::Image& image) {
+	return false;
+}
+
+bool RecordingDriver::PrepareTexture(xo::Texture* tex) {
+	EnsureTextureProperlyDefined(tex, 0);
+	if (IsTextureValid(tex->TexID))
+		return true;
+
+	tex->TexID = RegisterTexture((uintptr_t) tex);
+	tex->InvalidateWholeSurface();
+	return true;
+}
+
+bool RecordingDriver::UploadTextureRect(const xo::Texture* tex, xo::Box rect, const void* data) {
+	NumUploadBytes += (uint64_t) rect.Width() * rect.Height() * tex->BytesPerPixel();
+	return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "../xo/xo.h"
+#include "../xo/Render/RenderBase.h"
+
+/* A RenderBase that does no drawing at all, but counts what it is asked to do.
+
+This lets us time Renderer on its own, without the cost of a rasterizer or a GPU driver.
+*/
+class RecordingDriver : public xo::RenderBase {
+public:
+	uint64_t NumDrawCalls   = 0;
+	uint64_t NumVertices    = 0;
+	uint64_t NumTextures    = 0; // Number of texture loads that had an invalid region to upload
+	uint64_t NumUploadBytes = 0; // Bytes of texels that were streamed by UploadTextureRect
+
+	RecordingDriver(int width, int height);
+
+	void ResetCounters();
+
+	const char* RendererName() override;
+
+	bool InitializeDevice(xo::SysWnd& wnd) override;
+	void DestroyDevice(xo::SysWnd& wnd) override;
+	void SurfaceLost() override;
+
+	bool BeginRender(xo::SysWnd& wnd) override;
+	void EndRender(xo::SysWnd& wnd, uint32_t endRenderFlags) override;
+
+	void PreRender() override;
+	void PostRenderCleanup() override;
+
+	xo::ProgBase* GetShader(xo::Shaders shader) override;
+	void          ActivateShader(xo::Shaders shader) override;
+
+	void Draw(xo::GPUPrimitiveTypes type, int nvertex, const void* v) override;
+
+	bool LoadTexture(xo::Texture* tex, int texUnit) override;
+	bool ReadBackbuffer(xo::Image& image) override;
+
+	bool PrepareTexture(xo::Texture* tex) override;
+	bool UploadTextureRect(const xo::Texture* tex, xo::Box rect, const void* data) override;
+};
@@ -0,0 +1,159 @@
+#include "SyntheticDoc.h"
+
+static const char* DocKindNames[DocKindEND] = {
+    "grid",
+    "deep",
+    "text",
+    "classes",
+    "canvas",
+};
+
+static const char* Words[] = {
+    "the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog", "layout", "of", "a", "document",
+    "is", "mostly", "text", "and", "boxes", "which", "must", "wrap", "onto", "new", "lines", "when",
+};
+
+// Deterministic, so that every run generates the same document
+static uint32_t NextRandom(uint32_t& state) {
+	state = state * 1664525 + 1013904223;
+	return state >> 8;
+}
+
+const char* DocKindName(DocKinds kind) {
+	return DocKindNames[kind];
+}
+
+bool ParseDocKind(const char* name, DocKinds& kind) {
+	for (int i = 0; i < DocKindEND; i++) {
+		if (strcmp(name, DocKindNames[i]) == 0) {
+			kind = (DocKinds) i;
+			return true;
+		}
+	}
+	return false;
+}
+
+std::string SyntheticDoc::Markup(DocKinds kind, size_t numNodes) {
+	std::string out;
+	switch (kind) {
+	case DocGrid: MarkupGrid(out, numNodes); break;
+	case DocDeep: MarkupDeep(out, numNodes); break;
+	case DocText: MarkupText(out, numNodes); break;
+	case DocClasses: MarkupClasses(out, numNodes); break;
+	case DocCanvas: MarkupCanvas(out, numNodes); break;
+	default: break;
+	}
+	return out;
+}
+
+void SyntheticDoc::Prepare(DocKinds kind, xo::Doc* doc) {
+	if (kind != DocClasses)
+		return;
+	uint32_t rnd = 1;
+	for (int i = 0; i < NumClasses; i++) {
+		uint32_t r     = NextRandom(rnd);
+		auto     name  = tsf::fmt("c%v", i);
+		auto     style = tsf::fmt("width: %vpx; height: %vpx; margin: %vpx; border-radius: %vpx; background: #%06x",
+		                          4 + r % 12, 4 + (r >> 4) % 12, 1 + (r >> 8) % 3, (r >> 10) % 3, (r >> 12) & 0xffffff);
+		doc->ClassParse(name.c_str(), style.c_str());
+	}
+}
+
+void SyntheticDoc::Finish(DocKinds kind, xo::Doc* doc) {
+	if (kind == DocCanvas)
+		FinishCanvases(&doc->Root);
+}
+
+void SyntheticDoc::MarkupGrid(std::string& out, size_t numNodes) {
+	size_t   n   = 0;
+	uint32_t rnd = 1;
+	while (n < numNodes) {
+		out += "<div style='width: 100%; height: 10px; margin: 1px; break: after'>";
+		n++;
+		for (int x = 0; x < 100 && n < numNodes; x++, n++)
+			out += tsf::fmt("<div style='width: 8px; height: 8px; margin: 1px; background: #%06x'></div>", NextRandom(rnd) & 0xffffff);
+		out += "</div>";
+	}
+}
+
+void SyntheticDoc::MarkupDeep(std::string& out, size_t numNodes) {
+	size_t n = 0;
+	while (n < numNodes) {
+		int depth = 0;
+		for (; depth < DeepLevels && n < numNodes; depth++, n++)
+			out += "<div style='padding: 1px; border: 1px #888'>";
+		for (int i = 0; i < depth; i++)
+			out += "</div>";
+	}
+}
+
+void SyntheticDoc::MarkupText(std::string& out, size_t numNodes) {
+	size_t   n        = 0;
+	uint32_t rnd      = 1;
+	size_t   numWords = sizeof(Words) / sizeof(Words[0]);
+	while (n < numNodes) {
+		// A paragraph is a div, and then runs of text that alternate with spans
+		out += "<div style='margin: 4px; font-size: 13px'>";
+		n++;
+		for (int run = 0; run < 5 && n < numNodes; run++, n++) {
+			bool span = run % 2 == 1;
+			if (span) {
+				out += "<span style='color: #a00'>";
+				n++;
+			}
+			for (int w = 0; w < 12; w++) {
+				out += Words[NextRandom(rnd) % numWords];
+				out += " ";
+			}
+			if (span)
+				out += "</span>";
+		}
+		out += "</div>";
+	}
+}
+
+void SyntheticDoc::MarkupClasses(std::string& out, size_t numNodes) {
+	size_t   n   = 0;
+	uint32_t rnd = 1;
+	while (n < numNodes) {
+		out += "<div style='break: after'>";
+		n++;
+		for (int x = 0; x < 50 && n < numNodes; x++, n++) {
+			uint32_t r = NextRandom(rnd);
+			out += tsf::fmt("<div class='c%v c%v c%v'></div>", r % NumClasses, (r >> 8) % NumClasses, (r >> 16) % NumClasses);
+		}
+		out += "</div>";
+	}
+}
+
+void SyntheticDoc::MarkupCanvas(std::string& out, size_t numNodes) {
+	// Only one element in ten is a canvas, so that a million nodes does not need gigabytes of images
+	size_t n = 0;
+	while (n < numNodes) {
+		out += "<div style='break: after'>";
+		n++;
+		for (int x = 0; x < 40 && n < numNodes; x++, n++) {
+			if (x % 10 == 0)
+				out += tsf::fmt("<canvas style='width: %vpx; height: %vpx; margin: 1px'></canvas>", CanvasSize, CanvasSize);
+			else
+				out += "<div style='width: 12px; height: 12px; margin: 1px; background: #ddd'></div>";
+		}
+		out += "</div>";
+	}
+}
+
+void SyntheticDoc::FinishCanvases(xo::DomNode* node) {
+	for (auto c : node->GetChildren()) {
+		if (c->GetTag() == xo::TagCanvas) {
+			xo::DomCanvas* canvas = static_cast<xo::DomCanvas*>(c);
+			canvas->SetImageSizeOnly(CanvasSize, CanvasSize);
+			xo::Canvas2D* c2d = canvas->GetCanvas2D();
+			c2d->Fill(xo::Color::RGBA(255, 255, 255, 255));
+			c2d->FillCircle(CanvasSize / 2, CanvasSize / 2, CanvasSize / 3, xo::Color::RGBA(0, 120, 200, 255));
+			c2d->StrokeLine(0, 0, CanvasSize, CanvasSize, xo::Color::RGBA(200, 0, 0, 255), 1.5f);
+			canvas->ReleaseAndInvalidate(c2d);
+		} else if (c->IsNode()) {
+			FinishCanvases(static_cast<xo::DomNode*>(c));
+		}
+	}
+}
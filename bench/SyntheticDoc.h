@@ -0,0 +1,44 @@
+#pragma once
+#include "../xo/xo.h"
+
+// Shapes of document that stress different parts of the pipeline
+enum DocKinds {
+	DocGrid,    // Rows of small fixed-size boxes, two levels deep
+	DocDeep,    // Chains of nested boxes, 50 levels deep, without any text
+	DocText,    // Paragraphs of words, with a few inline spans
+	DocClasses, // Boxes that each reference several out of hundreds of classes
+	DocCanvas,  // Rows of labelled boxes, where every tenth element is a small canvas
+	DocKindEND,
+};
+
+const char* DocKindName(DocKinds kind);
+bool        ParseDocKind(const char* name, DocKinds& kind);
+
+/* Generates documents of a given shape and size, for benchmarking.
+
+The output is a function of only the kind and the number of nodes, so results are comparable between runs
+and between commits. Elements and text nodes are both counted as nodes.
+*/
+class SyntheticDoc {
+public:
+	// Return markup for Doc::Parse, with approximately 'numNodes' nodes
+	static std::string Markup(DocKinds kind, size_t numNodes);
+
+	// Setup that must happen before Parse, such as defining classes
+	static void Prepare(DocKinds kind, xo::Doc* doc);
+
+	// Setup that must happen after Parse, such as drawing into canvases
+	static void Finish(DocKinds kind, xo::Doc* doc);
+
+protected:
+	static const int NumClasses = 256;
+	static const int CanvasSize = 16;
+	static const int DeepLevels = 50;
+
+	static void MarkupGrid(std::string& out, size_t numNodes);
+	static void MarkupDeep(std::string& out, size_t numNodes);
+	static void MarkupText(std::string& out, size_t numNodes);
+	static void MarkupClasses(std::string& out, size_t numNodes);
+	static void MarkupCanvas(std::string& out, size_t numNodes);
+	static void FinishCanvases(xo::DomNode* node);
+};
@@ -16,3 +16,31 @@ xo::String LoadFileAsString(const char* file)
 	}
 	return result;
 }
+
+RenderTester::RenderTester(int width, int height) {
+	Wnd = xo::SysWndHeadless::NewWithDoc(width, height);
+	xo::AddOrRemoveDocsFromGlobalList();
+	Group = Wnd->DocGroup;
+	Doc   = Group->Doc;
+}
+
+RenderTester::~RenderTester() {
+	delete Wnd;
+	xo::AddOrRemoveDocsFromGlobalList();
+}
+
+uint32_t PixelAt(const xo::Image& img, int x, int y) {
+	return *((const uint32_t*) img.DataAt(x, y));
+}
+
+bool ImagesEqual(const xo::Image& a, const xo::Image& b) {
+	if (a.Width != b.Width || a.Height != b.Height)
+		return false;
+	for (int y = 0; y < (int) a.Height; y++) {
+		for (int x = 0; x < (int) a.Width; x++) {
+			if (PixelAt(a, x, y) != PixelAt(b, x, y))
+				return false;
+		}
+	}
+	return true;
+}
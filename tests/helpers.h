@@ -3,3 +3,29 @@
 inline bool EQ(const char* a, const char* b) { return strcmp(a, b) == 0; }
 
 xo::String LoadFileAsString(const char* file);
+
+// Assigns a value to a global setting, and puts the original value back at the end of the scope
+template <typename T>
+class ScopedGlobal {
+public:
+	ScopedGlobal(T& setting, T value) : Setting(setting), Original(setting) { Setting = value; }
+	~ScopedGlobal() { Setting = Original; }
+
+private:
+	T& Setting;
+	T  Original;
+};
+
+// A headless window with a document, for tests that render or that need a live document. The window is destroyed at the end of the scope.
+class RenderTester {
+public:
+	xo::SysWnd*   Wnd;
+	xo::DocGroup* Group;
+	xo::Doc*      Doc;
+
+	RenderTester(int width, int height);
+	~RenderTester();
+};
+
+uint32_t PixelAt(const xo::Image& img, int x, int y); // RGBA
+bool     ImagesEqual(const xo::Image& a, const xo::Image& b);
@@ -19,7 +19,10 @@ int main(int argc, char** argv)
 	_CrtSetAllocHook(CrtAllocHook);
 #endif
 
-	xo::Initialize();
+	// Parallel layout is only enabled when there are worker threads, so make sure there are some, even on a single core machine
+	xo::InitParams init;
+	init.NumWorkerThreads = 3;
+	xo::Initialize(&init);
 
 	// Uncomment this line to run tests on DirectX
 	//xoGlobal()->PreferOpenGL = false;
@@ -12,33 +12,97 @@ static void SetDocDims(xo::Doc* doc, int width, int height) {
 // }
 
 TESTFUNC(DocumentClone) {
-	// I need to add a null renderer for these kind of tests
-	xo::SysWnd* wnd = xo::SysWnd::New();
-	xo::AddOrRemoveDocsFromGlobalList();
-	xo::DocGroup* g = wnd->DocGroup;
+	RenderTester  t(16, 16);
+	xo::DocGroup* g = t.Group;
+	// Clone_NumEls is a running total. Every change adds the elements that are named beside it, which are copied in the
+	// first frame after the change, and the frames without modifications that follow must not add to it.
+	// The headless window has a valid size from the start, so the first frame copies the new root.
 	g->Render();
 	SetDocDims(g->Doc, 16, 16);
-	TTASSERT(g->RenderStats.Clone_NumEls == 0);
+	TTASSERT(g->RenderStats.Clone_NumEls == 1); // +1: root
 	xo::Doc* d = g->Doc;
 
 	xo::DomNode* div1 = d->Root.AddNode(xo::TagDiv);
 	for (int i = 0; i < 5; i++) {
 		g->Render();
-		TTASSERT(g->RenderStats.Clone_NumEls == 2); // root and div1
+		TTASSERT(g->RenderStats.Clone_NumEls == 3); // +2: root and div1
 	}
 
 	div1->StyleParsef("left: 10px;");
 	for (int i = 0; i < 5; i++) {
 		g->Render();
-		TTASSERT(g->RenderStats.Clone_NumEls == 3); // div1
+		TTASSERT(g->RenderStats.Clone_NumEls == 4); // +1: div1
 	}
 
 	d->Root.DeleteChild(div1);
 	for (int i = 0; i < 5; i++) {
 		g->Render();
-		TTASSERT(g->RenderStats.Clone_NumEls == 5); // root and div1
+		TTASSERT(g->RenderStats.Clone_NumEls == 6); // +2: root and div1
 	}
+}
+
+// Only the classes that were modified since the previous frame are copied to the renderer,
+// unless a style variable changes, in which case all of them must be copied again.
+TESTFUNC(DocumentClone_Classes) {
+	RenderTester  t(16, 16);
+	xo::DocGroup* g = t.Group;
+	xo::Doc*      d = t.Doc;
+	xo::Image     img;
+
+	for (int i = 0; i < 50; i++)
+		d->ClassParse(tsf::fmt("c%v", i).c_str(), "width: 4px; height: 4px");
+	d->Root.AddNode(xo::TagDiv)->AddClass("c7");
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	uint32_t n = g->RenderStats.Clone_NumClasses;
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Clone_NumClasses == n);
 
-	delete wnd;
-	xo::AddOrRemoveDocsFromGlobalList();
+	d->ClassParse("c7", "width: 5px; height: 4px");
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Clone_NumClasses == n + 1);
+	const xo::StyleClass* c7 = g->RenderDoc->Doc.ClassStyles.GetByID(d->ClassStyles.GetClassID("c7"));
+	TTASSERT(c7->Default().Get(xo::CatWidth)->GetSize() == xo::Size::Pixels(5));
+
+	size_t numClasses = d->ClassStyles.Size();
+	d->SetStyleVar("w", "6px");
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Clone_NumClasses == n + 1 + numClasses);
+
+	// A class that is changed through a pointer that was kept from before the previous frame is copied too,
+	// while merely looking the class up is not a change
+	n                  = g->RenderStats.Clone_NumClasses;
+	xo::StyleClass* c9 = d->ClassStyles.GetOrCreate("c9");
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Clone_NumClasses == n);
+	TTASSERT(c9->Parse(xo::StyleClass::PseudoDefault, "width: 7px", -1, d));
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Clone_NumClasses == n + 1);
+	const xo::StyleClass* r9 = g->RenderDoc->Doc.ClassStyles.GetByID(d->ClassStyles.GetClassID("c9"));
+	TTASSERT(r9->Default().Get(xo::CatWidth)->GetSize() == xo::Size::Pixels(7));
+}
+
+// A large number of modified elements is cloned on the worker threads
+TESTFUNC(DocumentClone_Parallel) {
+	RenderTester  t(16, 16);
+	xo::DocGroup* g = t.Group;
+	xo::Doc*      d = t.Doc;
+	xo::Image     img;
+
+	xo::cheapvec<xo::DomNode*> nodes;
+	for (int i = 0; i < 10000; i++)
+		nodes += d->Root.AddNode(xo::TagDiv);
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+
+	for (size_t i = 0; i < nodes.size(); i += 2)
+		nodes[i]->StyleParse("width: 3px");
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+
+	const xo::Doc& r = g->RenderDoc->Doc;
+	for (size_t i = 0; i < nodes.size(); i++) {
+		const xo::DomNode* rn = r.GetNodeByInternalID(nodes[i]->GetInternalID());
+		TTASSERT(rn != nullptr);
+		TTASSERT(rn->GetParentID() == d->Root.GetInternalID());
+		TTASSERT((rn->GetStyle().Get(xo::CatWidth) != nullptr) == (i % 2 == 0));
+	}
+	TTASSERT(r.Root.ChildCount() == nodes.size());
 }
@@ -0,0 +1,130 @@
+#include "pch.h"
+
+static xo::OriginalEvent MakeEvent(xo::Events type, float x) {
+	xo::OriginalEvent ev;
+	ev.Event.Type         = type;
+	ev.Event.PointCount   = 1;
+	ev.Event.PointsAbs[0] = Vec2f(x, 0);
+	return ev;
+}
+
+TESTFUNC(EventQueue_Coalesce) {
+	xo::EventQueue        q;
+	xo::EventQueue::Slots slots;
+	q.Initialize(false);
+
+	q.Add(MakeEvent(xo::EventMouseDown, 0));
+	for (int i = 1; i <= 4; i++)
+		q.AddOrReplace(MakeEvent(xo::EventMouseMove, (float) i), slots);
+	q.Add(MakeEvent(xo::EventMouseUp, 5), &slots);
+	q.AddOrReplace(MakeEvent(xo::EventMouseMove, 6), slots);
+	TTASSERT(q.Size() == 4);
+
+	// The moves keep the place of the first move, carry the position of the last, and remember the rest.
+	// The move after the mouse up is not merged into the moves before it.
+	xo::OriginalEvent ev;
+	TTASSERT(q.PopTail(ev) && ev.Event.Type == xo::EventMouseDown);
+	TTASSERT(q.PopTail(ev) && ev.Event.Type == xo::EventMouseMove);
+	TTASSERT(ev.Event.PointsAbs[0].x == 4);
+	TTASSERT(ev.Event.CoalescedCount == 3);
+	for (int i = 0; i < 3; i++)
+		TTASSERT(ev.Event.Coalesced[i].PointsAbs[0].x == i + 1);
+	TTASSERT(q.PopTail(ev) && ev.Event.Type == xo::EventMouseUp);
+	TTASSERT(ev.Event.CoalescedCount == 0);
+	TTASSERT(q.PopTail(ev) && ev.Event.Type == xo::EventMouseMove);
+	TTASSERT(ev.Event.PointsAbs[0].x == 6);
+	TTASSERT(ev.Event.CoalescedCount == 0);
+	TTASSERT(!q.PopTail(ev));
+	TTASSERT(q.Size() == 0);
+
+	// Several segments of one chain are dispatched in order, between the events that separate them
+	for (int i = 10; i < 13; i++) {
+		q.AddOrReplace(MakeEvent(xo::EventMouseMove, (float) i), slots);
+		q.AddOrReplace(MakeEvent(xo::EventMouseMove, (float) i + 0.5f), slots);
+		q.Add(MakeEvent(xo::EventMouseUp, (float) i), &slots);
+	}
+	for (int i = 10; i < 13; i++) {
+		TTASSERT(q.PopTail(ev) && ev.Event.Type == xo::EventMouseMove);
+		TTASSERT(ev.Event.PointsAbs[0].x == (float) i + 0.5f && ev.Event.CoalescedCount == 1);
+		TTASSERT(q.PopTail(ev) && ev.Event.Type == xo::EventMouseUp && ev.Event.PointsAbs[0].x == i);
+	}
+	TTASSERT(!q.PopTail(ev));
+
+	// A move that arrives after the previous one was dispatched starts a new chain
+	q.AddOrReplace(MakeEvent(xo::EventMouseMove, 7), slots);
+	TTASSERT(q.PopTail(ev) && ev.Event.PointsAbs[0].x == 7 && ev.Event.CoalescedCount == 0);
+
+	// History is bounded
+	for (int i = 0; i < xo::EventQueue::MaxHistory + 10; i++)
+		q.AddOrReplace(MakeEvent(xo::EventMouseMove, (float) i), slots);
+	TTASSERT(q.PopTail(ev) && ev.Event.CoalescedCount == xo::EventQueue::MaxHistory);
+	TTASSERT(ev.Event.Coalesced[xo::EventQueue::MaxHistory - 1].PointsAbs[0].x == xo::EventQueue::MaxHistory + 8);
+}
+
+// Tallies the events that EventQueue_Producers pops
+struct ProducerTally {
+	static const int NumThreads = 4;
+	static const int PerThread  = 20000;
+
+	int  LastKey[NumThreads];
+	int  NumKeys    = 0;
+	int  NumMoves   = 0;
+	bool Overflowed = false;
+
+	ProducerTally() {
+		for (int i = 0; i < NumThreads; i++)
+			LastKey[i] = -1;
+	}
+
+	void Consume(const xo::OriginalEvent& ev) {
+		if (ev.Event.Type == xo::EventKeyDown) {
+			int v = (int) ev.Event.PointsAbs[0].x;
+			int t = v / PerThread;
+			TTASSERT(v % PerThread > LastKey[t]);
+			LastKey[t] = v % PerThread;
+			NumKeys++;
+		} else {
+			NumMoves += 1 + ev.Event.CoalescedCount;
+			Overflowed |= ev.Event.CoalescedCount == xo::EventQueue::MaxHistory;
+		}
+	}
+};
+
+TESTFUNC(EventQueue_Producers) {
+	const int             perThread = ProducerTally::PerThread;
+	const int             half      = ProducerTally::NumThreads * perThread / 2;
+	xo::EventQueue        q;
+	xo::EventQueue::Slots slots;
+	q.Initialize(true);
+
+	std::vector<std::thread> producers;
+	for (int t = 0; t < ProducerTally::NumThreads; t++) {
+		producers.emplace_back([&q, &slots, t] {
+			for (int i = 0; i < perThread; i++) {
+				if (i % 2 == 0)
+					q.Add(MakeEvent(xo::EventKeyDown, (float) (t * perThread + i)), &slots);
+				else
+					q.AddOrReplace(MakeEvent(xo::EventMouseMove, (float) i), slots);
+			}
+		});
+	}
+
+	// Every key press arrives exactly once, and in order for each producer.
+	// Every move arrives either directly, or in the history of a later move, unless the history overflowed.
+	ProducerTally tally;
+	while (tally.NumKeys < half) {
+		q.SemObj().wait();
+		xo::OriginalEvent ev;
+		TTASSERT(q.PopTail(ev));
+		tally.Consume(ev);
+	}
+	for (auto& p : producers)
+		p.join();
+	xo::OriginalEvent ev;
+	while (q.PopTail(ev))
+		tally.Consume(ev);
+
+	TTASSERT(tally.NumKeys == half);
+	TTASSERT(tally.Overflowed ? tally.NumMoves <= half : tally.NumMoves == half);
+	TTASSERT(q.Size() == 0);
+}
@@ -0,0 +1,39 @@
+#include "pch.h"
+#include "../xo/Text/FontStore.h"
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+// The kerning tables that FontStore builds must agree with Freetype, for Latin-1 pairs, which come from
+// the dense table, and for pairs outside of Latin-1, which come from the hashed glyph pairs.
+TESTFUNC(FontStore_Kerning) {
+	const xo::Font* font = xo::Global()->FontStore->GetByFontID(xo::Global()->FontStore->GetFallbackFontID());
+	FT_Face         face = (FT_Face) font->FTFace;
+
+	xo::cheapvec<uint32_t> chars;
+	for (uint32_t c = 32; c < 127; c++)
+		chars += c;
+	for (uint32_t c = 0xc0; c < 0x100; c++)
+		chars += c;
+	for (uint32_t c = 0x391; c < 0x3ca; c++) // Greek
+		chars += c;
+	for (uint32_t c = 0x410; c < 0x450; c++) // Cyrillic
+		chars += c;
+
+	std::lock_guard<std::mutex> lock(font->FTFace_Lock);
+	size_t                      numKerned = 0;
+	for (auto left : chars) {
+		FT_UInt leftGlyph = FT_Get_Char_Index(face, left);
+		for (auto right : chars) {
+			FT_UInt   rightGlyph = FT_Get_Char_Index(face, right);
+			FT_Vector expect     = {0, 0};
+			if (FT_HAS_KERNING(face))
+				FT_Get_Kerning(face, leftGlyph, rightGlyph, FT_KERNING_UNSCALED, &expect);
+			TTASSERT(font->Kerning.Get(left, right, leftGlyph, rightGlyph) == expect.x);
+			numKerned += expect.x != 0 ? 1 : 0;
+		}
+	}
+
+	// Otherwise we have tested nothing
+	if (FT_HAS_KERNING(face))
+		TTASSERT(numKerned != 0);
+}
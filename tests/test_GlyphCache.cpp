@@ -0,0 +1,102 @@
+#include "pch.h"
+#include "../xo/Text/GlyphCache.h"
+#include "../xo/Text/FontStore.h"
+#include "../xo/Render/TextureAtlas.h"
+
+static const size_t GlyphCacheTest_AtlasBytes = xo::GlyphAtlasSize * xo::GlyphAtlasSize;
+
+// The latin letters of one font and size
+static ohash::set<xo::GlyphCacheKey> GlyphCacheTest_Letters(xo::FontID font, uint8_t size) {
+	ohash::set<xo::GlyphCacheKey> keys;
+	for (uint32_t ch = 'A'; ch <= 'Z'; ch++) {
+		keys.insert(xo::GlyphCacheKey(font, ch, size, 0));
+		keys.insert(xo::GlyphCacheKey(font, ch + 'a' - 'A', size, 0));
+	}
+	return keys;
+}
+
+static int GlyphCacheTest_NumPresent(xo::GlyphCache& cache, const ohash::set<xo::GlyphCacheKey>& keys) {
+	auto glyphs = cache.BeginRead();
+	int  n      = 0;
+	for (auto k : keys)
+		n += glyphs->GetGlyph(k) != nullptr ? 1 : 0;
+	cache.EndRead(glyphs);
+	return n;
+}
+
+// Eviction must take the least recently used glyphs first, never touch the glyphs of the current frame,
+// and compaction must keep the device textures of the atlases that it frees, and reuse their space.
+TESTFUNC(GlyphCache_Trim) {
+	ScopedGlobal<size_t> maxBytes(xo::Global()->GlyphCacheMaxBytes, 0);
+	ScopedGlobal<bool>   noDiskCache(xo::Global()->EnableGlyphDiskCache, false);
+
+	xo::GlyphCache cache;
+	xo::FontID     font = xo::Global()->FontStore->GetFallbackFontID();
+
+	// One frame per size. The large glyphs of frames 1..4 fill a few atlases, and the small glyphs are what should survive.
+	const int                     numFrames        = 7;
+	const uint8_t                 sizes[numFrames] = {12, 100, 110, 90, 120, 16, 20};
+	ohash::set<xo::GlyphCacheKey> frames[numFrames];
+	for (int f = 0; f < numFrames; f++) {
+		frames[f] = GlyphCacheTest_Letters(font, sizes[f]);
+		cache.RenderGlyphs(frames[f]);
+		cache.EndFrame();
+	}
+	uint32_t numAtlases = cache.NumAtlases();
+	TTASSERT(numAtlases >= 3);
+	TTASSERT(cache.AtlasBytes() == numAtlases * GlyphCacheTest_AtlasBytes);
+
+	// Pretend that the renderer uploaded every atlas
+	auto glyphs = cache.BeginRead();
+	for (uint32_t i = 0; i < numAtlases; i++)
+		glyphs->GetAtlasMutable(i)->TexID = 100 + i;
+
+	// The oldest glyphs are drawn again in the current frame
+	for (auto k : frames[0])
+		glyphs->MarkUsed(glyphs->GetGlyph(k));
+	cache.EndRead(glyphs);
+
+	xo::Global()->GlyphCacheMaxBytes = GlyphCacheTest_AtlasBytes;
+	cache.EndFrame();
+
+	// Glyphs of the current frame survive, and the rest go in order of age, no matter how small they are.
+	// Eviction stops part of the way through frame 4.
+	TTASSERT(GlyphCacheTest_NumPresent(cache, frames[0]) == (int) frames[0].size());
+	for (int f = 1; f < 4; f++)
+		TTASSERT(GlyphCacheTest_NumPresent(cache, frames[f]) == 0);
+	TTASSERT(GlyphCacheTest_NumPresent(cache, frames[4]) < (int) frames[4].size());
+	for (int f = 5; f < numFrames; f++)
+		TTASSERT(GlyphCacheTest_NumPresent(cache, frames[f]) == (int) frames[f].size());
+
+	// Compaction leaves a single atlas, and every atlas keeps its device texture, whether it was freed or not
+	TTASSERT(cache.NumAtlases() == 1);
+	TTASSERT(cache.AtlasBytes() == GlyphCacheTest_AtlasBytes);
+	glyphs = cache.BeginRead();
+	for (uint32_t i = 0; i < numAtlases; i++)
+		TTASSERT(glyphs->GetAtlas(i)->TexID == 100 + i);
+	cache.EndRead(glyphs);
+
+	// Evicted glyphs go into the space that was freed, without another atlas
+	ohash::set<xo::GlyphCacheKey> few;
+	for (uint32_t ch = 'A'; ch < 'K'; ch++)
+		few.insert(xo::GlyphCacheKey(font, ch, sizes[3], 0));
+	uint32_t numGlyphs = cache.NumGlyphs();
+	cache.RenderGlyphs(few);
+	TTASSERT(cache.NumGlyphs() == numGlyphs + few.size());
+	TTASSERT(cache.NumAtlases() == 1);
+
+	// Once the live atlas is full, the next atlas reuses one that was freed, along with its device texture
+	cache.RenderGlyphs(frames[3]);
+	TTASSERT(cache.NumAtlases() == 2);
+	glyphs = cache.BeginRead();
+	for (int f = 0; f < numFrames; f++) {
+		for (auto k : frames[f]) {
+			const xo::Glyph* g = glyphs->GetGlyph(k);
+			if (g == nullptr)
+				continue;
+			TTASSERT(g->AtlasID < numAtlases);
+			TTASSERT(glyphs->GetAtlas(g->AtlasID)->TexID == 100 + g->AtlasID);
+		}
+	}
+	cache.EndRead(glyphs);
+}
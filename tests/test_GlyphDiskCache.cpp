@@ -0,0 +1,44 @@
+#include "pch.h"
+#include "../xo/Text/GlyphDiskCache.h"
+
+// Glyphs must survive a round trip through the file, and a damaged file must be rejected
+TESTFUNC(GlyphDiskCache) {
+	xo::String path = xo::Global()->CacheDir + XO_DIR_SEP_STR + "test-glyphs";
+
+	xo::cheapvec<xo::GlyphDiskCache::Record> records;
+	xo::cheapvec<uint8_t>                    texels;
+	for (uint32_t i = 0; i < 3; i++) {
+		xo::GlyphDiskCache::Record r;
+		memset(&r, 0, sizeof(r));
+		r.FontHash          = 0x1234567890ull;
+		r.Char              = 'a' + i;
+		r.Size              = 12;
+		r.Glyph.Width       = (uint16_t) (i + 1);
+		r.Glyph.Height      = 2;
+		r.Glyph.MetricTop   = (int16_t) (10 + i);
+		r.Glyph.MetricWidth = (uint16_t) (i + 1);
+		r.TexelOffset       = (uint32_t) texels.size();
+		for (uint32_t t = 0; t < r.Glyph.Width * r.Glyph.Height; t++)
+			texels += (uint8_t) (i * 16 + t);
+		records += r;
+	}
+	TTASSERT(xo::GlyphDiskCache::Save(path.CStr(), records, texels));
+
+	xo::GlyphDiskCache disk;
+	TTASSERT(disk.Open(path.CStr()));
+	TTASSERT(disk.NumRecords() == 3);
+	for (uint32_t i = 0; i < 3; i++) {
+		const xo::GlyphDiskCache::Record& r = disk.GetRecord(i);
+		TTASSERT(r.Char == 'a' + i);
+		TTASSERT(r.Glyph.MetricTop == 10 + i);
+		TTASSERT(memcmp(disk.GetTexels(r), &texels[records[i].TexelOffset], r.Glyph.Width * r.Glyph.Height) == 0);
+	}
+	disk.Close();
+
+	// A texel offset beyond the end of the file
+	records[2].TexelOffset = 1000;
+	TTASSERT(xo::GlyphDiskCache::Save(path.CStr(), records, texels));
+	TTASSERT(!disk.Open(path.CStr()));
+
+	remove(path.CStr());
+}
@@ -23,3 +23,35 @@ TESTFUNC(Parser)
 	}
 
 }
+
+// Nodes that are much deeper than the parser's initial stack must keep the children and attributes
+// that were collected before the stack grew.
+TESTFUNC(Parser_DeepNesting)
+{
+	const int   depth = 300;
+	std::string src;
+	for (int i = 0; i < depth; i++)
+		src += tsf::fmt("<div class='c%v'>before%v", i, i);
+	for (int i = depth - 1; i >= 0; i--)
+		src += tsf::fmt("after%v</div>", i);
+
+	xo::Doc d(nullptr);
+	TTASSERT(d.Parse(src.c_str()) == "");
+
+	TTASSERT(d.Root.ChildCount() == 1);
+	const xo::DomNode* node = (const xo::DomNode*) d.Root.ChildByIndex(0);
+	for (int i = 0; i < depth; i++) {
+		TTASSERT(node->IsNode());
+		TTASSERT(node->HasClass(tsf::fmt("c%v", i).c_str()));
+		if (i == depth - 1) {
+			// The innermost text is a single node
+			TTASSERT(node->ChildCount() == 1);
+			TTASSERT(xo::String(node->ChildByIndex(0)->GetText()) == tsf::fmt("before%vafter%v", i, i).c_str());
+			break;
+		}
+		TTASSERT(node->ChildCount() == 3);
+		TTASSERT(xo::String(node->ChildByIndex(0)->GetText()) == tsf::fmt("before%v", i).c_str());
+		TTASSERT(xo::String(node->ChildByIndex(2)->GetText()) == tsf::fmt("after%v", i).c_str());
+		node = (const xo::DomNode*) node->ChildByIndex(1);
+	}
+}
@@ -0,0 +1,523 @@
+#include "pch.h"
+
+// A change to one element must repaint only the region around that element, and the result
+// must be identical to a full repaint.
+TESTFUNC(Render_PartialRepaint) {
+	RenderTester  t(64, 64);
+	xo::DocGroup* g = t.Group;
+	xo::Doc*      d = t.Doc;
+
+	d->Root.StyleParse("margin: 0; padding: 0; background: #fff");
+	xo::DomNode* a = d->Root.AddNode(xo::TagDiv);
+	xo::DomNode* b = d->Root.AddNode(xo::TagDiv);
+	a->StyleParse("position: absolute; left: 4px; top: 4px; width: 8px; height: 8px; background: #f00");
+	b->StyleParse("position: absolute; left: 40px; top: 40px; width: 8px; height: 8px; background: #00f");
+
+	xo::Image img;
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Render_RepaintArea == 64 * 64);
+
+	b->StyleParse("background: #0f0");
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Render_RepaintArea != 0);
+	TTASSERT(g->RenderStats.Render_RepaintArea < 32 * 32);
+	xo::Image partial;
+	partial.Set(xo::TexFormatRGBA8, img.Width, img.Height, img.Data);
+
+	ScopedGlobal<bool> fullRepaint(xo::Global()->EnablePartialRepaint, false);
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Render_RepaintArea == 64 * 64);
+
+	TTASSERT(ImagesEqual(partial, img));
+	TTASSERT(PixelAt(img, 44, 44) == xo::Color::RGBA(0, 255, 0, 255).GetRGBA());
+	TTASSERT(PixelAt(img, 8, 8) == xo::Color::RGBA(255, 0, 0, 255).GetRGBA());
+}
+
+// Changing one element must not change the layout of the flow contexts around it, so their layout
+// is copied from the previous frame. The result must be identical to a full layout.
+TESTFUNC(Render_IncrementalLayout) {
+	RenderTester  t(64, 64);
+	xo::DocGroup* g = t.Group;
+	xo::Doc*      d = t.Doc;
+
+	d->Root.StyleParse("margin: 0; padding: 0; background: #fff");
+	xo::DomNode* boxes[4];
+	for (int i = 0; i < 4; i++) {
+		boxes[i] = d->Root.AddNode(xo::TagDiv);
+		boxes[i]->StyleParse("flow-context: new; width: 16px; height: 8px; background: #00f");
+		boxes[i]->AddNode(xo::TagDiv)->StyleParse("width: 4px; height: 4px; background: #f00");
+	}
+
+	xo::Image img;
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Layout_NumNodesReused == 0);
+	xo::LayoutResult*      layout = g->RenderDoc->AcquireLatestLayout();
+	const xo::RenderDomEl* inner  = layout->Node(boxes[0])->Children[0];
+	g->RenderDoc->ReleaseLayout(layout);
+
+	boxes[1]->StyleParse("height: 12px");
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Layout_NumNodesReused == 3);
+
+	// The unchanged subtree is shared with the previous layout, rather than copied
+	layout = g->RenderDoc->AcquireLatestLayout();
+	TTASSERT(layout->Node(boxes[0])->Children[0] == inner);
+	g->RenderDoc->ReleaseLayout(layout);
+	xo::Image incremental;
+	incremental.Set(xo::TexFormatRGBA8, img.Width, img.Height, img.Data);
+
+	ScopedGlobal<bool> fullLayout(xo::Global()->EnableIncrementalLayout, false);
+	boxes[1]->StyleParse("height: 12px");
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Layout_NumNodesReused == 0);
+
+	TTASSERT(ImagesEqual(incremental, img));
+	TTASSERT(PixelAt(img, 34, 2) == xo::Color::RGBA(255, 0, 0, 255).GetRGBA());
+}
+
+// Rows with a fixed size are laid out on the worker threads. The result must be identical to a serial layout.
+TESTFUNC(Render_ParallelLayout) {
+	RenderTester  t(64, 64);
+	xo::DocGroup* g = t.Group;
+	xo::Doc*      d = t.Doc;
+
+	d->Root.StyleParse("margin: 0; padding: 0; background: #fff");
+	for (int i = 0; i < 6; i++) {
+		xo::DomNode* row = d->Root.AddNode(xo::TagDiv);
+		row->StyleParse("flow-context: new; break: after; width: 100%; height: 10px");
+		row->AddNode(xo::TagDiv)->StyleParse(i % 2 == 0 ? "width: 4px; height: 4px; background: #f00" : "width: 6px; height: 6px; background: #00f");
+		row->AddNode(xo::TagDiv)->StyleParse("margin-left: 2px; width: 8px; height: 3px; background: #0f0");
+	}
+
+	ScopedGlobal<bool> fullLayout(xo::Global()->EnableIncrementalLayout, false);
+	xo::Image          img;
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Layout_NumParallelJobs == 6);
+	xo::Image parallel;
+	parallel.Set(xo::TexFormatRGBA8, img.Width, img.Height, img.Data);
+
+	ScopedGlobal<bool> serialLayout(xo::Global()->EnableParallelLayout, false);
+	d->Root.StyleParse("margin: 0");
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Layout_NumParallelJobs == 0);
+
+	TTASSERT(ImagesEqual(parallel, img));
+	TTASSERT(PixelAt(img, 1, 11) == xo::Color::RGBA(0, 0, 255, 255).GetRGBA());
+}
+
+// Elements with the same tag, classes, style and inherited values share a single resolved style.
+// Changing a class must invalidate the cache, and the result must be identical to resolving every element.
+TESTFUNC(Render_StyleCache) {
+	RenderTester  t(64, 64);
+	xo::DocGroup* g = t.Group;
+	xo::Doc*      d = t.Doc;
+
+	d->Root.StyleParse("margin: 0; padding: 0; background: #fff");
+	d->ClassParse("cell", "width: 4px; height: 4px; margin: 1px; background: #f00");
+	for (int i = 0; i < 16; i++)
+		d->Root.AddNode(xo::TagDiv)->AddClass("cell");
+
+	xo::Image img;
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Layout_NumStyleHits >= 15);
+	TTASSERT(PixelAt(img, 2, 2) == xo::Color::RGBA(255, 0, 0, 255).GetRGBA());
+
+	d->ClassParse("cell", "width: 4px; height: 4px; margin: 1px; background: #00f");
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Layout_NumStyleHits >= 15);
+	xo::Image cached;
+	cached.Set(xo::TexFormatRGBA8, img.Width, img.Height, img.Data);
+
+	ScopedGlobal<bool> noStyleCache(xo::Global()->EnableStyleCache, false);
+	d->Root.StyleParse("margin: 0");
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Layout_NumStyleHits == 0);
+
+	TTASSERT(ImagesEqual(cached, img));
+	TTASSERT(PixelAt(img, 8, 2) == xo::Color::RGBA(0, 0, 255, 255).GetRGBA());
+}
+
+// Every frame is recorded by the profiler, and the records can be exported as a Chrome trace
+TESTFUNC(Render_FrameProfiler) {
+	RenderTester  t(64, 64);
+	xo::DocGroup* g = t.Group;
+	xo::Doc*      d = t.Doc;
+
+	d->Root.StyleParse("margin: 0; padding: 0; background: #fff");
+	xo::DomNode* a = d->Root.AddNode(xo::TagDiv);
+	xo::Image    img;
+	for (int i = 0; i < 3; i++) {
+		a->StyleParse(i % 2 == 0 ? "width: 8px; height: 8px; background: #f00" : "width: 8px; height: 8px; background: #00f");
+		TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	}
+
+	xo::cheapvec<xo::FrameRecord> frames;
+	g->Profiler.GetFrames(frames);
+	TTASSERT(frames.size() == 3);
+	for (size_t i = 1; i < frames.size(); i++)
+		TTASSERT(frames[i].Frame == frames[i - 1].Frame + 1);
+	TTASSERT(frames[2].NumLayoutPasses >= 1);
+	TTASSERT(frames[2].PhaseTime[xo::ProfileLayout] <= frames[2].PhaseTime[xo::ProfileFrame]);
+	TTASSERT(frames[2].PhaseTime[xo::ProfileStyleResolve] == 0); // Only the coarse phases, unless EnableFrameProfiler is set
+
+	xo::ProfileSummary layout = g->Profiler.Summarize(xo::ProfileLayout);
+	TTASSERT(layout.Count == 3);
+	TTASSERT(layout.P50 <= layout.P99);
+	TTASSERT(layout.P99 <= layout.Max);
+
+	std::string trace = g->Profiler.ChromeTrace();
+	TTASSERT(trace.find("\"traceEvents\"") != std::string::npos);
+	TTASSERT(trace.find("\"Layout\"") != std::string::npos);
+
+	g->Profiler.Reset();
+	TTASSERT(g->Profiler.Summarize(xo::ProfileLayout).Count == 0);
+}
+
+// Words that have been measured before are copied out of the word cache. The result must be identical
+// to measuring every word.
+TESTFUNC(Render_WordCache) {
+	RenderTester  t(128, 64);
+	xo::DocGroup* g = t.Group;
+	xo::Doc*      d = t.Doc;
+
+	d->Root.StyleParse("margin: 0; padding: 0; background: #fff");
+	xo::DomNode* txt = d->Root.AddNode(xo::TagDiv);
+	txt->StyleParse("width: 120px; font-size: 12px; color: #000");
+	txt->SetText("the cat sat on the mat, and the dog sat on the cat");
+	xo::DomNode* box = d->Root.AddNode(xo::TagDiv);
+	box->StyleParse("width: 4px; height: 4px; background: #f00");
+
+	ScopedGlobal<bool> fullLayout(xo::Global()->EnableIncrementalLayout, false);
+	xo::Image          img;
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	box->StyleParse("background: #00f");
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Layout_NumWordHits >= 13);
+	xo::Image cached;
+	cached.Set(xo::TexFormatRGBA8, img.Width, img.Height, img.Data);
+
+	ScopedGlobal<bool> noWordCache(xo::Global()->EnableWordCache, false);
+	box->StyleParse("background: #00f");
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Layout_NumWordHits == 0);
+
+	int numDark = 0;
+	for (int y = 0; y < 64; y++) {
+		for (int x = 0; x < 128; x++) {
+			TTASSERT(PixelAt(cached, x, y) == PixelAt(img, x, y));
+			numDark += (PixelAt(img, x, y) & 0xff) < 128;
+		}
+	}
+	TTASSERT(numDark > 0);
+}
+
+// CR LF is a single line break, and words with non-ASCII characters are measured like any other word
+TESTFUNC(Render_TextLineBreaks) {
+	RenderTester  t(128, 64);
+	xo::DocGroup* g = t.Group;
+	xo::Doc*      d = t.Doc;
+
+	d->Root.StyleParse("margin: 0; padding: 0; background: #fff");
+	xo::DomNode* txt = d->Root.AddNode(xo::TagDiv);
+	txt->StyleParse("font-size: 12px; color: #000");
+
+	xo::Image img;
+	txt->SetText("caf\xc3\xa9 one\r\ntwo  three");
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	xo::Image crlf;
+	crlf.Set(xo::TexFormatRGBA8, img.Width, img.Height, img.Data);
+
+	txt->SetText("caf\xc3\xa9 one\ntwo  three");
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+
+	int numDark = 0;
+	for (int y = 0; y < 64; y++) {
+		for (int x = 0; x < 128; x++) {
+			TTASSERT(PixelAt(crlf, x, y) == PixelAt(img, x, y));
+			numDark += (PixelAt(img, x, y) & 0xff) < 128;
+		}
+	}
+	TTASSERT(numDark > 0);
+}
+
+// A list with a million rows only creates nodes for the rows on screen, and reuses them when it scrolls
+TESTFUNC(Render_VirtualList) {
+	RenderTester  t(64, 64);
+	xo::DocGroup* g = t.Group;
+	xo::Doc*      d = t.Doc;
+
+	d->Root.StyleParse("margin: 0; padding: 0; background: #fff");
+	auto list       = xo::controls::VirtualList::AppendTo(&d->Root, 40, 10);
+	list->RenderRow = [](xo::DomNode* row, size_t index) {
+		row->StyleParsef("background: %v", index % 2 == 0 ? "#00f" : "#f00");
+	};
+	list->SetNumRows(1000000);
+	d->UI.DispatchDocProcess();
+
+	uint32_t blue  = xo::Color::RGBA(0, 0, 255, 255).GetRGBA();
+	uint32_t red   = xo::Color::RGBA(255, 0, 0, 255).GetRGBA();
+	uint32_t white = xo::Color::RGBA(255, 255, 255, 255).GetRGBA();
+
+	// 4 visible rows, and 4 below them
+	xo::Image img;
+	TTASSERT(list->GetNumVisibleRows() == 4);
+	TTASSERT(list->Root->ChildCount() == 8);
+	TTASSERT(list->NumRowsRendered == 8);
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(PixelAt(img, 2, 5) == blue);
+	TTASSERT(PixelAt(img, 2, 15) == red);
+	TTASSERT(PixelAt(img, 2, 45) == white);
+
+	// Row 0 moves into the overscan, and only row 9 is new
+	list->ScrollBy(1);
+	d->UI.DispatchDocProcess();
+	TTASSERT(list->NumRowsRendered == 9);
+	TTASSERT(list->Root->ChildCount() == 9);
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(PixelAt(img, 2, 5) == red);
+	TTASSERT(PixelAt(img, 2, 45) == white);
+
+	list->ScrollToRow(500000);
+	d->UI.DispatchDocProcess();
+	TTASSERT(list->Root->ChildCount() == 12);
+	TTASSERT(list->GetRowNode(500000) != nullptr);
+	TTASSERT(list->GetRowNode(1) == nullptr);
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(PixelAt(img, 2, 5) == blue);
+
+	list->ScrollToRow(5000000);
+	TTASSERT(list->GetFirstRow() == 1000000 - 4);
+
+	// Rows of 10 and 20 pixels: only rows 0, 1 and 2 fit
+	list->RowHeight = [](size_t index) { return index % 2 == 0 ? 10.0f : 20.0f; };
+	list->InvalidateRowHeights();
+	list->InvalidateRows();
+	list->ScrollToRow(0);
+	d->UI.DispatchDocProcess();
+	TTASSERT(list->GetNumVisibleRows() == 3);
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(PixelAt(img, 2, 25) == red);
+	TTASSERT(PixelAt(img, 2, 35) == blue);
+}
+
+TESTFUNC(Render_Animation) {
+	RenderTester  t(64, 64);
+	xo::DocGroup* g = t.Group;
+	xo::Doc*      d = t.Doc;
+
+	d->Root.StyleParse("margin: 0; padding: 0; background: #fff");
+	auto a = d->Root.ParseAppendNode("<div style='position: absolute; left: 0; top: 0; width: 10px; height: 10px; background: #f00'/>");
+	auto b = d->Root.ParseAppendNode("<div style='position: absolute; left: 20px; top: 0; width: 10px; height: 10px; background: #0f0'/>");
+	auto c = d->Root.ParseAppendNode("<div style='position: absolute; left: 0; top: 20px; width: 10px; height: 10px; background: #00f'/>");
+
+	uint32_t white = xo::Color::RGBA(255, 255, 255, 255).GetRGBA();
+	uint32_t green = xo::Color::RGBA(0, 255, 0, 255).GetRGBA();
+	uint32_t blue  = xo::Color::RGBA(0, 0, 255, 255).GetRGBA();
+
+	// A finished animation holds its final value
+	double        now = xo::TimeAccurateSeconds();
+	xo::Animation fade;
+	fade.Node      = a->GetInternalID();
+	fade.Property  = xo::AnimBackground;
+	fade.Duration  = 1;
+	fade.Start     = now - 10;
+	fade.FromColor = xo::Color::RGBA(255, 0, 0, 255);
+	fade.ToColor   = xo::Color::RGBA(0, 0, 255, 255);
+	d->Animate(fade);
+
+	// This one is half way through, and lasts long enough to still be running at the second frame
+	xo::Animation slide;
+	slide.Node      = b->GetInternalID();
+	slide.Property  = xo::AnimTranslateX;
+	slide.Duration  = 1000;
+	slide.Start     = now - 500;
+	slide.FromValue = 0;
+	slide.ToValue   = 20;
+	d->Animate(slide);
+
+	xo::Image img;
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(PixelAt(img, 5, 5) == blue);
+	TTASSERT(PixelAt(img, 22, 5) == white);
+	TTASSERT(PixelAt(img, 35, 5) == green);
+	TTASSERT(g->RenderStats.Anim_NumApplied == 2);
+	TTASSERT(g->IsAnimating());
+
+	// Nothing but the animations has changed, so layout is skipped
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Layout_Skipped == 1);
+	TTASSERT(PixelAt(img, 5, 5) == blue);
+	TTASSERT(PixelAt(img, 35, 5) == green);
+
+	// Size animations need layout, but they don't touch the canonical document
+	c->AnimateValue(xo::AnimWidth, 10, 30, 0);
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Layout_Skipped == 0);
+	TTASSERT(PixelAt(img, 25, 25) == blue);
+	TTASSERT(c->GetStyle().Get(xo::CatWidth)->GetSize().Val == 10);
+
+	// Stopping an animation restores the original value
+	b->StopAnimation(xo::AnimTranslateX);
+	c->StopAnimation(xo::AnimWidth);
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(PixelAt(img, 22, 5) == green);
+	TTASSERT(PixelAt(img, 25, 25) == white);
+	TTASSERT(!g->IsAnimating());
+	TTASSERT(g->NextAnimationChange() == 0);
+
+	// A stepped animation, such as a blinking caret, needs no frames in between its steps. It only asks to be woken up for the next one.
+	xo::Animation blink;
+	blink.Node      = b->GetInternalID();
+	blink.Property  = xo::AnimBackground;
+	blink.Easing    = xo::EaseStep;
+	blink.Flags     = xo::AnimRepeat;
+	blink.Duration  = 100;
+	blink.Start     = xo::TimeAccurateSeconds();
+	blink.FromColor = xo::Color::RGBA(0, 0, 255, 255);
+	blink.ToColor   = xo::Color::RGBA(255, 255, 255, 255);
+	d->Animate(blink);
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(PixelAt(img, 25, 5) == blue);
+	TTASSERT(!g->IsAnimating());
+	TTASSERT(g->NextAnimationChange() == blink.Start + 50);
+	TTASSERT(blink.NextChange(blink.Start + 60) == blink.Start + 100);
+	blink.Flags = 0;
+	TTASSERT(blink.NextChange(blink.Start + 60) == DBL_MAX);
+	blink.Easing = xo::EaseLinear;
+	TTASSERT(blink.NextChange(blink.Start + 60) == blink.Start + 60);
+	b->StopAnimation(xo::AnimBackground);
+
+	a->Delete();
+	TTASSERT(d->GetAnimations().size() == 0);
+}
+
+// Boxes that are unchanged since the previous frame are copied out of the vertex cache, and the
+// result must be identical to generating all of them again.
+TESTFUNC(Render_VertexCache) {
+	RenderTester  t(64, 64);
+	xo::DocGroup* g = t.Group;
+	xo::Doc*      d = t.Doc;
+
+	d->Root.StyleParse("margin: 0; padding: 0; background: #fff");
+	xo::DomNode* boxes[3];
+	for (int i = 0; i < 3; i++) {
+		boxes[i] = d->Root.AddNode(xo::TagDiv);
+		boxes[i]->StyleParsef("position: absolute; left: %vpx; top: 4px; width: 12px; height: 30px; border: 2px #000; border-radius: 5px; background: #f00", 4 + i * 20);
+	}
+
+	// Damage tracking would skip the unchanged boxes altogether
+	ScopedGlobal<bool> fullRepaint(xo::Global()->EnablePartialRepaint, false);
+
+	xo::Image img;
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	uint32_t all = g->RenderStats.Render_NumNodesCached;
+	TTASSERT(all >= 3);
+
+	boxes[1]->StyleParse("background: #00f");
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Render_NumNodesCached == all - 1);
+	xo::Image cached;
+	cached.Set(xo::TexFormatRGBA8, img.Width, img.Height, img.Data);
+
+	{
+		ScopedGlobal<bool> noVertexCache(xo::Global()->EnableVertexCache, false);
+		TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+		TTASSERT(g->RenderStats.Render_NumNodesCached == 0);
+	}
+
+	TTASSERT(ImagesEqual(cached, img));
+	TTASSERT(PixelAt(img, 30, 20) == xo::Color::RGBA(0, 0, 255, 255).GetRGBA());
+	TTASSERT(PixelAt(img, 50, 20) == xo::Color::RGBA(255, 0, 0, 255).GetRGBA());
+
+	// The entries of deleted boxes are discarded, even though their IDs are below the end of the ID table
+	xo::VertexCache& cache = g->RenderDoc->VertexCache;
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	size_t live = cache.NumLiveVertices();
+	TTASSERT(boxes[0]->GetInternalID() < boxes[2]->GetInternalID());
+	boxes[0]->Delete();
+	boxes[1]->Delete();
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(cache.NumLiveVertices() < live);
+	TTASSERT(cache.NumLiveVertices() > 0);
+}
+
+TESTFUNC(Render_ImageStreaming) {
+	RenderTester  t(64, 64);
+	xo::DocGroup* g = t.Group;
+	xo::Doc*      d = t.Doc;
+
+	d->Root.StyleParse("margin: 0; padding: 0; background: #fff");
+	xo::DomCanvas* canvas = d->Root.AddCanvas();
+	canvas->SetSize(32, 32);
+	xo::Canvas2D* c2d = canvas->GetCanvas2D();
+	c2d->Fill(xo::Color::RGBA(0, 0, 255, 255));
+	canvas->ReleaseCanvas(c2d);
+
+	// Only 8 of the 32 rows fit into a frame
+	ScopedGlobal<size_t> budget(xo::Global()->ImageUploadBudget, 8 * 32 * 4);
+	ScopedGlobal<bool>   fullRepaint(xo::Global()->EnablePartialRepaint, false);
+
+	g->Render();
+	TTASSERT(g->RenderStats.Render_ImageBytes == 8 * 32 * 4);
+	TTASSERT(g->IsStreamingImages());
+
+	// RenderToImage waits for the rest of the rows to arrive
+	xo::Image img;
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(!g->IsStreamingImages());
+	TTASSERT(PixelAt(img, 2, 2) == xo::Color::RGBA(0, 0, 255, 255).GetRGBA());
+	TTASSERT(PixelAt(img, 29, 29) == xo::Color::RGBA(0, 0, 255, 255).GetRGBA());
+	TTASSERT(PixelAt(img, 40, 40) == xo::Color::RGBA(255, 255, 255, 255).GetRGBA());
+}
+
+// Quads of consecutive nodes share a draw call, until the texture changes, or the batch is full.
+// When the batch fills up on an image, the image's quads must not be drawn with the glyph atlas that is bound after it.
+TESTFUNC(Render_BatchQuads) {
+	RenderTester  t(1024, 64);
+	xo::DocGroup* g = t.Group;
+	xo::Doc*      d = t.Doc;
+
+	// A plain box is 16 vertices, so the root and these boxes fill a batch exactly, once they have a background
+	d->Root.StyleParse("margin: 0; padding: 0; background: #fff");
+	const int                 numBoxes = xo::RenderBase::MaxDrawVertices / 16 - 1;
+	std::vector<xo::DomNode*> boxes;
+	for (int i = 0; i < numBoxes; i++) {
+		boxes.push_back(d->Root.AddNode(xo::TagDiv));
+		boxes.back()->StyleParsef("position: absolute; left: %vpx; top: %vpx; width: 1px; height: 1px", i % 1024, 48 + (i / 1024) * 2);
+	}
+	xo::DomCanvas* canvas = d->Root.AddCanvas();
+	canvas->StyleParse("position: absolute; left: 0; top: 0");
+	canvas->SetSize(16, 16);
+	xo::Canvas2D* c2d = canvas->GetCanvas2D();
+	c2d->Fill(xo::Color::RGBA(0, 0, 255, 255));
+	canvas->ReleaseCanvas(c2d);
+	xo::DomNode* txt = d->Root.AddNode(xo::TagDiv);
+	txt->StyleParse("position: absolute; left: 20px; top: 0; font-size: 12px; color: #000");
+	txt->SetText("the cat sat on the mat");
+
+	// The root and the image share a draw call, and the text needs another, because it binds the glyph atlas
+	ScopedGlobal<bool> fullRepaint(xo::Global()->EnablePartialRepaint, false);
+	xo::Image          img;
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Render_NumDrawCalls == 2);
+	xo::Image reference;
+	reference.Set(xo::TexFormatRGBA8, img.Width, img.Height, img.Data);
+
+	// Now the image overflows the batch
+	for (auto box : boxes)
+		box->StyleParse("background: #f00");
+	TTASSERT(g->RenderToImage(img) == xo::RenderResultDone);
+	TTASSERT(g->RenderStats.Render_NumDrawCalls == 3);
+
+	int numDark = 0;
+	for (int y = 0; y < 40; y++) {
+		for (int x = 0; x < 1024; x++) {
+			TTASSERT(PixelAt(reference, x, y) == PixelAt(img, x, y));
+			numDark += (PixelAt(img, x, y) & 0xff) < 128;
+		}
+	}
+	TTASSERT(numDark > 0);
+	TTASSERT(PixelAt(img, 8, 8) == xo::Color::RGBA(0, 0, 255, 255).GetRGBA());
+	TTASSERT(PixelAt(img, 1023, 48) == xo::Color::RGBA(255, 0, 0, 255).GetRGBA());
+}
@@ -63,7 +63,7 @@ TESTFUNC(StyleVars) {
 			TTASSERT(thing1);
 
 			// Verify sanity of 'thing' class - this is before variable bake
-			const auto& attribs = thing1->Default.Attribs;
+			const auto& attribs = thing1->Default().Attribs;
 			TTASSERT(attribs.size() == 5);
 			TTASSERT(attribs[0].Category == xo::CatGenBorder && attribs[0].Flags == xo::StyleAttrib::FlagVerbatim);
 			TTASSERT(attribs[1].Category == xo::CatPadding_Left && attribs[1].GetSize().Val == 2);
@@ -0,0 +1,75 @@
+#include "pch.h"
+
+static void CheckParallelFor(xo::TaskScheduler& s, size_t n, size_t grain) {
+	std::vector<std::atomic<int>> hits(n);
+	for (auto& h : hits)
+		h = 0;
+	std::atomic<bool> tooLarge(false);
+	s.ParallelFor(0, n, grain, [&](size_t first, size_t last) {
+		if (last - first > grain)
+			tooLarge = true;
+		for (size_t i = first; i < last; i++)
+			hits[i]++;
+	});
+	for (size_t i = 0; i < n; i++)
+		TTASSERT(hits[i] == 1);
+	TTASSERT(!tooLarge);
+}
+
+TESTFUNC(TaskScheduler_ParallelFor) {
+	// Without workers, the calling thread does everything
+	xo::TaskScheduler none;
+	none.Start(0);
+	CheckParallelFor(none, 1000, 64);
+	none.Stop();
+
+	xo::TaskScheduler s;
+	s.Start(4);
+	TTASSERT(s.NumThreads() == 4);
+	CheckParallelFor(s, 0, 8);
+	CheckParallelFor(s, 1, 8);
+	CheckParallelFor(s, 1000, 1);
+	CheckParallelFor(s, 100000, 37);
+	s.Stop();
+	TTASSERT(s.NumThreads() == 0);
+
+	// A stopped scheduler can be started again
+	s.Start(2);
+	CheckParallelFor(s, 5000, 100);
+	s.Stop();
+}
+
+TESTFUNC(TaskScheduler_Groups) {
+	xo::TaskScheduler s;
+	s.Start(3);
+
+	// Tasks that wait on groups of their own must not deadlock, even when there are more of them than workers
+	std::atomic<int> leaves(0);
+	{
+		xo::TaskGroup outer(s);
+		for (int i = 0; i < 16; i++) {
+			outer.Run([&s, &leaves] {
+				xo::TaskGroup inner(s);
+				for (int j = 0; j < 16; j++)
+					inner.Run([&leaves] { leaves++; });
+				inner.Wait();
+			});
+		}
+		outer.Wait();
+		TTASSERT(leaves == 16 * 16);
+	}
+
+	// ParallelFor from inside a task
+	std::atomic<size_t> sum(0);
+	xo::TaskGroup       g(s);
+	for (int i = 0; i < 4; i++) {
+		g.Run([&s, &sum] {
+			s.ParallelFor(0, 1000, 10, [&sum](size_t first, size_t last) {
+				for (size_t k = first; k < last; k++)
+					sum += k;
+			});
+		});
+	}
+	g.Wait();
+	TTASSERT(sum == 4 * (999 * 1000 / 2));
+}
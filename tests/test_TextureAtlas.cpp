@@ -0,0 +1,81 @@
+#include "pch.h"
+#include "../xo/Render/TextureAtlas.h"
+
+struct AtlasRect {
+	uint16_t X, Y, W, H;
+};
+
+// Returns false if any two rectangles, including their padding, overlap
+static bool NoOverlap(const std::vector<AtlasRect>& rects, int size, int padding) {
+	std::vector<uint8_t> used(size * size, 0);
+	for (const auto& r : rects) {
+		for (int y = r.Y; y < r.Y + r.H + padding; y++) {
+			for (int x = r.X; x < r.X + r.W + padding; x++) {
+				if (x >= size || y >= size || used[y * size + x])
+					return false;
+				used[y * size + x] = 1;
+			}
+		}
+	}
+	return true;
+}
+
+TESTFUNC(TextureAtlas) {
+	const int        size    = 128;
+	const int        padding = 1;
+	xo::TextureAtlas atlas;
+	atlas.Initialize(size, size, xo::TexFormatGrey8, padding);
+	atlas.Zero();
+
+	// Fill the atlas with glyph-like rectangles of varying heights
+	std::vector<AtlasRect> rects;
+	for (int i = 0; true; i++) {
+		AtlasRect r;
+		r.W = 5 + i % 4;
+		r.H = 9 + i % 3;
+		if (!atlas.Alloc(r.W, r.H, r.X, r.Y))
+			break;
+		rects.push_back(r);
+	}
+	TTASSERT(atlas.NumRects() == rects.size());
+	TTASSERT(atlas.Occupancy() > 0.6f);
+	TTASSERT(NoOverlap(rects, size, padding));
+
+	// A freed rectangle is reused by the next rectangle of the same size
+	AtlasRect mid = rects[rects.size() / 2];
+	atlas.FreeRect(mid.X, mid.Y, mid.W, mid.H);
+	AtlasRect again = mid;
+	TTASSERT(atlas.Alloc(again.W, again.H, again.X, again.Y));
+	TTASSERT(again.X == mid.X && again.Y == mid.Y);
+
+	// Once everything is freed, the whole atlas is available again
+	for (const auto& r : rects)
+		atlas.FreeRect(r.X, r.Y, r.W, r.H);
+	TTASSERT(atlas.NumRects() == 0);
+	TTASSERT(atlas.Occupancy() == 0);
+	uint16_t x, y;
+	TTASSERT(atlas.Alloc(size - padding * 2, size - padding * 2, x, y));
+	TTASSERT(x == padding && y == padding);
+
+	atlas.Free();
+}
+
+// With deferred invalidation, changes only reach InvalidRect once they are published
+TESTFUNC(TextureAtlas_DeferInvalidation) {
+	xo::TextureAtlas atlas;
+	atlas.Initialize(64, 64, xo::TexFormatGrey8, 1);
+	atlas.Zero();
+	atlas.ClearInvalidRect();
+	atlas.DeferInvalidation = true;
+
+	uint16_t x, y;
+	TTASSERT(atlas.Alloc(8, 8, x, y));
+	TTASSERT(!atlas.InvalidRect.IsAreaPositive());
+	TTASSERT(atlas.PendingInvalidRect.IsAreaPositive());
+
+	atlas.PublishInvalidRect();
+	TTASSERT(atlas.InvalidRect == xo::Box(x, y, x + 8, y + 8));
+	TTASSERT(!atlas.PendingInvalidRect.IsAreaPositive());
+
+	atlas.Free();
+}
@@ -1,4 +1,5 @@
 #include "pch.h"
+#include "../xo/Parse/DocParser.h"
 
 TESTFUNC(VDomDiff) {
 	auto test = [](const char* a, const char* b, std::vector<int> expectOps = {}) {
@@ -43,3 +44,146 @@ void VDomDiffFuzz() {
 	b = all.substr(split + 1);
 	VDomDiffFuzz(a.c_str(), b.c_str());
 }
+
+static std::string DescribeDom(const xo::DomEl* el) {
+	if (el->GetTag() == xo::TagText)
+		return tsf::fmt("'%v'", el->GetText());
+	const xo::DomNode* node = el->ToNode();
+	std::string        s    = xo::TagNames[node->GetTag()];
+	for (auto c : node->GetClasses())
+		s += tsf::fmt(" .%v", c.ID);
+	for (auto a : node->GetStyle().Attribs)
+		s += tsf::fmt(" %v:%v", (int) a.Category, a.ValU32);
+	s += "(";
+	for (auto c : node->GetChildren())
+		s += DescribeDom(c) + " ";
+	return s + ")";
+}
+
+// Patch must turn the DOM built from 'a' into the DOM built from 'b', and leave unchanged elements alone
+TESTFUNC(VDomPatch) {
+	RenderTester t(16, 16);
+	xo::Doc*     d = t.Doc;
+
+	typedef xo::vdom::PatchOp Op;
+	xo::DomNode*              dst = nullptr;
+
+	auto test = [&](const char* a, const char* b, std::vector<Op> expectOps, bool checkOps = true) {
+		xo::Pool        pool;
+		xo::DocParser   parser;
+		xo::vdom::Node* va = pool.AllocT<xo::vdom::Node>(true);
+		xo::vdom::Node* vb = pool.AllocT<xo::vdom::Node>(true);
+		TTASSERT(parser.Parse(a, va, &pool) == "");
+		TTASSERT(parser.Parse(b, vb, &pool) == "");
+
+		d->Root.Clear();
+		dst         = d->Root.AddNode(xo::TagDiv);
+		auto expect = d->Root.AddNode(xo::TagDiv);
+		TTASSERT(dst->Parse(a) == "");
+		TTASSERT(expect->Parse(b) == "");
+
+		std::vector<Op> ops;
+		TTASSERT(xo::vdom::Patch(va, vb, dst, [&](Op op, const xo::vdom::Node* na, const xo::vdom::Node* nb) { ops.push_back(op); }) == "");
+		TTASSERT(DescribeDom(dst) == DescribeDom(expect));
+		if (checkOps)
+			TTASSERT(ops == expectOps);
+	};
+
+	const char* abcde = "<div key='a'>a</div><div key='b'>b</div><div key='c'>c</div><div key='d'>d</div><div key='e'>e</div>";
+
+	test(abcde, "<div key='a'>a</div><div key='c'>c</div><div key='d'>d</div><div key='b'>b</div><div key='e'>e</div>", {Op::Move});
+	test(abcde, "<div key='z'>z</div><div key='a'>a</div><div key='b'>b</div><div key='c'>c</div><div key='d'>d</div><div key='e'>e</div>", {Op::Insert});
+	test(abcde, "<div key='a'>a</div><div key='b'>b</div><div key='d'>d</div><div key='e'>e</div>", {Op::Delete});
+	test(abcde, "<div key='e'>e</div><div key='d'>d</div><div key='c'>c</div><div key='b'>b</div><div key='a'>a</div>", {Op::Move, Op::Move, Op::Move, Op::Move});
+	test(abcde, "<div key='a'>a</div><div key='x'>x</div><div key='c'>C</div><div key='d'>d</div><div key='e'>e</div>", {Op::UpdateText, Op::Delete, Op::Insert});
+	test("<div>hello</div>", "<div>world</div>", {Op::UpdateText});
+	test("<div style='width: 5px'>x</div>", "<div style='width: 6px' class='foo'>x</div>", {Op::UpdateAttribs});
+	test("<div>x</div>", "<lab>x</lab>", {Op::Delete, Op::Insert});
+	test("<div><lab>1</lab><lab>2</lab></div>", "<div><lab>1</lab><lab>2</lab><lab>3</lab></div>", {Op::Insert});
+
+	// Only the first occurrence of a duplicated key is matched
+	test("<div key='x'>x</div><div key='a'>1</div><div key='a'>2</div>", "<div key='a'>1</div><div key='x'>x</div>", {Op::Delete, Op::Move});
+
+	// A long list, reversed, with some elements deleted, and others inserted
+	std::string longA, longB;
+	for (int i = 0; i < 3000; i++)
+		longA += tsf::fmt("<div key='%v'>%v</div>", i, i);
+	for (int i = 3000; i-- != 0;) {
+		if (i % 7 != 0)
+			longB += tsf::fmt("<div key='%v'>%v</div>", i, i);
+		if (i % 10 == 0)
+			longB += tsf::fmt("<div key='new%v'>new</div>", i);
+	}
+	test(longA.c_str(), longB.c_str(), {}, false);
+
+	// Moved and untouched elements are the same objects as before, and only the parent has a new version
+	test(abcde, abcde, {});
+	const xo::DomEl* els[5];
+	uint32_t         versions[5];
+	for (size_t i = 0; i < 5; i++) {
+		els[i]      = dst->ChildByIndex(i);
+		versions[i] = els[i]->GetVersion();
+	}
+	xo::Pool        pool;
+	xo::DocParser   parser;
+	xo::vdom::Node* va = pool.AllocT<xo::vdom::Node>(true);
+	xo::vdom::Node* vb = pool.AllocT<xo::vdom::Node>(true);
+	parser.Parse(abcde, va, &pool);
+	parser.Parse("<div key='b'>b</div><div key='a'>a</div><div key='c'>c</div><div key='d'>d</div><div key='e'>e</div>", vb, &pool);
+	TTASSERT(xo::vdom::Patch(va, vb, dst) == "");
+	TTASSERT(dst->ChildByIndex(0) == els[1]);
+	TTASSERT(dst->ChildByIndex(1) == els[0]);
+	for (size_t i = 0; i < 5; i++)
+		TTASSERT(els[i]->GetVersion() == versions[i]);
+}
+
+class DiffableList : public xo::rx::Control {
+public:
+	std::vector<std::string> Items;
+	int                      NumRenders = 0;
+
+	DiffableList(xo::DomNode* root) : Control(root) {}
+
+	bool RenderDiffable() override { return true; }
+
+	xo::String RenderVDom(xo::vdom::Node* root, xo::Pool* pool) override {
+		NumRenders++;
+		std::string markup;
+		for (size_t i = 0; i < Items.size(); i++)
+			markup += tsf::fmt("<div key='%v'>%v</div>", Items[i], Items[i]);
+		return xo::DocParser().Parse(markup.c_str(), root, pool);
+	}
+};
+
+// A diffable control only modifies the elements that changed
+TESTFUNC(VDomControl) {
+	RenderTester t(16, 16);
+	xo::Doc*     d = t.Doc;
+
+	auto list   = new DiffableList(d->Root.AddNode(xo::TagDiv));
+	list->Items = {"a", "b", "c", "d"};
+	d->UI.DispatchDocProcess();
+	TTASSERT(list->NumRenders == 1);
+	TTASSERT(list->Root->ChildCount() == 4);
+	TTASSERT(strcmp(list->Root->ChildByIndex(3)->ToNode()->GetText(), "d") == 0);
+
+	const xo::DomEl* b        = list->Root->ChildByIndex(1);
+	const xo::DomEl* c        = list->Root->ChildByIndex(2);
+	uint32_t         bVersion = b->GetVersion();
+	uint32_t         cVersion = c->GetVersion();
+
+	list->Items = {"a", "c", "b", "e"};
+	list->SetDirty();
+	d->UI.DispatchDocProcess();
+	TTASSERT(list->NumRenders == 2);
+	TTASSERT(list->Root->ChildCount() == 4);
+	TTASSERT(list->Root->ChildByIndex(1) == c);
+	TTASSERT(list->Root->ChildByIndex(2) == b);
+	TTASSERT(b->GetVersion() == bVersion);
+	TTASSERT(c->GetVersion() == cVersion);
+	TTASSERT(strcmp(list->Root->ChildByIndex(3)->ToNode()->GetText(), "e") == 0);
+
+	// Nothing changes when nothing is dirty
+	d->UI.DispatchDocProcess();
+	TTASSERT(list->NumRenders == 2);
+}
@@ -11,8 +11,11 @@
 #pragma warning(pop)
 #endif
 
+// We render with the software renderer, so that truth images are the same on every machine,
+// and so that these tests can run on machines without a GPU.
 xoImageTester::xoImageTester() {
-	Wnd = xo::SysWnd::New();
+	Wnd = xo::SysWndHeadless::NewWithDoc(256, 256);
+	XO_ASSERT(Wnd != nullptr);
 	xo::AddOrRemoveDocsFromGlobalList();
 	SetSize(256, 256);
 	Wnd->Show();
@@ -65,9 +68,9 @@ void xoImageTester::DoTruthImage(const char* filename, std::function<void(xo::Do
 	t.TruthImage(filename, setup);
 }
 
-xo::String xoImageTester::PathRelativeToTestData(const char* path, const char* extension) {
+xo::String xoImageTester::PathRelativeToRepo(const char* path) {
 	// binPath: C:\dev\individual\xo\t2-output\win64-msvc2013-debug-default\Test.exe
-	// result:  C:\dev\individual\xo\testdata\<path>
+	// result:  C:\dev\individual\xo\<path>
 	std::string binPath  = TTGetProcessPath();
 	xo::String  fullPath = binPath.c_str();
 	auto        parts    = fullPath.Split(XO_DIR_SEP_STR);
@@ -75,7 +78,14 @@ xo::String xoImageTester::PathRelativeToTestData(const char* path, const char* e
 	parts.pop();
 	parts.pop();
 	fullPath = xo::String::Join(parts, XO_DIR_SEP_STR);
-	fullPath += xo::String(XO_DIR_SEP_STR) + "testdata";
+	fullPath += XO_DIR_SEP_STR;
+	fullPath += path;
+	return fullPath;
+}
+
+xo::String xoImageTester::PathRelativeToTestData(const char* path, const char* extension) {
+	// result:  C:\dev\individual\xo\testdata\<path>
+	xo::String fullPath = PathRelativeToRepo("testdata");
 	if (path[0] != 0 || (extension && extension[0] != 0)) {
 		fullPath += XO_DIR_SEP_STR;
 		fullPath += path;
@@ -85,6 +95,14 @@ xo::String xoImageTester::PathRelativeToTestData(const char* path, const char* e
 	return fullPath;
 }
 
+// Truth images of individual tests, such as Layout_BodyMargin, were rendered by RenderSoft, and live in tests/truth.
+// DoDirectory passes rooted paths of the .xoml files in testdata, and their truth images stay next to them.
+xo::String xoImageTester::PathRelativeToTruth(const char* path) {
+	if (path[0] == '/' || path[0] == '\\' || path[1] == ':')
+		return path;
+	return PathRelativeToRepo("tests" XO_DIR_SEP_STR "truth") + XO_DIR_SEP_STR + path;
+}
+
 void xoImageTester::SetSize(uint32_t width, uint32_t height) {
 	if (width == ImageWidth && height == ImageHeight)
 		return;
@@ -157,10 +175,7 @@ void xoImageTester::CreateOrVerifyTruthImage(bool create, const char* filename,
 	Wnd->DocGroup->Doc->Reset();
 	setup(Wnd->DocGroup->Doc->Root);
 
-	// if filename is not rooted, then assume it's relative to 'testdata'
-	xo::String fixedRoot = filename;
-	if (filename[0] != '/' && filename[0] != '\\' && filename[1] != ':')
-		fixedRoot = PathRelativeToTestData(filename);
+	xo::String fixedRoot = PathRelativeToTruth(filename);
 
 	xo::String truthFile = fixedRoot;
 	xo::String newSample = fixedRoot + "-observed-result";
@@ -9,7 +9,9 @@ public:
 
 	static void		DoDirectory(const char* dir);
 	static void		DoTruthImage(const char* filename, std::function<void(xo::DomNode& root)> setup);
+	static xo::String	PathRelativeToRepo(const char* path);
 	static xo::String	PathRelativeToTestData(const char* path, const char* extension = nullptr);
+	static xo::String	PathRelativeToTruth(const char* path);	// A relative 'path' is inside tests/truth. A rooted 'path' is used as-is.
 
 	void		SetSize(uint32_t width, uint32_t height);
 
@@ -308,6 +308,10 @@ local Test = Program {
 	Depends = {
 		xo,
 		crt,
+		freetype, -- test_FontStore.cpp compares our kerning against Freetype's
+	},
+	Includes = {
+		"dependencies/freetype/include",
 	},
 	Libs = { 
 		{ "m", "stdc++", "pthread"; Config = "linux-*" },
@@ -322,8 +326,24 @@ local Test = Program {
 	}
 }
 
+-- Headless benchmark of parse, clone, style, layout and render, on synthetic documents. See bench/Benchmark.cpp.
+local Benchmark = Program {
+	Name = "Benchmark",
+	Depends = {
+		xo,
+		crt,
+	},
+	Libs = { 
+		{ "m", "stdc++", "pthread"; Config = "linux-*" },
+	},
+	Sources = {
+		makeGlob("bench", {}),
+	}
+}
+
 Default(xo)
 Default(Test)
+Default(Benchmark)
 Default(ExampleBench)
 Default(ExampleCanvas)
 Default(ExampleEvents)
@@ -0,0 +1,62 @@
+#include "pch.h"
+#include "Animation.h"
+
+namespace xo {
+
+static uint8_t LerpChannel(uint8_t a, uint8_t b, float p) {
+	return (uint8_t) Clamp((int) floor((float) a + ((float) b - (float) a) * p + 0.5f), 0, 255);
+}
+
+bool Animation::IsFinished(double now) const {
+	return !(Flags & AnimRepeat) && now >= Start + Duration;
+}
+
+double Animation::NextChange(double now) const {
+	if (IsFinished(now) || Duration <= 0)
+		return DBL_MAX;
+	if (Easing != EaseStep)
+		return now;
+
+	// A step animation changes at every half period. With AnimAlternate, some of these are not real
+	// changes, but waking up for nothing is cheap.
+	double half = Duration / 2.0;
+	double next = Start + (floor(Max(now - Start, 0.0) / half) + 1) * half;
+	if (!(Flags & AnimRepeat) && next > Start + half)
+		return DBL_MAX;
+	return next;
+}
+
+float Animation::Progress(double now) const {
+	double t = Duration > 0 ? (now - Start) / Duration : 1.0;
+	t        = Max(t, 0.0);
+	if (Flags & AnimRepeat) {
+		double cycle = floor(t);
+		t -= cycle;
+		if ((Flags & AnimAlternate) && ((int64_t) cycle & 1))
+			t = 1.0 - t;
+	} else {
+		t = Min(t, 1.0);
+	}
+
+	float p = (float) t;
+	switch (Easing) {
+	case EaseLinear: return p;
+	case EaseIn: return p * p;
+	case EaseOut: return p * (2 - p);
+	case EaseInOut: return p < 0.5f ? 2 * p * p : -1 + (4 - 2 * p) * p;
+	case EaseStep: return p < 0.5f ? 0.0f : 1.0f;
+	}
+	return p;
+}
+
+float Animation::ValueAt(double now) const {
+	float p = Progress(now);
+	return FromValue + (ToValue - FromValue) * p;
+}
+
+Color Animation::ColorAt(double now) const {
+	// Interpolate in sRGB, which is how the colors were specified
+	float p = Progress(now);
+	return Color::RGBA(LerpChannel(FromColor.r, ToColor.r, p), LerpChannel(FromColor.g, ToColor.g, p), LerpChannel(FromColor.b, ToColor.b, p), LerpChannel(FromColor.a, ToColor.a, p));
+}
+} // namespace xo
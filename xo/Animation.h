@@ -0,0 +1,62 @@
+#pragma once
+#include "Defs.h"
+
+namespace xo {
+
+// Properties that can be animated by the render thread
+enum AnimProperties : uint8_t {
+	AnimBackground,  // Background color
+	AnimBorderColor, // Color of all four borders
+	AnimOpacity,     // Multiplies the alpha of the element and all of its descendants. 0 .. 1
+	AnimTranslateX,  // Moves the element and its descendants, without affecting layout. Pixels.
+	AnimTranslateY,  // Same as AnimTranslateX
+	AnimWidth,       // Content width in pixels. This affects layout.
+	AnimHeight,      // Content height in pixels. This affects layout.
+};
+
+enum AnimEasings : uint8_t {
+	EaseLinear,
+	EaseIn,    // Quadratic, slow at the start
+	EaseOut,   // Quadratic, slow at the end
+	EaseInOut, // Quadratic, slow at both ends
+	EaseStep,  // 'From' for the first half, and 'To' for the second half. Use this to blink.
+};
+
+enum AnimFlags : uint8_t {
+	AnimRepeat    = 1, // Start again at the end, forever
+	AnimAlternate = 2, // When repeating, run backwards on every second iteration
+};
+
+/* Animation of one property of one DOM node, which is evaluated by the render thread.
+
+Animations are owned by Doc, and they are copied into the renderer's clone of the document along
+with everything else. From then on, the render thread evaluates them on every frame, without any
+help from the UI thread. The elements being animated are never modified, so a running animation
+does not cause the document to be cloned again.
+
+An animation that does not repeat holds its final value until it is stopped. Once all animations
+have reached the end, the renderer stops producing frames. An EaseStep animation only changes
+twice per period, so instead of producing frames in between, the renderer asks to be woken up
+when it next changes.
+*/
+struct XO_API Animation {
+	InternalID     Node      = InternalIDNull;
+	AnimProperties Property  = AnimBackground;
+	AnimEasings    Easing    = EaseLinear;
+	uint8_t        Flags     = 0; // AnimFlags
+	float          Duration  = 0; // Seconds
+	double         Start     = 0; // Value of TimeAccurateSeconds() when the animation started
+	Color          FromColor = Color::Transparent();
+	Color          ToColor   = Color::Transparent();
+	float          FromValue = 0;
+	float          ToValue   = 0;
+
+	bool  IsColor() const { return Property == AnimBackground || Property == AnimBorderColor; }
+	bool  AffectsLayout() const { return Property == AnimWidth || Property == AnimHeight; }
+	bool   IsFinished(double now) const; // Repeating animations never finish
+	double NextChange(double now) const; // Time at which the value next changes. This is 'now' if the value changes continuously, and DBL_MAX if it never changes again.
+	float  Progress(double now) const;   // Eased position between From (0) and To (1)
+	float  ValueAt(double now) const;
+	Color  ColorAt(double now) const;
+};
+} // namespace xo
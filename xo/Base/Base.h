@@ -51,7 +51,9 @@
 #include <functional>
 #include <vector>
 #include <mutex>
+#include <condition_variable>
 #include <thread>
+#include <deque>
 
 #ifdef _WIN32
 typedef SSIZE_T ssize_t;
@@ -139,6 +141,7 @@ typedef Mat4T<float> Mat4f;
 #include "../Base/CPU.h"
 #include "../Base/Error.h"
 #include "../Base/Queue.h"
+#include "../Base/TaskScheduler.h"
 #include "../Base/xoString.h"
 #include "../Base/OS_Error.h"
 #include "../Base/OS_Time.h"
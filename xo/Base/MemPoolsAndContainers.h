@@ -310,6 +310,7 @@ public:
 	~FixedSizeHeap();
 
 	void  Initialize(uint32_t maxAllocations, uint32_t allocationSize);
+	bool  IsInitialized() const { return Heap != nullptr; }
 	void* Alloc(size_t bytes);
 	void* Realloc(void* buf, size_t bytes);
 	void  Free(void* buf);
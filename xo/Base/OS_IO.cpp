@@ -4,6 +4,8 @@
 #ifndef _WIN32
 #include <dirent.h>
 #include <sys/stat.h> // Added for Android
+#include <sys/mman.h>
+#include <fcntl.h>
 #endif
 
 #ifndef _WIN32
@@ -138,6 +140,79 @@ XO_API bool FindFiles(const char* _dir, std::function<bool(const FilesystemItem&
 #endif
 }
 
+XO_API bool RenameFileReplace(const char* src, const char* dst) {
+#ifdef _WIN32
+	return !!MoveFileExA(src, dst, MOVEFILE_REPLACE_EXISTING);
+#else
+	return rename(src, dst) == 0;
+#endif
+}
+
+MappedFile::MappedFile() {
+}
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+bool MappedFile::Open(const char* path) {
+	Close();
+#ifdef _WIN32
+	File = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (File == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(File, &size) || size.QuadPart == 0) {
+		Close();
+		return false;
+	}
+	Mapping = CreateFileMappingA(File, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (Mapping != NULL)
+		Base = MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+	if (Base == nullptr) {
+		Close();
+		return false;
+	}
+	Length = (size_t) size.QuadPart;
+	return true;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd == -1)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		close(fd);
+		return false;
+	}
+	// The mapping keeps its own reference to the file, so we don't need the descriptor anymore
+	void* base = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED)
+		return false;
+	Base   = base;
+	Length = (size_t) st.st_size;
+	return true;
+#endif
+}
+
+void MappedFile::Close() {
+#ifdef _WIN32
+	if (Base != nullptr)
+		UnmapViewOfFile(Base);
+	if (Mapping != NULL)
+		CloseHandle(Mapping);
+	if (File != INVALID_HANDLE_VALUE)
+		CloseHandle(File);
+	Mapping = NULL;
+	File    = INVALID_HANDLE_VALUE;
+#else
+	if (Base != nullptr)
+		munmap((void*) Base, Length);
+#endif
+	Base   = nullptr;
+	Length = 0;
+}
+
 #ifndef _WIN32
 #undef STAT_TIME
 #endif
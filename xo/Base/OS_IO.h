@@ -35,4 +35,31 @@ The callback must respond in the following ways
 This function returns false if an error occurred other than "no files found"
 */
 XO_API bool FindFiles(const char* dir, std::function<bool(const FilesystemItem& item)> callback);
+
+// Replace 'dst' with 'src', atomically if the platform allows it. Used to publish a cache file that was written to a temporary name.
+XO_API bool RenameFileReplace(const char* src, const char* dst);
+
+/* A read-only view of an entire file, mapped into memory.
+The file cannot be replaced on Windows while it is mapped, so close it before writing a new version.
+*/
+class XO_API MappedFile {
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool Open(const char* path); // Returns false if the file does not exist, or cannot be mapped
+	void Close();
+
+	const void* Data() const { return Base; }
+	size_t      Size() const { return Length; }
+	bool        IsOpen() const { return Base != nullptr; }
+
+private:
+	const void* Base   = nullptr;
+	size_t      Length = 0;
+#ifdef _WIN32
+	HANDLE File    = INVALID_HANDLE_VALUE;
+	HANDLE Mapping = NULL;
+#endif
+};
 }
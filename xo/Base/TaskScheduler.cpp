@@ -0,0 +1,183 @@
+#include "pch.h"
+#include "TaskScheduler.h"
+
+namespace xo {
+
+// The scheduler that the current thread is a worker of, if any
+static thread_local TaskScheduler* CurrentScheduler = nullptr;
+static thread_local int            CurrentWorker    = -1;
+
+TaskGroup::TaskGroup(TaskScheduler& scheduler) : Scheduler(scheduler) {
+	NumPending = 0;
+}
+
+TaskGroup::~TaskGroup() {
+	Wait();
+}
+
+void TaskGroup::Run(std::function<void()> func) {
+	NumPending++;
+	TaskScheduler::Task task;
+	task.Func  = std::move(func);
+	task.Group = this;
+	Scheduler.Push(std::move(task));
+}
+
+void TaskGroup::Wait() {
+	int self = Scheduler.Self();
+	while (NumPending.load(std::memory_order_acquire) != 0) {
+		// Our own tasks may be sitting in another thread's deque, while that thread runs one of its own
+		if (!Scheduler.RunOne(self))
+			std::this_thread::yield();
+	}
+}
+
+TaskScheduler::TaskScheduler() {
+	NumQueued   = 0;
+	NumSleeping = 0;
+	Exiting     = false;
+	Deques += new Deque();
+}
+
+TaskScheduler::~TaskScheduler() {
+	Stop();
+	for (size_t i = 0; i < Deques.size(); i++)
+		delete Deques[i];
+}
+
+void TaskScheduler::Start(int numThreads) {
+	XO_ASSERT(Workers.size() == 0);
+	Exiting = false;
+
+	// The injection deque stays last
+	Deque* inject = Deques.rpop();
+	for (int i = 0; i < numThreads; i++)
+		Deques += new Deque();
+	Deques += inject;
+
+	for (int i = 0; i < numThreads; i++)
+		Workers.push_back(std::thread(&TaskScheduler::WorkerFunc, this, i));
+}
+
+void TaskScheduler::Stop() {
+	if (Workers.size() == 0)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(SleepLock);
+		Exiting = true;
+		Wake.notify_all();
+	}
+	for (size_t i = 0; i < Workers.size(); i++)
+		Workers[i].join();
+
+	Deque* inject = Deques.back();
+	for (size_t i = 0; i < Workers.size(); i++)
+		delete Deques[i];
+	Deques.clear();
+	Deques += inject;
+	Workers.clear();
+}
+
+int TaskScheduler::Self() const {
+	return CurrentScheduler == this ? CurrentWorker : -1;
+}
+
+void TaskScheduler::Push(Task&& task) {
+	int    self = Self();
+	Deque* d    = Deques[self != -1 ? self : Deques.size() - 1];
+	NumQueued++;
+	{
+		std::lock_guard<std::mutex> lock(d->Lock);
+		d->Tasks.push_back(std::move(task));
+	}
+
+	// A worker increments NumSleeping before it checks NumQueued, and we increment NumQueued before
+	// we check NumSleeping, so either it sees our task, or we see that it needs waking.
+	if (NumSleeping != 0) {
+		std::lock_guard<std::mutex> lock(SleepLock);
+		Wake.notify_one();
+	}
+}
+
+bool TaskScheduler::RunOne(int self) {
+	Task task;
+	bool found = false;
+	if (self != -1) {
+		Deque*                      d = Deques[self];
+		std::lock_guard<std::mutex> lock(d->Lock);
+		if (d->Tasks.size() != 0) {
+			task = std::move(d->Tasks.back());
+			d->Tasks.pop_back();
+			found = true;
+		}
+	}
+
+	// Steal, starting with our neighbour, so that thieves spread out over the victims
+	size_t n = Deques.size();
+	for (size_t i = 1; i <= n && !found; i++) {
+		size_t victim = ((size_t) (self + 1) + i) % n;
+		if ((int) victim == self)
+			continue;
+		Deque*                      d = Deques[victim];
+		std::lock_guard<std::mutex> lock(d->Lock);
+		if (d->Tasks.size() != 0) {
+			task = std::move(d->Tasks.front());
+			d->Tasks.pop_front();
+			found = true;
+		}
+	}
+
+	if (!found)
+		return false;
+
+	NumQueued--;
+	task.Func();
+	task.Group->NumPending.fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+void TaskScheduler::WorkerFunc(int self) {
+	CurrentScheduler = this;
+	CurrentWorker    = self;
+	while (true) {
+		if (RunOne(self))
+			continue;
+
+		std::unique_lock<std::mutex> lock(SleepLock);
+		NumSleeping++;
+		Wake.wait(lock, [this] { return NumQueued != 0 || Exiting; });
+		NumSleeping--;
+		if (Exiting && NumQueued == 0)
+			break;
+	}
+	CurrentScheduler = nullptr;
+	CurrentWorker    = -1;
+}
+
+void TaskScheduler::ParallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t first, size_t last)>& func) {
+	if (end <= begin)
+		return;
+	grain = Max<size_t>(grain, 1);
+	if (Workers.size() == 0 || end - begin <= grain) {
+		for (size_t i = begin; i < end; i += grain)
+			func(i, Min(i + grain, end));
+		return;
+	}
+
+	TaskGroup group(*this);
+	Split(group, begin, end, grain, func);
+	group.Wait();
+}
+
+// Hand off the upper half of the range, and keep halving the lower half, until it fits in a grain.
+// A thief takes the oldest, and therefore largest, half, and splits it in the same way.
+void TaskScheduler::Split(TaskGroup& group, size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& func) {
+	while (end - begin > grain) {
+		size_t mid = begin + (end - begin) / 2;
+		group.Run([this, &group, mid, end, grain, &func] { Split(group, mid, end, grain, func); });
+		end = mid;
+	}
+	func(begin, end);
+}
+} // namespace xo
@@ -0,0 +1,78 @@
+#pragma once
+
+namespace xo {
+
+class TaskScheduler;
+
+/* A set of tasks that is waited upon as a unit.
+Wait() does not sleep while there is work queued anywhere in the scheduler. Instead, the waiting
+thread runs tasks itself, so a group always finishes, even if every worker is busy, or if there
+are no workers at all. The destructor waits.
+*/
+class XO_API TaskGroup {
+public:
+	explicit TaskGroup(TaskScheduler& scheduler);
+	~TaskGroup();
+
+	void Run(std::function<void()> func); // Queue 'func' to run on any thread
+	void Wait();                           // Return once every task of this group has finished
+
+private:
+	friend class TaskScheduler;
+	TaskScheduler&       Scheduler;
+	std::atomic<int32_t> NumPending;
+};
+
+/* Work-stealing task scheduler, which owns the worker threads.
+
+Every worker owns a deque. A worker pushes the tasks that it creates onto the bottom of its own deque,
+and pops from the bottom too, so it works depth-first, on data that is still in its cache. An idle
+worker steals from the top of another deque, which is where the largest pieces of work are, because
+ParallelFor hands off the upper half of its range at every split. Threads that are not workers (such
+as the render thread) push onto a shared injection deque, which the workers steal from.
+
+Each deque is guarded by its own mutex, rather than being a lock-free Chase-Lev deque. The owner and
+a thief only meet when a deque is nearly empty, and a task is much more work than the lock.
+Idle workers sleep on a condition variable, and are woken when a task is pushed.
+*/
+class XO_API TaskScheduler {
+public:
+	TaskScheduler();
+	~TaskScheduler();
+
+	void Start(int numThreads); // Create the worker threads. Zero is valid, in which case every task runs on the thread that waits for it.
+	void Stop();                // Run all queued tasks to completion, and join the worker threads
+	int  NumThreads() const { return (int) Workers.size(); }
+
+	// Call func(first, last) on subranges of [begin, end) that are no larger than 'grain', and return once all of them have finished.
+	// The calling thread takes part. If there are no workers, or the range fits in a single grain, then it does all the work itself.
+	void ParallelFor(size_t begin, size_t end, size_t grain, const std::function<void(size_t first, size_t last)>& func);
+
+private:
+	friend class TaskGroup;
+
+	struct Task {
+		std::function<void()> Func;
+		TaskGroup*            Group = nullptr;
+	};
+
+	struct Deque {
+		std::mutex       Lock;
+		std::deque<Task> Tasks; // Owner uses the back, thieves use the front
+	};
+
+	std::vector<std::thread> Workers;
+	cheapvec<Deque*>         Deques; // One per worker, followed by the injection deque
+	std::mutex               SleepLock;
+	std::condition_variable  Wake;
+	std::atomic<int32_t>     NumQueued;   // Tasks that have been pushed, but not yet popped. Incremented before the push.
+	std::atomic<int32_t>     NumSleeping; // Workers waiting on Wake
+	std::atomic<bool>        Exiting;
+
+	int  Self() const;       // Index of the calling thread's deque, or -1 if the caller is not one of our workers
+	void Push(Task&& task);
+	bool RunOne(int self);   // Pop a task from our own deque, or steal one, and run it. Returns false if there was nothing to run.
+	void WorkerFunc(int self);
+	void Split(TaskGroup& group, size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)>& func);
+};
+} // namespace xo
@@ -232,16 +232,25 @@ void Canvas2D::Text(float x, float y, float angle, float size, Color color, cons
 	auto col = ColorToAggS8(color);
 
 	if (useCache) {
-		auto                        cache = Global()->GlyphCache;
-		std::lock_guard<std::mutex> cache_lock(cache->Lock);
-		int                         flags = 0;
-		int                         posX  = (int) pos.x;
-		int                         posY  = (int) pos.y;
+		// Only a cache miss takes the cache's lock. After that, we need a snapshot that includes the new glyph.
+		auto cache  = Global()->GlyphCache;
+		auto glyphs = cache->BeginRead();
+		int  flags  = 0;
+		int  posX   = (int) pos.x;
+		int  posY   = (int) pos.y;
 		for (auto ch : utfz::cp(str)) {
 			GlyphCacheKey key(fnt->ID, ch, isize, flags);
-			auto          glyph = cache->GetOrRenderGlyph(key);
+			auto          glyph = glyphs->GetGlyph(key);
+			if (!glyph) {
+				cache->EndRead(glyphs);
+				cache->RenderGlyph(key);
+				glyphs = cache->BeginRead();
+				glyph  = glyphs->GetGlyph(key);
+				if (!glyph)
+					continue;
+			}
 			if (!glyph->IsNull()) {
-				auto atlas = cache->GetAtlas(glyph->AtlasID);
+				auto atlas = glyphs->GetAtlas(glyph->AtlasID);
 				for (unsigned y = 0; y < glyph->Height; y++) {
 					int         outX = posX + glyph->MetricLeft;
 					int         outY = posY + y - glyph->MetricTop;
@@ -254,6 +263,7 @@ void Canvas2D::Text(float x, float y, float angle, float size, Color color, cons
 				// ignore vertical advance
 			}
 		}
+		cache->EndRead(glyphs);
 	} else {
 		std::lock_guard<std::mutex> ft_face_lock(fnt->FTFace_Lock);
 		FT_Error                    e = FT_Set_Pixel_Sizes(fnt->FTFace, isize, isize);
@@ -0,0 +1,82 @@
+#include "pch.h"
+#include "DirtyBitmap.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace xo {
+
+void DirtyBitmap::Set(size_t i) {
+	size_t w = i >> 6;
+	if (w >= Words.size()) {
+		size_t oldWords   = Words.size();
+		size_t oldSummary = Summary.size();
+		Words.resize(w + 1);
+		memset(Words.data + oldWords, 0, (Words.size() - oldWords) * sizeof(uint64_t));
+		Summary.resize((Words.size() + 63) >> 6);
+		if (Summary.size() != oldSummary)
+			memset(Summary.data + oldSummary, 0, (Summary.size() - oldSummary) * sizeof(uint64_t));
+	}
+	Words[w] |= (uint64_t) 1 << (i & 63);
+	Summary[w >> 6] |= (uint64_t) 1 << (w & 63);
+}
+
+bool DirtyBitmap::Get(size_t i) const {
+	size_t w = i >> 6;
+	if (w >= Words.size())
+		return false;
+	return (Words[w] & ((uint64_t) 1 << (i & 63))) != 0;
+}
+
+size_t DirtyBitmap::Count() const {
+	size_t n = 0;
+	for (size_t s = 0; s < Summary.size(); s++) {
+		for (uint64_t bits = Summary[s]; bits != 0; bits &= bits - 1)
+			n += PopCount(Words[(s << 6) + BitScan(bits)]);
+	}
+	return n;
+}
+
+void DirtyBitmap::Reset() {
+	for (size_t s = 0; s < Summary.size(); s++) {
+		for (uint64_t bits = Summary[s]; bits != 0; bits &= bits - 1)
+			Words[(s << 6) + BitScan(bits)] = 0;
+	}
+	if (Summary.size() != 0)
+		memset(Summary.data, 0, Summary.size() * sizeof(uint64_t));
+}
+
+void DirtyBitmap::Clear() {
+	Words.clear();
+	Summary.clear();
+}
+
+void DirtyBitmap::ToList(cheapvec<InternalID>& list) const {
+	for (size_t s = 0; s < Summary.size(); s++) {
+		for (uint64_t bits = Summary[s]; bits != 0; bits &= bits - 1) {
+			size_t w = (s << 6) + BitScan(bits);
+			for (uint64_t word = Words[w]; word != 0; word &= word - 1)
+				list += (InternalID) ((w << 6) + BitScan(word));
+		}
+	}
+}
+
+unsigned DirtyBitmap::BitScan(uint64_t v) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, v);
+	return (unsigned) index;
+#else
+	return (unsigned) __builtin_ctzll(v);
+#endif
+}
+
+unsigned DirtyBitmap::PopCount(uint64_t v) {
+#ifdef _MSC_VER
+	return (unsigned) __popcnt64(v);
+#else
+	return (unsigned) __builtin_popcountll(v);
+#endif
+}
+} // namespace xo
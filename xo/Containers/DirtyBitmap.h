@@ -0,0 +1,34 @@
+#pragma once
+#include "../Defs.h"
+
+namespace xo {
+
+/* Set of dirty element IDs, used by Doc to track which elements need to be copied to the renderer.
+
+The bits live in 64-bit words, and a second level holds one bit per word, which is set if that
+word is not zero. Iterating, counting and resetting all skip over clean words via the summary,
+so their cost is proportional to the number of dirty elements, rather than the number of elements
+in the document. This matters because we reset the bitmap every frame.
+
+Set() grows the bitmap as necessary. Bits beyond the end are considered clear.
+*/
+class XO_API DirtyBitmap {
+public:
+	void   Set(size_t i);
+	bool   Get(size_t i) const;
+	size_t Size() const { return Words.size() * 64; } // Number of bits that are addressable without growing
+	size_t Count() const;                            // Number of set bits
+	void   Reset();                                  // Clear all bits, without releasing memory
+	void   Clear();                                  // Clear all bits, and release memory
+
+	// Append the index of every set bit to 'list', in ascending order
+	void ToList(cheapvec<InternalID>& list) const;
+
+protected:
+	cheapvec<uint64_t> Words;   // Bit i is in Words[i / 64]
+	cheapvec<uint64_t> Summary; // Bit w is set if Words[w] is not zero
+
+	static unsigned BitScan(uint64_t v);  // Index of lowest set bit. v must not be zero.
+	static unsigned PopCount(uint64_t v); // Number of set bits
+};
+} // namespace xo
@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "VariableTable.h"
+#include "../../dependencies/hash/xxhash_xo_wrapper.h"
 
 namespace xo {
 
@@ -56,6 +57,21 @@ void VariableTable::CloneFrom_Incremental(const VariableTable& src) {
 	// modified bits are cleared by Doc::ResetModified()
 }
 
+uint64_t VariableTable::ComputeHash(uint64_t seed) const {
+	uint64_t h = XXH64(nullptr, 0, seed ^ Values.size());
+	for (size_t i = 0; i < Values.size(); i++)
+		h = XXH64(Values[i].CStr(), Values[i].Length(), h);
+	return h;
+}
+
+bool VariableTable::AnyModified() const {
+	for (size_t i = 0; i < IsModified.size(); i++) {
+		if (IsModified[i])
+			return true;
+	}
+	return false;
+}
+
 void VariableTable::ResetModified() {
 	//IDTable.ResetModified();
 	IsModified.fill(false);
@@ -38,8 +38,10 @@ public:
 	const char* GetByID(int id) const;            // Returns null if not defined
 	int         GetID(const char* var) const;
 
-	void CloneFrom_Incremental(const VariableTable& src);
-	void ResetModified();
+	void     CloneFrom_Incremental(const VariableTable& src);
+	void     ResetModified();
+	bool     AnyModified() const;
+	uint64_t ComputeHash(uint64_t seed) const; // Hash of all values
 
 protected:
 	xo::Doc*             Doc;
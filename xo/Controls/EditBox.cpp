@@ -31,33 +31,28 @@ DomNode* EditBox::AppendTo(DomNode* node, const char* txt) {
 	s->EditBoxID = edit->GetInternalID();
 	s->CaretID   = caret->GetInternalID();
 
-	auto flip = [s](Doc* doc) {
-		s->IsBlinkVisible = !s->IsBlinkVisible;
-		auto caret        = doc->GetNodeByInternalIDMutable(s->CaretID);
-		caret->StyleParse(s->IsBlinkVisible ? "background: #000" : "background: #0000");
+	// The caret blinks on the render thread, so a blinking caret does not modify the document. Because it uses
+	// EaseStep, the renderer only produces a frame when the caret turns on or off.
+	// Restarting the animation makes the caret visible for the first half of the period.
+	auto blink = [s](Doc* doc) {
+		auto  caret  = doc->GetNodeByInternalIDMutable(s->CaretID);
+		float period = 2 * Global()->CaretBlinkTimeMS / 1000.0f;
+		caret->AnimateColor(AnimBackground, Color::Black(), Color::Transparent(), period, EaseStep, AnimRepeat);
 	};
 
-	auto timer = [s, edit, flip](Event& ev) {
-		if (edit->HasFocus())
-			flip(ev.Doc);
-		if (!edit->HasFocus())
-			ev.CancelTimer();
-	};
-
-	auto changeText = [s, flip, edit](xo::Doc* doc, const std::string& txt) {
+	auto changeText = [s, blink, edit](xo::Doc* doc, const std::string& txt) {
 		if (txt != edit->GetText())
 			edit->SetText(txt.c_str());
 
 		// always show the caret after pressing any key
-		s->IsBlinkVisible = false;
-		flip(doc);
+		blink(doc);
 
 		// We need the DOM to call us back when it's finished rendering, because we don't yet have
 		// the RenderDomText node that we need in order to place our caret.
 		s->PlaceCaretOnNextRender = true;
 	};
 
-	edit->OnClick([s, flip, edit, timer](Event& ev) {
+	edit->OnClick([s, blink](Event& ev) {
 		//Trace("[%f %f]\n", ev.PointsRel[0].x, ev.PointsRel[0].y);
 		RenderDomNode* rbox = ev.LayoutResult->IDToNodeTable[ev.Target->GetInternalID()];
 		if (rbox->Children.size() >= 1 && rbox->Children[0]->IsText()) {
@@ -78,12 +73,8 @@ DomNode* EditBox::AppendTo(DomNode* node, const char* txt) {
 				crack = -1;
 			s->CaretPos = crack;
 			PlaceCaretIndicator(s, ev);
-			// restart the timer, so that the caret is visible for the next 500ms or so, after the user clicked
-			if (s->TimerID)
-				edit->RemoveHandler(s->TimerID);
-			s->TimerID        = edit->OnTimer(timer, Global()->CaretBlinkTimeMS);
-			s->IsBlinkVisible = false;
-			flip(ev.Doc);
+			// restart the blink, so that the caret is visible for the next 500ms or so, after the user clicked
+			blink(ev.Doc);
 		}
 	});
 	edit->OnKeyDown([s, changeText, edit](Event& ev) {
@@ -143,9 +134,8 @@ DomNode* EditBox::AppendTo(DomNode* node, const char* txt) {
 		s->CaretPos = ClampCaretPos(s->CaretPos + 1, txt.length());
 		changeText(ev.Doc, txt);
 	});
-	edit->OnGetFocus([s, flip, edit, timer](Event& ev) {
-		if (!s->TimerID)
-			s->TimerID = edit->OnTimer(timer, Global()->CaretBlinkTimeMS);
+	edit->OnGetFocus([blink](Event& ev) {
+		blink(ev.Doc);
 	});
 	edit->OnRender([s](Event& ev) {
 		if (s->PlaceCaretOnNextRender) {
@@ -153,12 +143,9 @@ DomNode* EditBox::AppendTo(DomNode* node, const char* txt) {
 			PlaceCaretIndicator(s, ev);
 		}
 	});
-	edit->OnLoseFocus([s, flip, edit](Event& ev) {
-		s->IsBlinkVisible = true;
-		flip(ev.Doc);
-		if (s->TimerID)
-			edit->RemoveHandler(s->TimerID);
-		s->TimerID = 0;
+	edit->OnLoseFocus([s](Event& ev) {
+		auto caret = ev.Doc->GetNodeByInternalIDMutable(s->CaretID);
+		caret->StopAnimation(AnimBackground);
 	});
 	edit->OnDestroy([s](Event& ev) {
 		delete s;
@@ -17,9 +17,7 @@ public:
 		InternalID EditBoxID              = 0;
 		InternalID CaretID                = 0;
 		int        CaretPos               = 0; // UTF-8 code point position in our string. Caret sits after this character.
-		bool       IsBlinkVisible         = false;
 		bool       PlaceCaretOnNextRender = false;
-		uint64_t   TimerID                = 0;
 	};
 
 	static void     InitializeStyles(Doc* doc);
@@ -0,0 +1,234 @@
+#include "pch.h"
+#include "VirtualList.h"
+#include "../Doc.h"
+
+namespace xo {
+namespace controls {
+
+const float VirtualList::ParkedTop = -100000;
+
+VirtualList::VirtualList(DomNode* root, float viewportHeight, float rowHeight) : rx::Control(root) {
+	FixedRowHeight = rowHeight;
+	SetViewportHeight(viewportHeight);
+
+	root->OnMouseDown([this](Event& ev) {
+		HandleMouseDown(ev);
+	});
+
+	root->OnKeyDown([this](Event& ev) {
+		HandleKeyDown(ev);
+	});
+}
+
+void VirtualList::InitializeStyles(Doc* doc) {
+	doc->ClassParse("xo.virtuallist", "width: 100%; flow-context: new; canfocus: true");
+	doc->ClassParse("xo.virtuallist.row", "position: absolute; left: 0; width: 100%; flow-context: new");
+}
+
+VirtualList* VirtualList::AppendTo(DomNode* node, float viewportHeight, float rowHeight) {
+	auto root = node->AddNode(TagDiv);
+	root->AddClass("xo.virtuallist");
+	return new VirtualList(root, viewportHeight, rowHeight);
+}
+
+void VirtualList::SetNumRows(size_t numRows) {
+	if (numRows == NumRows)
+		return;
+	NumRows        = numRows;
+	RowTopsInvalid = true;
+	SetDirty();
+}
+
+void VirtualList::SetViewportHeight(float px) {
+	ViewportHeight = px;
+	Root->StyleParsef("height: %vpx", px);
+	SetDirty();
+}
+
+void VirtualList::SetFixedRowHeight(float px) {
+	FixedRowHeight = px;
+	SetDirty();
+}
+
+void VirtualList::InvalidateRows() {
+	RowsInvalid = true;
+	SetDirty();
+}
+
+void VirtualList::InvalidateRowHeights() {
+	RowTopsInvalid = true;
+	SetDirty();
+}
+
+void VirtualList::ScrollToRow(size_t index) {
+	index = Min(index, MaxFirstRow());
+	if (index == FirstRow)
+		return;
+	FirstRow = index;
+	SetDirty();
+}
+
+void VirtualList::ScrollBy(int64_t rows) {
+	if (rows < 0 && (size_t) -rows > FirstRow)
+		ScrollToRow(0);
+	else
+		ScrollToRow(FirstRow + rows);
+}
+
+DomNode* VirtualList::GetRowNode(size_t index) const {
+	for (const auto& slot : Slots) {
+		if (slot.Row == index)
+			return slot.Node;
+	}
+	return nullptr;
+}
+
+void VirtualList::ObservableTouched(rx::Observable* target) {
+	RowsInvalid = true;
+	rx::Control::ObservableTouched(target);
+}
+
+void VirtualList::Render() {
+	if (RowCount && RowCount() != NumRows) {
+		NumRows        = RowCount();
+		RowTopsInvalid = true;
+	}
+	if (RowHeight && RowTopsInvalid)
+		UpdateRowTops();
+
+	FirstRow = Min(FirstRow, MaxFirstRow());
+
+	// Find the rows that fit entirely inside the viewport. Always show at least one row.
+	double top = RowTop(FirstRow);
+	VisibleEnd = FirstRow;
+	while (VisibleEnd < NumRows && (VisibleEnd == FirstRow || RowTop(VisibleEnd + 1) - top <= ViewportHeight))
+		VisibleEnd++;
+
+	size_t begin = FirstRow - Min<size_t>(FirstRow, Overscan);
+	size_t end   = Min(VisibleEnd + Overscan, NumRows);
+
+	// Slots that are already showing a row inside the window keep it. The rest are free to be recycled.
+	SlotByRow.resize(end - begin);
+	SlotByRow.fill(-1);
+	cheapvec<int32_t> spare;
+	for (size_t i = 0; i < Slots.size(); i++) {
+		Slot& slot = Slots[i];
+		if (RowsInvalid || slot.Row < begin || slot.Row >= end)
+			spare += (int32_t) i;
+		else
+			SlotByRow[slot.Row - begin] = (int32_t) i;
+	}
+	RowsInvalid = false;
+
+	for (size_t row = begin; row < end; row++) {
+		int32_t index = SlotByRow[row - begin];
+		if (index == -1) {
+			if (spare.size() != 0) {
+				index = spare.back();
+				spare.pop();
+			} else {
+				Slot slot;
+				slot.Node = Root->AddNode(TagDiv);
+				slot.Node->AddClass("xo.virtuallist.row");
+				index = (int32_t) Slots.size();
+				Slots += slot;
+			}
+			Slots[index].Row = row;
+			if (RenderRow)
+				RenderRow(Slots[index].Node, row);
+			NumRowsRendered++;
+		}
+		bool visible = row >= FirstRow && row < VisibleEnd;
+		PlaceSlot(Slots[index], visible ? (float) (RowTop(row) - top) : ParkedTop, HeightOf(row));
+	}
+
+	// Delete the slots that we no longer need, for example when the viewport shrinks
+	if (spare.size() != 0) {
+		for (size_t i = 0; i < spare.size(); i++) {
+			Slots[spare[i]].Node->Delete();
+			Slots[spare[i]].Node = nullptr;
+		}
+		size_t j = 0;
+		for (size_t i = 0; i < Slots.size(); i++) {
+			if (Slots[i].Node != nullptr)
+				Slots[j++] = Slots[i];
+		}
+		Slots.resize(j);
+	}
+}
+
+double VirtualList::RowTop(size_t index) {
+	if (RowHeight)
+		return RowTops[index];
+	return (double) index * FixedRowHeight;
+}
+
+float VirtualList::HeightOf(size_t index) {
+	if (RowHeight)
+		return (float) (RowTops[index + 1] - RowTops[index]);
+	return FixedRowHeight;
+}
+
+size_t VirtualList::MaxFirstRow() {
+	if (NumRows == 0)
+		return 0;
+	if (!RowHeight) {
+		size_t fit = FixedRowHeight > 0 ? (size_t) (ViewportHeight / FixedRowHeight) : NumRows;
+		return NumRows - Min(Max<size_t>(fit, 1), NumRows);
+	}
+	if (RowTopsInvalid)
+		UpdateRowTops();
+	double bottom = RowTop(NumRows);
+	size_t first  = NumRows - 1;
+	while (first != 0 && bottom - RowTop(first - 1) <= ViewportHeight)
+		first--;
+	return first;
+}
+
+void VirtualList::UpdateRowTops() {
+	// For a million rows, this is a few milliseconds, which is why we only do it when the rows change
+	RowTops.resize(NumRows + 1);
+	double sum = 0;
+	for (size_t i = 0; i < NumRows; i++) {
+		RowTops[i] = sum;
+		sum += RowHeight(i);
+	}
+	RowTops[NumRows] = sum;
+	RowTopsInvalid   = false;
+}
+
+void VirtualList::PlaceSlot(Slot& slot, float top, float height) {
+	// Only touch the style when it changes, so that rows which don't move keep their cached layout
+	if (slot.Top != top || slot.Height != height) {
+		slot.Node->StyleParsef("top: %vpx; height: %vpx", top, height);
+		slot.Top    = top;
+		slot.Height = height;
+	}
+}
+
+void VirtualList::HandleMouseDown(Event& ev) {
+	if (ev.Button == Button::MouseWheelScrollUp) {
+		ScrollBy(-(int64_t) WheelRows);
+		ev.StopPropagation();
+	} else if (ev.Button == Button::MouseWheelScrollDown) {
+		ScrollBy(WheelRows);
+		ev.StopPropagation();
+	}
+}
+
+void VirtualList::HandleKeyDown(Event& ev) {
+	int64_t page = Max<int64_t>(GetNumVisibleRows(), 1);
+	switch (ev.Button) {
+	case Button::KeyUp: ScrollBy(-1); break;
+	case Button::KeyDown: ScrollBy(1); break;
+	case Button::KeyPageUp: ScrollBy(-page); break;
+	case Button::KeyPageDown: ScrollBy(page); break;
+	case Button::KeyHome: ScrollToRow(0); break;
+	case Button::KeyEnd: ScrollToRow(NumRows); break;
+	default: return;
+	}
+	ev.StopPropagation();
+}
+
+} // namespace controls
+} // namespace xo
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "../Defs.h"
+#include "../Reactive/Control.h"
+
+namespace xo {
+class Doc;
+class DomNode;
+namespace controls {
+
+/* A scrolling list that only creates DOM nodes for the rows that are on screen
+
+The list knows how many rows there are, and how tall each row is, but it only asks for the
+content of a row when that row scrolls into view. Every row is an absolutely positioned child
+of Root, so the cost of layout, cloning and hit testing depends on the height of the viewport,
+and not on the number of rows.
+
+A few rows above and below the viewport (the overscan) are rendered ahead of time, and parked
+far outside of the window. When one of them scrolls into view, only its position changes.
+Rows that leave the window are recycled, so RenderRow is given a node that may have shown a
+different row before. RenderRow must therefore replace all of the content of the node.
+
+xo has no clipping, so the list scrolls in whole rows, and only shows rows that fit
+entirely inside the viewport.
+
+The list is an rx::Control, so you can Watch() an Observable data source. When that is touched,
+all materialized rows are rendered again at the end of the event dispatch.
+
+The control deletes itself when Root is deleted.
+*/
+class XO_API VirtualList : public rx::Control {
+public:
+	std::function<void(DomNode* row, size_t index)> RenderRow;           // Fill 'row' with the content of row 'index'. Replace everything, because the node may have shown a different row before.
+	std::function<float(size_t index)>              RowHeight;           // Optional height of row 'index', in pixels. If empty, all rows are FixedRowHeight tall.
+	std::function<size_t()>                         RowCount;            // Optional. Called at the start of every Render, so that a watched data source can change the number of rows.
+	uint32_t                                        Overscan        = 4; // Number of rows above and below the viewport that are rendered ahead of time
+	uint32_t                                        WheelRows       = 3; // Number of rows moved by one click of the mouse wheel
+	uint64_t                                        NumRowsRendered = 0; // Number of times that RenderRow has been called
+
+	VirtualList(DomNode* root, float viewportHeight, float rowHeight);
+
+	static void         InitializeStyles(Doc* doc);
+	static VirtualList* AppendTo(DomNode* node, float viewportHeight, float rowHeight);
+
+	void     SetNumRows(size_t numRows);
+	size_t   GetNumRows() const { return NumRows; }
+	void     SetViewportHeight(float px);
+	void     SetFixedRowHeight(float px);
+	void     InvalidateRows();       // Render all materialized rows again, for example after the data behind them has changed
+	void     InvalidateRowHeights(); // Call this when the values returned by RowHeight have changed
+	void     ScrollToRow(size_t index);
+	void     ScrollBy(int64_t rows);
+	size_t   GetFirstRow() const { return FirstRow; }
+	size_t   GetNumVisibleRows() const { return VisibleEnd - FirstRow; } // As of the most recent Render
+	DomNode* GetRowNode(size_t index) const;                             // Returns null if the row is not materialized
+
+	// Implementation of rx::Control
+	void Render() override;
+	void ObservableTouched(rx::Observable* target) override;
+
+protected:
+	static const size_t NoRow = (size_t) -1;
+	static const float  ParkedTop; // Rows in the overscan are placed here, so that they are never visible
+
+	struct Slot {
+		DomNode* Node   = nullptr;
+		size_t   Row    = NoRow; // Row that Node is showing
+		float    Top    = 0;     // Value of the 'top' style of Node
+		float    Height = 0;     // Value of the 'height' style of Node
+	};
+
+	cheapvec<Slot>    Slots;
+	cheapvec<int32_t> SlotByRow; // Temporary, used by Render. Index into Slots, or -1.
+	cheapvec<double>  RowTops;   // Prefix sum of row heights, when RowHeight is set. Has NumRows + 1 entries.
+	size_t            NumRows        = 0;
+	size_t            FirstRow       = 0;
+	size_t            VisibleEnd     = 0; // One past the last row that is on screen
+	float             ViewportHeight = 0;
+	float             FixedRowHeight = 0;
+	bool              RowsInvalid    = false;
+	bool              RowTopsInvalid = true;
+
+	double RowTop(size_t index);
+	float  HeightOf(size_t index);
+	size_t MaxFirstRow();
+	void   UpdateRowTops();
+	void   PlaceSlot(Slot& slot, float top, float height);
+	void   HandleMouseDown(Event& ev);
+	void   HandleKeyDown(Event& ev);
+};
+
+} // namespace controls
+} // namespace xo
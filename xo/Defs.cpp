@@ -256,17 +256,6 @@ XO_API void AddOrRemoveDocsFromGlobalList() {
 		Global()->Docs += p;
 }
 
-void WorkerThreadFunc() {
-	while (true) {
-		Global()->JobQueue.SemObj().wait();
-		if (Global()->ExitSignalled)
-			break;
-		Job job;
-		XO_VERIFY(Global()->JobQueue.PopTail(job));
-		job.JobFunc(job.JobData);
-	}
-}
-
 static void InitializeThread();
 static void ShutdownThread();
 
@@ -277,12 +266,14 @@ void UIThread() {
 		Global()->UIEventQueue.SemObj().wait();
 		if (Global()->ExitSignalled)
 			break;
-		OriginalEvent          ev;
-		TQueue<OriginalEvent>& q      = Global()->UIEventQueue;
-		uint32_t               qsize1 = q.Size();
+		OriginalEvent ev;
+		EventQueue&   q      = Global()->UIEventQueue;
+		uint32_t      qsize1 = q.Size();
 		XO_VERIFY(Global()->UIEventQueue.PopTail(ev));
 		uint32_t qsize2 = q.Size();
+		double   start  = TimeAccurateSeconds();
 		ev.DocGroup->ProcessEvent(ev.Event);
+		ev.DocGroup->Profiler.AddEvent(ev.Event.Type, ev.TimeCreated, start, TimeAccurateSeconds());
 	}
 }
 
@@ -385,7 +376,7 @@ XO_API void Initialize(const InitParams* init) {
 		Globals->CacheDir = DefaultCacheDir();
 
 	Globals->TargetFPS            = 60;
-	Globals->NumWorkerThreads     = Min(numCPUCores, 4); // I can't think of a reason right now why you'd want lots of these
+	Globals->NumWorkerThreads     = Max(numCPUCores - 1, 0); // The thread that waits on a parallel section works too
 	Globals->MaxSubpixelGlyphSize = 60;
 	Globals->PreferOpenGL         = false; // Should be false on Windows, because DX generally starts up faster than OpenGL
 	Globals->EnableVSync          = false;
@@ -413,21 +404,30 @@ XO_API void Initialize(const InitParams* init) {
 #endif
 	// Do we round text line heights to whole pixels?
 	// We only render sub-pixel text on low resolution monitors that do not change orientation (ie desktop).
-	Globals->RoundLineHeights    = Globals->EnableSubpixelText || Globals->EpToPixel < 2.0f;
-	Globals->SnapBoxes           = true;
-	Globals->SnapHorzText        = false;
-	Globals->UseFreetypeSubpixel = false;
-	Globals->EnableKerning       = !Globals->EnableSubpixelText || !Globals->SnapHorzText;
-	Globals->EnableKerning       = false; // Freetype's kerning is CRAZY SLOW.. from one quick profile that I did. Will investigate more later.
-	Globals->ShowCoarseTimes     = false;
+	Globals->RoundLineHeights        = Globals->EnableSubpixelText || Globals->EpToPixel < 2.0f;
+	Globals->SnapBoxes               = true;
+	Globals->SnapHorzText            = false;
+	Globals->UseFreetypeSubpixel     = false;
+	Globals->EnableKerning           = !Globals->EnableSubpixelText || !Globals->SnapHorzText;
+	Globals->EnableKerning           = false; // Freetype's kerning is CRAZY SLOW.. from one quick profile that I did. Will investigate more later.
+	Globals->ShowCoarseTimes         = false;
+	Globals->EnablePartialRepaint    = true;
+	Globals->EnableIncrementalLayout = true;
+	Globals->EnableParallelLayout    = true;
+	Globals->EnableStyleCache        = true;
+	Globals->EnableWordCache         = true;
+	Globals->EnableVertexCache       = true;
+	Globals->EnableGlyphDiskCache    = true;
+	Globals->EnableFrameProfiler     = false;
 	//Globals->DebugZeroClonedChildList = true;
-	Globals->MaxTextureID = ~((TextureID) 0);
+	Globals->MaxTextureID       = ~((TextureID) 0);
+	Globals->GlyphCacheMaxBytes = 16 * 1024 * 1024;
+	Globals->ImageUploadBudget  = 4 * 1024 * 1024;
 	//Globals->ClearColor.Set( 200, 0, 200, 255 );  // Make our clear color a very noticeable purple, so you know when you've screwed up the root node
 	Globals->ClearColor.Set(255, 150, 255, 255); // Make our clear color a very noticeable purple, so you know when you've screwed up the root node
 	Globals->DocAddQueue.Initialize(false);
 	Globals->DocRemoveQueue.Initialize(false);
 	Globals->UIEventQueue.Initialize(true);
-	Globals->JobQueue.Initialize(true);
 	Globals->FontStore = new FontStore();
 	Globals->FontStore->InitializeFreetype();
 	Globals->GlyphCache = new GlyphCache();
@@ -435,9 +435,10 @@ XO_API void Initialize(const InitParams* init) {
 	dummySysWnd->PlatformInitialize(init);
 	delete dummySysWnd;
 	InitializeXoThreads();
+	if (init && init->NumWorkerThreads >= 0)
+		Globals->NumWorkerThreads = init->NumWorkerThreads;
 	Trace("xo creating %d worker threads (%d CPU cores).\n", (int) Globals->NumWorkerThreads, (int) numCPUCores);
-	for (int i = 0; i < Globals->NumWorkerThreads; i++)
-		Globals->WorkerThreads.push_back(std::thread(WorkerThreadFunc));
+	Globals->Scheduler.Start(Globals->NumWorkerThreads);
 }
 
 // This is the companion to Initialize.
@@ -457,15 +458,9 @@ XO_API void Shutdown() {
 
 	ShutdownXoThreads();
 
-	// signal all threads to exit
-	Job nullJob = Job();
-	for (size_t i = 0; i < Globals->WorkerThreads.size(); i++)
-		Globals->JobQueue.Add(nullJob);
-
-	// wait for each thread in turn
-	for (size_t i = 0; i < Globals->WorkerThreads.size(); i++)
-		Globals->WorkerThreads[i].join();
+	Globals->Scheduler.Stop();
 
+	Globals->GlyphCache->SaveToDisk();
 	Globals->GlyphCache->Clear();
 	delete Globals->GlyphCache;
 	Globals->GlyphCache = NULL;
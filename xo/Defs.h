@@ -4,6 +4,7 @@
 // strive to remain quite small.
 
 #include "Tags.h"
+#include "EventQueue.h"
 
 namespace xo {
 
@@ -25,6 +26,7 @@ class Layout;
 class LayoutResult;
 class Pool;
 class DocGroup;
+class FrameProfiler;
 class RenderDoc;
 class Renderer;
 class RenderDomEl;
@@ -235,8 +237,8 @@ public:
 	Box  OffsetBy(Point p) { return Box(Left + p.X, Top + p.Y, Right + p.X, Bottom + p.Y); }
 	bool IsInsideMe(Point p) const { return p.X >= Left && p.Y >= Top && p.X < Right && p.Y < Bottom; }
 	bool IsAreaZero() const { return Width() == 0 || Height() == 0; }
-	bool operator==(const Box& b) { return Left == b.Left && Right == b.Right && Top == b.Top && Bottom == b.Bottom; }
-	bool operator!=(const Box& b) { return !(*this == b); }
+	bool operator==(const Box& b) const { return Left == b.Left && Right == b.Right && Top == b.Top && Bottom == b.Bottom; }
+	bool operator!=(const Box& b) const { return !(*this == b); }
 	// $XO_GCC_ALIGN_BUG
 	Box& operator=(const Box& b) {
 		Left   = b.Left;
@@ -383,13 +385,19 @@ struct StyleClassID {
 	operator uint32_t() const { return ID; }
 };
 
-struct Job {
-	void* JobData;
-	void (*JobFunc)(void* jobdata);
-};
-
 struct XO_API RenderStats {
-	uint32_t Clone_NumEls; // Number of DOM elements cloned
+	uint32_t Clone_NumEls;           // Number of DOM elements cloned
+	uint32_t Clone_NumClasses;       // Number of style classes cloned
+	uint32_t Layout_NumNodesReused;  // Number of flow context nodes whose layout was copied from the previous frame
+	uint32_t Layout_NumParallelJobs; // Number of subtrees that were laid out by the worker threads
+	uint32_t Layout_NumStyleHits;    // Number of elements whose resolved style was copied out of the style cache
+	uint32_t Layout_NumWordHits;     // Number of words whose character placements were copied out of the word cache
+	uint32_t Layout_Skipped;         // 1 if the most recent frame skipped layout, because only animations of non-layout properties had progressed
+	uint32_t Anim_NumApplied;        // Number of animations applied by the most recent frame
+	uint32_t Render_NumDrawCalls;    // Number of draw calls issued by the most recent frame
+	uint32_t Render_RepaintArea;     // Number of pixels redrawn by the most recent frame
+	uint32_t Render_NumNodesCached;  // Number of nodes whose vertices were copied out of the vertex cache by the most recent frame
+	uint32_t Render_ImageBytes;      // Number of bytes of image texels streamed to the GPU by the most recent frame
 
 	void Reset();
 };
@@ -467,7 +475,7 @@ enum Shaders {
 // A single instance of this is accessible via Global()
 struct GlobalStruct {
 	int  TargetFPS;
-	int  NumWorkerThreads;      // Read-only. Set during Initialize().
+	int  NumWorkerThreads;      // Read-only. Set during Initialize(). Overridable with InitParams.
 	int  MaxSubpixelGlyphSize;  // Maximum font size where we will use sub-pixel glyph textures
 	bool PreferOpenGL;          // Prefer OpenGL over DirectX. If this is true, then on Windows OpenGL will be tried first.
 	bool EnableVSync;           // This is only respected during device initialization, so you must set it at application start. It raises latency noticeably. This has no effect on DirectX windowed rendering.
@@ -491,8 +499,18 @@ struct GlobalStruct {
 	TextureID MaxTextureID;        // Used to test texture ID wrap-around. Were it not for testing, this could be 2^32 - 1
 	Color     ClearColor;          // glClearColor
 	String    CacheDir;            // Root directory where we store font caches, etc. Overridable with InitParams
-
-	bool ShowCoarseTimes; // Show coarse frame times
+	size_t    GlyphCacheMaxBytes;  // Budget for glyph atlases. Least recently used glyphs are evicted beyond this. Zero means unlimited.
+	size_t    ImageUploadBudget;   // Bytes of modified image texels that are streamed to the GPU per frame. The rest wait for the following frames. Zero means unlimited.
+
+	bool ShowCoarseTimes;         // Show coarse frame times
+	bool EnablePartialRepaint;    // Only redraw the parts of the window whose layout has changed, if the renderer preserves its back buffer
+	bool EnableIncrementalLayout; // Reuse the layout of unchanged flow contexts from the previous frame
+	bool EnableParallelLayout;    // Lay out independent flow contexts on the worker threads
+	bool EnableStyleCache;        // Resolve the style of elements with identical inputs only once
+	bool EnableWordCache;         // Remember the character placements of words across frames
+	bool EnableVertexCache;       // Retain the vertices of unchanged boxes across frames
+	bool EnableGlyphDiskCache;    // Seed the glyph cache from CacheDir at startup, and save it at shutdown
+	bool EnableFrameProfiler;     // Record the time of every phase of every frame in DocGroup::Profiler. When false, only the coarse phases are recorded. This times the style resolution of every node, so it is off by default.
 
 	// Debugging flags. Enabling these should make debugging easier.
 	// Some of them may turn out to have a small enough performance hit that you can
@@ -506,20 +524,20 @@ struct GlobalStruct {
 	cheapvec<DocGroup*>   Docs;           // Only Main thread is allowed to touch this.
 	TQueue<DocGroup*>     DocAddQueue;    // Documents requesting addition
 	TQueue<DocGroup*>     DocRemoveQueue; // Documents requesting removal
-	TQueue<OriginalEvent> UIEventQueue;   // Global event queue, consumed by the one-and-only UI thread
-	TQueue<Job>           JobQueue;       // Global job queue, consumed by the worker thread pool
+	EventQueue            UIEventQueue;   // Global event queue, consumed by the one-and-only UI thread
+	TaskScheduler         Scheduler;      // Owns the worker threads
 	xo::FontStore*        FontStore;      // All fonts known to the system.
 	xo::GlyphCache*       GlyphCache;     // This might have to move into a less global domain.
 
-	std::atomic<bool>        ExitSignalled;
-	std::vector<std::thread> WorkerThreads;
-	std::thread              UIThread; // Only used on Windows desktop
+	std::atomic<bool> ExitSignalled;
+	std::thread       UIThread; // Only used on Windows desktop
 };
 
 // Optional initialization parameters
 struct InitParams {
-	float  EpToPixel = 0; // Override Eye Pixels to Device Pixels (ends up in GlobalStruct.EpToPixel)
-	String CacheDir;      // Override cache directory used for font caches etc.
+	float  EpToPixel        = 0;  // Override Eye Pixels to Device Pixels (ends up in GlobalStruct.EpToPixel)
+	int    NumWorkerThreads = -1; // Override the number of worker threads. -1 means one less than the number of CPU cores.
+	String CacheDir;              // Override cache directory used for font caches etc.
 #if XO_PLATFORM_WIN_DESKTOP
 	HICON WindowsAppIconLarge = nullptr; // Override the large icon of the "xo" window class
 	HICON WindowsAppIconSmall = nullptr; // Override the small icon of the "xo" window class
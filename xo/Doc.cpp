@@ -9,6 +9,7 @@
 #include "Controls/EditBox.h"
 #include "Controls/Button.h"
 #include "Controls/MsgBox.h"
+#include "Controls/VirtualList.h"
 
 namespace xo {
 
@@ -35,8 +36,8 @@ void Doc::IncVersion() {
 }
 
 void Doc::ResetModifiedBitmap() {
-	if (ChildIsModified.size() != 0)
-		ChildIsModified.fill(false);
+	ChildIsModified.Reset();
+	ClassStyles.ResetModified();
 	StyleVariables.ResetModified();
 	StyleVerbatimStrings.ResetModified();
 }
@@ -54,39 +55,63 @@ void Doc::CloneSlowInto(Doc& c, uint32_t cloneFlags, RenderStats& stats) const {
 	while (c.ChildByInternalID.size() < ChildByInternalID.size())
 		c.ChildByInternalID += nullptr;
 
-	// Although it would be trivial to parallelize the following two passes, I think it is unlikely to be worth it,
-	// since I suspect these passes will be bandwidth limited.
-
-	// Pass 1: Ensure that all objects that are present in the source document have a valid pointer in the target document
-	for (size_t i = 0; i < ChildIsModified.size(); i++) {
-		if (ChildIsModified[i]) {
-			stats.Clone_NumEls++;
-			const DomEl* src = GetChildByInternalID((xo::InternalID) i);
-			DomEl*       dst = c.GetChildByInternalIDMutable((xo::InternalID) i);
-			if (src && !dst) {
-				// create in destination
-				c.ChildByInternalID[i] = c.AllocChild(src->GetTag(), src->GetParentID());
-			} else if (!src && dst) {
-				// destroy destination. Make it forget its children, because this loop takes care of all elements.
-				dst->ForgetChildren();
-				c.FreeChild(dst);
-				c.ChildByInternalID[i] = nullptr;
-			}
+	cheapvec<InternalID> modified;
+	ChildIsModified.ToList(modified);
+	stats.Clone_NumEls += (uint32_t) modified.size();
+
+	// Pass 1: Ensure that all objects that are present in the source document have a valid pointer in the target document.
+	// This allocates from the target document, so it must run on a single thread.
+	for (size_t i = 0; i < modified.size(); i++) {
+		InternalID   id  = modified[i];
+		const DomEl* src = GetChildByInternalID(id);
+		DomEl*       dst = c.GetChildByInternalIDMutable(id);
+		if (src && !dst) {
+			// create in destination
+			c.ChildByInternalID[id] = c.AllocChild(src->GetTag(), src->GetParentID());
+		} else if (!src && dst) {
+			// destroy destination. Make it forget its children, because this loop takes care of all elements.
+			dst->ForgetChildren();
+			c.FreeChild(dst);
+			c.ChildByInternalID[id] = nullptr;
 		}
 	}
 
-	// Pass 2: Clone the contents of all our modified objects into our target
-	for (size_t i = 0; i < ChildIsModified.size(); i++) {
-		if (ChildIsModified[i]) {
-			const DomEl* src = GetChildByInternalID((xo::InternalID) i);
-			DomEl*       dst = c.GetChildByInternalIDMutable((xo::InternalID) i);
+	// Pass 2: Clone the contents of all our modified objects into our target.
+	// Every element only writes to its own copy, so this is safe to spread over the worker threads.
+	auto cloneRange = [this, &c, &modified, cloneFlags](size_t first, size_t last) {
+		for (size_t i = first; i < last; i++) {
+			const DomEl* src = GetChildByInternalID(modified[i]);
+			DomEl*       dst = c.GetChildByInternalIDMutable(modified[i]);
 			if (src)
 				src->CloneSlowInto(*dst, cloneFlags);
 		}
+	};
+	if (modified.size() >= ParallelCloneThreshold)
+		Global()->Scheduler.ParallelFor(0, modified.size(), ParallelCloneChunk, cloneRange);
+	else
+		cloneRange(0, modified.size());
+
+	// The renderer expands style variables inside its copy of the classes, so a change to any variable
+	// means that every class must be copied again, in its original form.
+	bool   varsModified = StyleVariables.AnyModified();
+	size_t numClasses   = 0;
+	if (varsModified)
+		ClassStyles.CloneSlowInto(c.ClassStyles);
+	else
+		numClasses = ClassStyles.CloneModifiedInto(c.ClassStyles);
+	stats.Clone_NumClasses += (uint32_t) (varsModified ? ClassStyles.Size() : numClasses);
+
+	// Tag styles are public, so we have no modified bits for them. There are only a handful, so compare them instead.
+	bool tagsModified = false;
+	for (size_t i = 0; i < TagEND; i++) {
+		if (!TagStyles[i].Equals(c.TagStyles[i])) {
+			TagStyles[i].CloneSlowInto(c.TagStyles[i]);
+			tagsModified = true;
+		}
 	}
 
-	ClassStyles.CloneSlowInto(c.ClassStyles);
-	CloneStaticArrayWithCloneSlowInto(c.TagStyles, TagStyles);
+	if (varsModified || numClasses != 0 || tagsModified)
+		c.StyleVersion++;
 
 	c.StyleVariables.CloneFrom_Incremental(StyleVariables);
 	c.Strings.CloneFrom_Incremental(Strings);
@@ -95,6 +120,9 @@ void Doc::CloneSlowInto(Doc& c, uint32_t cloneFlags, RenderStats& stats) const {
 	c.Images.CloneMetadataFrom(Images);
 	c.VectorIcons.CloneFrom_Incremental(VectorIcons);
 
+	// There are seldom more than a handful of these, so there is no point in tracking modifications
+	c.Animations = Animations;
+
 	c.Version = Version;
 
 	UI.CloneSlowInto(c.UI);
@@ -104,6 +132,19 @@ InternalID Doc::InternalIDSize() const {
 	return (InternalID) ChildByInternalID.size();
 }
 
+uint64_t Doc::ComputeStyleHash(uint64_t seed) const {
+	uint64_t h = ClassStyles.ComputeHash(seed);
+	for (size_t i = 0; i < TagEND; i++)
+		h = TagStyles[i].ComputeHash(h);
+	return StyleVariables.ComputeHash(h);
+}
+
+uint64_t Doc::StyleFingerprint() const {
+	if (IsReadOnly)
+		return StyleVersion;
+	return ComputeStyleHash(0);
+}
+
 void Doc::TouchedByOtherThread() {
 	Group->TouchedByOtherThread();
 }
@@ -118,20 +159,20 @@ bool Doc::ClassParse(const char* klass, const char* style, size_t styleMaxLen) {
 		pseudo                    = colon + 1;
 		klass                     = tmpKlass.CStr();
 	}
-	StyleClass* s      = ClassStyles.GetOrCreate(klass);
-	Style*      subset = nullptr;
+	StyleClass*         s      = ClassStyles.GetOrCreate(klass);
+	StyleClass::Pseudos subset = StyleClass::PseudoDefault;
 	if (pseudo.Length() == 0) {
-		subset = &s->Default;
+		subset = StyleClass::PseudoDefault;
 	} else if (pseudo == "hover") {
-		subset = &s->Hover;
+		subset = StyleClass::PseudoHover;
 	} else if (pseudo == "focus") {
-		subset = &s->Focus;
+		subset = StyleClass::PseudoFocus;
 	} else if (pseudo == "capture") {
-		subset = &s->Capture;
+		subset = StyleClass::PseudoCapture;
 	} else {
 		return false;
 	}
-	return subset->Parse(style, styleMaxLen, this);
+	return s->Parse(subset, style, styleMaxLen, this);
 }
 
 bool Doc::HasClass(const char* klass) const {
@@ -255,6 +296,27 @@ void Doc::DocProcessHandlers(cheapvec<NodeEventIDPair>& handlers) {
 	}
 }
 
+void Doc::Animate(const Animation& anim) {
+	IncVersion();
+	for (size_t i = 0; i < Animations.size(); i++) {
+		if (Animations[i].Node == anim.Node && Animations[i].Property == anim.Property) {
+			Animations[i] = anim;
+			return;
+		}
+	}
+	Animations += anim;
+}
+
+void Doc::StopAnimation(InternalID node, AnimProperties prop) {
+	for (size_t i = 0; i < Animations.size(); i++) {
+		if (Animations[i].Node == node && Animations[i].Property == prop) {
+			Animations.erase(i);
+			IncVersion();
+			return;
+		}
+	}
+}
+
 void Doc::ChildAdded(DomEl* el) {
 	XO_ASSERT(el->GetDoc() == this);
 	XO_ASSERT(el->GetInternalID() == 0);
@@ -288,6 +350,10 @@ void Doc::ChildRemoved(DomEl* el) {
 			NodeLostTimer(elID);
 		if (node->HandlesEvent(EventRender))
 			NodeLostRender(elID);
+		for (size_t i = Animations.size() - 1; i != -1; i--) {
+			if (Animations[i].Node == elID)
+				Animations.erase(i);
+		}
 	}
 	IncVersion();
 	SetChildModified(elID);
@@ -299,10 +365,7 @@ void Doc::ChildRemoved(DomEl* el) {
 }
 
 void Doc::SetChildModified(InternalID id) {
-	size_t index = id;
-	while (ChildIsModified.size() <= index)
-		ChildIsModified.push_back(false);
-	ChildIsModified[index] = true;
+	ChildIsModified.Set(id);
 	IncVersion();
 }
 
@@ -318,9 +381,10 @@ void Doc::Reset() {
 	IncVersion();
 	Pool.FreeAll();
 	Root.SetInternalID(InternalIDNull); // Root will be assigned InternalIDRoot when we call ChildAdded() on it.
-	ChildIsModified.clear();
+	ChildIsModified.Clear();
 	ResetInternalIDs();
 	NodesWithTimers.clear();
+	Animations.clear();
 }
 
 void Doc::ResetInternalIDs() {
@@ -371,5 +435,6 @@ void Doc::InitializeDefaultControls() {
 	controls::EditBox::InitializeStyles(this);
 	controls::Button::InitializeStyles(this);
 	controls::MsgBox::InitializeStyles(this);
+	controls::VirtualList::InitializeStyles(this);
 }
 } // namespace xo
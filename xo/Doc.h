@@ -5,6 +5,7 @@
 #include "Containers/StringTable.h"
 #include "Containers/StringTableGC.h"
 #include "Containers/VariableTable.h"
+#include "Containers/DirtyBitmap.h"
 #include "Image/ImageStore.h"
 #include "DocUI.h"
 
@@ -27,6 +28,14 @@ produce incorrect behaviour. A safer alternative would be to only recycle IDs on
 around 2^32. That would force more complicated code on us, because we could no longer use a
 simple lookup table for ID -> Object. I guess time will tell if this is a problem.
 
+Render Clone
+------------
+The renderer works on its own read-only Doc, which CloneSlowInto keeps up to date, while
+DocGroup holds DocLock. Only the elements and style classes that were modified since the last
+sync are copied, and tag styles are copied only if they differ. This is an incremental copy,
+not a snapshot that shares structure with us: our elements are mutable, and they refer to
+each other by raw pointer, so the renderer can't hold on to them while the UI thread runs.
+
 */
 class XO_API Doc {
 	XO_DISALLOW_COPY_AND_ASSIGN(Doc);
@@ -47,8 +56,10 @@ public:
 	uint32_t   GetVersion() { return Version; }                                      // Renderers use purposefully loose thread semantics on this. Valgrind will be unhappy with this.
 	void       ResetModifiedBitmap();                                                // Reset the 'is modified' bitmap of all DOM elements and other things, such as the variable table.
 	void       MakeFreeIDsUsable();                                                  // All of our dependent renderers have been updated, we can move FreeIDs over to UsableIDs.
-	void       CloneSlowInto(Doc& c, uint32_t cloneFlags, RenderStats& stats) const; // Used to make a read-only clone for the renderer. Preserves existing.
+	void       CloneSlowInto(Doc& c, uint32_t cloneFlags, RenderStats& stats) const; // Used to make a read-only clone for the renderer. Preserves existing, and copies only what has been modified.
 	InternalID InternalIDSize() const;                                               // Returns the size of the InternalID table
+	uint64_t   ComputeStyleHash(uint64_t seed) const;                                // Hash of class styles, tag styles and style variables
+	uint64_t   StyleFingerprint() const;                                             // Changes whenever class styles, tag styles or style variables change. Cheap on a read-only clone.
 	DocGroup*  GetDocGroup() const { return Group; }
 	void       TouchedByOtherThread(); // TouchedByOtherThread is documented inside DocGroup
 
@@ -92,6 +103,11 @@ public:
 	void   DocProcessHandlers(cheapvec<NodeEventIDPair>& handlers);
 	size_t AnyDocProcessHandlers() const { return NodesWithDocProcess.size() != 0; }
 
+	// Animations that are evaluated by the renderer. See Animation.h.
+	void                       Animate(const Animation& anim); // Replaces any animation of the same property of the same node
+	void                       StopAnimation(InternalID node, AnimProperties prop);
+	const cheapvec<Animation>& GetAnimations() const { return Animations; }
+
 	//void				ChildAddedFromDocumentClone( DomEl* el );
 	void           ChildAdded(DomEl* el);
 	void           ChildRemoved(DomEl* el);
@@ -103,23 +119,35 @@ public:
 	DomEl*         GetChildByInternalIDMutable(InternalID id) { return ChildByInternalID[id]; }
 	DomNode*       GetNodeByInternalIDMutable(InternalID id) { return ChildByInternalID[id] ? ChildByInternalID[id]->ToNode() : nullptr; }
 
+	// IDs of elements deleted since the last render sync. These are not reused until MakeFreeIDsUsable.
+	const cheapvec<InternalID>& GetFreeIDs() const { return FreeIDs; }
+
+	// Elements that have been added, modified or deleted since the last render sync
+	const DirtyBitmap& GetModifiedBitmap() const { return ChildIsModified; }
+
 protected:
 	volatile uint32_t      Version;
-	xo::Pool               Pool;       // Used only when making a clone via CloneFast()
-	bool                   IsReadOnly; // Read-only clone used for rendering
+	xo::Pool               Pool;             // Used only when making a clone via CloneFast()
+	bool                   IsReadOnly;       // Read-only clone used for rendering
+	uint32_t               StyleVersion = 0; // Incremented by CloneSlowInto whenever styles are copied into this clone
 	cheapvec<DomEl*>       ChildByInternalID;
-	cheapvec<bool>         ChildIsModified; // Bit is set if child has been modified since we last synced with the renderer -- TODO - change to proper bitmap
+	DirtyBitmap            ChildIsModified; // Bit is set if child has been modified since we last synced with the renderer
 	cheapvec<InternalID>   UsableIDs;       // When we do a render sync, then FreeIDs are moved into UsableIDs
 	cheapvec<InternalID>   FreeIDs;
 	ohash::set<InternalID> NodesWithTimers;     // Set of all nodes that have an OnTimer event handler registered
 	ohash::set<InternalID> NodesWithRender;     // Set of all nodes that have an OnRender event handler registered
 	ohash::set<InternalID> NodesWithDocProcess; // Set of all nodes that have an OnDocProcess event handler registered
+	cheapvec<Animation>    Animations;
 	VariableTable          StyleVariables;
 	StringTableGC          StyleVerbatimStrings; // Table of all the verbatim style strings that contain variable references
 	VariableTable          VectorIcons;          // SVG Icons. Abuse VariableTable... VariableTable might need a rename or a slight refactor!
 
+	static const size_t ParallelCloneThreshold = 4096; // Below this number of modified elements, a single thread is faster
+	static const size_t ParallelCloneChunk     = 512;  // Grain of the parallel clone
+
 	void ResetInternalIDs();
 	void InitializeDefaultTagStyles();
 	void InitializeDefaultControls();
+
 };
 } // namespace xo
@@ -51,7 +51,7 @@ RenderResult DocGroup::RenderToImage(Image& image) {
 	// The 10 here is an arbitrary thumbsuck. We'll see if we ever need a controllable limit.
 	const int    maxAttempts = 10;
 	RenderResult res         = RenderResultNeedMore;
-	for (int attempt = 0; res == RenderResultNeedMore && attempt < maxAttempts; attempt++)
+	for (int attempt = 0; (res == RenderResultNeedMore || IsStreamingImages()) && attempt < maxAttempts; attempt++)
 		res = RenderInternal(&image);
 	return res;
 }
@@ -72,17 +72,23 @@ RenderResult DocGroup::RenderInternal(Image* targetImage) {
 	bool wndDirty = Wnd->GetInvalidateRect().IsAreaPositive();
 	bool haveLock = false;
 
+	Profiler.BeginFrame();
+
 	// If docAge = 0, then we do not need to make a new copy of Doc.
 	// We merely need to run animations, or repaint our window.
 	bool docModified = DocAge() >= 1;
 
+	// Images that did not fit into the previous frame's upload budget are still waiting in Doc
+	bool imageBacklog = TextureStreamer.HasBacklog();
+
 	// I'm not quite sure how we should handle this. The idea is that you don't want to go without a UI update
 	// for too long, even if the UI thread is taking its time, and being bombarded with messages.
-	if (docModified || targetImage != NULL) {
+	if (docModified || imageBacklog || targetImage != NULL) {
 		// If UI thread has performed even a single update since we last rendered, then pause our thread until we can gain the DocLock
-		auto tstart = TimeAccurateSeconds();
+		Profiler.BeginPhase(ProfileDocLockWait);
 		DocLock.lock();
-		auto time = TimeAccurateSeconds() - tstart;
+		Profiler.EndPhase(ProfileDocLockWait);
+		double time = Profiler.Current().PhaseTime[ProfileDocLockWait];
 		if (time > 0.001)
 			TimeTrace("DocGroup.RenderInternal took %d ms to acquire DocLock\n", (int) (time * 1000));
 		haveLock = true;
@@ -91,25 +97,38 @@ RenderResult DocGroup::RenderInternal(Image* targetImage) {
 	bool docValid    = Doc->UI.GetViewportWidth() != 0 && Doc->UI.GetViewportHeight() != 0;
 	bool beganRender = false;
 
-	double timeCopyDoc = 0;
-
 	if (haveLock) {
-		UploadImagesToGPU(beganRender);
+		Profiler.BeginPhase(ProfileUploadImages);
+		StageImages(beganRender);
+		Profiler.EndPhase(ProfileUploadImages);
 
 		//Trace( "Render Version %u\n", Doc->GetVersion() );
-		CodeTimer t;
+		Profiler.BeginPhase(ProfileCopyDoc);
 		RenderDoc->CopyFromCanonical(*Doc, RenderStats);
 
 		// Assume we are the only renderer of 'Doc'. If this assumption were not true, then you would need to update
 		// all renderers simultaneously, so that you can guarantee that UsableIDs all go to FreeIDs atomically.
 		//Trace( "MakeFreeIDsUsable\n" );
 		Doc->MakeFreeIDsUsable();
-		Doc->ResetModifiedBitmap(); // AbcBitMap has an absolutely awful implementation of this (uint8_t-filled vs SSE or at least pointer-word-size-filled)
-		timeCopyDoc = t.Measure();
+		Doc->ResetModifiedBitmap();
+		Profiler.EndPhase(ProfileCopyDoc);
 
 		DocLock.unlock();
 	}
 
+	// The staged texels go to the GPU after DocLock is released, so that the UI thread is not held up by them
+	RenderStats.Render_ImageBytes = 0;
+	if (beganRender) {
+		Profiler.BeginPhase(ProfileStreamImages);
+		RenderStats.Render_ImageBytes = TextureStreamer.Upload(Wnd->Renderer);
+		Profiler.EndPhase(ProfileStreamImages);
+
+		// Rows that arrive in a later frame than the change that invalidated them are not seen by
+		// damage tracking, which only compares layouts, so the whole window must be repainted.
+		if (imageBacklog)
+			RenderDoc->Damage.Reset();
+	}
+
 	RenderResult rendResult   = RenderResultDone;
 	bool         presentFrame = false;
 
@@ -117,12 +136,13 @@ RenderResult DocGroup::RenderInternal(Image* targetImage) {
 		//TimeTrace( "Render start\n" );
 		if (!beganRender && !Wnd->BeginRender()) {
 			TimeTrace("BeginRender failed\n");
+			Profiler.EndFrame();
 			return RenderResultNeedMore;
 		}
 		beganRender = true;
 
 		//TimeTrace( "Render DO\n" );
-		rendResult = RenderDoc->Render(Wnd->Renderer);
+		rendResult = RenderDoc->Render(Wnd->Renderer, RenderStats, Profiler, Wnd->GetInvalidateRect());
 
 		presentFrame = true;
 
@@ -133,7 +153,9 @@ RenderResult DocGroup::RenderInternal(Image* targetImage) {
 	if (beganRender) {
 		// presentFrame will be false when the only action we've taken on the GPU is uploading textures.
 		//TimeTrace( "Render Finish\n" );
+		Profiler.BeginPhase(ProfileSwap);
 		Wnd->EndRender(presentFrame ? 0 : EndRenderNoSwap);
+		Profiler.EndPhase(ProfileSwap);
 	}
 
 	// If anybody is listening, queue a "post render" event
@@ -148,14 +170,21 @@ RenderResult DocGroup::RenderInternal(Image* targetImage) {
 		DocLock.unlock();
 	}
 
-	if (Global()->ShowCoarseTimes)
-		xo::Trace("Copy: %.1f, Bake: %.1f, Layout: %.1f, Render: %.1f, PostRender: %.1f\n",
-		          timeCopyDoc * 1000, RenderDoc->TimeVariableBake * 1000, RenderDoc->TimeLayout * 1000, RenderDoc->TimeRender * 1000, RenderDoc->TimePostRender * 1000);
+	Profiler.EndFrame();
+
+	if (Global()->ShowCoarseTimes) {
+		FrameRecord f;
+		if (Profiler.GetLastFrame(f))
+			xo::Trace("Copy: %.1f, Bake: %.1f, Layout: %.1f, Render: %.1f, PostRender: %.1f, Swap: %.1f, DrawCalls: %d, RepaintArea: %d\n",
+			          f.PhaseTime[ProfileCopyDoc] * 1000, f.PhaseTime[ProfileVariableBake] * 1000, f.PhaseTime[ProfileLayout] * 1000, f.PhaseTime[ProfileRender] * 1000,
+			          f.PhaseTime[ProfilePostRender] * 1000, f.PhaseTime[ProfileSwap] * 1000, (int) RenderStats.Render_NumDrawCalls, (int) RenderStats.Render_RepaintArea);
+	}
 
 	return rendResult;
 }
 
-void DocGroup::UploadImagesToGPU(bool& beganRender) {
+// This runs under DocLock. It only copies the invalid texels out of Doc, and the upload happens later.
+void DocGroup::StageImages(bool& beganRender) {
 	beganRender                    = false;
 	cheapvec<Image*> invalidImages = Doc->Images.InvalidList();
 	if (invalidImages.size() != 0) {
@@ -163,14 +192,7 @@ void DocGroup::UploadImagesToGPU(bool& beganRender) {
 			return;
 
 		beganRender = true;
-
-		for (size_t i = 0; i < invalidImages.size(); i++) {
-			if (Wnd->Renderer->LoadTexture(invalidImages[i], 0)) {
-				invalidImages[i]->ClearInvalidRect();
-			} else {
-				XOTRACE_WARNING("Failed to upload image to GPU\n");
-			}
-		}
+		TextureStreamer.Stage(Wnd->Renderer, invalidImages);
 	}
 }
 
@@ -178,37 +200,20 @@ uint32_t DocGroup::DocAge() const {
 	return Doc->GetVersion() - RenderDoc->Doc.GetVersion();
 }
 
-struct AddOrReplaceMessage_Context {
-	const OriginalEvent* NewEvent;
-	bool                 DidReplace;
-};
-
-static bool AddOrReplaceMessage_Scan(void* context, OriginalEvent* iter) {
-	AddOrReplaceMessage_Context* cx = (AddOrReplaceMessage_Context*) context;
-	if (iter->DocGroup == cx->NewEvent->DocGroup && iter->Event.Type == cx->NewEvent->Event.Type) {
-		// TODO: Keep a history of the replaced events, so that a program that needs to have
-		// smooth cursor input can use all of the events that were sent by the OS. To do this, we'll
-		// want to store time of events, as well as extend Event to be able to store a chain of
-		// missed events that came before it.
-		cx->DidReplace = true;
-		*iter          = *cx->NewEvent;
-		return false;
-	}
-	return true;
-}
-
 // Why do we do this? Normally the OS does this for us - it coalesces mouse move messages into
 // a single message, when we ask for it. However, because our message polling loop runs on a different
 // thread to our 'program' thread, we can consume mouse move messages faster than the 'program'
 // can process them. By 'program' here, we mean the DOM event handlers that run from our UI thread.
-// Because of this, we can end up with a massive backlog of messages to process. Right now
-// all we do is replace old events from the queue, but in future.. see the TODO message above.
+// Because of this, we can end up with a massive backlog of messages to process. The queue merges
+// them in constant time, and the replaced events are kept in the history of the event that is
+// finally dispatched (Event.Coalesced), so that a program that needs smooth input can use all
+// of the points that were sent by the OS.
 void DocGroup::AddOrReplaceMessage(const OriginalEvent& ev) {
-	AddOrReplaceMessage_Context cx = {&ev, false};
-	Global()->UIEventQueue.Scan(false, &cx, &AddOrReplaceMessage_Scan);
-	if (!cx.DidReplace) {
-		Global()->UIEventQueue.Add(ev);
-	}
+	Global()->UIEventQueue.AddOrReplace(ev, ev.DocGroup->EventSlots);
+}
+
+void DocGroup::AddMessage(const OriginalEvent& ev) {
+	Global()->UIEventQueue.Add(ev, &ev.DocGroup->EventSlots);
 }
 
 // This function is called from the one and only UIThread, inside Defs.cpp
@@ -255,7 +260,20 @@ void DocGroup::ProcessEvent(Event& ev) {
 }
 
 bool DocGroup::IsDirty() const {
-	return IsDocVersionDifferentToRenderer() || Wnd->GetInvalidateRect().IsAreaPositive();
+	return IsDocVersionDifferentToRenderer() || Wnd->GetInvalidateRect().IsAreaPositive() || IsAnimating() || IsStreamingImages();
+}
+
+bool DocGroup::IsAnimating() const {
+	double next = RenderDoc->Animator.NextChange;
+	return RenderDoc->Animator.IsAnimating || (next != 0 && TimeAccurateSeconds() >= next);
+}
+
+double DocGroup::NextAnimationChange() const {
+	return RenderDoc->Animator.NextChange;
+}
+
+bool DocGroup::IsStreamingImages() const {
+	return TextureStreamer.HasBacklog();
 }
 
 bool DocGroup::IsDocVersionDifferentToRenderer() const {
@@ -1,6 +1,8 @@
 #pragma once
 #include "Defs.h"
 #include "Event.h"
+#include "FrameProfiler.h"
+#include "Render/TextureStreamer.h"
 
 namespace xo {
 
@@ -16,6 +18,7 @@ public:
 	xo::RenderDoc*  RenderDoc           = nullptr; // Copy of Canonical Document, as well as rendered state of document
 	bool            DestroyDocWithGroup = false;
 	xo::RenderStats RenderStats;
+	FrameProfiler   Profiler;
 
 	static DocGroup* New(); // Create a new platform-specific DocGroup object
 
@@ -29,6 +32,9 @@ public:
 
 	bool IsDirty() const;
 	bool IsDocVersionDifferentToRenderer() const;
+	bool   IsAnimating() const;         // True if the renderer must produce a frame, because animations are running, or a stepped animation is due to change
+	double NextAnimationChange() const; // Time at which a stepped animation changes next, or zero if there is none. The message loop must wake up by then.
+	bool   IsStreamingImages() const;   // True if the renderer must keep producing frames, because modified images exceeded the upload budget
 
 	// This is called by rx::Control when it receives an ObservableTouched() callback from a thread that is not our UI thread.
 	// This is a paradigm that gets used whenever there are threads doing background work, and there are UI components
@@ -45,16 +51,24 @@ public:
 	// the necessary event handler, and then re-render the world if necessary.
 	void TouchedByOtherThread();
 
+	// Add an event to the UI queue, merging it into any undispatched event of the same type for the same DocGroup.
+	// This is used for events like mouse moves, where the UI thread only needs the latest state.
+	static void AddOrReplaceMessage(const OriginalEvent& ev);
+
+	// Add an event to the UI queue. Events that are added to ev.DocGroup after this one will not be merged
+	// into any that were added before it, so that, for example, a mouse move is never dispatched ahead of a mouse up.
+	static void AddMessage(const OriginalEvent& ev);
+
 protected:
-	std::mutex        DocLock; // Mutation of 'Doc', or cloning of 'Doc' for the renderer
-	std::atomic<bool> IsTouchedByOtherThread;
+	std::mutex          DocLock; // Mutation of 'Doc', or cloning of 'Doc' for the renderer
+	std::atomic<bool>   IsTouchedByOtherThread;
+	xo::TextureStreamer TextureStreamer; // Moves modified images to the GPU
+	EventQueue::Slots   EventSlots;      // Coalescing state of our events inside Global()->UIEventQueue
 
 	virtual void InternalTouchedByOtherThread() = 0;
 
 	RenderResult RenderInternal(Image* targetImage);
-	void         UploadImagesToGPU(bool& beganRender);
+	void         StageImages(bool& beganRender);
 	uint32_t     DocAge() const;
-
-	static void AddOrReplaceMessage(const OriginalEvent& ev);
 };
 } // namespace xo
@@ -47,6 +47,7 @@ violating any thread model principle here.
 enum XoWindowsTimers {
 	XoWindowsTimerRenderOutsideMainMsgPump = 1, // Used to force repaint events when window is being sized
 	XoWindowsTimerGenericEvent             = 2, // A user event, such as when you bind to DomNode.OnTimer
+	XoWindowsTimerAnimation                = 3, // Wakes up the message loop when a stepped animation, such as a blinking caret, changes
 };
 
 static Button WM_MouseButtonToXo(UINT message, WPARAM wParam) {
@@ -195,6 +196,15 @@ void DocGroupWindows::SetSysWndTimer(uint32_t periodMS) {
 	}
 }
 
+void DocGroupWindows::SetAnimationTimer(double at) {
+	if (at == 0) {
+		KillTimer(GetHWND(), XoWindowsTimerAnimation);
+		return;
+	}
+	double delay = Max(at - TimeAccurateSeconds(), 0.0);
+	SetTimer(GetHWND(), XoWindowsTimerAnimation, (uint32_t) ceil(delay * 1000), nullptr);
+}
+
 HWND DocGroupWindows::GetHWND() {
 	return ((SysWndWindows*) Wnd)->Wnd;
 }
@@ -227,7 +237,7 @@ LRESULT DocGroupWindows::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM
 
 	case WM_SIZE:
 		ev.Event.MakeWindowSize(int(lParam & 0xffff), int((lParam >> 16) & 0xffff));
-		Global()->UIEventQueue.Add(ev);
+		DocGroup::AddMessage(ev);
 		break;
 
 	case WM_TIMER:
@@ -236,6 +246,9 @@ LRESULT DocGroupWindows::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM
 		} else if (wParam == XoWindowsTimerGenericEvent) {
 			ev.Event.Type = EventTimer;
 			AddOrReplaceMessage(ev);
+		} else if (wParam == XoWindowsTimerAnimation) {
+			// Waking up is all that we need. RunMessageLoop will see that the animation is due, and render.
+			KillTimer(hWnd, XoWindowsTimerAnimation);
 		}
 		break;
 
@@ -304,7 +317,7 @@ LRESULT DocGroupWindows::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM
 		IsTouchedByOtherThread = false;
 		ev.Event.Type = EventDocProcess;
 		ev.Event.DocProcess = DocProcessEvents::TouchedByBackgroundThread;
-		Global()->UIEventQueue.Add(ev);
+		DocGroup::AddMessage(ev);
 		break;
 
 	case WM_MOUSEMOVE:
@@ -332,7 +345,7 @@ LRESULT DocGroupWindows::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM
 		ev.Event.Type         = EventMouseLeave;
 		ev.Event.PointCount   = 1;
 		ev.Event.PointsAbs[0] = cursor;
-		Global()->UIEventQueue.Add(ev);
+		DocGroup::AddMessage(ev);
 		break;
 
 	case WM_LBUTTONDOWN:
@@ -345,7 +358,7 @@ LRESULT DocGroupWindows::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM
 		ev.Event.PointCount   = 1;
 		ev.Event.PointsAbs[0] = cursor;
 		PopulateModifierKeyStates(ev.Event);
-		Global()->UIEventQueue.Add(ev);
+		DocGroup::AddMessage(ev);
 		break;
 
 	case WM_LBUTTONUP:
@@ -358,7 +371,7 @@ LRESULT DocGroupWindows::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM
 		ev.Event.PointCount   = 1;
 		ev.Event.PointsAbs[0] = cursor;
 		PopulateModifierKeyStates(ev.Event);
-		Global()->UIEventQueue.Add(ev);
+		DocGroup::AddMessage(ev);
 		break;
 
 	case WM_LBUTTONDBLCLK:
@@ -371,7 +384,7 @@ LRESULT DocGroupWindows::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM
 		ev.Event.PointCount   = 1;
 		ev.Event.PointsAbs[0] = cursor;
 		PopulateModifierKeyStates(ev.Event);
-		Global()->UIEventQueue.Add(ev);
+		DocGroup::AddMessage(ev);
 		break;
 
 	case WM_KEYDOWN:
@@ -379,7 +392,7 @@ LRESULT DocGroupWindows::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM
 		ev.Event.Type = EventKeyDown;
 		WM_KeyButtonToXo(wParam, lParam, ev.Event.Button, ev.Event.KeyChar);
 		PopulateModifierKeyStates(ev.Event);
-		Global()->UIEventQueue.Add(ev);
+		DocGroup::AddMessage(ev);
 		// Also add an EventKeyChar message, so that one doesn't need to deal with two messages
 		// that distinguish between arbitrary different keys. For example, why does BACKSPACE
 		// generate a WM_CHAR, but VK_DELETE only generates WM_KEYDOWN? That seems pretty arbitrary.
@@ -402,7 +415,7 @@ LRESULT DocGroupWindows::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM
 		ev.Event.Type = EventKeyUp;
 		WM_KeyButtonToXo(wParam, lParam, ev.Event.Button, ev.Event.KeyChar);
 		PopulateModifierKeyStates(ev.Event);
-		Global()->UIEventQueue.Add(ev);
+		DocGroup::AddMessage(ev);
 		break;
 
 	// Although the docs for WM_UNICHAR seem ideal for us (an ANSI window), WM_UNICHAR messages
@@ -427,7 +440,7 @@ LRESULT DocGroupWindows::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM
 			ev.Event.Type    = EventKeyChar;
 			ev.Event.KeyChar = (int32_t) wParam;
 			PopulateModifierKeyStates(ev.Event);
-			Global()->UIEventQueue.Add(ev);
+			DocGroup::AddMessage(ev);
 		}
 		return 0;
 
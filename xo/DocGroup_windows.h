@@ -14,6 +14,7 @@ public:
 	static LRESULT CALLBACK StaticWndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
 	LRESULT                 WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
 	void                    SetSysWndTimer(uint32_t periodMS);
+	void                    SetAnimationTimer(double at); // Wake up the message loop at time 'at', so that it renders the next step of an animation. Zero cancels.
 	HWND                    GetHWND();
 
 protected:
@@ -117,6 +117,16 @@ void DocUI::CloneSlowInto(DocUI& c) const {
 	c.Cursor           = Cursor;
 }
 
+void DocUI::GetPseudoClassIDs(cheapvec<InternalID>& ids) const {
+	ids.clear();
+	for (auto id : HoverSet)
+		ids += id;
+	if (CurrentFocusID != InternalIDNull)
+		ids += CurrentFocusID;
+	if (CurrentCaptureID != InternalIDNull)
+		ids += CurrentCaptureID;
+}
+
 void DocUI::DispatchDocProcess() {
 	cheapvec<NodeEventIDPair> handlers;
 	Doc->DocProcessHandlers(handlers);
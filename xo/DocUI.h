@@ -37,6 +37,7 @@ public:
 	bool    IsFocused(InternalID id) const { return CurrentFocusID == id; }
 	bool    IsCaptured(InternalID id) const { return CurrentCaptureID == id; }
 	Cursors GetCursor() const { return Cursor; }
+	void    GetPseudoClassIDs(cheapvec<InternalID>& ids) const; // Elements whose style is affected by :hover, :focus or :capture. May contain duplicates.
 
 	// Capture input, so that all UI events are dispatched only to this node, until ReleaseCapture is called.
 	void SetCapture(InternalID id);
@@ -115,6 +115,37 @@ void DomNode::DeleteChild(DomEl* c) {
 	DeleteChildInternal(c);
 }
 
+// Replace the children in [first, last) with 'children', in a single pass. Every element of 'children'
+// must already be one of our children, either inside that range, or after it (such as an element that
+// was just appended). Children inside the range that are not in 'children' are deleted.
+void DomNode::ReplaceChildren(size_t first, size_t last, const cheapvec<DomEl*>& children) {
+	XO_ASSERT(first <= last && last <= Children.size());
+	IncVersion();
+	ohash::set<xo::InternalID> keep;
+	for (auto c : children)
+		keep.insert(c->GetInternalID());
+
+	cheapvec<DomEl*> all;
+	cheapvec<DomEl*> dead;
+	all.reserve(Children.size());
+	for (size_t i = 0; i < first; i++)
+		all += Children[i];
+	for (size_t i = first; i < last; i++) {
+		if (!keep.contains(Children[i]->GetInternalID()))
+			dead += Children[i];
+	}
+	for (auto c : children)
+		all += c;
+	for (size_t i = last; i < Children.size(); i++) {
+		if (!keep.contains(Children[i]->GetInternalID()))
+			all += Children[i];
+	}
+	Children = std::move(all);
+
+	for (auto c : dead)
+		DeleteChildInternal(c);
+}
+
 void DomNode::Clear() {
 	IncVersion();
 	for (size_t i = 0; i < Children.size(); i++)
@@ -210,6 +241,36 @@ void DomNode::HackSetStyle(StyleAttrib attrib) {
 	Style.Set(attrib);
 }
 
+void DomNode::AnimateColor(AnimProperties prop, Color from, Color to, float seconds, AnimEasings easing, uint8_t flags) {
+	Animation a;
+	a.Node      = InternalID;
+	a.Property  = prop;
+	a.Easing    = easing;
+	a.Flags     = flags;
+	a.Duration  = seconds;
+	a.Start     = TimeAccurateSeconds();
+	a.FromColor = from;
+	a.ToColor   = to;
+	Doc->Animate(a);
+}
+
+void DomNode::AnimateValue(AnimProperties prop, float from, float to, float seconds, AnimEasings easing, uint8_t flags) {
+	Animation a;
+	a.Node      = InternalID;
+	a.Property  = prop;
+	a.Easing    = easing;
+	a.Flags     = flags;
+	a.Duration  = seconds;
+	a.Start     = TimeAccurateSeconds();
+	a.FromValue = from;
+	a.ToValue   = to;
+	Doc->Animate(a);
+}
+
+void DomNode::StopAnimation(AnimProperties prop) {
+	Doc->StopAnimation(InternalID, prop);
+}
+
 void DomNode::AddClass(const char* classes) {
 	IncVersion();
 	size_t s = 0;
@@ -1,5 +1,6 @@
 #pragma once
 #include "DomEl.h"
+#include "../Animation.h"
 
 namespace xo {
 
@@ -9,6 +10,7 @@ Right now it's 136 bytes on Windows x64.
 */
 class XO_API DomNode : public DomEl {
 	XO_DISALLOW_COPY_AND_ASSIGN(DomNode);
+	friend class Animator;
 
 public:
 	DomNode(xo::Doc* doc, xo::Tag tag, xo::InternalID parentID);
@@ -40,6 +42,7 @@ public:
 	DomText*       AddText(const std::string& txt, size_t position = -1);
 	void           Delete(); // Remove from DOM, and delete self
 	void           DeleteChild(DomEl* c);
+	void           ReplaceChildren(size_t first, size_t last, const cheapvec<DomEl*>& children); // See comment in DomNode.cpp
 	void           Clear(); // Delete all children
 	size_t         ChildCount() const { return Children.size(); }
 	DomEl*         ChildByIndex(size_t index);
@@ -66,6 +69,12 @@ public:
 	void HackSetStyle(const Style& style);
 	void HackSetStyle(StyleAttrib attrib); // TODO: This is also "Hack" because it doesn't work for attribute such as background-image
 
+	// Animations run on the render thread, without modifying this node. See Animation.h.
+	// Starting an animation replaces any animation of the same property of this node.
+	void AnimateColor(AnimProperties prop, Color from, Color to, float seconds, AnimEasings easing = EaseLinear, uint8_t flags = 0);
+	void AnimateValue(AnimProperties prop, float from, float to, float seconds, AnimEasings easing = EaseLinear, uint8_t flags = 0);
+	void StopAnimation(AnimProperties prop);
+
 	// Classes
 	void AddClass(const char* classes); // Add one more space-separated classes
 	void RemoveClass(const char* klass);
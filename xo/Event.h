@@ -159,6 +159,14 @@ public:
 
 /* User interface event (keyboard, mouse, touch, etc).
 */
+// An earlier event that was merged into a newer event of the same type, because the UI thread
+// had fallen behind. See EventQueue.
+struct XO_API CoalescedEvent {
+	double TimeCreated;               // TimeAccurateSeconds() when the OS produced the event
+	int    PointCount;                // Same as Event.PointCount
+	Vec2f  PointsAbs[XO_MAX_TOUCHES]; // Same as Event.PointsAbs
+};
+
 class XO_API Event {
 public:
 	xo::Doc*                Doc          = nullptr;
@@ -177,6 +185,8 @@ public:
 	Vec2f                   PointsRel[XO_MAX_TOUCHES];           // Points relative to Target's content-box top-left
 	bool                    IsStopPropagationToggled = false;    // True if StopPropagation() has been called, and the event must not bubble out to enclosing DOM elements
 	bool                    IsCancelTimerToggled     = false;    // True if CancelTimer() has been called, in which case the timer will be cancelled
+	int                     CoalescedCount           = 0;        // Number of entries in Coalesced
+	const CoalescedEvent*   Coalesced                = nullptr;  // Events that were merged into this one, oldest first. Only valid during dispatch.
 
 	Event();
 	~Event();
@@ -191,8 +201,9 @@ public:
 // Because there is only one event queue, it needs to know the destination DocGroup.
 class XO_API OriginalEvent {
 public:
-	xo::DocGroup* DocGroup = nullptr;
+	xo::DocGroup* DocGroup    = nullptr;
 	xo::Event     Event;
+	double        TimeCreated = TimeAccurateSeconds(); // Used by FrameProfiler to measure how long the event waited in the queue
 };
 
 typedef std::function<void()>          EventHandlerLambda0; // 0 Parameters
@@ -0,0 +1,185 @@
+#include "pch.h"
+#include "EventQueue.h"
+#include "Event.h"
+
+namespace xo {
+
+struct EventQueue::Node {
+	std::atomic<Node*>     Next;
+	OriginalEvent          Ev;
+	std::atomic<Pending*>* Chain = nullptr; // If not null, then this node is a token for a coalescing slot, and Ev is unused
+};
+
+struct EventQueue::Pending {
+	OriginalEvent Ev;
+	Pending*      Older = nullptr;
+};
+
+static int BitIndex(uint32_t v) {
+	int i = 0;
+	while (v > 1) {
+		v >>= 1;
+		i++;
+	}
+	return i;
+}
+
+// The low bit of a link in a chain marks a seal, which is the boundary between two segments
+static bool IsSealed(EventQueue::Pending* p) {
+	return ((uintptr_t) p & 1) != 0;
+}
+
+static EventQueue::Pending* Sealed(EventQueue::Pending* p) {
+	return (EventQueue::Pending*) ((uintptr_t) p | 1);
+}
+
+static EventQueue::Pending* Unsealed(EventQueue::Pending* p) {
+	return (EventQueue::Pending*) ((uintptr_t) p & ~(uintptr_t) 1);
+}
+
+static void DeleteChain(EventQueue::Pending* p) {
+	p = Unsealed(p);
+	while (p != nullptr) {
+		EventQueue::Pending* older = Unsealed(p->Older);
+		delete p;
+		p = older;
+	}
+}
+
+EventQueue::Slots::Slots() {
+	for (int i = 0; i < NumSlots; i++)
+		Chains[i] = nullptr;
+}
+
+EventQueue::Slots::~Slots() {
+	for (int i = 0; i < NumSlots; i++)
+		DeleteChain(Chains[i].exchange(nullptr));
+}
+
+std::atomic<EventQueue::Pending*>* EventQueue::Slots::ForType(uint32_t eventType) {
+	return &Chains[BitIndex(eventType) % NumSlots];
+}
+
+EventQueue::EventQueue() {
+	Node* stub = new Node();
+	stub->Next = nullptr;
+	Head       = stub;
+	Tail       = stub;
+	Count      = 0;
+	History    = new CoalescedEvent[MaxHistory];
+}
+
+EventQueue::~EventQueue() {
+	while (Tail != nullptr) {
+		Node* next = Tail->Next;
+		if (next != nullptr && next->Chain != nullptr)
+			DeleteChain(next->Chain->exchange(nullptr));
+		delete Tail;
+		Tail = next;
+	}
+	delete[] History;
+}
+
+void EventQueue::Initialize(bool useSemaphore) {
+	UseSemaphore = useSemaphore;
+}
+
+void EventQueue::Push(Node* node) {
+	node->Next = nullptr;
+	Count++;
+	Node* prev = Head.exchange(node, std::memory_order_acq_rel);
+	// Until this store, the consumer cannot see 'node' or anything added after it
+	prev->Next.store(node, std::memory_order_release);
+	if (UseSemaphore)
+		Sem.signal();
+}
+
+void EventQueue::Add(const OriginalEvent& ev, Slots* slots) {
+	for (int i = 0; slots != nullptr && i < Slots::NumSlots; i++) {
+		std::atomic<Pending*>& chain = slots->Chains[i];
+		Pending*               head  = chain.load(std::memory_order_relaxed);
+		while (head != nullptr && !IsSealed(head)) {
+			if (chain.compare_exchange_weak(head, Sealed(head), std::memory_order_acq_rel, std::memory_order_relaxed))
+				break;
+		}
+	}
+	Node* node = new Node();
+	node->Ev   = ev;
+	Push(node);
+}
+
+void EventQueue::AddOrReplace(const OriginalEvent& ev, Slots& slots) {
+	std::atomic<Pending*>* chain = slots.ForType(ev.Event.Type);
+	Pending*               p     = new Pending();
+	p->Ev                        = ev;
+	Pending* older               = chain->load(std::memory_order_relaxed);
+	do {
+		p->Older = older;
+	} while (!chain->compare_exchange_weak(older, p, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+	// If there was already a chain, then its token is in the queue, and the consumer will find our event when it gets there
+	if (older == nullptr || IsSealed(older)) {
+		Node* token  = new Node();
+		token->Chain = chain;
+		Push(token);
+	}
+}
+
+bool EventQueue::PopTail(OriginalEvent& ev) {
+	Node* next = Tail->Next.load(std::memory_order_acquire);
+	if (next == nullptr) {
+		if (Head.load(std::memory_order_acquire) == Tail)
+			return false;
+		// A producer has swapped Head, but has not yet linked its node
+		while ((next = Tail->Next.load(std::memory_order_acquire)) == nullptr)
+			std::this_thread::yield();
+	}
+	delete Tail;
+	Tail = next;
+	Count--;
+
+	if (next->Chain == nullptr) {
+		ev = next->Ev;
+		return true;
+	}
+
+	// Only we ever take events out of a chain, and a token exists only while its segment is not empty
+	Pending* newest = TakeOldest(*next->Chain);
+	ev              = newest->Ev;
+
+	int n = 0;
+	for (Pending* p = newest->Older; p != nullptr && n < MaxHistory; p = p->Older, n++) {
+		CoalescedEvent& h = History[MaxHistory - 1 - n];
+		h.TimeCreated     = p->Ev.TimeCreated;
+		h.PointCount      = p->Ev.Event.PointCount;
+		for (int i = 0; i < XO_MAX_TOUCHES; i++)
+			h.PointsAbs[i] = p->Ev.Event.PointsAbs[i];
+	}
+	ev.Event.CoalescedCount = n;
+	ev.Event.Coalesced      = n != 0 ? History + MaxHistory - n : nullptr;
+	DeleteChain(newest);
+	return true;
+}
+
+// Detach the oldest segment of a chain, and return its newest event.
+// Producers only ever replace the head of a chain, so every link below the head is ours to modify.
+EventQueue::Pending* EventQueue::TakeOldest(std::atomic<Pending*>& chain) {
+	while (true) {
+		Pending* head     = chain.load(std::memory_order_acquire);
+		Pending* boundary = nullptr; // The node whose Older is the deepest seal, or null if the oldest segment begins at the head
+		XO_ASSERT(head != nullptr);
+		for (Pending* p = Unsealed(head); p->Older != nullptr; p = Unsealed(p->Older)) {
+			if (IsSealed(p->Older))
+				boundary = p;
+		}
+		if (boundary != nullptr) {
+			Pending* oldest = Unsealed(boundary->Older);
+			boundary->Older = nullptr;
+			return oldest;
+		}
+		// A producer may push onto the head while we look at it
+		if (chain.compare_exchange_strong(head, nullptr, std::memory_order_acq_rel, std::memory_order_acquire))
+			return Unsealed(head);
+	}
+}
+} // namespace xo
@@ -0,0 +1,83 @@
+#pragma once
+
+// This is included by Defs.h, so it may only refer to the event types by name.
+
+namespace xo {
+
+class OriginalEvent;
+struct CoalescedEvent;
+
+/* The process-wide queue of OS events, consumed by the one-and-only UI thread.
+
+Producers are the OS message threads, and occasionally the render thread. They never take a lock.
+The queue is Dmitry Vyukov's unbounded multi-producer single-consumer linked list: Add is a single
+atomic exchange on Head, followed by linking the previous node to the new one. The consumer owns
+Tail, and the node that it last popped stays behind as the list's stub. Nodes come from the heap.
+
+Coalescing
+----------
+AddOrReplace is for events such as mouse moves, where only the most recent state matters, but where
+the OS produces them faster than the UI thread can dispatch them. Every DocGroup owns a Slots object,
+with one slot per event type. A slot holds a chain of the events that have not been dispatched yet,
+newest first. A producer pushes its event onto the chain with a compare-and-swap, and only if the
+chain was empty does it also add a token to the queue. When the consumer reaches the token, it takes
+the whole chain, dispatches the newest event, and hands the older ones to the event's history
+(Event.Coalesced), so that a drawing program can still see every point the pointer passed through.
+The token holds the place in the queue of the first event of the chain, which is the same place that
+the old scan-and-replace approach left a coalesced event in.
+
+Events must not be coalesced across another event of their DocGroup, otherwise a move that followed
+a button release would be dispatched before the release. So when Add is given the Slots of the event's
+DocGroup, it seals every chain of those slots, by setting the low bit of the chain's head pointer.
+A sealed link divides a chain into segments. An event that is pushed onto a sealed head starts a new
+segment, with a token of its own, which lands in the queue behind the event that was added. Tokens are
+popped in order, so the consumer always detaches the oldest segment, which is at the far end of the chain.
+Producers never follow a link, so a sealed pointer is only ever dereferenced by the consumer.
+
+CAVEAT: As with Queue, when the semaphore is enabled, a consumer must wait on it once per PopTail.
+*/
+class XO_API EventQueue {
+public:
+	static const int MaxHistory = 64; // Older coalesced events than this are dropped
+
+	struct Pending;
+
+	// Coalescing state of one DocGroup
+	class XO_API Slots {
+	public:
+		static const int NumSlots = 32; // One for every bit of the Events enum
+
+		Slots();
+		~Slots();
+
+		std::atomic<Pending*>* ForType(uint32_t eventType);
+
+	private:
+		friend class EventQueue;
+		std::atomic<Pending*> Chains[NumSlots]; // Undispatched events, newest first
+	};
+
+	EventQueue();
+	~EventQueue();
+
+	void       Initialize(bool useSemaphore);
+	void       Add(const OriginalEvent& ev, Slots* slots = nullptr); // If 'slots' is given, later events in those slots do not coalesce with earlier ones
+	void       AddOrReplace(const OriginalEvent& ev, Slots& slots); // Merge 'ev' into any undispatched event of the same type, for the same DocGroup
+	bool       PopTail(OriginalEvent& ev);                          // Returns false if the queue is empty. ev.Event.Coalesced remains valid until the next PopTail.
+	int32_t    Size() const { return Count; }
+	Semaphore& SemObj() { return Sem; }
+
+private:
+	struct Node;
+
+	std::atomic<Node*>   Head;  // Most recently added node. Shared by all producers.
+	Node*                Tail;  // Most recently popped node, which is the stub. Owned by the consumer.
+	std::atomic<int32_t> Count; // Number of items that have been added, but not yet popped
+	Semaphore            Sem;
+	bool                 UseSemaphore = false;
+	CoalescedEvent*      History      = nullptr; // MaxHistory entries, owned by the consumer
+
+	void            Push(Node* node);
+	static Pending* TakeOldest(std::atomic<Pending*>& chain);
+};
+} // namespace xo
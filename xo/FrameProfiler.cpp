@@ -0,0 +1,262 @@
+#include "pch.h"
+#include "FrameProfiler.h"
+
+namespace xo {
+
+static const double BucketBase = 10e-6; // Top of the first histogram bucket
+
+XO_API const char* ProfilePhaseName(ProfilePhases phase) {
+	switch (phase) {
+	case ProfileFrame: return "Frame";
+	case ProfileDocLockWait: return "DocLockWait";
+	case ProfileUploadImages: return "UploadImages";
+	case ProfileCopyDoc: return "CopyDoc";
+	case ProfileStreamImages: return "StreamImages";
+	case ProfileVariableBake: return "VariableBake";
+	case ProfileLayout: return "Layout";
+	case ProfileStyleResolve: return "StyleResolve";
+	case ProfileLayoutRepass: return "LayoutRepass";
+	case ProfileRender: return "Render";
+	case ProfileTextureUpload: return "TextureUpload";
+	case ProfilePostRender: return "PostRender";
+	case ProfileSwap: return "Swap";
+	default: return "?";
+	}
+}
+
+void FrameProfiler::Histogram::Reset() {
+	for (int i = 0; i < NumBuckets; i++)
+		Buckets[i] = 0;
+	Count = 0;
+	Max   = 0;
+}
+
+void FrameProfiler::Histogram::Add(double seconds) {
+	Buckets[BucketOf(seconds)]++;
+	Count++;
+	float max = Max.load();
+	while ((float) seconds > max && !Max.compare_exchange_weak(max, (float) seconds)) {
+	}
+}
+
+ProfileSummary FrameProfiler::Histogram::Summarize() const {
+	uint32_t counts[NumBuckets];
+	uint32_t total = 0;
+	for (int i = 0; i < NumBuckets; i++) {
+		counts[i] = Buckets[i].load();
+		total += counts[i];
+	}
+
+	ProfileSummary s;
+	s.Count = total;
+	s.P50   = 0;
+	s.P99   = 0;
+	s.Max   = Max.load();
+	if (total == 0)
+		return s;
+
+	// The rank of a percentile is rounded up, so that p99 of 50 samples is the largest one
+	uint32_t rank50 = (total * 50 + 99) / 100;
+	uint32_t rank99 = (total * 99 + 99) / 100;
+	uint32_t sum    = 0;
+	for (int i = 0; i < NumBuckets; i++) {
+		uint32_t prev = sum;
+		sum += counts[i];
+		if (prev < rank50 && sum >= rank50)
+			s.P50 = Min(BucketTop(i), s.Max);
+		if (prev < rank99 && sum >= rank99)
+			s.P99 = Min(BucketTop(i), s.Max);
+	}
+	return s;
+}
+
+int FrameProfiler::Histogram::BucketOf(double seconds) {
+	if (seconds <= BucketBase)
+		return 0;
+	int b = (int) ceil(4.0 * log2(seconds / BucketBase));
+	return Clamp(b, 0, NumBuckets - 1);
+}
+
+double FrameProfiler::Histogram::BucketTop(int bucket) {
+	return BucketBase * pow(2.0, bucket / 4.0);
+}
+
+template <typename T, uint32_t N>
+FrameProfiler::Ring<T, N>::Ring() {
+	for (uint32_t i = 0; i < N; i++)
+		Slots[i].Seq = 0;
+	Head = 0;
+}
+
+template <typename T, uint32_t N>
+void FrameProfiler::Ring<T, N>::Push(const T& v) {
+	uint64_t h    = Head.load(std::memory_order_relaxed);
+	Slot&    slot = Slots[h % N];
+	slot.Seq.store(2 * h + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.Value = v;
+	slot.Seq.store(2 * h + 2, std::memory_order_release);
+	Head.store(h + 1, std::memory_order_release);
+}
+
+template <typename T, uint32_t N>
+void FrameProfiler::Ring<T, N>::Read(cheapvec<T>& out) const {
+	out.clear();
+	uint64_t h = Head.load(std::memory_order_acquire);
+	uint64_t n = h < N ? h : N;
+	for (uint64_t i = h - n; i < h; i++) {
+		const Slot& slot = Slots[i % N];
+		uint64_t    seq  = slot.Seq.load(std::memory_order_acquire);
+		if (seq != 2 * i + 2)
+			continue;
+		T copy = slot.Value;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		// If the writer has lapped us, then the copy may be torn
+		if (slot.Seq.load(std::memory_order_relaxed) != seq)
+			continue;
+		out += copy;
+	}
+}
+
+FrameProfiler::FrameProfiler() {
+	memset(&Building, 0, sizeof(Building));
+	Reset();
+}
+
+FrameProfiler::~FrameProfiler() {
+}
+
+void FrameProfiler::BeginFrame() {
+	memset(&Building, 0, sizeof(Building));
+	Building.Frame = NextFrame++;
+	Building.Start = TimeAccurateSeconds();
+	InFrame        = true;
+}
+
+void FrameProfiler::EndFrame() {
+	if (!InFrame)
+		return;
+	InFrame                          = false;
+	Building.PhaseTime[ProfileFrame] = (float) (TimeAccurateSeconds() - Building.Start);
+	Frames.Push(Building);
+
+	Phases[ProfileFrame].Add(Building.PhaseTime[ProfileFrame]);
+	for (int i = ProfileFrame + 1; i < ProfilePhaseEND; i++) {
+		if (Building.PhaseTime[i] != 0)
+			Phases[i].Add(Building.PhaseTime[i]);
+	}
+}
+
+void FrameProfiler::BeginPhase(ProfilePhases phase) {
+	// Keep the start of the first occurrence, so that a phase that runs more than once covers all of them in the trace
+	float t = (float) (TimeAccurateSeconds() - Building.Start);
+	if (Building.PhaseTime[phase] == 0)
+		Building.PhaseStart[phase] = t;
+	Building.PhaseTime[phase] -= t;
+}
+
+void FrameProfiler::EndPhase(ProfilePhases phase) {
+	Building.PhaseTime[phase] += (float) (TimeAccurateSeconds() - Building.Start);
+}
+
+void FrameProfiler::AddToPhase(ProfilePhases phase, ProfilePhases parent, double seconds) {
+	if (seconds <= 0)
+		return;
+	if (Building.PhaseTime[phase] == 0)
+		Building.PhaseStart[phase] = Building.PhaseStart[parent];
+	Building.PhaseTime[phase] += (float) seconds;
+}
+
+void FrameProfiler::AddEvent(uint32_t type, double created, double dispatchStart, double dispatchEnd) {
+	EventRecord r;
+	r.Created   = created;
+	r.QueueTime = (float) (dispatchStart - created);
+	r.Dispatch  = (float) (dispatchEnd - dispatchStart);
+	r.Type      = type;
+	Events.Push(r);
+	EventLatency.Add(dispatchEnd - created);
+}
+
+void FrameProfiler::GetFrames(cheapvec<FrameRecord>& frames) const {
+	Frames.Read(frames);
+}
+
+void FrameProfiler::GetEvents(cheapvec<EventRecord>& events) const {
+	Events.Read(events);
+}
+
+bool FrameProfiler::GetLastFrame(FrameRecord& frame) const {
+	cheapvec<FrameRecord> frames;
+	Frames.Read(frames);
+	if (frames.size() == 0)
+		return false;
+	frame = frames.back();
+	return true;
+}
+
+ProfileSummary FrameProfiler::Summarize(ProfilePhases phase) const {
+	return Phases[phase].Summarize();
+}
+
+ProfileSummary FrameProfiler::SummarizeEventLatency() const {
+	return EventLatency.Summarize();
+}
+
+std::string FrameProfiler::ChromeTrace() const {
+	cheapvec<FrameRecord> frames;
+	cheapvec<EventRecord> events;
+	Frames.Read(frames);
+	Events.Read(events);
+
+	// Timestamps are in microseconds, relative to the oldest record
+	double origin = 0;
+	if (frames.size() != 0)
+		origin = frames[0].Start;
+	if (events.size() != 0 && (frames.size() == 0 || events[0].Created < origin))
+		origin = events[0].Created;
+
+	std::string out = "{\"traceEvents\":[\n";
+	out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Render\"}},\n";
+	out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"UI\"}}";
+
+	for (const auto& f : frames) {
+		for (int i = 0; i < ProfilePhaseEND; i++) {
+			if (i != ProfileFrame && f.PhaseTime[i] == 0)
+				continue;
+			double ts = (f.Start - origin + f.PhaseStart[i]) * 1e6;
+			out += tsf::fmt(",\n{\"name\":\"%v\",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1",
+			                ProfilePhaseName((ProfilePhases) i), ts, f.PhaseTime[i] * 1e6);
+			if (i == ProfileFrame)
+				out += tsf::fmt(",\"args\":{\"frame\":%v,\"layoutPasses\":%v}", f.Frame, f.NumLayoutPasses);
+			out += "}";
+		}
+	}
+
+	for (const auto& e : events) {
+		double ts = (e.Created - origin) * 1e6;
+		out += tsf::fmt(",\n{\"name\":\"Queued\",\"cat\":\"event\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":2,\"args\":{\"type\":%v}}",
+		                ts, e.QueueTime * 1e6, e.Type);
+		out += tsf::fmt(",\n{\"name\":\"Dispatch\",\"cat\":\"event\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":2,\"args\":{\"type\":%v}}",
+		                ts + e.QueueTime * 1e6, e.Dispatch * 1e6, e.Type);
+	}
+
+	out += "\n]}\n";
+	return out;
+}
+
+bool FrameProfiler::WriteChromeTrace(const char* filename) const {
+	std::string json = ChromeTrace();
+	FILE*       f    = fopen(filename, "wb");
+	if (f == nullptr)
+		return false;
+	bool ok = fwrite(json.c_str(), 1, json.size(), f) == json.size();
+	ok      = fclose(f) == 0 && ok;
+	return ok;
+}
+
+void FrameProfiler::Reset() {
+	for (int i = 0; i < ProfilePhaseEND; i++)
+		Phases[i].Reset();
+	EventLatency.Reset();
+}
+} // namespace xo
@@ -0,0 +1,131 @@
+#pragma once
+#include "Defs.h"
+
+namespace xo {
+
+enum ProfilePhases {
+	ProfileFrame,          // The whole frame, from the moment the render thread starts work
+	ProfileDocLockWait,    // Waiting for the UI thread to release DocLock
+	ProfileUploadImages,   // Copying the parts of images that were changed by the UI thread into staging memory, under DocLock
+	ProfileCopyDoc,        // CopyFromCanonical
+	ProfileStreamImages,   // Handing the staged texels to the GPU, after DocLock is released
+	ProfileVariableBake,   // Expanding style variables inside class styles
+	ProfileLayout,         // All layout passes, including style resolution
+	ProfileStyleResolve,   // Part of ProfileLayout. Summed over all threads.
+	ProfileLayoutRepass,   // Part of ProfileLayout, spent in passes after the first, because glyphs or fonts were missing
+	ProfileRender,         // Generating draw calls
+	ProfileTextureUpload,  // Part of ProfileRender
+	ProfilePostRender,     // Publishing the layout to the UI thread
+	ProfileSwap,           // EndRender, which presents the frame
+	ProfilePhaseEND,
+};
+
+XO_API const char* ProfilePhaseName(ProfilePhases phase);
+
+struct FrameRecord {
+	uint64_t Frame;                       // Sequence number of the frame
+	double   Start;                       // TimeAccurateSeconds() at the start of the frame
+	float    PhaseStart[ProfilePhaseEND]; // Seconds since Start. For a phase that is summed, this is the start of its parent.
+	float    PhaseTime[ProfilePhaseEND];  // Seconds. Zero if the phase did not run.
+	uint32_t NumLayoutPasses;
+};
+
+struct EventRecord {
+	double   Created;   // TimeAccurateSeconds() when the event was created by the window system
+	float    QueueTime; // Seconds from creation until the UI thread picked the event up
+	float    Dispatch;  // Seconds spent inside the event handlers
+	uint32_t Type;      // xo::Events
+};
+
+struct ProfileSummary {
+	uint32_t Count; // Number of samples since the last Reset
+	double   P50;   // Seconds. These are the upper bounds of histogram buckets, so they are accurate to about 19%.
+	double   P99;
+	double   Max;
+};
+
+/* Timing of every frame of a DocGroup, and of the events that its UI thread dispatched.
+
+The render thread builds a FrameRecord while it works on a frame, with BeginPhase/EndPhase,
+and EndFrame publishes it into a ring buffer of the most recent MaxFrames frames. Events are
+published by the UI thread into a second ring. Each ring has a single writer, and any thread
+may read it without taking a lock: every slot carries a sequence number, and a reader discards
+a slot that was overwritten while it was being copied out.
+
+In addition, every phase has a histogram that covers all frames since the last Reset, from
+which p50 and p99 can be queried. There are four buckets per doubling, starting at 10 microseconds,
+and anything slower than about half a second lands in the last bucket. Max is exact.
+
+ChromeTrace produces JSON in the Chrome trace-event format, which can be loaded into
+chrome://tracing or Perfetto. Frames are on one track, and events on another.
+*/
+class XO_API FrameProfiler {
+public:
+	static const uint32_t MaxFrames = 256;
+	static const uint32_t MaxEvents = 256;
+
+	FrameProfiler();
+	~FrameProfiler();
+
+	// Render thread
+	void         BeginFrame();
+	void         EndFrame();
+	void         BeginPhase(ProfilePhases phase);
+	void         EndPhase(ProfilePhases phase); // May be called more than once per frame, in which case the times are summed
+	void         AddToPhase(ProfilePhases phase, ProfilePhases parent, double seconds); // Record a phase that was measured elsewhere, as part of 'parent'
+	FrameRecord& Current() { return Building; }
+
+	// UI thread
+	void AddEvent(uint32_t type, double created, double dispatchStart, double dispatchEnd);
+
+	// Any thread
+	void           GetFrames(cheapvec<FrameRecord>& frames) const; // Most recent frames, oldest first
+	void           GetEvents(cheapvec<EventRecord>& events) const; // Most recent events, oldest first
+	bool           GetLastFrame(FrameRecord& frame) const;
+	ProfileSummary Summarize(ProfilePhases phase) const;
+	ProfileSummary SummarizeEventLatency() const; // From creation of an event until its handlers have finished
+	std::string    ChromeTrace() const;
+	bool           WriteChromeTrace(const char* filename) const;
+	void           Reset(); // Clear the histograms
+
+private:
+	static const int NumBuckets = 64;
+
+	class Histogram {
+	public:
+		std::atomic<uint32_t> Buckets[NumBuckets];
+		std::atomic<uint32_t> Count;
+		std::atomic<float>    Max;
+
+		void           Reset();
+		void           Add(double seconds);
+		ProfileSummary Summarize() const;
+
+		static int    BucketOf(double seconds);
+		static double BucketTop(int bucket);
+	};
+
+	template <typename T, uint32_t N>
+	class Ring {
+	public:
+		struct Slot {
+			std::atomic<uint64_t> Seq; // 2 * (index + 1) once the slot holds record 'index'. Odd while it is being written.
+			T                     Value;
+		};
+		Slot                  Slots[N];
+		std::atomic<uint64_t> Head; // Number of records ever written
+
+		Ring();
+		void Push(const T& v);
+		void Read(cheapvec<T>& out) const;
+	};
+
+	FrameRecord                  Building;
+	uint64_t                     NextFrame = 0;
+	bool                         InFrame   = false;
+	Ring<FrameRecord, MaxFrames> Frames;
+	Ring<EventRecord, MaxEvents> Events;
+	Histogram                    Phases[ProfilePhaseEND];
+	Histogram                    EventLatency;
+};
+} // namespace xo
@@ -4,10 +4,19 @@
 #include "Dom/DomNode.h"
 #include "Dom/DomText.h"
 #include "Render/RenderDomEl.h"
+#include "Render/StyleCache.h"
 #include "Render/StyleResolve.h"
 #include "Text/FontStore.h"
 #include "Text/GlyphCache.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define XO_CHUNKER_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define XO_CHUNKER_SSE2 1
+#endif
+
 namespace xo {
 
 /* This is called serially.
@@ -18,37 +27,228 @@ The reason is because we eventually want to be able to parallelize layout.
 Missing glyphs are a once-off cost (ie once per application instance),
 so it's not worth trying to use a mutable glyph cache.
 
+The workers that perform parallel layout only read from the glyph cache. Their missing glyphs
+are merged into ours, and rendered here, between passes.
+
 */
-void Layout::PerformLayout(const xo::Doc& doc, RenderDomNode& root, xo::Pool* pool) {
-	Doc        = &doc;
-	Pool       = pool;
-	Boxer.Pool = pool;
+void Layout::PerformLayout(const xo::Doc& doc, RenderDomNode& root, xo::Pool* pool, LayoutCache* cache, StyleCache* styleCache, WordCache* wordCache) {
+	Doc              = &doc;
+	Cache            = cache;
+	Words            = Global()->EnableWordCache ? wordCache : nullptr;
+	Pool             = pool;
+	Boxer.Pool       = pool;
+	Stack.StyleCache = Global()->EnableStyleCache ? styleCache : nullptr;
 	Stack.Initialize(Doc, Pool);
 
 	// These are thumbsuck numbers.
 	// 100 is max expected tree depth.
 	// 64 is related to size of LayoutOutput, and number of expected objects
 	// inside the vectors that store LayoutOutput inside RunNode
-	FHeap.Initialize(100, 64);
+	if (!FHeap.IsInitialized())
+		FHeap.Initialize(100, 64);
 
 	SnapBoxes     = Global()->SnapBoxes;
 	SnapHorzText  = Global()->SnapHorzText;
 	EnableKerning = Global()->EnableKerning;
-
+	ProfileStyles = Global()->EnableFrameProfiler;
+
+	if (Cache)
+		Cache->BeginLayout(doc);
+	if (Stack.StyleCache)
+		Stack.StyleCache->BeginLayout(doc);
+	if (Words)
+		Words->BeginLayout();
+
+	bool parallel    = Global()->EnableParallelLayout && Global()->NumWorkerThreads != 0;
+	NumParallelJobs  = 0;
+	NumPasses        = 0;
+	TimeStyleResolve = 0;
+	TimeRepasses     = 0;
+
+	double firstPassEnd = 0;
 	while (true) {
+		NumPasses++;
 		Fonts = Global()->FontStore->GetImmutableTable();
+		Glyphs = Global()->GlyphCache->BeginRead();
 
-		LayoutInternal(root);
+		if (parallel) {
+			BeginParallelDiscovery();
+			LayoutInternal(root);
+			RunParallelJobs();
+			NumParallelJobs = (uint32_t) Jobs.size();
+		}
+
+		// If discovery found nothing to do in parallel, then its output is already complete.
+		// If the workers were missing glyphs, then we need another pass anyway.
+		bool needConsume = Jobs.size() != 0 && GlyphsNeeded.size() == 0 && FontsNeeded.size() == 0;
+		if (!parallel || needConsume) {
+			ParallelPass = parallel ? ParallelConsume : ParallelNone;
+			LayoutInternal(root);
+		}
+		ParallelPass = ParallelNone;
+		Global()->GlyphCache->EndRead(Glyphs);
+		Glyphs = nullptr;
+		if (Words)
+			MergeNewWords();
 
 		if (GlyphsNeeded.size() == 0 && FontsNeeded.size() == 0) {
 			XOTRACE_LAYOUT_VERBOSE("Layout done\n");
 			break;
 		} else {
 			XOTRACE_LAYOUT_VERBOSE("Layout done (but need another pass for missing fonts/glyphs)\n");
+			if (NumPasses == 1)
+				firstPassEnd = TimeAccurateSeconds();
 			RenderFontsNeeded();
 			RenderGlyphsNeeded();
 		}
 	}
+	if (NumPasses > 1)
+		TimeRepasses = TimeAccurateSeconds() - firstPassEnd;
+
+	if (Cache)
+		Cache->EndLayout();
+}
+
+Layout::~Layout() {
+	for (size_t i = 0; i < Workers.size(); i++) {
+		delete Workers[i]->Layout;
+		delete Workers[i];
+	}
+}
+
+void Layout::BeginParallelDiscovery() {
+	ParallelPass = ParallelDiscover;
+	Jobs.clear();
+	JobByInternalID.resize(Doc->InternalIDSize());
+	if (JobByInternalID.size() != 0)
+		JobByInternalID.fill(-1);
+}
+
+// The calling thread lays out jobs too, so this makes progress even if all of the workers are busy
+void Layout::RunParallelJobs() {
+	if (Jobs.size() == 0)
+		return;
+
+	size_t numHelpers = Min((size_t) Global()->NumWorkerThreads, Jobs.size() - 1);
+	while (Workers.size() < numHelpers + 1) {
+		ParallelWorker* w = new ParallelWorker();
+		w->Owner          = this;
+		w->Layout         = new xo::Layout();
+		w->Layout->FHeap.Initialize(100, 64);
+		Workers += w;
+	}
+	for (size_t i = 0; i <= numHelpers; i++) {
+		Workers[i]->Pool.FreeAllExceptOne();
+		Workers[i]->Layout->BeginWorker(*this, &Workers[i]->Pool);
+	}
+
+	NextJob = 0;
+	TaskGroup group(Global()->Scheduler);
+	for (size_t i = 1; i <= numHelpers; i++) {
+		ParallelWorker* w = Workers[i];
+		group.Run([w] { ParallelWorkerFunc(w); });
+	}
+	ParallelWorkerFunc(Workers[0]);
+	group.Wait();
+
+	for (size_t i = 0; i <= numHelpers; i++) {
+		for (auto key : Workers[i]->Layout->GlyphsNeeded)
+			GlyphsNeeded.insert(key);
+		for (auto font : Workers[i]->Layout->FontsNeeded)
+			FontsNeeded.insert(font);
+		Workers[i]->Layout->GlyphsNeeded.clear();
+		Workers[i]->Layout->FontsNeeded.clear();
+		TimeStyleResolve += Workers[i]->Layout->TimeStyleResolve;
+	}
+
+	// The consume pass can then find the words that the workers measured
+	if (Words)
+		MergeNewWords();
+}
+
+// The workers are done, so nobody is reading Words
+void Layout::MergeNewWords() {
+	for (size_t i = 0; i <= Workers.size(); i++) {
+		xo::Layout* lay = i == 0 ? this : Workers[i - 1]->Layout;
+		Words->MergeFrom(lay->NewWords);
+		Words->NumHits += lay->NumWordHits;
+		Words->NumMisses += lay->NumWordMisses;
+		lay->NewWords.Clear();
+		lay->NumWordHits   = 0;
+		lay->NumWordMisses = 0;
+	}
+}
+
+void Layout::ParallelWorkerFunc(ParallelWorker* w) {
+	xo::Layout* owner = w->Owner;
+	while (true) {
+		size_t i = owner->NextJob++;
+		if (i >= owner->Jobs.size())
+			break;
+		w->Layout->RunParallelJob(owner->Jobs[i]);
+	}
+}
+
+void Layout::BeginWorker(const Layout& owner, xo::Pool* pool) {
+	Doc           = owner.Doc;
+	Cache         = nullptr;
+	Pool          = pool;
+	Boxer.Pool    = pool;
+	Fonts         = owner.Fonts;
+	Glyphs        = owner.Glyphs;
+	PtToPixel     = owner.PtToPixel;
+	EpToPixel     = owner.EpToPixel;
+	SnapBoxes     = owner.SnapBoxes;
+	SnapHorzText  = owner.SnapHorzText;
+	EnableKerning = owner.EnableKerning;
+	ProfileStyles = owner.ProfileStyles;
+	Words         = owner.Words;
+	ParallelPass  = ParallelNone;
+
+	TimeStyleResolve = 0;
+	Stack.Initialize(Doc, Pool);
+	Stack.StyleCache = owner.Stack.StyleCache;
+}
+
+void Layout::RunParallelJob(ParallelJob& job) {
+	// Rebuild the style that the node inherits from its ancestors
+	cheapvec<const DomNode*> ancestors;
+	for (const DomNode* a = job.Node->GetParent(); a != nullptr; a = a->GetParent())
+		ancestors += a;
+	Stack.Reset();
+	for (size_t i = ancestors.size() - 1; i != -1; i--)
+		StyleResolver::ResolveAndPush(Stack, ancestors[i]);
+
+	// Place the node inside a dummy parent, whose content box is the space that remained in the real parent
+	BoxLayout::NodeInput space;
+	space.InternalID          = InternalIDNull;
+	space.Tag                 = Tag_DummyRoot;
+	space.ContentWidth        = job.Result.RemainingX;
+	space.ContentHeight       = job.Result.RemainingY;
+	space.MarginBorderPadding = Box(0, 0, 0, 0);
+	space.Bump                = BumpRegular;
+	space.NewFlowContext      = true;
+	space.Position            = PositionStatic;
+
+	cheapvec<int32_t> restartPoints;
+	LayoutInput       in;
+	in.RestartPoints = &restartPoints;
+	in.ParentRNode   = new (Pool->AllocT<RenderDomNode>(false)) RenderDomNode(InternalIDNull, Tag_DummyRoot, Pool);
+	in.ParentWidth   = job.Result.ParentWidth;
+	in.ParentHeight  = job.Result.ParentHeight;
+
+	LayoutOutput out;
+	Box          spaceBox;
+	Boxer.BeginDocument();
+	Boxer.BeginNode(space);
+	RunNode(job.Node, in, out);
+	Boxer.EndNode(spaceBox);
+	Boxer.EndDocument();
+
+	job.Result.RNode         = static_cast<const RenderDomNode*>(out.RNode);
+	job.Result.ContentWidth  = out.RNode->Pos.Width();
+	job.Result.ContentHeight = out.RNode->Pos.Height();
+	job.Result.Baseline      = out.Baseline;
 }
 
 void Layout::RenderFontsNeeded() {
@@ -63,8 +263,7 @@ void Layout::RenderFontsNeeded() {
 }
 
 void Layout::RenderGlyphsNeeded() {
-	for (auto it = GlyphsNeeded.begin(); it != GlyphsNeeded.end(); it++)
-		Global()->GlyphCache->RenderGlyph(*it);
+	Global()->GlyphCache->RenderGlyphs(GlyphsNeeded);
 	GlyphsNeeded.clear();
 }
 
@@ -77,6 +276,8 @@ void Layout::LayoutInternal(RenderDomNode& root) {
 	Pool->FreeAll();
 	root.Children.clear();
 	Stack.Reset();
+	if (Cache)
+		Cache->BeginPass();
 
 	XOTRACE_LAYOUT_VERBOSE("Layout 2\n");
 
@@ -94,19 +295,24 @@ void Layout::LayoutInternal(RenderDomNode& root) {
 }
 
 void Layout::RunNode(const DomNode* node, const LayoutInput& in, LayoutOutput& out) {
-	static int debug_num_run;
-	debug_num_run++;
-
 	BoxLayout::NodeInput boxIn;
 
-	StyleResolver::ResolveAndPush(Stack, node);
+	if (ProfileStyles) {
+		double start = TimeAccurateSeconds();
+		StyleResolver::ResolveAndPush(Stack, node);
+		TimeStyleResolve += TimeAccurateSeconds() - start;
+	} else {
+		StyleResolver::ResolveAndPush(Stack, node);
+	}
 
 	Box         margin        = ComputeBox(in.ParentWidth, in.ParentHeight, CatMargin_Left);
 	Box         padding       = ComputeBox(in.ParentWidth, in.ParentHeight, CatPadding_Left);
 	Box         border        = ComputeBox(in.ParentWidth, in.ParentHeight, CatBorder_Left);
 	Box         borderRadius  = ComputeBox(in.ParentWidth, in.ParentHeight, CatBorderRadius_TL);
-	Pos         contentWidth  = ComputeWidthOrHeightDimension(in.ParentWidth, Boxer.RemainingSpaceX(), CatWidth);
-	Pos         contentHeight = ComputeWidthOrHeightDimension(in.ParentHeight, Boxer.RemainingSpaceY(), CatHeight);
+	Pos         remainingX    = Boxer.RemainingSpaceX();
+	Pos         remainingY    = Boxer.RemainingSpaceY();
+	Pos         contentWidth  = ComputeWidthOrHeightDimension(in.ParentWidth, remainingX, CatWidth);
+	Pos         contentHeight = ComputeWidthOrHeightDimension(in.ParentHeight, remainingY, CatHeight);
 	BoxSizeType boxSizeType   = Stack.Get(CatBoxSizing).GetBoxSizing();
 
 	if (padding.Top < 0)
@@ -147,6 +353,85 @@ void Layout::RunNode(const DomNode* node, const LayoutInput& in, LayoutOutput& o
 	boxIn.Bump                = Stack.Get(CatBump).GetBump();
 	boxIn.Position            = Stack.Get(CatPosition).GetPositionType();
 
+	// The layout of a new flow context depends only on its style, its descendants, and these inputs
+	LayoutCache::Entry        cacheEntry;
+	const LayoutCache::Entry* reuse     = nullptr;
+	bool                      fromCache = false;
+	bool                      deferred  = false;
+	if (boxIn.NewFlowContext && (Cache || ParallelPass != ParallelNone)) {
+		cacheEntry.StyleHash    = LayoutCache::HashStyle(Stack);
+		cacheEntry.ParentWidth  = in.ParentWidth;
+		cacheEntry.ParentHeight = in.ParentHeight;
+		cacheEntry.RemainingX   = remainingX;
+		cacheEntry.RemainingY   = remainingY;
+		if (in.RestartPoints == nullptr || in.RestartPoints->size() == 0) {
+			if (Cache)
+				reuse = Cache->Find(node->GetInternalID(), cacheEntry);
+			fromCache = reuse != nullptr;
+			if (!reuse && ParallelPass == ParallelDiscover)
+				deferred = node != &Doc->Root && node->ChildCount() != 0 && IsDefined(contentWidth) && IsDefined(contentHeight);
+			if (!reuse && ParallelPass == ParallelConsume && JobByInternalID[node->GetInternalID()] != -1) {
+				const LayoutCache::Entry& job = Jobs[JobByInternalID[node->GetInternalID()]].Result;
+				if (job.SameInputs(cacheEntry))
+					reuse = &job;
+			}
+		}
+	}
+
+	if (deferred) {
+		JobByInternalID[node->GetInternalID()] = (int32_t) Jobs.size();
+		ParallelJob& job                       = Jobs.add();
+		job.Node                               = node;
+		job.Result                             = cacheEntry;
+	}
+
+	if (reuse || deferred) {
+		// Either nothing inside this node has changed, in which case we take its contents from the previous
+		// layout, or a worker thread has laid it out. A deferred node is an empty placeholder of the correct size.
+		if (reuse) {
+			boxIn.ContentWidth  = reuse->ContentWidth;
+			boxIn.ContentHeight = reuse->ContentHeight;
+		}
+		Boxer.BeginNode(boxIn);
+		Box marginBox;
+		if (Boxer.EndNode(marginBox) == BoxLayout::FlowRestart) {
+			XO_DIE_MSG("Untested layout restart position");
+			in.RestartPoints->push(0);
+		}
+		rnode->Pos = marginBox.ShrunkBy(boxIn.MarginBorderPadding);
+		rnode->SetStyle(Stack);
+		rnode->Style.BorderRadius.Set2BitPrecision(borderRadius);
+		rnode->Style.BorderSize = border;
+		rnode->Style.Padding    = padding;
+		if (fromCache)
+			Cache->NumReused++;
+
+		out.Baseline = reuse ? reuse->Baseline : PosNULL;
+		PopulateBindings(out.Binds);
+
+		// The previous layout outlives this one, so we can point into it, unless our parent is going to move our children.
+		// A worker's heap is reset before the next layout, so its output is always copied.
+		if (fromCache && Cache->ShareReused && !MovesChildren(out.Binds))
+			LayoutCache::ShareChildren(reuse->RNode, rnode);
+		else if (reuse)
+			LayoutCache::CloneChildren(reuse->RNode, rnode, Pool);
+		out.RNode     = rnode;
+		out.RNodeTop  = rnode->Pos.Top;
+		out.MarginBox = marginBox;
+		out.Break     = myBreak;
+
+		if (Cache && reuse && !MovesChildren(out.Binds)) {
+			cacheEntry.RNode         = rnode;
+			cacheEntry.ContentWidth  = reuse->ContentWidth;
+			cacheEntry.ContentHeight = reuse->ContentHeight;
+			cacheEntry.Baseline      = reuse->Baseline;
+			Cache->Add(node->GetInternalID(), cacheEntry);
+		}
+
+		Stack.StackPop();
+		return;
+	}
+
 	cheapvec<int32_t> myRestartPoints;
 
 	LayoutInput childIn;
@@ -277,6 +562,15 @@ void Layout::RunNode(const DomNode* node, const LayoutInput& in, LayoutOutput& o
 	out.MarginBox = marginBox;
 	out.Break     = Stack.Get(CatBreak).GetBreakType();
 
+	// Our parent moves our children when it stretches us with bindings, which would corrupt a cached copy
+	if (Cache && boxIn.NewFlowContext && !MovesChildren(out.Binds)) {
+		cacheEntry.RNode         = rnode;
+		cacheEntry.ContentWidth  = rnode->Pos.Width();
+		cacheEntry.ContentHeight = rnode->Pos.Height();
+		cacheEntry.Baseline      = out.Baseline;
+		Cache->Add(node->GetInternalID(), cacheEntry);
+	}
+
 	Stack.StackPop();
 }
 
@@ -413,9 +707,9 @@ void Layout::GenerateTextWords(TextRunState& ts) {
 		XO_ASSERT(ts.RestartPoints->size() == 0); // Text is a leaf node. The restart stack must be empty now.
 	}
 
-	GlyphCache*   glyphCache = Global()->GlyphCache;
-	GlyphCacheKey key        = MakeGlyphCacheKey(ts);
-	const Font*   font       = Fonts.GetByFontID(ts.FontID);
+	GlyphCacheKey key  = MakeGlyphCacheKey(ts);
+	const Font*   font = Fonts.GetByFontID(ts.FontID);
+	ts.ASCIIGlyphs     = Glyphs->GetASCII(key);
 
 	Pos fontHeightRounded = RealToPos((float) ts.FontSizePx);
 	Pos charWidth_32      = Realx256ToPos(font->LinearHoriAdvance_Space_x256) * ts.FontSizePx;
@@ -511,7 +805,7 @@ void Layout::GenerateTextWords(TextRunState& ts) {
 		case ChunkLineBreak: {
 			aborted = true;
 			Boxer.AddNewLineCharacter(lineHeight);
-			ts.RestartPoints->push(chunk.Start + txt_offset + 1);
+			ts.RestartPoints->push(chunk.End + txt_offset);
 			break;
 		}
 		}
@@ -553,21 +847,49 @@ void Layout::OffsetTextHorz(TextRunState& ts, Pos offsetHorz, size_t numChars) {
 // All characters go into a queue, which gets flushed whenever we flow onto a new line.
 // Returns the width of the word
 Pos Layout::MeasureWord(const char* txt, const Font* font, Pos fontAscender, Chunk chunk, TextRunState& ts) {
+	WordCache::Key wordKey;
+	if (Words) {
+		wordKey                     = MakeWordCacheKey(ts);
+		const WordCache::Entry* hit = Words->Find(wordKey, txt + chunk.Start, chunk.End - chunk.Start);
+		if (!hit)
+			hit = NewWords.Find(wordKey, txt + chunk.Start, chunk.End - chunk.Start);
+		if (hit) {
+			NumWordHits++;
+			for (uint32_t i = 0; i < hit->NumChars; i++) {
+				RenderCharEl& rtxt = ts.Chars.PushHead();
+				rtxt               = hit->Chars[i];
+				rtxt.OriginalCharIndex += chunk.Start;
+			}
+			return hit->Width;
+		}
+		NumWordMisses++;
+	}
+
 	// I find it easier to understand when referring to this value as "baseline" instead of "ascender"
 	Pos baseline = fontAscender;
 
 	Pos           posX      = 0;
 	GlyphCacheKey key       = MakeGlyphCacheKey(ts);
 	const Glyph*  prevGlyph = nullptr;
+	int32_t       prevChar  = 0;
+	bool          missing   = false;
+	int           numChars  = 0;
 
 	for (int32_t i = chunk.Start; i < chunk.End;) {
-		int seq_len = 0;
-		key.Char    = utfz::decode(txt + i, seq_len);
-		i += seq_len;
-		const Glyph* glyph = Global()->GlyphCache->GetGlyph(key);
+		const Glyph* glyph;
+		if (chunk.IsASCII) {
+			key.Char = (uint8_t) txt[i++];
+			glyph    = ts.ASCIIGlyphs ? ts.ASCIIGlyphs->Glyphs[key.Char] : nullptr;
+		} else {
+			int seq_len = 0;
+			key.Char    = utfz::decode(txt + i, seq_len);
+			i += seq_len;
+			glyph = Glyphs->GetGlyph(key);
+		}
 		if (!glyph) {
 			ts.GlyphsNeeded = true;
 			GlyphsNeeded.insert(key);
+			missing = true;
 			continue;
 		}
 		if (glyph->IsNull()) {
@@ -576,12 +898,9 @@ Pos Layout::MeasureWord(const char* txt, const Font* font, Pos fontAscender, Chu
 			prevGlyph = nullptr;
 		}
 		if (EnableKerning && prevGlyph) {
-			// Multithreading hazard here. I'm not sure whether FT_Get_Kerning is thread safe.
-			// Also, I have stepped inside there and I see it does a binary search. We might
-			// be better off caching the kerning for frequent pairs of glyphs in a hash table.
-			FT_Vector kern;
-			FT_Get_Kerning(font->FTFace, prevGlyph->FTGlyphIndex, glyph->FTGlyphIndex, FT_KERNING_UNSCALED, &kern);
-			Pos kerning = ((kern.x * ts.FontSizePx) << PosShift) / font->FTFace->units_per_EM;
+			// The kerning table is immutable, so this is safe to read from the parallel layout threads, without touching FTFace
+			int32_t kern    = font->Kerning.Get(prevChar, key.Char, prevGlyph->FTGlyphIndex, glyph->FTGlyphIndex);
+			Pos     kerning = ((kern * ts.FontSizePx) << PosShift) / font->UnitsPerEM;
 			posX += kerning;
 		}
 
@@ -597,6 +916,17 @@ Pos Layout::MeasureWord(const char* txt, const Font* font, Pos fontAscender, Chu
 		rtxt.Width             = RealToPos(glyph->MetricWidth);
 		posX += HoriAdvance(glyph, ts);
 		prevGlyph = glyph;
+		prevChar  = key.Char;
+		numChars++;
+	}
+
+	if (Words && !missing) {
+		TempWordChars.clear_noalloc();
+		for (int i = numChars - 1; i >= 0; i--) {
+			TempWordChars += ts.Chars.FromHead(i);
+			TempWordChars.back().OriginalCharIndex -= chunk.Start;
+		}
+		NewWords.Add(wordKey, txt + chunk.Start, chunk.End - chunk.Start, posX, TempWordChars.data, TempWordChars.size());
 	}
 	return posX;
 }
@@ -846,6 +1176,20 @@ bool Layout::IsLinebreak(int ch) {
 	return ch == '\r' || ch == '\n';
 }
 
+WordCache::Key Layout::MakeWordCacheKey(const TextRunState& ts) const {
+	WordCache::Key key;
+	key.FontID     = ts.FontID;
+	key.FontSizePx = ts.FontSizePx;
+	key.Flags      = 0;
+	if (ts.IsSubPixel)
+		key.Flags |= WordCache::KeySubPixel;
+	if (EnableKerning)
+		key.Flags |= WordCache::KeyKerning;
+	if (SnapHorzText)
+		key.Flags |= WordCache::KeySnapHorz;
+	return key;
+}
+
 GlyphCacheKey Layout::MakeGlyphCacheKey(RenderDomText* rnode) {
 	uint8_t flags = 0;
 	if (rnode->IsSubPixel())
@@ -883,6 +1227,15 @@ void Layout::MoveChildren(RenderDomEl* relem, Point delta) {
 	}
 }
 
+// Returns true if PositionChildFromBindings will stretch the child from its left or top edge
+bool Layout::MovesChildren(const BindingSet& bindings) {
+	auto hbound      = [](StyleAttrib a) { return !a.IsNull() && !(a.IsBindingTypeEnum() && a.GetHorizontalBinding() == HorizontalBindingNULL); };
+	auto vbound      = [](StyleAttrib a) { return !a.IsNull() && !(a.IsBindingTypeEnum() && a.GetVerticalBinding() == VerticalBindingNULL); };
+	bool stretchLeft = hbound(bindings.HChildLeft) && (hbound(bindings.HChildCenter) || hbound(bindings.HChildRight));
+	bool stretchTop  = vbound(bindings.VChildTop) && (vbound(bindings.VChildCenter) || vbound(bindings.VChildBaseline) || vbound(bindings.VChildBottom));
+	return stretchLeft || stretchTop;
+}
+
 Pos Layout::LayoutOutput::BaselinePlusRNodeTop() const {
 	return Baseline == PosNULL ? PosNULL : Baseline + RNodeTop;
 }
@@ -891,22 +1244,116 @@ Layout::Chunker::Chunker(const char* txt) : Txt(txt),
                                             Pos(0) {
 }
 
+/* The scanners below read whole aligned blocks, starting at the block that contains the first byte.
+An aligned load never crosses a page boundary, so reading past the null terminator is safe, even
+though the bytes after it don't belong to us. Bits of the masks that lie before the first byte are
+discarded. Without SSE2 we fall back to reading one byte at a time.
+*/
+#if XO_CHUNKER_AVX2
+static const uintptr_t ChunkerBlock = 32;
+
+static inline uint32_t ChunkerWordEndMask(const char* block, uint32_t& highBits) {
+	__m256i v = _mm256_load_si256((const __m256i*) block);
+	__m256i e = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_setzero_si256()), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(32)));
+	e         = _mm256_or_si256(e, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(9)));
+	e         = _mm256_or_si256(e, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')));
+	e         = _mm256_or_si256(e, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+	highBits  = (uint32_t) _mm256_movemask_epi8(v);
+	return (uint32_t) _mm256_movemask_epi8(e);
+}
+
+static inline uint32_t ChunkerNotEqualMask(const char* block, char ch) {
+	__m256i v = _mm256_load_si256((const __m256i*) block);
+	return ~(uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(ch)));
+}
+#elif XO_CHUNKER_SSE2
+static const uintptr_t ChunkerBlock = 16;
+
+static inline uint32_t ChunkerWordEndMask(const char* block, uint32_t& highBits) {
+	__m128i v = _mm_load_si128((const __m128i*) block);
+	__m128i e = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_setzero_si128()), _mm_cmpeq_epi8(v, _mm_set1_epi8(32)));
+	e         = _mm_or_si128(e, _mm_cmpeq_epi8(v, _mm_set1_epi8(9)));
+	e         = _mm_or_si128(e, _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+	e         = _mm_or_si128(e, _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+	highBits  = (uint32_t) _mm_movemask_epi8(v);
+	return (uint32_t) _mm_movemask_epi8(e);
+}
+
+static inline uint32_t ChunkerNotEqualMask(const char* block, char ch) {
+	__m128i v = _mm_load_si128((const __m128i*) block);
+	return ~(uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(ch))) & 0xffff;
+}
+#endif
+
+#if XO_CHUNKER_AVX2 || XO_CHUNKER_SSE2
+static inline uint32_t ChunkerLowestBit(uint32_t v) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, v);
+	return (uint32_t) index;
+#else
+	return (uint32_t) __builtin_ctz(v);
+#endif
+}
+
+// Returns the position of the first null, tab, space, CR or LF at or after 'p'.
+// Sets isASCII to false if any byte before that is 128 or above.
+static const char* ChunkerScanWord(const char* p, bool& isASCII) {
+	const char* block = (const char*) ((uintptr_t) p & ~(ChunkerBlock - 1));
+	uint32_t    valid = ~(uint32_t) 0 << (uint32_t) (p - block);
+	uint32_t    high  = 0;
+	uint32_t    end   = ChunkerWordEndMask(block, high) & valid;
+	high &= valid;
+	while (end == 0) {
+		isASCII = isASCII && high == 0;
+		block += ChunkerBlock;
+		end = ChunkerWordEndMask(block, high);
+	}
+	uint32_t i = ChunkerLowestBit(end);
+	isASCII    = isASCII && (high & ((1u << i) - 1)) == 0;
+	return block + i;
+}
+
+// Returns the position of the first byte at or after 'p' that is not 'ch'. 'ch' must not be zero.
+static const char* ChunkerScanRun(const char* p, char ch) {
+	const char* block = (const char*) ((uintptr_t) p & ~(ChunkerBlock - 1));
+	uint32_t    other = ChunkerNotEqualMask(block, ch) & (~(uint32_t) 0 << (uint32_t) (p - block));
+	while (other == 0) {
+		block += ChunkerBlock;
+		other = ChunkerNotEqualMask(block, ch);
+	}
+	return block + ChunkerLowestBit(other);
+}
+#else
+static const char* ChunkerScanWord(const char* p, bool& isASCII) {
+	for (; *p != 0 && *p != 9 && *p != 32 && *p != '\r' && *p != '\n'; p++)
+		isASCII = isASCII && (uint8_t) *p < 128;
+	return p;
+}
+
+static const char* ChunkerScanRun(const char* p, char ch) {
+	for (; *p == ch; p++) {
+	}
+	return p;
+}
+#endif
+
 bool Layout::Chunker::Next(Chunk& c) {
 	if (Txt[Pos] == 0)
 		return false;
 
 	char first = Txt[Pos];
 	c.Start    = Pos;
+	c.IsASCII  = false;
 	switch (first) {
 	case 9:
 	case 32:
 		c.Type = ChunkSpace;
-		for (; Txt[Pos] == first; Pos++) {
-		}
+		Pos    = (int32_t) (ChunkerScanRun(Txt + Pos, first) - Txt);
 		break;
 	case '\r':
 		c.Type = ChunkLineBreak;
-		if (Txt[Pos] == '\n')
+		if (Txt[Pos + 1] == '\n')
 			Pos += 2;
 		else
 			Pos += 1;
@@ -916,13 +1363,9 @@ bool Layout::Chunker::Next(Chunk& c) {
 		Pos++;
 		break;
 	default:
-		c.Type = ChunkWord;
-		while (true) {
-			Pos++;
-			char ch = Txt[Pos];
-			if (ch == 0 || ch == 9 || ch == 32 || ch == '\r' || ch == '\n')
-				break;
-		}
+		c.Type    = ChunkWord;
+		c.IsASCII = true;
+		Pos       = (int32_t) (ChunkerScanWord(Txt + Pos, c.IsASCII) - Txt);
 	}
 	c.End = Pos;
 	return true;
@@ -6,6 +6,8 @@
 #include "../Text/FontStore.h"
 #include "../Base/MemPoolsAndContainers.h"
 #include "BoxLayout.h"
+#include "LayoutCache.h"
+#include "WordCache.h"
 
 namespace xo {
 
@@ -16,14 +18,46 @@ because we will probably end up splitting the text stuff out into a separate
 class, due to the fact that it gets complex if you're doing it properly
 (ie non-latin fonts, bidirectional, asian, etc).
 
-Hidden things that would bite you if you tried to multithread this:
-* We get kerning data from Freetype for each glyph pair, and I'm not sure
-that is thread safe.
+Parallel layout
+
+A node that defines a new flow context, and whose content width and height are known
+before its children are laid out (ie fixed or percentage sizes), cannot affect the placement
+of anything outside of itself, except through its baseline. Such subtrees are laid out
+concurrently, in three steps:
+1. Discover. Run a serial layout that stops at these nodes, and emits a placeholder of the
+   correct size for each of them. This tells us the inputs of every independent subtree.
+2. Run every subtree on the worker pool. Each worker has its own Layout object, and therefore
+   its own RenderStack, BoxLayout, FixedSizeHeap, Pool, and set of missing glyphs.
+3. Run the serial layout again, but this time copy the finished subtrees into place.
+   This second pass is necessary because the parents of these nodes need their baselines.
+Subtrees that are nested inside an independent subtree are laid out serially by the worker.
+Workers live as long as their owner, so an owner that is reused for every frame (as RenderDoc does)
+creates them, and their heaps, only once.
+If the discovery pass does not find any independent subtrees, then it is the final layout.
+
+Layout never touches a Freetype face, so the workers don't need any locks for text.
+Kerning comes from Font::Kerning, which is built when the font is loaded, and never changes.
+
+If a LayoutCache is given, then nodes that define a new flow context, and which have not changed
+since the previous layout, are copied out of the previous layout instead of being recomputed.
+See LayoutCache for the rules.
+
+If a StyleCache is given, then it is shared by our RenderStack and those of the workers.
+A WordCache, which MeasureWord consults before measuring a word, is shared too, but only for
+lookups. The words that a Layout measures go into its own NewWords, and after every pass, the
+owner merges its own and those of its workers into the shared cache.
 
 */
 class XO_API Layout {
 public:
-	void PerformLayout(const Doc& doc, RenderDomNode& root, Pool* pool);
+	uint32_t NumParallelJobs  = 0; // Number of subtrees that were laid out by the worker pool, in the most recent layout
+	uint32_t NumPasses        = 0; // Number of passes of the most recent layout. More than one means that fonts or glyphs were missing.
+	double   TimeStyleResolve = 0; // Seconds spent resolving styles, summed over all threads. Only measured when Global()->EnableFrameProfiler is set.
+	double   TimeRepasses     = 0; // Seconds spent in passes after the first
+
+	~Layout();
+
+	void PerformLayout(const Doc& doc, RenderDomNode& root, Pool* pool, LayoutCache* cache = nullptr, StyleCache* styleCache = nullptr, WordCache* wordCache = nullptr);
 
 protected:
 	// Packed set of bindings between child and parent node
@@ -70,21 +104,42 @@ protected:
 		int32_t   Start;
 		int32_t   End;
 		ChunkType Type;
+		bool      IsASCII; // Every byte is below 128. Only set for ChunkWord.
 	};
 
 	struct TextRunState {
-		const DomText*        Node;
-		RenderDomNode*        RNode;    // Parent of the text nodes
-		RenderDomText*        RNodeTxt; // Child of RNode
-		RingBuf<RenderCharEl> Chars;
-		cheapvec<int32_t>*    RestartPoints;
-		float                 FontWidthScale;
-		int                   FontSizePx;
-		bool                  GlyphsNeeded;
-		bool                  IsSubPixel;
-		Pos                   FontAscender;
-		xo::FontID            FontID;
-		xo::Color             Color;
+		const DomText*                          Node;
+		RenderDomNode*                          RNode;    // Parent of the text nodes
+		RenderDomText*                          RNodeTxt; // Child of RNode
+		RingBuf<RenderCharEl>                   Chars;
+		cheapvec<int32_t>*                      RestartPoints;
+		const GlyphTableImmutable::ASCIIGlyphs* ASCIIGlyphs; // Null if none of the ASCII glyphs of this font are in the cache
+		float                                   FontWidthScale;
+		int                                     FontSizePx;
+		bool                                    GlyphsNeeded;
+		bool                                    IsSubPixel;
+		Pos                                     FontAscender;
+		xo::FontID                              FontID;
+		xo::Color                               Color;
+	};
+
+	enum ParallelPasses {
+		ParallelNone,     // Serial layout
+		ParallelDiscover, // Emit placeholders for independent subtrees, and record them as jobs
+		ParallelConsume,  // Copy the output of the jobs into place
+	};
+
+	// A subtree that is laid out by the worker pool
+	struct ParallelJob {
+		const DomNode*     Node;
+		LayoutCache::Entry Result; // Inputs are filled in by the discovery pass, and outputs by a worker
+	};
+
+	// State of a thread that is laying out ParallelJobs
+	struct ParallelWorker {
+		xo::Layout* Owner;
+		xo::Layout* Layout;
+		xo::Pool    Pool; // Render nodes produced by the worker live here until they are copied into the final layout
 	};
 
 	struct FlowState {
@@ -99,6 +154,11 @@ protected:
 	};
 
 	const xo::Doc*               Doc;
+	LayoutCache*                 Cache;
+	xo::WordCache*               Words = nullptr; // Read-only during a pass
+	xo::WordCache                NewWords;        // Words that we measured during this pass, which are not in Words
+	uint32_t                     NumWordHits   = 0;
+	uint32_t                     NumWordMisses = 0;
 	BoxLayout                    Boxer;
 	xo::Pool*                    Pool;
 	RenderStack                  Stack;
@@ -106,16 +166,29 @@ protected:
 	float                        PtToPixel;
 	float                        EpToPixel;
 	FontTableImmutable           Fonts;
+	const GlyphTableImmutable*   Glyphs = nullptr; // Held for the duration of a pass. Workers share the snapshot of their owner.
 	ohash::set<GlyphCacheKey>    GlyphsNeeded;
 	ohash::set<FontIDWeightPair> FontsNeeded; // Will only be here because of a weight that is not 400 (regular)
 	TextRunState                 TempText;
 	bool                         SnapBoxes;
 	bool                         SnapHorzText;
 	bool                         EnableKerning;
+	bool                         ProfileStyles; // Measure TimeStyleResolve
+	ParallelPasses               ParallelPass = ParallelNone;
+	cheapvec<ParallelJob>        Jobs;
+	cheapvec<int32_t>            JobByInternalID; // Index into Jobs, or -1
+	cheapvec<ParallelWorker*>    Workers;
+	std::atomic<size_t>          NextJob;
+	cheapvec<RenderCharEl>       TempWordChars; // Characters of the word that MeasureWord is adding to Words
 
 	void  RenderFontsNeeded();
 	void  RenderGlyphsNeeded();
 	void  LayoutInternal(RenderDomNode& root);
+	void  BeginParallelDiscovery();
+	void  RunParallelJobs();
+	void  MergeNewWords();
+	void  BeginWorker(const Layout& owner, xo::Pool* pool);
+	void  RunParallelJob(ParallelJob& job);
 	void  RunNode(const DomNode* node, const LayoutInput& in, LayoutOutput& out);
 	void  RunText(const DomText* node, const LayoutInput& in, LayoutOutput& out);
 	Point PositionChildFromBindings(const LayoutInput& cin, Pos parentBaseline, LayoutOutput& cout);
@@ -132,7 +205,8 @@ protected:
 	Box  ComputeBox(Pos containerWidth, Pos containerHeight, StyleBox box);
 	void PopulateBindings(BindingSet& bindings);
 
-	Pos HoriAdvance(const Glyph* glyph, const TextRunState& ts);
+	Pos            HoriAdvance(const Glyph* glyph, const TextRunState& ts);
+	WordCache::Key MakeWordCacheKey(const TextRunState& ts) const;
 
 	static Pos           HBindOffset(HorizontalBindings bind, Pos left, Pos width);
 	static Pos           VBindOffset(VerticalBindings bind, Pos top, Pos baseline, Pos height);
@@ -143,6 +217,8 @@ protected:
 	static GlyphCacheKey MakeGlyphCacheKey(bool isSubPixel, FontID fontID, int fontSizePx);
 	static bool          IsAllZeros(const cheapvec<int32_t>& list);
 	static void          MoveChildren(RenderDomEl* relem, Point delta);
+	static bool          MovesChildren(const BindingSet& bindings);
+	static void          ParallelWorkerFunc(ParallelWorker* w);
 
 	static bool IsDefined(Pos p) { return p != PosNULL; }
 	static bool IsNull(Pos p) { return p == PosNULL; }
@@ -150,7 +226,8 @@ protected:
 	// Break a string up into chunks, where each chunk is either a word, or
 	// a series of one or more identical whitespace characters. A linebreak
 	// such as \r\n is emitted as a single chunk.
-	// When I get around to it, this will probably do UTF8 interpretation too
+	// Words and runs of whitespace are scanned 16 or 32 bytes at a time, which also tells us
+	// whether a word is pure ASCII, so that MeasureWord can skip UTF-8 decoding.
 	class Chunker {
 	public:
 		Chunker(const char* txt);
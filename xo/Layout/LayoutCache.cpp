@@ -0,0 +1,163 @@
+#include "pch.h"
+#include "LayoutCache.h"
+#include "Doc.h"
+#include "Dom/DomEl.h"
+#include "Render/RenderDomEl.h"
+#include "Render/RenderStack.h"
+#include "../../dependencies/hash/xxhash_xo_wrapper.h"
+
+namespace xo {
+
+bool LayoutCache::Entry::SameInputs(const Entry& b) const {
+	return StyleHash == b.StyleHash &&
+	       ParentWidth == b.ParentWidth &&
+	       ParentHeight == b.ParentHeight &&
+	       RemainingX == b.RemainingX &&
+	       RemainingY == b.RemainingY;
+}
+
+void LayoutCache::BeginLayout(const Doc& doc) {
+	uint64_t fingerprint = ComputeFingerprint(doc);
+	CanReuse             = Global()->EnableIncrementalLayout && fingerprint == Fingerprint && Prev.size() != 0;
+	Fingerprint          = fingerprint;
+
+	SubtreeChanged.Reset();
+
+	for (size_t i = 0; i < ChangedIDs.size(); i++)
+		MarkChanged(doc, ChangedIDs[i]);
+	ChangedIDs.clear();
+
+	// Hovering over an element changes its style, without modifying the element
+	cheapvec<InternalID> pseudo;
+	doc.UI.GetPseudoClassIDs(pseudo);
+	for (size_t i = 0; i < pseudo.size(); i++) {
+		if (!Contains(PseudoIDs, pseudo[i]))
+			MarkChanged(doc, pseudo[i]);
+	}
+	for (size_t i = 0; i < PseudoIDs.size(); i++) {
+		if (!Contains(pseudo, PseudoIDs[i]))
+			MarkChanged(doc, PseudoIDs[i]);
+	}
+	std::swap(PseudoIDs, pseudo);
+}
+
+void LayoutCache::BeginPass() {
+	Next.clear();
+	NumReused = 0;
+}
+
+void LayoutCache::EndLayout() {
+	std::swap(Prev, Next);
+	Next.clear();
+}
+
+void LayoutCache::Invalidate(const DirtyBitmap& modified) {
+	modified.ToList(ChangedIDs);
+}
+
+void LayoutCache::ForceChanged(InternalID id) {
+	ChangedIDs += id;
+}
+
+const LayoutCache::Entry* LayoutCache::Find(InternalID id, const Entry& inputs) const {
+	if (!CanReuse || (size_t) id >= Prev.size() || SubtreeChanged.Get(id))
+		return nullptr;
+	const Entry& e = Prev[id];
+	if (e.RNode == nullptr || e.Ambiguous || !e.SameInputs(inputs))
+		return nullptr;
+	return &e;
+}
+
+void LayoutCache::Add(InternalID id, const Entry& e) {
+	Grow(Next, id);
+	if (Next[id].RNode != nullptr) {
+		Next[id].Ambiguous = true;
+		return;
+	}
+	Next[id] = e;
+}
+
+void LayoutCache::ShareChildren(const RenderDomNode* src, RenderDomNode* dst) {
+	dst->Children.resize(src->Children.size());
+	for (size_t i = 0; i < src->Children.size(); i++)
+		dst->Children[i] = src->Children[i];
+}
+
+void LayoutCache::CloneChildren(const RenderDomNode* src, RenderDomNode* dst, Pool* pool) {
+	dst->Children.resize(src->Children.size());
+	for (size_t i = 0; i < src->Children.size(); i++) {
+		const RenderDomEl* c = src->Children[i];
+		if (c->IsNode()) {
+			const RenderDomNode* cnode = static_cast<const RenderDomNode*>(c);
+			RenderDomNode*       copy  = new (pool->AllocT<RenderDomNode>(false)) RenderDomNode(cnode->InternalID, cnode->Tag, pool);
+			copy->Pos                  = cnode->Pos;
+			copy->Style                = cnode->Style;
+			CloneChildren(cnode, copy, pool);
+			dst->Children[i] = copy;
+		} else {
+			const RenderDomText* ctxt = static_cast<const RenderDomText*>(c);
+			RenderDomText*       copy = new (pool->AllocT<RenderDomText>(false)) RenderDomText(ctxt->InternalID, pool);
+			copy->Pos                 = ctxt->Pos;
+			copy->FontID              = ctxt->FontID;
+			copy->Color               = ctxt->Color;
+			copy->FontSizePx          = ctxt->FontSizePx;
+			copy->Flags               = ctxt->Flags;
+			copy->Text.resize(ctxt->Text.size());
+			if (ctxt->Text.size() != 0)
+				memcpy(&copy->Text[0], &ctxt->Text[0], ctxt->Text.size() * sizeof(RenderCharEl));
+			dst->Children[i] = copy;
+		}
+	}
+}
+
+uint64_t LayoutCache::HashStyle(const RenderStack& stack) {
+	StyleAttrib all[CatEND];
+	for (int i = CatFIRST; i < CatEND; i++)
+		all[i] = stack.Get((StyleCategories) i);
+	uint8_t pseudo[3] = {stack.HasHoverStyle(), stack.HasFocusStyle(), stack.HasCaptureStyle()};
+	uint64_t h        = XXH64(all + CatFIRST, (CatEND - CatFIRST) * sizeof(StyleAttrib), 0);
+	return XXH64(pseudo, sizeof(pseudo), h);
+}
+
+void LayoutCache::MarkChanged(const Doc& doc, InternalID id) {
+	// Stop as soon as we reach an element that is already marked, because all of its ancestors will be marked too
+	while (id != InternalIDNull && (size_t) id < (size_t) doc.InternalIDSize() && !SubtreeChanged.Get(id)) {
+		SubtreeChanged.Set(id);
+		const DomEl* el = doc.GetChildByInternalID(id);
+		if (el == nullptr)
+			break;
+		id = el->GetParentID();
+	}
+}
+
+void LayoutCache::Grow(cheapvec<Entry>& list, InternalID id) {
+	while (list.size() <= (size_t) id)
+		list += Entry();
+}
+
+uint64_t LayoutCache::ComputeFingerprint(const Doc& doc) {
+	const GlobalStruct* g = Global();
+	uint32_t settings[]   = {
+		doc.UI.GetViewportWidth(),
+		doc.UI.GetViewportHeight(),
+		(uint32_t) g->MaxSubpixelGlyphSize,
+		(uint32_t) g->SnapBoxes,
+		(uint32_t) g->SnapHorzText,
+		(uint32_t) g->EnableKerning,
+		(uint32_t) g->EnableSubpixelText,
+		(uint32_t) g->RoundLineHeights,
+	};
+	float    epToPixel = g->EpToPixel;
+	uint64_t h         = doc.StyleFingerprint();
+	h                  = XXH64(settings, sizeof(settings), h);
+	return XXH64(&epToPixel, sizeof(epToPixel), h);
+}
+
+bool LayoutCache::Contains(const cheapvec<InternalID>& list, InternalID id) {
+	for (size_t i = 0; i < list.size(); i++) {
+		if (list[i] == id)
+			return true;
+	}
+	return false;
+}
+} // namespace xo
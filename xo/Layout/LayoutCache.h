@@ -0,0 +1,97 @@
+#pragma once
+#include "../Defs.h"
+#include "../Containers/DirtyBitmap.h"
+
+namespace xo {
+
+class RenderStack;
+
+/* Remembers the layout of flow context nodes from the previous frame, so that Layout can copy
+the render tree of an unchanged subtree instead of recomputing it.
+
+A node that defines a new flow context lays out its children in its own coordinate system,
+and restarts never propagate out of it. Its render subtree is therefore a pure function of:
+* The resolved style of the node (which includes everything it inherits from its ancestors)
+* The size of its parent, and the space remaining in its parent's flow when it is placed
+* The DOM content and the styles of all of its descendants
+* Document-wide state, such as class styles, style variables and a few global settings
+
+The first two are stored in each Entry, and compared on lookup. The third is tracked with the
+document's modified bitmap: RenderDoc passes us the IDs of the elements that it copies from the
+canonical document, and at the next layout each of those, as well as any element whose :hover, :focus
+or :capture state has changed, marks itself and all of its ancestors as dirty. The cost is therefore
+proportional to the number of changed elements and the depth of the tree, not the size of the document.
+The renderer's Animator modifies styles without going through the canonical document, so it reports those
+elements with ForceChanged. The last one is reduced to a fingerprint, and if that changes, then nothing is reused.
+
+A reused node gets a new render node of its own, but its children are the children of the previous
+frame's node. The subtree is not copied, so the new render tree points into the memory of the previous
+one, and RenderDoc keeps that memory alive for as long as any layout refers to it. When ShareReused is
+false, the subtree is copied instead.
+
+Entries point into the render tree of the previous frame, so that tree must stay alive until the
+next layout is complete. RenderDoc guarantees this, because it only deletes its previous layout
+after publishing a new one.
+
+Nodes whose size can be stretched by bindings (eg left and right both bound) are never recorded,
+because their parent modifies them and their children after they have been laid out.
+*/
+class XO_API LayoutCache {
+public:
+	struct Entry {
+		const RenderDomNode* RNode = nullptr; // Render node that was produced last time. Null if this is not a valid entry.
+		uint64_t             StyleHash;       // Hash of the resolved style of the node
+		Pos                  ParentWidth;     // These four are the inputs from our parent
+		Pos                  ParentHeight;
+		Pos                  RemainingX;
+		Pos                  RemainingY;
+		Pos                  ContentWidth; // These three are the outputs
+		Pos                  ContentHeight;
+		Pos                  Baseline;
+		bool                 Ambiguous = false; // The node was laid out more than once during a single pass, so we don't know which result survived
+
+		bool SameInputs(const Entry& b) const;
+	};
+
+	uint32_t NumReused   = 0;    // Number of nodes reused during the most recent layout
+	bool     ShareReused = true; // Point into the previous render tree instead of copying reused subtrees
+
+	void BeginLayout(const Doc& doc);             // Compute dirty state. Call once before the first pass of a layout.
+	void BeginPass();                             // Discard entries recorded by a previous pass of the current layout
+	void EndLayout();                             // The entries recorded during the final pass become the reference for the next layout
+	void Invalidate(const DirtyBitmap& modified); // Treat every element in 'modified' as changed at the next layout
+	void ForceChanged(InternalID id);             // Treat 'id' as changed at the next layout
+
+	// Returns null if there is no entry with the same inputs, or if the subtree beneath 'id' has changed since it was recorded
+	const Entry* Find(InternalID id, const Entry& inputs) const;
+
+	// Record the result of laying out 'id'
+	void Add(InternalID id, const Entry& e);
+
+	// Make the children of 'src' the children of 'dst', without copying them. Only the list of pointers is allocated.
+	static void ShareChildren(const RenderDomNode* src, RenderDomNode* dst);
+
+	// Deep copy the children of 'src' into 'dst'. All memory is allocated from 'pool'.
+	static void CloneChildren(const RenderDomNode* src, RenderDomNode* dst, Pool* pool);
+
+	// Hash the resolved style at the top of the stack
+	static uint64_t HashStyle(const RenderStack& stack);
+
+	// Hash of the document-wide state that affects layout. If this changes, then nothing is reused.
+	static uint64_t ComputeFingerprint(const Doc& doc);
+
+protected:
+	cheapvec<Entry>      Prev;           // Indexed by InternalID
+	cheapvec<Entry>      Next;           // Indexed by InternalID
+	DirtyBitmap          SubtreeChanged; // Set if an element, or any of its descendants, has changed. Indexed by InternalID.
+	cheapvec<InternalID> PseudoIDs;      // Elements that were hovered, focused or captured at the previous layout
+	cheapvec<InternalID> ChangedIDs;     // Elements passed to Invalidate or ForceChanged since the previous layout
+	uint64_t             Fingerprint = 0;
+	bool                 CanReuse    = false;
+
+	void MarkChanged(const Doc& doc, InternalID id);
+	void Grow(cheapvec<Entry>& list, InternalID id);
+
+	static bool Contains(const cheapvec<InternalID>& list, InternalID id);
+};
+} // namespace xo
@@ -0,0 +1,83 @@
+#include "pch.h"
+#include "WordCache.h"
+#include "../../dependencies/hash/xxhash_xo_wrapper.h"
+
+namespace xo {
+
+WordCache::WordCache() {
+	Pool.SetChunkSize(64 * 1024, 64 * 1024);
+}
+
+WordCache::~WordCache() {
+}
+
+void WordCache::BeginLayout() {
+	if (Pool.TotalAllocatedBytes() > MaxBytes)
+		Clear();
+	NumHits   = 0;
+	NumMisses = 0;
+}
+
+const WordCache::Entry* WordCache::Find(const Key& key, const char* word, size_t wordLen) const {
+	return FindEntry(Hash(key, word, wordLen), key, word, wordLen);
+}
+
+void WordCache::Add(const Key& key, const char* word, size_t wordLen, Pos width, const RenderCharEl* chars, size_t numChars) {
+	AddEntry(Hash(key, word, wordLen), key, word, wordLen, width, chars, numChars);
+}
+
+void WordCache::MergeFrom(const WordCache& other) {
+	for (auto& pair : other.Map) {
+		for (const Entry* e = pair.second; e != nullptr; e = e->Next)
+			AddEntry(e->Hash, e->Key, e->Word, e->WordLen, e->Width, e->Chars, e->NumChars);
+	}
+}
+
+void WordCache::AddEntry(uint64_t hash, const Key& key, const char* word, size_t wordLen, Pos width, const RenderCharEl* chars, size_t numChars) {
+	// Two threads might have measured the same word during the same pass
+	if (FindEntry(hash, key, word, wordLen) != nullptr)
+		return;
+
+	Entry* e    = Pool.AllocT<Entry>(false);
+	e->Hash     = hash;
+	e->Key      = key;
+	e->Word     = (const char*) Pool.Copy(word, wordLen);
+	e->WordLen  = (uint32_t) wordLen;
+	e->NumChars = (uint32_t) numChars;
+	e->Chars    = (const RenderCharEl*) Pool.Copy(chars, numChars * sizeof(RenderCharEl));
+	e->Width    = width;
+
+	Entry** head = Map.getp(hash);
+	if (head != nullptr) {
+		e->Next = *head;
+		*head   = e;
+	} else {
+		e->Next = nullptr;
+		Map.insert(hash, e);
+	}
+}
+
+void WordCache::Clear() {
+	Map.clear();
+	Pool.FreeAll();
+}
+
+const WordCache::Entry* WordCache::FindEntry(uint64_t hash, const Key& key, const char* word, size_t wordLen) const {
+	Entry* e = nullptr;
+	Map.get(hash, e);
+	for (; e != nullptr; e = e->Next) {
+		if (e->WordLen == wordLen && SameKey(e->Key, key) && memcmp(e->Word, word, wordLen) == 0)
+			return e;
+	}
+	return nullptr;
+}
+
+uint64_t WordCache::Hash(const Key& key, const char* word, size_t wordLen) {
+	int32_t k[3] = {key.FontID, key.FontSizePx, (int32_t) key.Flags};
+	return XXH64(word, wordLen, XXH64(k, sizeof(k), 0));
+}
+
+bool WordCache::SameKey(const Key& a, const Key& b) {
+	return a.FontID == b.FontID && a.FontSizePx == b.FontSizePx && a.Flags == b.Flags;
+}
+} // namespace xo
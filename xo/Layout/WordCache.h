@@ -0,0 +1,86 @@
+#pragma once
+#include "../Defs.h"
+#include "../Render/RenderDomEl.h"
+
+namespace xo {
+
+/* Remembers the character placements of words from previous layouts, so that measuring a word
+that has been seen before costs a hash lookup and a copy, instead of decoding its UTF-8, looking
+up every glyph, and asking Freetype for the kerning of every pair.
+
+The placement of a word is a pure function of:
+* Its bytes
+* The font, the font size, and whether glyphs are rendered with subpixel precision
+* The global settings SnapHorzText and EnableKerning
+All of these are part of the key. The metrics of a glyph never change after it has been rendered.
+
+Characters are stored relative to the start of the word, so OriginalCharIndex must be offset
+by the position of the word inside its text.
+
+A word with missing glyphs is never added, because it will be measured again once the glyphs
+have been rendered.
+
+The cache persists across frames. During a layout, it is shared by the worker threads, but
+nobody modifies it, so Find takes no lock. Every Layout collects the words that it measures
+in a WordCache of its own, which only its own thread touches, and the owner merges them into
+the shared cache with MergeFrom, once the workers are done. If the cache grows beyond MaxBytes,
+then we start from scratch at the next layout.
+*/
+class XO_API WordCache {
+public:
+	enum KeyFlags {
+		KeySubPixel = 1,
+		KeyKerning  = 2,
+		KeySnapHorz = 4,
+	};
+
+	struct Key {
+		xo::FontID FontID;
+		int32_t    FontSizePx;
+		uint32_t   Flags; // KeyFlags
+	};
+
+	struct Entry {
+		uint64_t            Hash;
+		WordCache::Key      Key;
+		const char*         Word;
+		uint32_t            WordLen;
+		uint32_t            NumChars;
+		const RenderCharEl* Chars;
+		Pos                 Width; // Sum of the horizontal advances of all characters
+		Entry*              Next;  // Next entry with the same hash
+	};
+
+	static const size_t MaxBytes = 4 * 1024 * 1024;
+
+	uint32_t NumHits   = 0; // Number of words found in the cache, during the most recent layout. Summed by Layout.
+	uint32_t NumMisses = 0; // Number of words that were measured, during the most recent layout. Summed by Layout.
+
+	WordCache();
+	~WordCache();
+
+	void BeginLayout(); // Discard everything if we have grown too large
+
+	// Returns null if the word is not in the cache. The entry remains valid until the next BeginLayout, MergeFrom or Clear.
+	// Safe to call from any number of threads at once, as long as nobody is modifying the cache.
+	const Entry* Find(const Key& key, const char* word, size_t wordLen) const;
+
+	// Remember the placement of the characters of a word. Not thread safe.
+	void Add(const Key& key, const char* word, size_t wordLen, Pos width, const RenderCharEl* chars, size_t numChars);
+
+	// Add every word of 'other' that we don't have yet. Not thread safe.
+	void MergeFrom(const WordCache& other);
+
+	size_t Size() const { return Map.size(); }
+	void   Clear();
+
+protected:
+	ohash::map<uint64_t, Entry*> Map;
+	xo::Pool                     Pool; // Entries, words and characters live here
+
+	const Entry*    FindEntry(uint64_t hash, const Key& key, const char* word, size_t wordLen) const;
+	void            AddEntry(uint64_t hash, const Key& key, const char* word, size_t wordLen, Pos width, const RenderCharEl* chars, size_t numChars);
+	static uint64_t Hash(const Key& key, const char* word, size_t wordLen);
+	static bool     SameKey(const Key& a, const Key& b);
+};
+} // namespace xo
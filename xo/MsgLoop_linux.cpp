@@ -48,7 +48,16 @@ static cheapvec<DocGroupLinux*> SelectDocsWithEventsInQueue() {
 
 	cheapvec<DocGroupLinux*> ready;
 
-	timeval timeout = {2, 0}; // seconds, microseconds
+	// Wake up in time for the next step of any stepped animation, such as a blinking caret
+	double wait = 2;
+	double now  = TimeAccurateSeconds();
+	for (DocGroup* dg : Global()->Docs) {
+		double next = dg->NextAnimationChange();
+		if (next != 0)
+			wait = Min(wait, Max(next - now, 0.0));
+	}
+
+	timeval timeout = {(time_t) wait, (suseconds_t) ((wait - floor(wait)) * 1000000)}; // seconds, microseconds
 	int     nsel    = select(xf_max + 1, &readFd, nullptr, nullptr, &timeout);
 	//printf("select: %d\n", nsel);
 	if (nsel == -1)
@@ -148,7 +157,7 @@ bool ProcessEventsForDoc(DocGroupLinux* dg) {
 			ev.Event.Type           = EventWindowSize;
 			ev.Event.PointsAbs[0].x = wa.width;
 			ev.Event.PointsAbs[0].y = wa.height;
-			Global()->UIEventQueue.Add(ev);
+			DocGroup::AddMessage(ev);
 			break;
 		}
 		case KeymapNotify:
@@ -164,10 +173,10 @@ bool ProcessEventsForDoc(DocGroupLinux* dg) {
 			bool dispatch, isChar;
 			MapKeyToEvent(xev.xkey, ev.Event, dispatch, isChar);
 			if (dispatch) {
-				Global()->UIEventQueue.Add(ev);
+				DocGroup::AddMessage(ev);
 				if (isChar && ev.Event.Type == EventKeyDown) {
 					ev.Event.Type = EventKeyChar;
-					Global()->UIEventQueue.Add(ev);
+					DocGroup::AddMessage(ev);
 				}
 			}
 			break;
@@ -175,9 +184,10 @@ bool ProcessEventsForDoc(DocGroupLinux* dg) {
 		case MotionNotify:
 			//printf("x,y = %d,%d\n", xev.xmotion.x, xev.xmotion.y);
 			ev.Event.Type           = EventMouseMove;
+			ev.Event.PointCount     = 1;
 			ev.Event.PointsAbs[0].x = xev.xmotion.x + cursorOffX;
 			ev.Event.PointsAbs[0].y = xev.xmotion.y + cursorOffY;
-			Global()->UIEventQueue.Add(ev);
+			DocGroup::AddOrReplaceMessage(ev);
 			break;
 		case ButtonPress:
 		case ButtonRelease:
@@ -185,7 +195,7 @@ bool ProcessEventsForDoc(DocGroupLinux* dg) {
 			ev.Event.PointsAbs[0].x = xev.xbutton.x + cursorOffX;
 			ev.Event.PointsAbs[0].y = xev.xbutton.y + cursorOffY;
 			MapButton(xev.xbutton, ev.Event);
-			Global()->UIEventQueue.Add(ev);
+			DocGroup::AddMessage(ev);
 			break;
 		}
 	}
@@ -210,7 +220,7 @@ XO_API void RunMessageLoop() {
 		for (DocGroup* dg : Global()->Docs) {
 			if (dg->IsDirty()) {
 				RenderResult rr = dg->Render();
-				if (rr == RenderResultNeedMore) {
+				if (rr == RenderResultNeedMore || dg->IsAnimating() || dg->IsStreamingImages()) {
 					dg->Wnd->PostRepaintMessage();
 				} else {
 					dg->Wnd->ValidateWindow();
@@ -9,8 +9,10 @@
 namespace xo {
 
 static void SetupTimerMessagesForAllDocs() {
-	for (DocGroup* dg : Global()->Docs)
+	for (DocGroup* dg : Global()->Docs) {
 		((DocGroupWindows*) dg)->SetSysWndTimer(dg->Doc->FastestTimerMS());
+		((DocGroupWindows*) dg)->SetAnimationTimer(dg->NextAnimationChange());
+	}
 }
 
 XO_API void RunMessageLoop() {
@@ -51,7 +53,7 @@ XO_API void RunMessageLoop() {
 			if (dg->IsDirty()) {
 				XOTRACE_OS_MSG_QUEUE("Render enter (%p)\n", dg);
 				RenderResult rr = dg->Render();
-				if (rr == RenderResultNeedMore) {
+				if (rr == RenderResultNeedMore || dg->IsAnimating() || dg->IsStreamingImages()) {
 					dg->Wnd->PostRepaintMessage();
 				} else {
 					dg->Wnd->ValidateWindow();
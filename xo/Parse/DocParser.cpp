@@ -69,6 +69,7 @@ struct ParseStack {
 				n[i] = std::move(Nodes[i]);
 			delete[] Nodes;
 			Nodes = n;
+			Cap   = ncap;
 		}
 		// This is the reason for our existence - we do not clear the storage inside the vectors
 		// Children and Attrib. Partner function Pop() is also crucial.
@@ -115,7 +116,7 @@ static Tag ParseTag(const char* t) {
 }
 
 // Recursively build real dom from virtual dom
-static String VDomToDom_R(vdom::Node* src, DomNode* dst) {
+static String VDomToDom_R(const vdom::Node* src, DomNode* dst) {
 	// Set attributes
 	for (size_t i = 0; i < src->NAttrib; i++) {
 		const auto& a = src->Attribs[i];
@@ -124,6 +125,8 @@ static String VDomToDom_R(vdom::Node* src, DomNode* dst) {
 				return tsf::fmt("Invalid style '%v'", a.Val).c_str();
 		} else if (Equals(a.Name, "class")) {
 			dst->AddClass(a.Val);
+		} else if (Equals(a.Name, "key")) {
+			// Only used by vdom::Patch, to match up children
 		} else {
 			return tsf::fmt("Invalid attribute '%v'", a.Name).c_str();
 		}
@@ -155,6 +158,17 @@ String DocParser::Parse(const char* src, DomNode* target) {
 	return VDomToDom_R(root, target);
 }
 
+String DocParser::InsertVDom(const vdom::Node* src, DomNode* parent, size_t position) {
+	if (src->IsText()) {
+		parent->AddText(src->Val, position);
+		return "";
+	}
+	auto tag = ParseTag(src->Name);
+	if (tag == TagNULL)
+		return tsf::fmt("Invalid tag '%v'", src->Name).c_str();
+	return VDomToDom_R(src, parent->AddNode(tag, position));
+}
+
 String DocParser::Parse(const char* src, vdom::Node* target, xo::Pool* pool) {
 	enum States {
 		SText,
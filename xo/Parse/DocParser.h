@@ -18,6 +18,7 @@ Example:
 
 The class and style strings can be quoted with single or double quotes.
 If you're embedding these strings inside C++ code, it's obviously nicer using single quotes.
+A 'key' attribute has no effect on the DOM. vdom::Patch uses it to match up children.
 
 The only escaped character sequences are these:
 	&gt;   >
@@ -42,6 +43,9 @@ public:
 	String Parse(const char* src, DomNode* target);
 	String Parse(const char* src, vdom::Node* target, xo::Pool* pool);
 
+	// Create a DOM element and all of its descendants from 'src', and insert it into 'parent' at 'position'
+	static String InsertVDom(const vdom::Node* src, DomNode* parent, size_t position = -1);
+
 protected:
 	xo::Pool*   Pool = nullptr;
 	static bool IsWhite(int c);
@@ -2,6 +2,7 @@
 #include "Control.h"
 #include "../Dom/DomNode.h"
 #include "../Doc.h"
+#include "../VirtualDom/Diff.h"
 
 namespace xo {
 namespace rx {
@@ -46,10 +47,42 @@ void Control::OnDocProcess(Event& ev) {
 		return;
 	Control* self = (Control*) ev.Context;
 	if (self->Dirty) {
-		self->Render();
+		if (self->RenderDiffable())
+			self->RenderDiff();
+		else
+			self->Render();
 		self->Dirty = false;
 	}
 }
 
+void Control::RenderDiff() {
+	Pool& pool = VDomPools[VDomPool ^ 1];
+	pool.FreeAll();
+	vdom::Node* next = pool.AllocT<vdom::Node>(true);
+	String      err  = RenderVDom(next, &pool);
+	if (err != "") {
+		Trace("Control render failed: %s\n", err.CStr());
+		return;
+	}
+
+	if (PrevVDom == nullptr || Root->ChildCount() != PrevVDom->NChild) {
+		// This is our first render, or somebody else has modified our DOM, so build it from scratch
+		vdom::Node empty = {};
+		Root->Clear();
+		err = vdom::Patch(&empty, next, Root);
+	} else {
+		err = vdom::Patch(PrevVDom, next, Root);
+	}
+
+	if (err != "") {
+		// The DOM no longer mirrors any virtual DOM, so the next render starts from scratch
+		Trace("Control render failed: %s\n", err.CStr());
+		PrevVDom = nullptr;
+		return;
+	}
+	PrevVDom = next;
+	VDomPool ^= 1;
+}
+
 } // namespace rx
 } // namespace xo
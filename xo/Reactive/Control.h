@@ -1,6 +1,7 @@
 #pragma once
 #include "../Defs.h"
 #include "Observer.h"
+#include "../VirtualDom/VirtualDom.h"
 
 namespace xo {
 namespace rx {
@@ -13,9 +14,19 @@ public:
 	Control(xo::DomNode* root);
 	virtual ~Control();
 
-	virtual void Render() = 0;
+	// Build the DOM beneath Root. This is only called when RenderDiffable() returns false.
+	virtual void Render() {}
+
+	// If this returns true, then RenderVDom is called instead of Render. The new virtual DOM is
+	// diffed against the previous one, and only the elements that changed are modified beneath Root,
+	// so the rest of the subtree is not marked as modified, and is not cloned again.
+	// A diffable control owns all of the children of Root.
 	virtual bool RenderDiffable() { return false; }
 
+	// Build the children of 'root', allocating everything from 'pool'. The simplest way of
+	// doing this is DocParser::Parse(markup, root, pool). Returns empty string on success, or an error message.
+	virtual String RenderVDom(vdom::Node* root, Pool* pool) { return ""; }
+
 	// Implementation of Observer
 	void ObservableTouched(Observable* target) override;
 
@@ -28,6 +39,11 @@ public:
 private:
 	std::thread::id BoundThread = std::thread::id(); // Thread on which UI is expected to run, including all DOM manipulation
 	bool            Dirty       = true;              // Hide Dirty behind getter/setter so that we can put breakpoints on SetDirty, and maybe do other things at that moment.
+	Pool            VDomPools[2];                    // Storage for the current and the previous virtual DOM
+	int             VDomPool = 0;                    // Index of the pool that holds PrevVDom
+	vdom::Node*     PrevVDom = nullptr;              // Virtual DOM that Root's children were built from. Null if we don't know.
+
+	void RenderDiff();
 };
 
 } // namespace rx
@@ -0,0 +1,138 @@
+#include "pch.h"
+#include "Animator.h"
+#include "RenderDoc.h"
+#include "RenderDomEl.h"
+#include "../Doc.h"
+
+namespace xo {
+
+Animator::Animator() {
+	IsAnimating = false;
+	NextChange  = 0;
+}
+
+bool Animator::HasLayoutAnimations(const Doc& doc) const {
+	for (const auto& a : doc.GetAnimations()) {
+		if (a.AffectsLayout())
+			return true;
+	}
+	return false;
+}
+
+void Animator::ApplyToDoc(Doc& doc, LayoutCache& cache, double now) {
+	RestoreDoc(doc, cache);
+	for (const auto& a : doc.GetAnimations()) {
+		if (!a.AffectsLayout())
+			continue;
+		DomNode* node = FindNode(doc, a.Node);
+		if (node == nullptr)
+			continue;
+		SavedAttrib save;
+		save.Node              = a.Node;
+		save.Category          = a.Property == AnimWidth ? CatWidth : CatHeight;
+		const StyleAttrib* old = node->Style.Get(save.Category);
+		save.Existed           = old != nullptr;
+		if (old != nullptr)
+			save.Original = *old;
+		Saved += save;
+
+		StyleAttrib attrib;
+		attrib.SetSize(save.Category, Size::Pixels(Max(a.ValueAt(now), 0.0f)));
+		node->Style.Set(attrib);
+		cache.ForceChanged(a.Node);
+	}
+}
+
+void Animator::RestoreDoc(Doc& doc, LayoutCache& cache) {
+	for (const auto& save : Saved) {
+		DomNode* node = FindNode(doc, save.Node);
+		if (node == nullptr)
+			continue;
+		cache.ForceChanged(save.Node);
+		if (save.Existed) {
+			node->Style.Set(save.Original);
+		} else {
+			auto& attribs = node->Style.Attribs;
+			for (size_t i = 0; i < attribs.size(); i++) {
+				if (attribs[i].GetCategory() == save.Category) {
+					attribs.erase(i);
+					break;
+				}
+			}
+		}
+	}
+	Saved.clear();
+}
+
+void Animator::ApplyToLayout(const Doc& doc, LayoutResult& layout, double now) {
+	const auto& anims     = doc.GetAnimations();
+	bool        animating = false;
+	double      next      = DBL_MAX;
+	NumApplied            = 0;
+
+	// Opacity goes last, so that it fades the animated colors of the element and its descendants
+	for (int pass = 0; pass < 2; pass++) {
+		for (const auto& a : anims) {
+			if ((a.Property == AnimOpacity) != (pass == 1))
+				continue;
+			double change = a.NextChange(now);
+			if (change <= now)
+				animating = true;
+			else
+				next = Min(next, change);
+			NumApplied++;
+			RenderDomNode* rnode = (size_t) a.Node < layout.IDToNodeTable.size() ? layout.IDToNodeTable[a.Node] : nullptr;
+			if (rnode == nullptr)
+				continue;
+			switch (a.Property) {
+			case AnimBackground:
+				rnode->Style.BackgroundColor = a.ColorAt(now);
+				break;
+			case AnimBorderColor: {
+				Color c = a.ColorAt(now);
+				for (int i = 0; i < 4; i++)
+					rnode->Style.BorderColor[i] = c;
+				break;
+			}
+			case AnimOpacity:
+				Fade(rnode, Clamp(a.ValueAt(now), 0.0f, 1.0f));
+				break;
+			case AnimTranslateX:
+				rnode->Pos.Offset(RealToPos(a.ValueAt(now)), 0);
+				break;
+			case AnimTranslateY:
+				rnode->Pos.Offset(0, RealToPos(a.ValueAt(now)));
+				break;
+			case AnimWidth:
+			case AnimHeight:
+				// Already applied by ApplyToDoc
+				break;
+			}
+		}
+	}
+	IsAnimating = animating;
+	NextChange  = next != DBL_MAX ? next : 0;
+}
+
+DomNode* Animator::FindNode(Doc& doc, InternalID id) {
+	if ((size_t) id >= (size_t) doc.InternalIDSize())
+		return nullptr;
+	return doc.GetNodeByInternalIDMutable(id);
+}
+
+void Animator::Fade(RenderDomEl* el, float opacity) {
+	auto fade = [opacity](Color& c) {
+		c.a = (uint8_t) Round(c.a * opacity);
+	};
+	RenderDomNode* node = el->ToNode();
+	if (node != nullptr) {
+		fade(node->Style.BackgroundColor);
+		for (int i = 0; i < 4; i++)
+			fade(node->Style.BorderColor[i]);
+		for (size_t i = 0; i < node->Children.size(); i++)
+			Fade(node->Children[i], opacity);
+	} else {
+		fade(el->ToText()->Color);
+	}
+}
+} // namespace xo
@@ -0,0 +1,48 @@
+#pragma once
+#include "../Animation.h"
+#include "../Style.h"
+
+namespace xo {
+
+class LayoutResult;
+class LayoutCache;
+
+/* Evaluates the animations of the renderer's clone of the document, on every frame.
+
+Colors, opacity and translation are written into the render tree after layout. They never
+change the layout, so when nothing else has changed since the previous frame, RenderDoc skips
+layout entirely, and applies them to a copy of the previous render tree.
+
+Width and height do change the layout. These are written straight into the styles of the
+elements of the clone before layout, without bumping their versions, because the clone's
+versions must keep mirroring the canonical document. Those elements must be restored before
+the clone is updated from the canonical document, otherwise an element that is not cloned
+again would keep its animated size. Every element that is written or restored is reported to
+the LayoutCache, so that only its subtree and its ancestors are laid out again.
+*/
+class XO_API Animator {
+public:
+	std::atomic<bool>   IsAnimating;    // True if the most recent frame had animations that change continuously. Read by the UI thread.
+	std::atomic<double> NextChange;     // Earliest time at which an animation that changes in steps (eg a blinking caret) changes again, or zero if there is none. Read by the UI thread.
+	uint32_t            NumApplied = 0; // Number of animations applied by the most recent frame
+
+	Animator();
+
+	bool HasLayoutAnimations(const Doc& doc) const;
+	void ApplyToDoc(Doc& doc, LayoutCache& cache, double now);            // Write animated sizes into element styles
+	void RestoreDoc(Doc& doc, LayoutCache& cache);                        // Undo ApplyToDoc
+	void ApplyToLayout(const Doc& doc, LayoutResult& layout, double now); // layout.IDToNodeTable must be populated
+
+protected:
+	struct SavedAttrib {
+		InternalID      Node;
+		StyleCategories Category;
+		bool            Existed; // False if the node had no attribute of this category
+		StyleAttrib     Original;
+	};
+	cheapvec<SavedAttrib> Saved; // Attributes overwritten by ApplyToDoc
+
+	static DomNode* FindNode(Doc& doc, InternalID id);
+	static void     Fade(RenderDomEl* el, float opacity);
+};
+} // namespace xo
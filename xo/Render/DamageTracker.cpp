@@ -0,0 +1,159 @@
+#include "pch.h"
+#include "DamageTracker.h"
+#include "RenderDomEl.h"
+#include "../Doc.h"
+#include "../Dom/DomCanvas.h"
+
+namespace xo {
+
+// FNV-1a
+static uint64_t HashBytes(uint64_t h, const void* data, size_t len) {
+	const uint8_t* b = (const uint8_t*) data;
+	for (size_t i = 0; i < len; i++) {
+		h ^= b[i];
+		h *= 1099511628211ull;
+	}
+	return h;
+}
+
+template <typename T>
+static uint64_t HashValue(uint64_t h, const T& v) {
+	return HashBytes(h, &v, sizeof(v));
+}
+
+static const uint64_t HashSeed = 14695981039346656037ull;
+
+Box DamageTracker::Update(const Doc& doc, const RenderDomNode* root, Box viewport, Box extra) {
+	ElSig empty;
+	empty.Bounds = Box::Inverted();
+	empty.Hash   = 0;
+	Next.resize(doc.InternalIDSize());
+	Next.fill(empty);
+
+	Walk(doc, Point(0, 0), root, InternalIDNull);
+
+	Box damage = Box::Inverted();
+	if (!HavePrev || viewport != PrevViewport) {
+		damage = viewport;
+	} else {
+		size_t n = Max(Prev.size(), Next.size());
+		for (size_t i = 0; i < n; i++) {
+			const ElSig& p = i < Prev.size() ? Prev[i] : empty;
+			const ElSig& c = i < Next.size() ? Next[i] : empty;
+			if (p.Hash != c.Hash || p.Bounds != c.Bounds) {
+				damage.ExpandToFit(p.Bounds);
+				damage.ExpandToFit(c.Bounds);
+			}
+		}
+	}
+	if (extra.IsAreaPositive())
+		damage.ExpandToFit(extra);
+	damage.ClampTo(viewport);
+	if (!damage.IsAreaPositive())
+		damage.SetInverted();
+
+	if (History.size() == MaxHistory)
+		History.erase(0);
+	History += damage;
+
+	std::swap(Prev, Next);
+	PrevViewport = viewport;
+	HavePrev     = true;
+	return damage;
+}
+
+bool DamageTracker::RepaintRegion(int backbufferAge, Box& region) const {
+	if (backbufferAge < 1 || backbufferAge > (int) History.size())
+		return false;
+	region = Box::Inverted();
+	for (size_t i = History.size() - backbufferAge; i < History.size(); i++)
+		region.ExpandToFit(History[i]);
+	return true;
+}
+
+void DamageTracker::Reset() {
+	HavePrev = false;
+	History.clear();
+}
+
+Box DamageTracker::PaintBounds(Point base, const RenderDomEl* el) {
+	Box b = el->Pos;
+	b.Offset(base);
+	if (el->IsNode()) {
+		// This matches the outer edges that Renderer::RenderNode emits
+		const StyleRender& style = static_cast<const RenderDomNode*>(el)->Style;
+		b.Left -= style.BorderSize.Left + style.Padding.Left;
+		b.Top -= style.BorderSize.Top + style.Padding.Top;
+		b.Right += style.BorderSize.Right + style.Padding.Right;
+		b.Bottom += style.BorderSize.Bottom + style.Padding.Bottom;
+	} else {
+		// Glyphs can hang outside of the line box (italics, accents, descenders), and the
+		// glyph quads are overdrawn to filter over their edges.
+		const RenderDomText* txt    = static_cast<const RenderDomText*>(el);
+		Point                origin = b.TopLeft();
+		for (size_t i = 0; i < txt->Text.size(); i++) {
+			const RenderCharEl& c = txt->Text[i];
+			b.ExpandToFit(Box(origin.X + c.X, origin.Y + c.Y, origin.X + c.X + c.Width, origin.Y + c.Y + IntToPos(txt->FontSizePx)));
+		}
+		int32_t hang = IntToPos(txt->FontSizePx / 2);
+		b.Left -= hang;
+		b.Right += hang;
+		b.Top -= hang;
+		b.Bottom += hang;
+	}
+	// Edges are anti-aliased by padding their geometry out by a pixel, so add 2 to be safe
+	return Box((PosRoundDown(b.Left) >> PosShift) - 2, (PosRoundDown(b.Top) >> PosShift) - 2, (PosRoundUp(b.Right) >> PosShift) + 2, (PosRoundUp(b.Bottom) >> PosShift) + 2);
+}
+
+void DamageTracker::Walk(const Doc& doc, Point base, const RenderDomEl* el, InternalID prevSibling) {
+	if ((size_t) el->InternalID >= Next.size()) {
+		ElSig empty;
+		empty.Bounds = Box::Inverted();
+		empty.Hash   = 0;
+		while (Next.size() <= (size_t) el->InternalID)
+			Next += empty;
+	}
+
+	ElSig& sig = Next[el->InternalID];
+	uint64_t h = sig.Hash == 0 ? HashSeed : sig.Hash;
+	h          = HashValue(h, base);
+	h          = HashValue(h, el->Pos);
+	h          = HashValue(h, el->Tag);
+	h          = HashValue(h, prevSibling);
+	sig.Bounds.ExpandToFit(PaintBounds(base, el));
+
+	if (el->IsText()) {
+		const RenderDomText* txt = static_cast<const RenderDomText*>(el);
+		h                        = HashValue(h, txt->FontID);
+		h                        = HashValue(h, txt->Color);
+		h                        = HashValue(h, txt->FontSizePx);
+		h                        = HashValue(h, txt->Flags);
+		if (txt->Text.size() != 0)
+			h = HashBytes(h, &txt->Text[0], txt->Text.size() * sizeof(RenderCharEl));
+		sig.Hash = h;
+	} else {
+		const RenderDomNode* node  = static_cast<const RenderDomNode*>(el);
+		const StyleRender&   style = node->Style;
+		h                          = HashValue(h, style.BorderSize);
+		h                          = HashValue(h, style.Padding);
+		h                          = HashValue(h, style.BorderRadius);
+		h                          = HashValue(h, style.BackgroundColor);
+		h                          = HashBytes(h, style.BorderColor, sizeof(style.BorderColor));
+		h                          = HashValue(h, style.BackgroundImageID);
+		if (node->IsCanvas()) {
+			// Drawing on a canvas changes nothing in the layout, but it does bump the version of the canvas element
+			const DomEl* canvas = doc.GetChildByInternalID(node->InternalID);
+			if (canvas)
+				h = HashValue(h, canvas->GetVersion());
+		}
+		sig.Hash = h;
+
+		Point      newBase = base + Point(node->Pos.Left, node->Pos.Top);
+		InternalID prev    = InternalIDNull;
+		for (size_t i = 0; i < node->Children.size(); i++) {
+			Walk(doc, newBase, node->Children[i], prev);
+			prev = node->Children[i]->InternalID;
+		}
+	}
+}
+} // namespace xo
@@ -0,0 +1,53 @@
+#pragma once
+#include "../Defs.h"
+
+namespace xo {
+
+/* Computes the region of the viewport that must be repainted, by comparing the layout
+of the current frame against the layout of the previous frame.
+
+Every element of a layout is reduced to a signature, which is the pixel bounds that the element
+may touch when it is drawn, and a hash of everything that affects its appearance (position, StyleRender,
+text, font, paint order among its siblings, and the version of canvas elements). Signatures are
+stored per InternalID. An element whose signature differs between two frames damages both its old
+and its new bounds.
+
+Back buffers are not necessarily the previous frame. With a swap chain of N buffers, the back buffer
+that we're about to draw into was last presented N frames ago, so we need to repaint the union of the
+damage of the last N frames. That is why we keep a short history of damage rectangles.
+
+All boxes produced here are in whole pixels, not in Pos units.
+*/
+class XO_API DamageTracker {
+public:
+	static const int MaxHistory = 4; // Back buffers older than this are repainted in full
+
+	// Compare 'root' against the layout from the previous call to Update, and record the difference
+	// as the damage of this frame. 'extra' is added to the damage (use it for OS invalidation).
+	// Returns the damage of this frame, which is an inverted box if nothing changed.
+	Box Update(const Doc& doc, const RenderDomNode* root, Box viewport, Box extra);
+
+	// Compute the region that must be redrawn into a back buffer that is 'backbufferAge' frames old.
+	// Returns false if the contents of such a back buffer are unknown, in which case everything must be redrawn.
+	bool RepaintRegion(int backbufferAge, Box& region) const;
+
+	// Forget all history. The next frame will damage the entire viewport.
+	void Reset();
+
+	// Returns the pixels that 'el' may touch when it is drawn with its parent's content box at 'base'
+	static Box PaintBounds(Point base, const RenderDomEl* el);
+
+protected:
+	struct ElSig {
+		Box      Bounds;
+		uint64_t Hash;
+	};
+	bool            HavePrev = false;
+	Box             PrevViewport;
+	cheapvec<ElSig> Prev; // Indexed by InternalID
+	cheapvec<ElSig> Next; // Indexed by InternalID
+	cheapvec<Box>   History;
+
+	void Walk(const Doc& doc, Point base, const RenderDomEl* el, InternalID prevSibling);
+};
+} // namespace xo
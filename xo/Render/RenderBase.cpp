@@ -74,6 +74,18 @@ uintptr_t RenderBase::GetTextureDeviceHandle(TextureID texID) const {
 	return TexIDToNative[absolute];
 }
 
+int RenderBase::BackbufferAge() {
+	return 0;
+}
+
+Box RenderBase::GetScissor() const {
+	Box b = Scissor;
+	b.ClampTo(Box(0, 0, FBWidth, FBHeight));
+	if (!b.IsAreaPositive())
+		b = Box(0, 0, 0, 0);
+	return b;
+}
+
 void RenderBase::EnsureTextureProperlyDefined(Texture* tex, int texUnit) {
 	XO_ASSERT(tex->Width != 0 && tex->Height != 0);
 	XO_ASSERT(tex->Format != TexFormatInvalid);
@@ -122,4 +134,10 @@ bool RenderDummy::LoadTexture(Texture* tex, int texUnit) {
 bool RenderDummy::ReadBackbuffer(Image& image) {
 	return false;
 }
+bool RenderDummy::PrepareTexture(Texture* tex) {
+	return true;
+}
+bool RenderDummy::UploadTextureRect(const Texture* tex, Box rect, const void* data) {
+	return true;
+}
 }
@@ -59,6 +59,10 @@ class XO_API RenderBase {
 public:
 	friend struct RenderBase_OnceOff;
 
+	// Maximum number of vertices that may be passed to a single Draw() call.
+	// Drivers size their streaming vertex buffer and their quad index buffer to fit this.
+	static const int MaxDrawVertices = 32768;
+
 	ShaderPerFrame  ShaderPerFrame; // This is a mess between DirectX and OpenGL. needs cleanup
 	ShaderPerObject ShaderPerObject;
 	Mat4f           MVProj;
@@ -103,11 +107,30 @@ public:
 	virtual bool LoadTexture(Texture* tex, int texUnit) = 0;
 	virtual bool ReadBackbuffer(Image& image)           = 0;
 
+	// Texture streaming, used by TextureStreamer.
+	// PrepareTexture creates the device texture of 'tex' if it does not exist yet, so that tex->TexID is valid,
+	// but it does not upload any texels. A texture that is created here has its whole surface invalidated.
+	// UploadTextureRect copies the texels of 'rect' into the device texture. 'data' holds exactly those texels,
+	// with rows packed tightly together. Neither function reads tex->Data.
+	virtual bool PrepareTexture(Texture* tex)                                      = 0;
+	virtual bool UploadTextureRect(const Texture* tex, Box rect, const void* data) = 0;
+
+	// Returns the number of frames since the current back buffer was last presented. This is only valid
+	// between BeginRender and EndRender. 1 means the back buffer holds the previous frame, 2 means the frame
+	// before that, etc. 0 means the contents are undefined, and the whole frame must be drawn.
+	virtual int BackbufferAge();
+
+	// Restrict clearing and drawing to 'box', which is in pixels. This must be set before PreRender.
+	// By default the scissor covers the entire framebuffer.
+	void SetScissor(Box box) { Scissor = box; }
+	Box  GetScissor() const;
+
 protected:
 	static const TextureID TEX_OFFSET_ONE = 1; // This constant causes the TextureID that we expose to never be zero.
 	TextureID              TexIDOffset;
 	cheapvec<uintptr_t>    TexIDToNative; // Maps from TextureID to native device texture (eg. GLuint or ID3D11Texture2D*). We're wasting 4 bytes here on OpenGL.
 	int                    FBWidth, FBHeight;
+	Box                    Scissor = Box(0, 0, INT32_MAX, INT32_MAX);
 
 	void        EnsureTextureProperlyDefined(Texture* tex, int texUnit);
 	std::string CommonShaderDefines();
@@ -134,5 +157,7 @@ public:
 
 	virtual bool LoadTexture(Texture* tex, int texUnit);
 	virtual bool ReadBackbuffer(Image& image);
+	virtual bool PrepareTexture(Texture* tex);
+	virtual bool UploadTextureRect(const Texture* tex, Box rect, const void* data);
 };
 }
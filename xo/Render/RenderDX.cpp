@@ -16,6 +16,8 @@ namespace xo {
 
 RenderDX::RenderDX() {
 	memset(&D3D, 0, sizeof(D3D));
+	memset(Staging, 0, sizeof(Staging));
+	NextStaging        = 0;
 	FBWidth = FBHeight = 0;
 	AllProgs[0]        = &PFill;
 	AllProgs[1]        = &PFillTex;
@@ -339,11 +341,12 @@ bool RenderDX::CompileShader(const char* name, const char* source, const char* s
 XO_DISABLE_CODE_ANALYSIS_WARNINGS_POP
 
 bool RenderDX::SetupBuffers() {
-	D3D.VertBufferBytes = 65536;
+	// Vx_Uber is our largest vertex type
+	D3D.VertBufferBytes = MaxDrawVertices * sizeof(Vx_Uber);
 	if (NULL == (D3D.VertBuffer = CreateBuffer(D3D.VertBufferBytes, D3D11_USAGE_DYNAMIC, D3D11_BIND_VERTEX_BUFFER, D3D11_CPU_ACCESS_WRITE, NULL)))
 		return false;
 
-	D3D.QuadIndexBufferSize = (65536 / 6) * 6;
+	D3D.QuadIndexBufferSize = (MaxDrawVertices / 4) * 6;
 	uint16_t* quadIndices   = new uint16_t[D3D.QuadIndexBufferSize];
 	size_t    qi            = 0;
 	for (size_t i = 0; qi < D3D.QuadIndexBufferSize; i += 4) {
@@ -384,6 +387,7 @@ void RenderDX::DestroyDevice(SysWnd& wnd) {
 	for (auto t : Textures2D)
 		delete t;
 	Textures2D.clear();
+	DestroyStaging();
 }
 
 void RenderDX::SurfaceLost() {
@@ -488,11 +492,7 @@ bool RenderDX::CreateTexture2D(Texture* tex) {
 	desc.BindFlags        = D3D11_BIND_SHADER_RESOURCE;
 	desc.CPUAccessFlags   = 0;
 	desc.MiscFlags        = 0;
-	switch (tex->Format) {
-	case TexFormatRGBA8: desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB; break;
-	case TexFormatGrey8: desc.Format = DXGI_FORMAT_R8_UNORM; break;
-	default: XO_DIE_MSG("Unrecognized texture format");
-	}
+	desc.Format           = TexFormatToDX(tex->Format);
 	ID3D11Texture2D* dxTex = NULL;
 	HRESULT          hr    = D3D.Device->CreateTexture2D(&desc, NULL, &dxTex);
 	if (!SUCCEEDED(hr)) {
@@ -535,6 +535,51 @@ void RenderDX::UpdateTexture2D(ID3D11Texture2D* dxTex, Texture* tex) {
 	D3D.Context->UpdateSubresource(dxTex, 0, &box, tex->DataAt(invRect.Left, invRect.Top), tex->Stride, 0);
 }
 
+bool RenderDX::EnsureStaging(StagingTexture& st, uint32_t width, uint32_t height, DXGI_FORMAT format) {
+	if (st.Tex != NULL && st.Width >= width && st.Height >= height && st.Format == format)
+		return true;
+
+	// Grow to the largest rectangle seen so far, so that we settle on a size quickly
+	if (st.Format == format) {
+		width  = Max(width, st.Width);
+		height = Max(height, st.Height);
+	}
+	if (st.Tex != NULL)
+		st.Tex->Release();
+	memset(&st, 0, sizeof(st));
+
+	D3D11_TEXTURE2D_DESC desc;
+	memset(&desc, 0, sizeof(desc));
+	desc.Width            = width;
+	desc.Height           = height;
+	desc.MipLevels        = 1;
+	desc.ArraySize        = 1;
+	desc.SampleDesc.Count = 1;
+	desc.Usage            = D3D11_USAGE_STAGING;
+	desc.BindFlags        = 0;
+	desc.CPUAccessFlags   = D3D11_CPU_ACCESS_WRITE;
+	desc.MiscFlags        = 0;
+	desc.Format           = format;
+	HRESULT hr            = D3D.Device->CreateTexture2D(&desc, NULL, &st.Tex);
+	if (!SUCCEEDED(hr)) {
+		Trace("CreateTexture2D for staging failed: %08x", hr);
+		st.Tex = NULL;
+		return false;
+	}
+	st.Width  = width;
+	st.Height = height;
+	st.Format = format;
+	return true;
+}
+
+void RenderDX::DestroyStaging() {
+	for (int i = 0; i < 2; i++) {
+		if (Staging[i].Tex != NULL)
+			Staging[i].Tex->Release();
+	}
+	memset(Staging, 0, sizeof(Staging));
+}
+
 void RenderDX::PostRenderCleanup() {
 }
 
@@ -633,6 +678,42 @@ bool RenderDX::LoadTexture(Texture* tex, int texUnit) {
 	return true;
 }
 
+bool RenderDX::PrepareTexture(Texture* tex) {
+	EnsureTextureProperlyDefined(tex, 0);
+	if (IsTextureValid(tex->TexID))
+		return true;
+	return CreateTexture2D(tex);
+}
+
+bool RenderDX::UploadTextureRect(const Texture* tex, Box rect, const void* data) {
+	if (!IsTextureValid(tex->TexID))
+		return false;
+	Texture2D*  mytex    = GetTextureDX(tex->TexID);
+	uint32_t    width    = rect.Width();
+	uint32_t    height   = rect.Height();
+	size_t      rowBytes = width * tex->BytesPerPixel();
+	DXGI_FORMAT format   = TexFormatToDX(tex->Format);
+
+	// Write into one of two staging textures, and let the GPU copy out of it. Alternating means that
+	// the texture we write into is never the one that the previous upload is still being copied from.
+	// If the GPU is still busy with it anyway, then don't wait, but let UpdateSubresource take a copy.
+	StagingTexture&          st = Staging[NextStaging];
+	D3D11_MAPPED_SUBRESOURCE map;
+	if (!EnsureStaging(st, width, height, format) || !SUCCEEDED(D3D.Context->Map(st.Tex, 0, D3D11_MAP_WRITE, D3D11_MAP_FLAG_DO_NOT_WAIT, &map))) {
+		D3D11_BOX box = {(UINT) rect.Left, (UINT) rect.Top, 0, (UINT) rect.Right, (UINT) rect.Bottom, 1};
+		D3D.Context->UpdateSubresource(mytex->Tex, 0, &box, data, (UINT) rowBytes, 0);
+		return true;
+	}
+	for (uint32_t y = 0; y < height; y++)
+		memcpy((char*) map.pData + map.RowPitch * y, (const char*) data + rowBytes * y, rowBytes);
+	D3D.Context->Unmap(st.Tex, 0);
+
+	D3D11_BOX srcBox = {0, 0, 0, width, height, 1};
+	D3D.Context->CopySubresourceRegion(mytex->Tex, 0, rect.Left, rect.Top, 0, st.Tex, 0, &srcBox);
+	NextStaging = (NextStaging + 1) % 2;
+	return true;
+}
+
 bool RenderDX::ReadBackbuffer(Image& image) {
 	D3D11_TEXTURE2D_DESC desc;
 	memset(&desc, 0, sizeof(desc));
@@ -683,5 +764,14 @@ int RenderDX::TexFilterToDX(TexFilter f) {
 	return 0;
 }
 
+DXGI_FORMAT RenderDX::TexFormatToDX(TexFormat f) {
+	switch (f) {
+	case TexFormatRGBA8: return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+	case TexFormatGrey8: return DXGI_FORMAT_R8_UNORM;
+	default: XO_DIE_MSG("Unrecognized texture format");
+	}
+	return DXGI_FORMAT_UNKNOWN;
+}
+
 #endif
 }
@@ -68,6 +68,8 @@ public:
 
 	bool LoadTexture(Texture* tex, int texUnit) override;
 	bool ReadBackbuffer(Image& image) override;
+	bool PrepareTexture(Texture* tex) override;
+	bool UploadTextureRect(const Texture* tex, Box rect, const void* data) override;
 
 private:
 	struct Texture2D {
@@ -75,6 +77,14 @@ private:
 		ID3D11ShaderResourceView* View;
 	};
 
+	// CPU-writable texture that UploadTextureRect copies texels into, before the GPU copies them into their destination
+	struct StagingTexture {
+		ID3D11Texture2D* Tex;
+		uint32_t         Width;
+		uint32_t         Height;
+		DXGI_FORMAT      Format;
+	};
+
 	D3DState D3D;
 
 	DXProg_Fill          PFill;
@@ -86,6 +96,8 @@ private:
 	static const int     NumProgs = 6;
 	DXProg*              AllProgs[NumProgs];
 	cheapvec<Texture2D*> Textures2D;
+	StagingTexture       Staging[2]; // UploadTextureRect alternates between these
+	int                  NextStaging;
 
 	bool          InitializeDXDevice(SysWnd& wnd);
 	bool          InitializeDXSurface(SysWnd& wnd);
@@ -100,11 +112,14 @@ private:
 	ID3D11Buffer* CreateBuffer(size_t sizeBytes, D3D11_USAGE usage, D3D11_BIND_FLAG bind, uint32_t cpuAccess, const void* initialContent);
 	bool          CreateTexture2D(Texture* tex);
 	void          UpdateTexture2D(ID3D11Texture2D* dxTex, Texture* tex);
+	bool          EnsureStaging(StagingTexture& st, uint32_t width, uint32_t height, DXGI_FORMAT format);
+	void          DestroyStaging();
 
 	TextureID  RegisterTextureDX(Texture2D* tex) { return RegisterTexture((uintptr_t) tex); }
 	Texture2D* GetTextureDX(TextureID texID) const { return (Texture2D*) GetTextureDeviceHandle(texID); }
 
-	static int TexFilterToDX(TexFilter f);
+	static int         TexFilterToDX(TexFilter f);
+	static DXGI_FORMAT TexFormatToDX(TexFormat f);
 };
 } // namespace xo
 #else
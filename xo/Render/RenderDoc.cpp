@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "../Layout/Layout.h"
+#include "../FrameProfiler.h"
 #include "RenderDoc.h"
 #include "Renderer.h"
 #include "RenderDX.h"
@@ -7,13 +8,37 @@
 
 namespace xo {
 
+void LayoutPool::AddRef() {
+	RefCount++;
+}
+
+void LayoutPool::Release() {
+	if (--RefCount == 0)
+		delete this;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 LayoutResult::LayoutResult(const Doc& doc) {
 	IsLocked = false;
-	Root.SetPool(&Pool);
+	Pools += new LayoutPool();
+	Pool = &Pools[0]->Pool;
+	Root.SetPool(Pool);
 	Root.InternalID = doc.Root.GetInternalID();
 }
 
 LayoutResult::~LayoutResult() {
+	for (size_t i = 0; i < Pools.size(); i++)
+		Pools[i]->Release();
+}
+
+void LayoutResult::SharePools(const LayoutResult& prev) {
+	for (size_t i = 0; i < prev.Pools.size(); i++) {
+		prev.Pools[i]->AddRef();
+		Pools += prev.Pools[i];
+	}
 }
 
 const RenderDomNode* LayoutResult::Body() const {
@@ -48,33 +73,105 @@ RenderDoc::~RenderDoc() {
 			Trace("RenderDoc waiting for layouts to be released\n");
 		SleepMS(1);
 	}
+	delete BaseLayout;
 }
 
-RenderResult RenderDoc::Render(RenderBase* driver) {
+RenderResult RenderDoc::Render(RenderBase* driver, RenderStats& stats, FrameProfiler& profiler, Box invalidRect) {
 	//XOTRACE_RENDER( "RenderDoc: Reset\n" );
 	if (!HasExpandedClassVariables) {
 		XOTRACE_RENDER("RenderDoc: Expand Class Variables\n");
-		CodeTimer t;
+		profiler.BeginPhase(ProfileVariableBake);
 		ExpandVerbatimClassVariables();
-		TimeVariableBake = t.Measure();
+		profiler.EndPhase(ProfileVariableBake);
 	}
 
-	LayoutResult* layout = new LayoutResult(Doc);
+	double   now         = TimeAccurateSeconds();
+	bool     animating   = Doc.GetAnimations().size() != 0;
+	uint64_t fingerprint = LayoutCache::ComputeFingerprint(Doc);
 
-	XOTRACE_RENDER("RenderDoc: Layout\n");
-	CodeTimer t;
-	Layout    lay;
-	lay.PerformLayout(Doc, layout->Root, &layout->Pool);
-	TimeLayout = t.MeasureAndRestart();
+	// If only colors, opacity or translation are animating, and nothing else has changed, then the previous layout is still valid
+	bool skipLayout      = animating && BaseLayout != nullptr && BaseComplete && BaseVersion == Doc.GetVersion() && BaseFingerprint == fingerprint && !Animator.HasLayoutAnimations(Doc);
+	stats.Layout_Skipped = skipLayout ? 1 : 0;
 
-	XOTRACE_RENDER("RenderDoc: Render\n");
-	Renderer     rend;
-	RenderResult res = rend.Render(&Doc, &VectorCache, driver, &layout->Root);
-	TimeRender       = t.MeasureAndRestart();
+	LayoutResult* layout = nullptr;
+	if (skipLayout) {
+		layout = CloneLayout(BaseLayout);
+	} else {
+		if (animating)
+			Animator.ApplyToDoc(Doc, LayoutCache, now);
+
+		layout = new LayoutResult(Doc);
+
+		// The layout that LayoutCache refers to. Every layout that shares from its predecessor keeps one more
+		// pool alive, so once the chain is long enough, we copy instead, and the old pools are released.
+		LayoutResult* prev      = BaseLayout != nullptr ? BaseLayout : LatestLayout;
+		LayoutCache.ShareReused = prev != nullptr && prev->Pools.size() < MaxSharedPools;
+
+		XOTRACE_RENDER("RenderDoc: Layout\n");
+		profiler.BeginPhase(ProfileLayout);
+		Layout.PerformLayout(Doc, layout->Root, layout->Pool, &LayoutCache, &StyleCache, &WordCache);
+		profiler.EndPhase(ProfileLayout);
+		if (LayoutCache.ShareReused && LayoutCache.NumReused != 0)
+			layout->SharePools(*prev);
+		profiler.AddToPhase(ProfileStyleResolve, ProfileLayout, Layout.TimeStyleResolve);
+		profiler.AddToPhase(ProfileLayoutRepass, ProfileLayout, Layout.TimeRepasses);
+		profiler.Current().NumLayoutPasses += Layout.NumPasses;
+		stats.Layout_NumNodesReused  = LayoutCache.NumReused;
+		stats.Layout_NumParallelJobs = Layout.NumParallelJobs;
+		stats.Layout_NumStyleHits    = Global()->EnableStyleCache ? StyleCache.NumHits.load() : 0;
+		stats.Layout_NumWordHits     = Global()->EnableWordCache ? WordCache.NumHits : 0;
+
+		// LayoutCache now refers to the new layout, so the previous base is no longer needed
+		delete BaseLayout;
+		BaseLayout = nullptr;
+		if (animating) {
+			BaseLayout      = layout;
+			BaseVersion     = Doc.GetVersion();
+			BaseFingerprint = fingerprint;
+			layout          = CloneLayout(BaseLayout);
+		}
+	}
 
 	layout->IDToNodeTable.resize(Doc.InternalIDSize());
 	PopulateIDToNode(layout, &layout->Root);
 
+	if (animating) {
+		Animator.ApplyToLayout(Doc, *layout, now);
+	} else {
+		Animator.IsAnimating = false;
+		Animator.NextChange  = 0;
+		Animator.NumApplied  = 0;
+	}
+	stats.Anim_NumApplied = Animator.NumApplied;
+
+	// Damage tracking is counted as part of rendering
+	profiler.BeginPhase(ProfileRender);
+
+	// Only redraw the parts of the back buffer that differ from what we want to show
+	XOTRACE_RENDER("RenderDoc: Damage\n");
+	Box viewport(0, 0, Doc.UI.GetViewportWidth(), Doc.UI.GetViewportHeight());
+	Box repaint = viewport;
+	Damage.Update(Doc, &layout->Root, viewport, invalidRect);
+	if (!Global()->EnablePartialRepaint || !Damage.RepaintRegion(driver->BackbufferAge(), repaint))
+		repaint = viewport;
+	driver->SetScissor(repaint);
+	stats.Render_RepaintArea = repaint.IsAreaPositive() ? repaint.Width() * repaint.Height() : 0;
+
+	XOTRACE_RENDER("RenderDoc: Render\n");
+	Renderer     rend;
+	RenderResult res = rend.Render(&Doc, &VectorCache, Global()->EnableVertexCache ? &VertexCache : nullptr, driver, &layout->Root, stats);
+	profiler.EndPhase(ProfileRender);
+	profiler.AddToPhase(ProfileTextureUpload, ProfileRender, rend.TimeTextureUpload);
+
+	// Glyphs and vectors that were missing from this frame will appear in the next frame, without any
+	// change to the layout, so the next frame cannot be a partial repaint.
+	if (res == RenderResultNeedMore)
+		Damage.Reset();
+	if (BaseLayout != nullptr && !skipLayout)
+		BaseComplete = res != RenderResultNeedMore;
+
+	profiler.BeginPhase(ProfilePostRender);
+
 	// Atomically publish the new layout
 	{
 		std::lock_guard<std::mutex> lock(LayoutLock);
@@ -87,12 +184,16 @@ RenderResult RenderDoc::Render(RenderBase* driver) {
 		}
 		LatestLayout = layout;
 	}
-	TimePostRender = t.MeasureAndRestart();
+	profiler.EndPhase(ProfilePostRender);
 
 	return res;
 }
 
 void RenderDoc::CopyFromCanonical(const xo::Doc& canonical, RenderStats& stats) {
+	// Elements that are not cloned again must not keep their animated sizes
+	Animator.RestoreDoc(Doc, LayoutCache);
+	VertexCache.Forget(canonical.GetFreeIDs());
+	LayoutCache.Invalidate(canonical.GetModifiedBitmap());
 	canonical.CloneSlowInto(Doc, 0, stats);
 	HasExpandedClassVariables = false;
 }
@@ -128,6 +229,14 @@ void RenderDoc::PurgeOldLayouts() {
 	}
 }
 
+LayoutResult* RenderDoc::CloneLayout(const LayoutResult* src) {
+	LayoutResult* c = new LayoutResult(Doc);
+	c->Root.Pos     = src->Root.Pos;
+	c->Root.Style   = src->Root.Style;
+	LayoutCache::CloneChildren(&src->Root, &c->Root, c->Pool);
+	return c;
+}
+
 void RenderDoc::PopulateIDToNode(LayoutResult* res, RenderDomNode* node) {
 	// populate 'node'
 	res->IDToNodeTable[node->InternalID] = node;
@@ -2,9 +2,29 @@
 #include "../Doc.h"
 #include "RenderDomEl.h"
 #include "VectorCache.h"
+#include "VertexCache.h"
+#include "DamageTracker.h"
+#include "../Layout/LayoutCache.h"
+#include "StyleCache.h"
+#include "../Layout/WordCache.h"
+#include "../Layout/Layout.h"
+#include "Animator.h"
 
 namespace xo {
 
+// Memory of a render tree. A layout that reuses a subtree of the previous layout points into the
+// previous layout's pools, so these are reference counted, and shared by all of the layouts that use them.
+class XO_API LayoutPool {
+public:
+	xo::Pool Pool;
+
+	void AddRef();
+	void Release(); // Deletes the object when the last reference is released
+
+protected:
+	std::atomic<int32_t> RefCount = {1};
+};
+
 // Output from layout
 class XO_API LayoutResult {
 public:
@@ -13,9 +33,12 @@ public:
 
 	bool                     IsLocked; // True if we are being used by the UI thread to do things like hit-testing
 	RenderDomNode            Root;     // This is a dummy node that is above Body. Use Body() to get the true root of the tree.
-	xo::Pool                 Pool;
+	xo::Pool*                Pool;     // New render nodes are allocated from here. Owned by Pools[0].
+	cheapvec<LayoutPool*>    Pools;    // Pools[0] is our own. The rest belong to earlier layouts, and hold the subtrees that we share with them.
 	cheapvec<RenderDomNode*> IDToNodeTable; // Mapping from InternalID to Node. Use Node() function rather than this directly.
 
+	void SharePools(const LayoutResult& prev); // Keep the pools of 'prev' alive for as long as we are
+
 	const RenderDomNode* Body() const; // This is the effective root of the DOM
 
 	// Returns null if invalid
@@ -30,23 +53,28 @@ public:
 
 /* Document used by renderer.
 The 'Doc' member is a complete clone of the original document.
+
+While the document has animations, the output of layout is kept privately in BaseLayout, and
+every frame publishes an animated copy of it. If only non-layout properties are animated, and
+the document has not changed since BaseLayout was produced, then layout is skipped entirely.
 */
 class XO_API RenderDoc {
 public:
 	xo::Doc Doc; // Defining state
 
-	xo::VectorCache VectorCache;
-
-	// Timings of most recent render
-	double TimeVariableBake = 0;
-	double TimeLayout       = 0;
-	double TimeRender       = 0;
-	double TimePostRender   = 0;
+	xo::VectorCache   VectorCache;
+	xo::VertexCache   VertexCache;
+	xo::DamageTracker Damage;
+	xo::LayoutCache   LayoutCache; // Refers to LatestLayout, so LatestLayout must outlive the next layout
+	xo::StyleCache    StyleCache;
+	xo::WordCache     WordCache;
+	xo::Animator      Animator;
+	xo::Layout        Layout; // Reused by every frame, so that its worker layouts and their heaps are only created once
 
 	RenderDoc(DocGroup* group);
 	~RenderDoc();
 
-	RenderResult Render(RenderBase* driver);
+	RenderResult Render(RenderBase* driver, RenderStats& stats, FrameProfiler& profiler, Box invalidRect); // invalidRect is in pixels, and is added to the repaint region
 	void         CopyFromCanonical(const xo::Doc& canonical, RenderStats& stats);
 
 	// Acquire the latest layout object. Call ReleaseLayout when you are done using it. Returns nullptr if no layouts exist.
@@ -64,8 +92,17 @@ protected:
 	LayoutResult*           LatestLayout = nullptr; // Most recent layout performed
 	cheapvec<LayoutResult*> OldLayouts;             // Layouts there were busy being used by the UI thread while the rendering thread progressed onto doing another layout
 
-	void PurgeOldLayouts();
-	void PopulateIDToNode(LayoutResult* res, RenderDomNode* node);
-	void ExpandVerbatimClassVariables(); // Expand and parse the value of style variables such as $dark-outline = #333
+	// Unanimated output of layout. Only used while animating. LayoutCache refers to this instead of LatestLayout.
+	LayoutResult* BaseLayout      = nullptr;
+	uint32_t      BaseVersion     = 0;     // Doc version that BaseLayout was produced from
+	uint64_t      BaseFingerprint = 0;     // LayoutCache fingerprint of the settings that BaseLayout was produced with
+	bool          BaseComplete    = false; // False if the frame that produced BaseLayout was missing glyphs or vectors
+
+	static const size_t MaxSharedPools = 8; // Beyond this, reused subtrees are copied, so that the pools of old layouts can be freed
+
+	void          PurgeOldLayouts();
+	void          PopulateIDToNode(LayoutResult* res, RenderDomNode* node);
+	void          ExpandVerbatimClassVariables(); // Expand and parse the value of style variables such as $dark-outline = #333
+	LayoutResult* CloneLayout(const LayoutResult* src);
 };
 } // namespace xo
@@ -24,6 +24,12 @@ static bool GLIsBooted = false;
 #ifndef GL_SRC1_COLOR
 #define GL_SRC1_COLOR 0x88F9
 #endif
+#ifndef GL_SCISSOR_TEST
+#define GL_SCISSOR_TEST 0x0C11
+#endif
+#ifndef GLX_BACK_BUFFER_AGE_EXT
+#define GLX_BACK_BUFFER_AGE_EXT 0x20F4
+#endif
 #ifndef GL_ONE_MINUS_SRC1_COLOR
 #define GL_ONE_MINUS_SRC1_COLOR 0x88FA
 #endif
@@ -85,6 +91,9 @@ RenderGL::RenderGL() {
 	Have_Unpack_RowLength  = false;
 	Have_sRGB_Framebuffer  = false;
 	Have_BlendFuncExtended = false;
+	Have_PixelBufferObject = false;
+	UploadBuffers[0]       = 0;
+	UploadBuffers[1]       = 0;
 	AllProgs[0]            = &PRect;
 	AllProgs[1]            = &PRect2;
 	AllProgs[2]            = &PRect3;
@@ -106,13 +115,22 @@ void RenderGL::Reset() {
 	for (int i = 0; i < NumProgs; i++)
 		AllProgs[i]->Reset();
 	memset(BoundTextures, 0, sizeof(BoundTextures));
-	ActiveShader = ShaderInvalid;
+	ActiveShader    = ShaderInvalid;
+	VertexBuffer     = 0;
+	QuadIndexBuffer  = 0;
+	UploadBuffers[0] = 0;
+	UploadBuffers[1] = 0;
+	BufferAge        = 0;
 }
 
 const char* RenderGL::RendererName() {
 	return "OpenGL";
 }
 
+int RenderGL::BackbufferAge() {
+	return BufferAge;
+}
+
 #if XO_PLATFORM_WIN_DESKTOP
 
 typedef BOOL (*_wglChoosePixelFormatARB)(HDC hdc, const int* piAttribIList, const FLOAT* pfAttribFList, UINT nMaxFormats, int* piFormats, UINT* nNumFormats);
@@ -241,6 +259,8 @@ bool RenderGL::InitializeDevice(SysWnd& wnd) {
 	int glxLoad = glx_LoadFunctions(w->XDisplay, 0);
 	Trace("oglload: %d\n", oglLoad);
 	Trace("glxload: %d\n", glxLoad);
+	const char* glxExt = glXQueryExtensionsString(w->XDisplay, 0);
+	Have_BufferAge     = glxExt != nullptr && strstr(glxExt, "GLX_EXT_buffer_age") != nullptr;
 	if (!CreateShaders())
 		return false;
 	Trace("Shaders created\n");
@@ -278,24 +298,31 @@ void RenderGL::CheckExtensions() {
 
 	if (strstr(ver, "OpenGL ES")) {
 		Trace("OpenGL ES\n");
-		Have_Unpack_RowLength = version >= 30 || hasExtension("GL_EXT_unpack_subimage");
-		Have_sRGB_Framebuffer = version >= 30 || hasExtension("GL_EXT_sRGB");
+		Have_Unpack_RowLength  = version >= 30 || hasExtension("GL_EXT_unpack_subimage");
+		Have_sRGB_Framebuffer  = version >= 30 || hasExtension("GL_EXT_sRGB");
+		Have_PixelBufferObject = version >= 30;
 	} else {
 		Trace("OpenGL Regular (non-ES)\n");
-		Have_Unpack_RowLength = true;
-		Have_sRGB_Framebuffer = version >= 40 || hasExtension("ARB_framebuffer_sRGB") || hasExtension("GL_EXT_framebuffer_sRGB");
+		Have_Unpack_RowLength  = true;
+		Have_sRGB_Framebuffer  = version >= 40 || hasExtension("ARB_framebuffer_sRGB") || hasExtension("GL_EXT_framebuffer_sRGB");
+		Have_PixelBufferObject = version >= 21 || hasExtension("GL_ARB_pixel_buffer_object");
 	}
+#ifndef GL_PIXEL_UNPACK_BUFFER
+	Have_PixelBufferObject = false;
+#endif
 
 	Have_BlendFuncExtended = hasExtension("GL_ARB_blend_func_extended");
 	Trace(
 	    "OpenGL Extensions ("
 	    "UNPACK_SUBIMAGE=%d, "
 	    "sRGB_FrameBuffer=%d, "
-	    "blend_func_extended=%d"
+	    "blend_func_extended=%d, "
+	    "pixel_buffer_object=%d"
 	    ")\n",
 	    Have_Unpack_RowLength ? 1 : 0,
 	    Have_sRGB_Framebuffer ? 1 : 0,
-	    Have_BlendFuncExtended ? 1 : 0);
+	    Have_BlendFuncExtended ? 1 : 0,
+	    Have_PixelBufferObject ? 1 : 0);
 }
 
 bool RenderGL::CreateShaders() {
@@ -316,7 +343,49 @@ bool RenderGL::CreateShaders() {
 
 	Check();
 
-	return true;
+	return CreateBuffers();
+}
+
+bool RenderGL::CreateBuffers() {
+	glGenBuffers(1, &VertexBuffer);
+	glGenBuffers(1, &QuadIndexBuffer);
+
+	// our quads are emitted clockwise or CCW, but here we re-arrange them to be output as a triangle list.
+	int       nindices = (MaxDrawVertices / 4) * 6;
+	uint16_t* indices  = (uint16_t*) MallocOrDie(sizeof(uint16_t) * nindices);
+	for (int i = 0, v = 0; i < nindices; v += 4) {
+		indices[i++] = v;
+		indices[i++] = v + 1;
+		indices[i++] = v + 3;
+
+		indices[i++] = v + 1;
+		indices[i++] = v + 2;
+		indices[i++] = v + 3;
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, QuadIndexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint16_t) * nindices, indices, GL_STATIC_DRAW);
+	free(indices);
+
+	if (Have_PixelBufferObject)
+		glGenBuffers(2, UploadBuffers);
+
+	Check();
+	return VertexBuffer != 0 && QuadIndexBuffer != 0;
+}
+
+void RenderGL::DeleteBuffers() {
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	if (VertexBuffer != 0)
+		glDeleteBuffers(1, &VertexBuffer);
+	if (QuadIndexBuffer != 0)
+		glDeleteBuffers(1, &QuadIndexBuffer);
+	if (UploadBuffers[0] != 0)
+		glDeleteBuffers(2, UploadBuffers);
+	VertexBuffer     = 0;
+	QuadIndexBuffer  = 0;
+	UploadBuffers[0] = 0;
+	UploadBuffers[1] = 0;
 }
 
 void RenderGL::DeleteShadersAndTextures() {
@@ -335,6 +404,8 @@ void RenderGL::DeleteShadersAndTextures() {
 
 	for (int i = 0; i < NumProgs; i++)
 		DeleteProgram(*AllProgs[i]);
+
+	DeleteBuffers();
 }
 
 ProgBase* RenderGL::GetShader(Shaders shader) {
@@ -421,6 +492,12 @@ bool RenderGL::BeginRender(SysWnd& wnd) {
 #elif XO_PLATFORM_LINUX_DESKTOP
 	auto w = (SysWndLinux*) &wnd;
 	glXMakeCurrent(w->XDisplay, w->XWindow, w->GLContext);
+	BufferAge = 0;
+	if (Have_BufferAge) {
+		unsigned int age = 0;
+		glXQueryDrawable(w->XDisplay, w->XWindow, GLX_BACK_BUFFER_AGE_EXT, &age);
+		BufferAge = (int) age;
+	}
 	return true;
 #else
 	return true;
@@ -451,6 +528,11 @@ void RenderGL::PreRender() {
 
 	glViewport(0, 0, FBWidth, FBHeight);
 
+	// GL's window origin is bottom left
+	Box scissor = GetScissor();
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(scissor.Left, FBHeight - scissor.Bottom, scissor.Width(), scissor.Height());
+
 	auto clear = Global()->ClearColor;
 
 	if (Global()->EnableSRGBFramebuffer && Have_sRGB_Framebuffer) {
@@ -548,7 +630,36 @@ GLint RenderGL::TexFilterToGL(TexFilter f) {
 	return GL_NEAREST;
 }
 
+bool RenderGL::TexFormatToGL(TexFormat f, int& iformat, int& format) {
+	switch (f) {
+	case TexFormatGrey8:
+		iformat = GL_XO_RED_OR_LUMINANCE;
+		format  = GL_XO_RED_OR_LUMINANCE;
+		return true;
+	case TexFormatRGBA8:
+		iformat = GL_SRGB8_ALPHA8;
+		//iformat = GL_RGBA8;
+		format = GL_RGBA;
+		return true;
+	default:
+		XO_TODO;
+	}
+	return false;
+}
+
+void RenderGL::TexParameters(const Texture* tex) {
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, TexFilterToGL(tex->FilterMin));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, TexFilterToGL(tex->FilterMax));
+	// Clamping should have no effect for RGB text, since we clamp inside our fragment shader.
+	// Also, when rendering 'whole pixel' glyphs, we shouldn't need clamping either, because
+	// our UV coordinates are exact, and we always have a 1:1 texel:pixel ratio.
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
 void RenderGL::PostRenderCleanup() {
+	glDisable(GL_SCISSOR_TEST);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glUseProgram(0);
 	ActiveShader = ShaderInvalid;
 }
@@ -558,8 +669,13 @@ void RenderGL::Draw(GPUPrimitiveTypes type, int nvertex, const void* v) {
 
 	SetShaderObjectUniforms();
 
+	XO_ASSERT(nvertex <= MaxDrawVertices);
+
+	// The vertex data is streamed into VertexBuffer below, so all attribute pointers are offsets into that buffer
+	glBindBuffer(GL_ARRAY_BUFFER, VertexBuffer);
+
 	int            stride = sizeof(Vx_PTC);
-	const uint8_t* vbyte  = (const uint8_t*) v;
+	const uint8_t* vbyte  = nullptr;
 
 	GLint varvpos      = -1;
 	GLint varvcol      = -1;
@@ -684,38 +800,21 @@ void RenderGL::Draw(GPUPrimitiveTypes type, int nvertex, const void* v) {
 		glEnableVertexAttribArray(varvtexClamp);
 	}
 
-	int nindices = 0;
-	switch (type) {
-	case GPUPrimQuads: nindices = (nvertex / 2) * 3; break;
-	case GPUPrimTriangles: nindices = nvertex; break;
-	default: XO_TODO;
-	}
-
-	XO_ASSERT(nindices < 65536);
-	uint16_t* indices = (uint16_t*) MallocOrDie(sizeof(uint16_t) * nindices);
+	// Re-specifying the whole buffer orphans the previous contents, so the driver doesn't need
+	// to wait for earlier draw calls that are still reading from it.
+	glBufferData(GL_ARRAY_BUFFER, nvertex * stride, v, GL_STREAM_DRAW);
 
 	switch (type) {
 	case GPUPrimQuads:
-		for (int i = 0, v = 0; v < nvertex; v += 4) {
-			indices[i++] = v;
-			indices[i++] = v + 1;
-			indices[i++] = v + 3;
-
-			indices[i++] = v + 1;
-			indices[i++] = v + 2;
-			indices[i++] = v + 3;
-		}
-		glDrawElements(GL_TRIANGLES, nindices, GL_UNSIGNED_SHORT, indices);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, QuadIndexBuffer);
+		glDrawElements(GL_TRIANGLES, (nvertex / 4) * 6, GL_UNSIGNED_SHORT, nullptr);
 		break;
 	case GPUPrimTriangles:
-		for (int i = 0; i < nvertex; i++)
-			indices[i] = i;
-		glDrawElements(GL_TRIANGLES, nvertex, GL_UNSIGNED_SHORT, indices);
+		glDrawArrays(GL_TRIANGLES, 0, nvertex);
 		break;
 	default:
 		XO_TODO;
 	}
-	free(indices);
 
 	//auto vx = (Vx_PTC*) vbyte;
 	//XOTRACE_RENDER( "DrawQuad done (%f,%f) (%f,%f) (%f,%f) (%f,%f)\n", vx[0].Pos.x, vx[0].Pos.y, vx[1].Pos.x, vx[1].Pos.y, vx[2].Pos.x, vx[2].Pos.y, vx[3].Pos.x, vx[3].Pos.y );
@@ -773,19 +872,7 @@ bool RenderGL::LoadTexture(Texture* tex, int texUnit) {
 
 	int iformat = 0;
 	int format  = 0;
-	switch (tex->Format) {
-	case TexFormatGrey8:
-		iformat = GL_XO_RED_OR_LUMINANCE;
-		format  = GL_XO_RED_OR_LUMINANCE;
-		break;
-	case TexFormatRGBA8:
-		iformat = GL_SRGB8_ALPHA8;
-		//iformat = GL_RGBA8;
-		format = GL_RGBA;
-		break;
-	default:
-		XO_TODO;
-	}
+	TexFormatToGL(tex->Format, iformat, format);
 
 	if (Have_Unpack_RowLength)
 		glPixelStorei(GL_UNPACK_ROW_LENGTH, tex->Stride / (int) tex->BytesPerPixel());
@@ -812,14 +899,7 @@ bool RenderGL::LoadTexture(Texture* tex, int texUnit) {
 		//free(copy);
 
 		glTexImage2D(GL_TEXTURE_2D, 0, iformat, tex->Width, tex->Height, 0, format, GL_UNSIGNED_BYTE, tex->Data);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, TexFilterToGL(tex->FilterMin));
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, TexFilterToGL(tex->FilterMax));
-		// Clamping should have no effect for RGB text, since we clamp inside our fragment shader.
-		// Also, when rendering 'whole pixel' glyphs, we shouldn't need clamping either, because
-		// our UV coordinates are exact, and we always have a 1:1 texel:pixel ratio.
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		TexParameters(tex);
 	} else {
 		glTexSubImage2D(GL_TEXTURE_2D, 0, invRect.Left, invRect.Top, invRect.Width(), invRect.Height(), format, GL_UNSIGNED_BYTE, tex->DataAt(invRect.Left, invRect.Top));
 	}
@@ -830,6 +910,72 @@ bool RenderGL::LoadTexture(Texture* tex, int texUnit) {
 	return true;
 }
 
+bool RenderGL::PrepareTexture(Texture* tex) {
+	EnsureTextureProperlyDefined(tex, 0);
+	if (IsTextureValid(tex->TexID))
+		return true;
+
+	int iformat = 0;
+	int format  = 0;
+	if (!TexFormatToGL(tex->Format, iformat, format))
+		return false;
+
+	GLuint t;
+	glGenTextures(1, &t);
+	tex->TexID = RegisterTextureInt(t);
+	tex->InvalidateWholeSurface();
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, t);
+	BoundTextures[0] = t;
+
+	// Allocate storage only. The texels arrive through UploadTextureRect.
+	glTexImage2D(GL_TEXTURE_2D, 0, iformat, tex->Width, tex->Height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+	TexParameters(tex);
+	return true;
+}
+
+bool RenderGL::UploadTextureRect(const Texture* tex, Box rect, const void* data) {
+	int iformat = 0;
+	int format  = 0;
+	if (!IsTextureValid(tex->TexID) || !TexFormatToGL(tex->Format, iformat, format))
+		return false;
+
+	GLuint glTexID = GetTextureDeviceHandleInt(tex->TexID);
+	glActiveTexture(GL_TEXTURE0);
+	if (BoundTextures[0] != glTexID) {
+		glBindTexture(GL_TEXTURE_2D, glTexID);
+		BoundTextures[0] = glTexID;
+	}
+
+	// Rows are packed, so the rows of a Grey8 texture are not necessarily aligned to 4 bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	const void* src = data;
+#ifdef GL_PIXEL_UNPACK_BUFFER
+	if (Have_PixelBufferObject) {
+		// glBufferData copies the texels into driver memory and returns, after which the GPU pulls them
+		// out of the buffer without stalling us. Respecifying the storage orphans whatever the buffer held
+		// before, and alternating between two buffers means that even a driver that does not orphan
+		// is never asked to overwrite the buffer that the previous upload is still reading from.
+		size_t bytes = (size_t) rect.Width() * (size_t) rect.Height() * tex->BytesPerPixel();
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, UploadBuffers[NextUploadBuffer]);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, data, GL_STREAM_DRAW);
+		NextUploadBuffer = (NextUploadBuffer + 1) % 2;
+		src              = nullptr; // Offset into the pixel buffer
+	}
+#endif
+
+	glTexSubImage2D(GL_TEXTURE_2D, 0, rect.Left, rect.Top, rect.Width(), rect.Height(), format, GL_UNSIGNED_BYTE, src);
+
+#ifdef GL_PIXEL_UNPACK_BUFFER
+	if (Have_PixelBufferObject)
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+#endif
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	return true;
+}
+
 bool RenderGL::ReadBackbuffer(Image& image) {
 	image.Alloc(TexFormatRGBA8, FBWidth, FBHeight);
 	if (Have_Unpack_RowLength)
@@ -63,16 +63,28 @@ public:
 
 	bool LoadTexture(Texture* tex, int texUnit) override;
 	bool ReadBackbuffer(Image& image) override;
+	int  BackbufferAge() override;
+	bool PrepareTexture(Texture* tex) override;
+	bool UploadTextureRect(const Texture* tex, Box rect, const void* data) override;
 
 protected:
 	Shaders     ActiveShader;
 	GLuint      BoundTextures[MaxTextureUnits];
+	GLuint      VertexBuffer    = 0; // Streaming vertex buffer. Re-specified on every Draw().
+	GLuint      QuadIndexBuffer = 0; // Immutable index buffer that turns MaxDrawVertices worth of quads into triangles
+	GLuint      UploadBuffers[2];    // Pixel buffer objects that UploadTextureRect alternates between
+	int         NextUploadBuffer = 0;
 	std::string BaseShader;
 	bool        Have_Unpack_RowLength;
 	bool        Have_sRGB_Framebuffer;
 	bool        Have_BlendFuncExtended;
+	bool        Have_BufferAge = false; // GLX_EXT_buffer_age
+	bool        Have_PixelBufferObject;
+	int         BufferAge      = 0;     // Queried at BeginRender
 
 	void PreparePreprocessor();
+	bool CreateBuffers();
+	void DeleteBuffers();
 	void DeleteProgram(GLProg& prog);
 	bool LoadProgram(GLProg& prog);
 	bool LoadProgram(GLProg& prog, const char* name, const char* vsrc, const char* fsrc);
@@ -87,6 +99,9 @@ protected:
 	template <typename TProg>
 	bool SetMVProj(Shaders shader, TProg& prog, const Mat4f& mvprojTransposed);
 
+	void TexParameters(const Texture* tex); // Filtering and clamping of the currently bound texture
+
 	static GLint TexFilterToGL(TexFilter f);
+	static bool  TexFormatToGL(TexFormat f, int& iformat, int& format);
 };
 } // namespace xo
@@ -0,0 +1,456 @@
+#include "pch.h"
+#include "RenderSoft.h"
+#include "../SysWnd.h"
+#include "../Text/GlyphCache.h"
+
+namespace xo {
+
+RenderSoft::RenderSoft() {
+	memset(BoundTextures, 0, sizeof(BoundTextures));
+	FBWidth  = 0;
+	FBHeight = 0;
+}
+
+RenderSoft::~RenderSoft() {
+	DeleteDeviceTextures();
+}
+
+const char* RenderSoft::RendererName() {
+	return "Software";
+}
+
+bool RenderSoft::InitializeDevice(SysWnd& wnd) {
+	for (int i = 0; i < 256; i++)
+		SRGBToLinear[i] = SRGB2Linear((uint8_t) i);
+
+	// 4096 levels are enough to reproduce every 8-bit sRGB value, except for a handful at the very bottom of the curve
+	for (int i = 0; i < 4096; i++)
+		LinearToSRGB[i] = Linear2SRGB((float) i / 4095.0f);
+
+	return true;
+}
+
+void RenderSoft::DestroyDevice(SysWnd& wnd) {
+	BackBuffer.Free();
+	BackBufferValid = false;
+	memset(BoundTextures, 0, sizeof(BoundTextures));
+	DeleteDeviceTextures();
+}
+
+void RenderSoft::SurfaceLost() {
+	memset(BoundTextures, 0, sizeof(BoundTextures));
+	DeleteDeviceTextures();
+	SurfaceLost_ForgetTextures();
+}
+
+bool RenderSoft::BeginRender(SysWnd& wnd) {
+	auto rect = wnd.GetRelativeClientRect();
+	FBWidth   = rect.Width();
+	FBHeight  = rect.Height();
+	if (FBWidth <= 0 || FBHeight <= 0)
+		return false;
+	if (BackBuffer.Width != (uint32_t) FBWidth || BackBuffer.Height != (uint32_t) FBHeight)
+		BackBufferValid = false;
+	return BackBuffer.Alloc(TexFormatRGBA8, FBWidth, FBHeight);
+}
+
+void RenderSoft::EndRender(SysWnd& wnd, uint32_t endRenderFlags) {
+	// There is nothing to present. Use ReadBackbuffer to get at the frame.
+}
+
+void RenderSoft::PreRender() {
+	// Mimic RenderGL, which clears an sRGB framebuffer with the linear equivalent of ClearColor
+	SRGBFramebuffer = Global()->EnableSRGBFramebuffer;
+
+	Mat4f mvproj;
+	mvproj.Identity();
+	Ortho(mvproj, 0, FBWidth, FBHeight, 0, 1, 0);
+	SetupToScreen(mvproj);
+
+	ClipRect = GetScissor();
+
+	auto     clear = Global()->ClearColor;
+	uint32_t rgba  = clear.GetRGBA();
+	for (int y = ClipRect.Top; y < ClipRect.Bottom; y++) {
+		uint32_t* line = (uint32_t*) BackBuffer.DataAtLine(y);
+		for (int x = ClipRect.Left; x < ClipRect.Right; x++)
+			line[x] = rgba;
+	}
+	BackBufferValid = true;
+}
+
+void RenderSoft::PostRenderCleanup() {
+	ActiveShader = ShaderInvalid;
+}
+
+ProgBase* RenderSoft::GetShader(Shaders shader) {
+	return nullptr;
+}
+
+void RenderSoft::ActivateShader(Shaders shader) {
+	ActiveShader = shader;
+}
+
+bool RenderSoft::LoadTexture(Texture* tex, int texUnit) {
+	EnsureTextureProperlyDefined(tex, texUnit);
+
+	if (!IsTextureValid(tex->TexID))
+		tex->TexID = RegisterTexture((uintptr_t) tex);
+
+	// A streamed texture is sampled out of our copy, because the caller's texture has no texels
+	Image* device          = tex->Data == nullptr ? GetDeviceTexture(tex->TexID) : nullptr;
+	BoundTextures[texUnit] = device != nullptr ? device : tex;
+	return true;
+}
+
+bool RenderSoft::PrepareTexture(Texture* tex) {
+	EnsureTextureProperlyDefined(tex, 0);
+	if (IsTextureValid(tex->TexID))
+		return true;
+
+	Image* device = new Image();
+	if (!device->Alloc(tex->Format, tex->Width, tex->Height)) {
+		delete device;
+		return false;
+	}
+	memset(device->Data, 0, device->Stride * device->Height);
+	device->FilterMin = tex->FilterMin;
+	device->FilterMax = tex->FilterMax;
+	DeviceTextures += device;
+	tex->TexID = RegisterTexture((uintptr_t) device);
+	tex->InvalidateWholeSurface();
+	return true;
+}
+
+bool RenderSoft::UploadTextureRect(const Texture* tex, Box rect, const void* data) {
+	Image* device = IsTextureValid(tex->TexID) ? GetDeviceTexture(tex->TexID) : nullptr;
+	if (device == nullptr)
+		return false;
+	device->CopyFrom(rect.Left, rect.Top, data, rect.Width() * (int) tex->BytesPerPixel(), rect.Width(), rect.Height());
+	return true;
+}
+
+Image* RenderSoft::GetDeviceTexture(TextureID texID) const {
+	Image* handle = (Image*) GetTextureDeviceHandle(texID);
+	for (size_t i = 0; i < DeviceTextures.size(); i++) {
+		if (DeviceTextures[i] == handle)
+			return handle;
+	}
+	return nullptr;
+}
+
+void RenderSoft::DeleteDeviceTextures() {
+	for (size_t i = 0; i < DeviceTextures.size(); i++)
+		delete DeviceTextures[i];
+	DeviceTextures.clear();
+}
+
+int RenderSoft::BackbufferAge() {
+	// We have only one buffer, and it is never discarded
+	return BackBufferValid ? 1 : 0;
+}
+
+bool RenderSoft::ReadBackbuffer(Image& image) {
+	return image.Set(TexFormatRGBA8, FBWidth, FBHeight, BackBuffer.Data);
+}
+
+void RenderSoft::Draw(GPUPrimitiveTypes type, int nvertex, const void* v) {
+	XO_ASSERT(nvertex <= MaxDrawVertices);
+
+	size_t stride = sizeof(Vx_PTC);
+	switch (ActiveShader) {
+	case ShaderUber: stride = sizeof(Vx_Uber); break;
+	case ShaderRect2:
+	case ShaderRect3:
+	case ShaderTextRGB:
+	case ShaderArc:
+	case ShaderQuadraticSpline: stride = sizeof(Vx_PTCV4); break;
+	case ShaderInvalid: XO_DIE(); break;
+	default: break;
+	}
+
+	const uint8_t* vbyte = (const uint8_t*) v;
+	Vertex         vx[4];
+
+	switch (type) {
+	case GPUPrimQuads:
+		for (int i = 0; i + 4 <= nvertex; i += 4) {
+			for (int j = 0; j < 4; j++)
+				LoadVertex(vbyte + (i + j) * stride, vx[j]);
+			// Same triangulation as the quad index buffers of the GPU drivers
+			DrawTriangle(vx[0], vx[1], vx[3]);
+			DrawTriangle(vx[1], vx[2], vx[3]);
+		}
+		break;
+	case GPUPrimTriangles:
+		for (int i = 0; i + 3 <= nvertex; i += 3) {
+			for (int j = 0; j < 3; j++)
+				LoadVertex(vbyte + (i + j) * stride, vx[j]);
+			DrawTriangle(vx[0], vx[1], vx[2]);
+		}
+		break;
+	default:
+		XO_TODO;
+	}
+}
+
+void RenderSoft::LoadVertex(const uint8_t* v, Vertex& out) const {
+	if (ActiveShader == ShaderUber) {
+		auto vx    = (const Vx_Uber*) v;
+		out.Pos    = Vec2f(vx->Pos.x, vx->Pos.y);
+		out.UV1    = Vec4f(vx->UV1);
+		out.UV2    = Vec4f(vx->UV2);
+		out.Color1 = ReadColor(vx->Color1);
+		out.Color2 = ReadColor(vx->Color2);
+		out.Shader = vx->Shader;
+		return;
+	}
+
+	// Vx_PTC and Vx_PTCV4 share their base layout
+	auto vx    = (const Vx_PTCV4*) v;
+	out.Pos    = Vec2f(vx->Pos.x, vx->Pos.y);
+	out.UV1    = Vec4f(vx->UV.x, vx->UV.y, 0, 0);
+	out.UV2    = Vec4f(0, 0, 0, 0);
+	out.Color1 = ReadColor(vx->Color);
+	out.Color2 = Vec4f(0, 0, 0, 0);
+	out.Shader = 0;
+	switch (ActiveShader) {
+	case ShaderTextRGB:
+	case ShaderArc:
+		out.UV2    = Vec4f(vx->V4);
+		out.Color2 = ReadColor(vx->Color2);
+		break;
+	default:
+		break;
+	}
+}
+
+// The vertex shaders all run fromSRGB on their colors
+Vec4f RenderSoft::ReadColor(uint32_t rgba) const {
+	auto c = (const uint8_t*) &rgba;
+	return Vec4f(SRGBToLinear[c[0]], SRGBToLinear[c[1]], SRGBToLinear[c[2]], c[3] * (1.0f / 255.0f));
+}
+
+uint8_t RenderSoft::WriteFB(float v) const {
+	v = Clamp(v, 0.0f, 1.0f);
+	if (SRGBFramebuffer)
+		return LinearToSRGB[(int) (v * 4095.0f + 0.5f)];
+	return (uint8_t) (v * 255.0f + 0.5f);
+}
+
+void RenderSoft::DrawTriangle(const Vertex& a, const Vertex& b, const Vertex& c) {
+	// Twice the signed area. Our Y axis points down, so front facing triangles (CCW in GL's
+	// clip space) have a negative area here. Cull the rest, just like RenderGL does with GL_CULL_FACE.
+	float area = (b.Pos.x - a.Pos.x) * (c.Pos.y - a.Pos.y) - (b.Pos.y - a.Pos.y) * (c.Pos.x - a.Pos.x);
+	if (area >= 0)
+		return;
+
+	// Walk the edges in the order that produces non-negative edge functions inside the triangle
+	const Vertex* v[3] = {&a, &c, &b};
+	area               = -area;
+
+	float minX = Min(a.Pos.x, Min(b.Pos.x, c.Pos.x));
+	float maxX = Max(a.Pos.x, Max(b.Pos.x, c.Pos.x));
+	float minY = Min(a.Pos.y, Min(b.Pos.y, c.Pos.y));
+	float maxY = Max(a.Pos.y, Max(b.Pos.y, c.Pos.y));
+	int   x0   = Max(ClipRect.Left, (int) floor(minX));
+	int   y0   = Max(ClipRect.Top, (int) floor(minY));
+	int   x1   = Min(ClipRect.Right - 1, (int) ceil(maxX));
+	int   y1   = Min(ClipRect.Bottom - 1, (int) ceil(maxY));
+
+	// Edge i runs from v[i] to v[i+1], and the weight that it produces belongs to the opposite vertex, v[i+2].
+	// When a pixel center lies exactly on an edge, it is owned by only one of the two triangles that
+	// share that edge. Those triangles traverse the edge in opposite directions, so a rule based on
+	// the edge's direction is enough to break the tie.
+	float ex[3], ey[3];
+	bool  owner[3];
+	for (int i = 0; i < 3; i++) {
+		ex[i]    = v[(i + 1) % 3]->Pos.x - v[i]->Pos.x;
+		ey[i]    = v[(i + 1) % 3]->Pos.y - v[i]->Pos.y;
+		owner[i] = ey[i] > 0 || (ey[i] == 0 && ex[i] < 0);
+	}
+
+	Vertex f;
+	f.Shader   = a.Shader;
+	float norm = 1.0f / area;
+
+	for (int y = y0; y <= y1; y++) {
+		float    py  = (float) y + 0.5f;
+		uint8_t* dst = (uint8_t*) BackBuffer.DataAt(x0, y);
+		for (int x = x0; x <= x1; x++, dst += 4) {
+			float px = (float) x + 0.5f;
+			float w[3];
+			bool  inside = true;
+			for (int i = 0; i < 3; i++) {
+				float e = (py - v[i]->Pos.y) * ex[i] - (px - v[i]->Pos.x) * ey[i];
+				inside  = inside && (e > 0 || (e == 0 && owner[i]));
+				w[(i + 2) % 3] = e * norm;
+			}
+			if (!inside)
+				continue;
+
+			f.UV1    = w[0] * v[0]->UV1 + w[1] * v[1]->UV1 + w[2] * v[2]->UV1;
+			f.UV2    = w[0] * v[0]->UV2 + w[1] * v[1]->UV2 + w[2] * v[2]->UV2;
+			f.Color1 = w[0] * v[0]->Color1 + w[1] * v[1]->Color1 + w[2] * v[2]->Color1;
+			f.Color2 = w[0] * v[0]->Color2 + w[1] * v[1]->Color2 + w[2] * v[2]->Color2;
+			Blend(dst, Shade(f, Vec2f(px, py)));
+		}
+	}
+}
+
+void RenderSoft::Blend(uint8_t* dst, const Fragment& frag) const {
+	// glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC1_COLOR, GL_ONE, GL_ONE_MINUS_SRC1_ALPHA)
+	dst[0] = WriteFB(frag.Out0.x + (1.0f - frag.Out1.x) * ReadFB(dst[0]));
+	dst[1] = WriteFB(frag.Out0.y + (1.0f - frag.Out1.y) * ReadFB(dst[1]));
+	dst[2] = WriteFB(frag.Out0.z + (1.0f - frag.Out1.z) * ReadFB(dst[2]));
+	dst[3] = (uint8_t) (Clamp(frag.Out0.w + (1.0f - frag.Out1.w) * dst[3] * (1.0f / 255.0f), 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+// Bilinear or nearest sampling, with GL_CLAMP_TO_EDGE. RGBA textures are sRGB, so they are returned linear.
+Vec4f RenderSoft::Sample(int texUnit, Vec2f uv) const {
+	const Texture* tex = BoundTextures[texUnit];
+	if (tex == nullptr || tex->Data == nullptr)
+		return Vec4f(0, 0, 0, 0);
+
+	auto texel = [this, tex](int x, int y) -> Vec4f {
+		x      = Clamp(x, 0, (int) tex->Width - 1);
+		y      = Clamp(y, 0, (int) tex->Height - 1);
+		auto p = (const uint8_t*) tex->DataAt(x, y);
+		if (tex->Format == TexFormatGrey8)
+			return Vec4f(p[0] * (1.0f / 255.0f), 0, 0, 1);
+		return Vec4f(SRGBToLinear[p[0]], SRGBToLinear[p[1]], SRGBToLinear[p[2]], p[3] * (1.0f / 255.0f));
+	};
+
+	float tx = uv.x * tex->Width - 0.5f;
+	float ty = uv.y * tex->Height - 0.5f;
+	if (tex->FilterMax == TexFilterNearest)
+		return texel((int) floor(tx + 0.5f), (int) floor(ty + 0.5f));
+
+	float fx  = (float) floor(tx);
+	float fy  = (float) floor(ty);
+	float ax  = tx - fx;
+	float ay  = ty - fy;
+	int   ix  = (int) fx;
+	int   iy  = (int) fy;
+	Vec4f top = (1 - ax) * texel(ix, iy) + ax * texel(ix + 1, iy);
+	Vec4f bot = (1 - ax) * texel(ix, iy + 1) + ax * texel(ix + 1, iy + 1);
+	return (1 - ay) * top + ay * bot;
+}
+
+RenderSoft::Fragment RenderSoft::Shade(const Vertex& f, Vec2f screenPos) const {
+	Fragment r;
+	switch (ActiveShader) {
+	case ShaderUber:
+		return ShadeUber(f, screenPos);
+	case ShaderFill:
+		r.Out0 = f.Color1;
+		break;
+	case ShaderFillTex:
+		r.Out0 = f.Color1 * Sample(0, Vec2f(f.UV1.x, f.UV1.y));
+		break;
+	case ShaderTextWhole:
+		r.Out0 = Premultiply(f.Color1) * Sample(0, Vec2f(f.UV1.x, f.UV1.y)).x;
+		break;
+	case ShaderTextRGB: {
+		// Unlike the uber shader, this one does not premultiply its RGB output
+		r      = ShadeSubpixelText(f.Color1, Vec2f(f.UV1.x, f.UV1.y), f.UV2);
+		r.Out0 = Vec4f(f.Color1.x, f.Color1.y, f.Color1.z, r.Out0.w);
+		return r;
+	}
+	case ShaderArc: {
+		// center1 = V4.xy, center2 = V4.zw, radius1 = UV.x, radius2 = UV.y
+		float distance1   = (screenPos - Vec2f(f.UV2.x, f.UV2.y)).size();
+		float distance2   = (screenPos - Vec2f(f.UV2.z, f.UV2.w)).size();
+		float color_blend = Clamp(distance1 - f.UV1.x + 0.5f, 0.0f, 1.0f);
+		float alpha_blend = Clamp(f.UV1.y - distance2 + 0.5f, 0.0f, 1.0f);
+		r.Out0            = ((1 - color_blend) * f.Color1 + color_blend * f.Color2) * alpha_blend;
+		break;
+	}
+	default:
+		r.Out0 = Vec4f(1, 1, 0, 1);
+		break;
+	}
+	r.Out1 = Vec4f(r.Out0.w, r.Out0.w, r.Out0.w, r.Out0.w);
+	return r;
+}
+
+RenderSoft::Fragment RenderSoft::ShadeUber(const Vertex& f, Vec2f screenPos) const {
+	int  shader      = (int) f.Shader;
+	bool enableBGTex = (shader & SHADER_FLAG_TEXBG) != 0;
+	bool bgTexPremul = (shader & SHADER_FLAG_TEXBG_PREMUL) != 0;
+	shader           = shader & SHADER_TYPE_MASK;
+
+	auto readBGTex = [&](Vec2f uv) -> Vec4f {
+		Vec4f c = Sample(0, uv);
+		return bgTexPremul ? c : Premultiply(c);
+	};
+	auto blendOver = [](const Vec4f& a, const Vec4f& b) -> Vec4f {
+		return (1.0f - b.w) * a + b;
+	};
+
+	Fragment r;
+	Vec4f    color;
+	switch (shader) {
+	case SHADER_ARC: {
+		Vec4f bgColor     = Premultiply(f.Color1);
+		Vec4f borderColor = Premultiply(f.Color2);
+		if (enableBGTex)
+			bgColor = blendOver(bgColor, readBGTex(Vec2f(f.UV2.z, f.UV2.w)));
+		float distance1   = (screenPos - Vec2f(f.UV1.x, f.UV1.y)).size();
+		float distance2   = (screenPos - Vec2f(f.UV1.z, f.UV1.w)).size();
+		float color_blend = Clamp(distance1 - f.UV2.x + 0.5f, 0.0f, 1.0f);
+		float alpha_blend = Clamp(f.UV2.y - distance2 + 0.5f, 0.0f, 1.0f);
+		color             = ((1 - color_blend) * bgColor + color_blend * borderColor) * alpha_blend;
+		break;
+	}
+	case SHADER_RECT: {
+		float borderWidth    = f.UV1.x;
+		float borderDistance = f.UV1.y;
+		Vec4f bgColor        = Premultiply(f.Color1);
+		Vec4f borderColor    = Premultiply(f.Color2);
+		float edgeAlpha      = Clamp(borderDistance + 0.5f, 0.0f, 1.0f);
+		float dclamped       = Clamp(borderWidth - borderDistance + 0.5f, 0.0f, 1.0f);
+		if (enableBGTex)
+			bgColor = blendOver(bgColor, readBGTex(Vec2f(f.UV1.z, f.UV1.w)));
+		color = ((1 - dclamped) * bgColor + dclamped * borderColor) * edgeAlpha;
+		break;
+	}
+	case SHADER_TEXT_SIMPLE:
+		color = Premultiply(f.Color1) * Sample(0, Vec2f(f.UV1.x, f.UV1.y)).x;
+		break;
+	case SHADER_TEXT_SUBPIXEL:
+		return ShadeSubpixelText(f.Color1, Vec2f(f.UV1.x, f.UV1.y), f.UV2);
+	default:
+		color = Vec4f(1, 1, 0, 1);
+		break;
+	}
+	r.Out0 = color;
+	r.Out1 = Vec4f(color.w, color.w, color.w, color.w);
+	return r;
+}
+
+// 7 tap horizontal filter that produces separate coverage for each of the R,G,B sub-pixels
+RenderSoft::Fragment RenderSoft::ShadeSubpixelText(const Vec4f& color, Vec2f uv, const Vec4f& texClamp) const {
+	float offset = 1.0f / GlyphAtlasSize;
+	float tap[7];
+	for (int i = 0; i < 7; i++)
+		tap[i] = Sample(0, Vec2f(Clamp(uv.x + offset * (i - 3), texClamp.x, texClamp.z), uv.y)).x;
+
+	const float w0 = 0.56f;
+	const float w1 = 0.28f;
+	const float w2 = 0.16f;
+
+	float r    = (w2 * tap[0] + w1 * tap[1] + w0 * tap[2] + w1 * tap[3] + w2 * tap[4]);
+	float g    = (w2 * tap[1] + w1 * tap[2] + w0 * tap[3] + w1 * tap[4] + w2 * tap[5]);
+	float b    = (w2 * tap[2] + w1 * tap[3] + w0 * tap[4] + w1 * tap[5] + w2 * tap[6]);
+	float aR   = r * color.w;
+	float aG   = g * color.w;
+	float aB   = b * color.w;
+	float avgA = (r + g + b) / 3.0f;
+
+	Fragment frag;
+	frag.Out0 = Vec4f(color.x * aR, color.y * aG, color.z * aB, avgA);
+	frag.Out1 = Vec4f(aR, aG, aB, avgA);
+	return frag;
+}
+} // namespace xo
@@ -0,0 +1,100 @@
+#pragma once
+#include "RenderBase.h"
+#include "../Image/Image.h"
+
+namespace xo {
+
+/* CPU rasterizer that implements RenderBase without any graphics device.
+
+This exists so that documents can be rendered to an Image on machines that have no GPU,
+such as build and benchmark servers. It is paired with SysWndHeadless.
+
+Draw() rasterizes triangles with pixel-center sampling and a consistent tie-breaking rule,
+so that the two triangles of a quad never touch the same pixel twice. Each fragment is then
+shaded by a C++ transcription of the corresponding GLSL shader, and blended with the same
+dual-source equation that RenderGL uses: dst = src0 + (1 - src1) * dst.
+
+Shaders that are implemented are Uber (all sub-shaders), TextRGB, TextWhole, Arc, Fill and FillTex.
+Anything else is drawn in solid yellow, which is the same thing that the uber shader does
+with an unrecognized shader type.
+
+The back buffer is never discarded, so BackbufferAge is always 1 after the first frame,
+and partial repaints with a scissor work as they do on a GPU with buffer age support.
+
+Textures are not copied. LoadTexture merely remembers the Texture object, and Draw samples
+directly out of its Data, so the texture must remain alive until the draw call that uses it.
+The exception is a texture that is streamed in with PrepareTexture and UploadTextureRect.
+Such a texture has no texels of its own on the render thread, so it gets a copy here,
+which plays the role of video memory.
+*/
+class XO_API RenderSoft : public RenderBase {
+public:
+	RenderSoft();
+	~RenderSoft() override;
+
+	const char* RendererName() override;
+
+	bool InitializeDevice(SysWnd& wnd) override;
+	void DestroyDevice(SysWnd& wnd) override;
+	void SurfaceLost() override;
+
+	bool BeginRender(SysWnd& wnd) override;
+	void EndRender(SysWnd& wnd, uint32_t endRenderFlags) override;
+
+	void PreRender() override;
+	void PostRenderCleanup() override;
+
+	ProgBase* GetShader(Shaders shader) override;
+	void      ActivateShader(Shaders shader) override;
+
+	void Draw(GPUPrimitiveTypes type, int nvertex, const void* v) override;
+
+	bool LoadTexture(Texture* tex, int texUnit) override;
+	bool ReadBackbuffer(Image& image) override;
+	int  BackbufferAge() override;
+	bool PrepareTexture(Texture* tex) override;
+	bool UploadTextureRect(const Texture* tex, Box rect, const void* data) override;
+
+protected:
+	// Vertex attributes after the equivalent of a vertex shader has run
+	struct Vertex {
+		Vec2f    Pos;
+		Vec4f    UV1;
+		Vec4f    UV2;
+		Vec4f    Color1; // Linear, not premultiplied
+		Vec4f    Color2; // Linear, not premultiplied
+		uint32_t Shader; // Vx_Uber.Shader. Not interpolated.
+	};
+
+	// Output of a fragment shader. Out1 is the per-channel coverage used by the blender.
+	struct Fragment {
+		Vec4f Out0;
+		Vec4f Out1;
+	};
+
+	Shaders          ActiveShader = ShaderInvalid;
+	Texture*         BoundTextures[MaxTextureUnits];
+	cheapvec<Image*> DeviceTextures;          // Copies of the textures created by PrepareTexture
+	Image            BackBuffer;
+	bool             BackBufferValid = false; // True once BackBuffer holds a frame of the current size
+	Box              ClipRect;                // Scissor of the current frame, clamped to the framebuffer
+	bool             SRGBFramebuffer = false;
+	float            SRGBToLinear[256];
+	uint8_t          LinearToSRGB[4096];
+
+	Image*   GetDeviceTexture(TextureID texID) const; // Returns null if 'texID' was not created by PrepareTexture
+	void     DeleteDeviceTextures();
+	void     LoadVertex(const uint8_t* v, Vertex& out) const;
+	void     DrawTriangle(const Vertex& a, const Vertex& b, const Vertex& c);
+	Fragment Shade(const Vertex& f, Vec2f screenPos) const;
+	Fragment ShadeUber(const Vertex& f, Vec2f screenPos) const;
+	Fragment ShadeSubpixelText(const Vec4f& color, Vec2f uv, const Vec4f& texClamp) const;
+	void     Blend(uint8_t* dst, const Fragment& frag) const;
+	Vec4f    Sample(int texUnit, Vec2f uv) const;
+	Vec4f    ReadColor(uint32_t rgba) const;
+	float    ReadFB(uint8_t v) const { return SRGBFramebuffer ? SRGBToLinear[v] : v * (1.0f / 255.0f); }
+	uint8_t  WriteFB(float v) const;
+
+	static Vec4f Premultiply(const Vec4f& c) { return Vec4f(c.x * c.w, c.y * c.w, c.z * c.w, c.w); }
+};
+} // namespace xo
@@ -4,6 +4,8 @@
 
 namespace xo {
 
+class StyleCache;
+
 // A single item on the render stack
 class XO_API RenderStackEl {
 public:
@@ -36,11 +38,14 @@ styles to blow that limit often. If they do, then it's simply a performance hit.
 */
 class XO_API RenderStack {
 public:
-	const xo::Doc* Doc;
-	Pool*          Pool;
-	StyleAttrib    Defaults[CatEND];
-	Style          VerbatimExplodeTemp; // Temporary object used for verbatim style explosion
-	cheapvec<char> VerbatimBufTemp;     // Temporary string used during verbatim explosion
+	const xo::Doc*     Doc;
+	Pool*              Pool;
+	StyleAttrib        Defaults[CatEND];
+	Style              VerbatimExplodeTemp;               // Temporary object used for verbatim style explosion
+	cheapvec<char>     VerbatimBufTemp;                   // Temporary string used during verbatim explosion
+	xo::StyleCache*    StyleCache              = nullptr; // If not null, then StyleResolver uses this to avoid resolving identical styles twice
+	cheapvec<uint32_t> StyleKeyTemp;                      // Temporary key used to look up StyleCache
+	bool               ResolvedExplicitInherit = false;   // Set by StyleResolver when an element has an explicit 'inherit' attribute
 
 	RenderStack();
 	~RenderStack();
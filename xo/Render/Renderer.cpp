@@ -4,42 +4,55 @@
 #include "RenderGL.h"
 #include "RenderDomEl.h"
 #include "TextureAtlas.h"
+#include "DamageTracker.h"
 #include "Text/GlyphCache.h"
 #include "../Image/Image.h"
 #include "../Dom/DomCanvas.h"
 
 namespace xo {
 
-const int SHADER_FLAG_TEXBG        = 16;
-const int SHADER_FLAG_TEXBG_PREMUL = 32;
-
-const int SHADER_ARC           = 1;
-const int SHADER_RECT          = 2;
-const int SHADER_TEXT_SIMPLE   = 3;
-const int SHADER_TEXT_SUBPIXEL = 4;
-
-RenderResult Renderer::Render(const xo::Doc* doc, xo::VectorCache* vcache, RenderBase* driver, const RenderDomNode* root) {
+RenderResult Renderer::Render(const xo::Doc* doc, xo::VectorCache* vcache, xo::VertexCache* vxcache, RenderBase* driver, const RenderDomNode* root, RenderStats& stats) {
 	Doc         = doc;
 	Driver      = driver;
 	Images      = &doc->Images;
 	Vectors     = &doc->GetSvgTable();
 	VectorCache = vcache;
+	VertexCache = vxcache;
 	Strings     = &doc->Strings;
 
 	Driver->PreRender();
+	Clip = Driver->GetScissor();
+
+	// Every glyph in our snapshot was published before we publish the invalid rectangles, so its texels will be uploaded
+	Glyphs = Global()->GlyphCache->BeginRead();
+	Global()->GlyphCache->PublishInvalidRects();
 
-	Global()->GlyphCache->Lock.lock();
+	if (VertexCache != nullptr)
+		VertexCache->BeginFrame();
 
 	// This phase is probably worth parallelizing
 	RenderEl(Point(0, 0), root);
 	// After RenderEl we are serial again.
 
+	FlushBatch();
+	BatchTexture = nullptr;
+
 	Driver->PostRenderCleanup();
 
+	stats.Render_NumDrawCalls   = NumDrawCalls;
+	stats.Render_NumNodesCached = 0;
+	if (VertexCache != nullptr) {
+		stats.Render_NumNodesCached = VertexCache->NumHits;
+		VertexCache->EndFrame(doc->InternalIDSize());
+	}
+
 	bool moreNeeded = GlyphsNeeded.size() != 0 || VectorsNeeded.size() != 0;
 
+	Global()->GlyphCache->EndRead(Glyphs);
+	Glyphs = nullptr;
+
 	RenderGlyphsNeeded();
-	Global()->GlyphCache->Lock.unlock();
+	Global()->GlyphCache->EndFrame();
 
 	RenderVectorsNeeded();
 
@@ -49,16 +62,24 @@ RenderResult Renderer::Render(const xo::Doc* doc, xo::VectorCache* vcache, Rende
 void Renderer::RenderEl(Point base, const RenderDomEl* el) {
 	if (el->Tag == TagText) {
 		Point newBase = base + Point(el->Pos.Left, el->Pos.Top);
-		RenderText(newBase, static_cast<const RenderDomText*>(el));
+		if (IsInsideClip(base, el))
+			RenderText(newBase, static_cast<const RenderDomText*>(el));
 	} else {
+		// Children are not necessarily inside their parent, so we must always recurse
 		const RenderDomNode* node = static_cast<const RenderDomNode*>(el);
-		RenderNode(base, node);
+		if (IsInsideClip(base, el))
+			RenderNode(base, node);
 		Point newBase = base + Point(node->Pos.Left, node->Pos.Top);
 		for (size_t i = 0; i < node->Children.size(); i++)
 			RenderEl(newBase, node->Children[i]);
 	}
 }
 
+bool Renderer::IsInsideClip(Point base, const RenderDomEl* el) const {
+	Box b = DamageTracker::PaintBounds(base, el);
+	return b.Left < Clip.Right && b.Right > Clip.Left && b.Top < Clip.Bottom && b.Bottom > Clip.Top;
+}
+
 struct BoxRadiusSet {
 	Vec2f TopLeft;
 	Vec2f BottomLeft;
@@ -157,6 +178,17 @@ void Renderer::RenderNode(Point base, const RenderDomNode* node) {
 	                  (border.Bottom != 0 && style->BorderColor[Bottom].a != 0);
 
 	if (bg.a != 0 || bgImage || anyBorders) {
+		uint64_t hash = 0;
+		if (VertexCache != nullptr) {
+			hash                  = VertexCache::Hash(pos, *style, shaderFlags, bgImageRect, bgImage);
+			const Vx_Uber* cached = nullptr;
+			int            n      = VertexCache->Find(node->InternalID, hash, cached);
+			if (n != -1) {
+				BatchQuads(n, cached);
+				return;
+			}
+		}
+
 		Vx_Uber vx[48];
 		float   vmid      = 0.5f * (top + bottom);
 		float   borderPos = border.Top;
@@ -352,8 +384,8 @@ void Renderer::RenderNode(Point base, const RenderDomNode* node) {
 			vx[c++].Set1(shader, VEC2(x[5], y[5]), VEC4(infinitelyThickBorder, -hpad, u[0], v[0]), bgRGBA, borderRGBA[Right]);
 		}
 
-		Driver->ActivateShader(ShaderUber);
-		Driver->Draw(GPUPrimQuads, c, vx);
+		Geometry.clear_noalloc();
+		Geometry.addn(vx, c);
 
 		if (anyArcs) {
 			// TODO: Fade between adjacent border colors
@@ -362,6 +394,10 @@ void Renderer::RenderNode(Point base, const RenderDomNode* node) {
 			RenderCornerArcs(shaderFlags, BottomRight, VEC2(right, bottom), radii.BottomRight, VEC2(border.Right, border.Bottom), VEC2(u[4], v[5]), uvScale, bgRGBA, borderRGBA[Right]);
 			RenderCornerArcs(shaderFlags, TopRight, VEC2(right, top), radii.TopRight, VEC2(border.Right, border.Top), VEC2(u[4], v[4]), uvScale, bgRGBA, borderRGBA[Right]);
 		}
+
+		if (VertexCache != nullptr)
+			VertexCache->Set(node->InternalID, hash, (int) Geometry.size(), Geometry.data);
+		BatchQuads((int) Geometry.size(), Geometry.data);
 	}
 }
 
@@ -373,7 +409,6 @@ void Renderer::RenderCornerArcs(int shaderFlags, Corners corner, Vec2f edge, Vec
 	if (borderWidth.x == 0 && borderWidth.y == 0)
 		borderRGBA = bgRGBA;
 
-	Driver->ActivateShader(ShaderUber);
 	float maxOuterRadius = Max(outerRadii.x, outerRadii.y);
 	float fanRadius;
 	int   divs;
@@ -474,7 +509,7 @@ void Renderer::RenderCornerArcs(int shaderFlags, Corners corner, Vec2f edge, Vec
 		vx[0].Set(SHADER_ARC | shaderFlags, center, arcCenters, VEC4(arcRadii.x, arcRadii.y, centerUV.x, centerUV.y), bgRGBA, borderRGBA);
 		vx[1].Set(SHADER_ARC | shaderFlags, fanPos, arcCenters, VEC4(arcRadii.x, arcRadii.y, fanUV.x, fanUV.y), bgRGBA, borderRGBA);
 		vx[2].Set(SHADER_ARC | shaderFlags, fanPosNext, arcCenters, VEC4(arcRadii.x, arcRadii.y, fanUVNext.x, fanUVNext.y), bgRGBA, borderRGBA);
-		Driver->Draw(GPUPrimTriangles, 3, vx);
+		AddTriangle(vx);
 		fanPos   = fanPosNext;
 		outerPos = outerPosNext;
 		innerPos = innerPosNext;
@@ -523,8 +558,8 @@ void Renderer::RenderQuadratic(Point base, const RenderDomNode* node) {
 		corners[i].V4.x  = -1;
 	}
 
-	Driver->ActivateShader(ShaderQuadraticSpline);
-	Driver->Draw(GPUPrimTriangles, 12, corners);
+	FlushBatch();
+	Draw(ShaderQuadraticSpline, GPUPrimTriangles, 12, corners);
 }
 
 void Renderer::RenderText(Point base, const RenderDomText* node) {
@@ -541,13 +576,14 @@ void Renderer::RenderText(Point base, const RenderDomText* node) {
 
 void Renderer::RenderTextChar_SubPixel(Point base, const RenderDomText* node, const RenderCharEl& txtEl) {
 	GlyphCacheKey glyphKey(node->FontID, txtEl.Char, node->FontSizePx, GlyphFlag_SubPixel_RGB);
-	const Glyph*  glyph = Global()->GlyphCache->GetGlyph(glyphKey);
+	const Glyph*  glyph = Glyphs->GetGlyph(glyphKey);
 	if (!glyph) {
 		GlyphsNeeded.insert(glyphKey);
 		return;
 	}
+	Glyphs->MarkUsed(glyph);
 
-	TextureAtlas* atlas       = Global()->GlyphCache->GetAtlasMutable(glyph->AtlasID);
+	TextureAtlas* atlas       = Glyphs->GetAtlasMutable(glyph->AtlasID);
 	float         atlasScaleX = 1.0f / atlas->Width;
 	float         atlasScaleY = 1.0f / atlas->Height;
 
@@ -617,22 +653,22 @@ void Renderer::RenderTextChar_SubPixel(Point base, const RenderDomText* node, co
 		corners[i].Shader = SHADER_TEXT_SUBPIXEL;
 	}
 
-	Driver->ActivateShader(ShaderUber);
 	//Driver->ActivateShader(ShaderTextRGB);
 	if (!LoadTexture(atlas, TexUnit0))
 		return;
-	Driver->Draw(GPUPrimQuads, 4, corners);
+	BatchQuads(4, corners);
 }
 
 void Renderer::RenderTextChar_WholePixel(Point base, const RenderDomText* node, const RenderCharEl& txtEl) {
 	GlyphCacheKey glyphKey(node->FontID, txtEl.Char, node->FontSizePx, 0);
-	const Glyph*  glyph = Global()->GlyphCache->GetGlyph(glyphKey);
+	const Glyph*  glyph = Glyphs->GetGlyph(glyphKey);
 	if (!glyph) {
 		GlyphsNeeded.insert(glyphKey);
 		return;
 	}
+	Glyphs->MarkUsed(glyph);
 
-	TextureAtlas* atlas       = Global()->GlyphCache->GetAtlasMutable(glyph->AtlasID);
+	TextureAtlas* atlas       = Glyphs->GetAtlasMutable(glyph->AtlasID);
 	float         atlasScaleX = 1.0f / atlas->Width;
 	float         atlasScaleY = 1.0f / atlas->Height;
 
@@ -688,15 +724,13 @@ void Renderer::RenderTextChar_WholePixel(Point base, const RenderDomText* node,
 	}
 
 	//Driver->ActivateShader(ShaderTextWhole);
-	Driver->ActivateShader(ShaderUber);
 	if (!LoadTexture(atlas, TexUnit0))
 		return;
-	Driver->Draw(GPUPrimQuads, 4, corners);
+	BatchQuads(4, corners);
 }
 
 void Renderer::RenderGlyphsNeeded() {
-	for (const auto& key : GlyphsNeeded)
-		Global()->GlyphCache->RenderGlyph(key);
+	Global()->GlyphCache->RenderGlyphs(GlyphsNeeded);
 	GlyphsNeeded.clear();
 }
 
@@ -706,10 +740,44 @@ void Renderer::RenderVectorsNeeded() {
 	VectorsNeeded.clear();
 }
 
+void Renderer::BatchQuads(int nvertex, const Vx_Uber* v) {
+	if (Batch.size() + nvertex > RenderBase::MaxDrawVertices)
+		FlushBatch();
+	Batch.addn(v, nvertex);
+}
+
+void Renderer::AddTriangle(const Vx_Uber* v) {
+	// Repeat the final vertex, so that the second triangle of the quad is degenerate
+	Vx_Uber quad[4] = {v[0], v[1], v[2], v[2]};
+	Geometry.addn(quad, 4);
+}
+
+void Renderer::FlushBatch() {
+	if (Batch.size() != 0)
+		Draw(ShaderUber, GPUPrimQuads, (int) Batch.size(), &Batch[0]);
+	Batch.clear_noalloc();
+}
+
+void Renderer::Draw(Shaders shader, GPUPrimitiveTypes type, int nvertex, const void* v) {
+	Driver->ActivateShader(shader);
+	Driver->Draw(type, nvertex, v);
+	NumDrawCalls++;
+}
+
 bool Renderer::LoadTexture(Texture* tex, TexUnits texUnit) {
-	if (!Driver->LoadTexture(tex, texUnit))
+	// Binding a different texture would affect the quads that are already in the batch
+	if (BatchTexture != nullptr && BatchTexture != tex)
+		FlushBatch();
+
+	bool      upload = tex->InvalidRect.IsAreaPositive();
+	CodeTimer t;
+	bool      ok = Driver->LoadTexture(tex, texUnit);
+	if (upload)
+		TimeTextureUpload += t.Measure();
+	if (!ok)
 		return false;
 
+	BatchTexture = tex;
 	tex->ClearInvalidRect();
 	return true;
 }
@@ -2,16 +2,33 @@
 #include "../Defs.h"
 #include "../Text/GlyphCache.h"
 #include "VectorCache.h"
+#include "VertexCache.h"
+#include "RenderBase.h"
 
 namespace xo {
 
 /* An instance of this is created for each render.
 Any state that is persisted between renderings is stored in RenderGL.
+
+Uber shader primitives are not sent to the driver one node at a time. Instead, they are
+accumulated into a frame-wide batch, which is flushed whenever the texture that it samples
+from changes, when some other shader needs to draw, when it is full, or at the end of the frame.
+Triangles (such as corner arcs) are added to the batch as degenerate quads, so that the
+batch remains a single quad list, and painter's order is preserved.
+
+Elements that lie entirely outside of the driver's scissor rectangle are skipped. The scissor is
+the damaged region of the frame, when only part of the frame is being repainted.
+
+The geometry of every node's box is retained in a VertexCache, which outlives the Renderer,
+so an unchanged box costs a copy into the batch.
 */
 class XO_API Renderer {
 public:
+	double TimeTextureUpload = 0; // Seconds spent loading textures with invalid regions onto the device, during the most recent render
+
 	// I initially tried to not pass Doc in here, but I eventually needed it to lookup canvas objects
-	RenderResult Render(const xo::Doc* doc, xo::VectorCache* vcache, RenderBase* driver, const RenderDomNode* root);
+	// vxcache may be null, in which case the geometry of every box is generated from scratch
+	RenderResult Render(const xo::Doc* doc, xo::VectorCache* vcache, xo::VertexCache* vxcache, RenderBase* driver, const RenderDomNode* root, RenderStats& stats);
 
 protected:
 	enum TexUnits {
@@ -28,11 +45,19 @@ protected:
 	const StringTable*         Strings     = nullptr;
 	const VariableTable*       Vectors     = nullptr;
 	xo::VectorCache*           VectorCache = nullptr;
+	xo::VertexCache*           VertexCache = nullptr;
 	RenderBase*                Driver      = nullptr;
+	const GlyphTableImmutable* Glyphs      = nullptr; // Snapshot of the glyph cache, held for the duration of the frame
 	ohash::set<GlyphCacheKey>  GlyphsNeeded;
 	ohash::set<VectorCacheKey> VectorsNeeded;
+	cheapvec<Vx_Uber>          Batch;                  // Uber shader quads that have not yet been sent to the driver
+	cheapvec<Vx_Uber>          Geometry;               // Quads of the box that RenderNode is busy generating
+	Texture*                   BatchTexture = nullptr; // Texture that is bound to the driver for the quads in Batch. Survives a flush, because the binding does.
+	uint32_t                   NumDrawCalls = 0;
+	Box                        Clip;                   // Driver's scissor rectangle, in pixels
 
 	void RenderEl(Point base, const RenderDomEl* node);
+	bool IsInsideClip(Point base, const RenderDomEl* el) const;
 	void RenderNode(Point base, const RenderDomNode* node);
 	void RenderCornerArcs(int shaderFlags, Corners corner, Vec2f edge, Vec2f outerRadii, Vec2f borderWidth, Vec2f centerUV, Vec2f uvScale, uint32_t bgRGBA, uint32_t borderRGBA);
 	void RenderQuadratic(Point base, const RenderDomNode* node);
@@ -41,8 +66,12 @@ protected:
 	void RenderTextChar_SubPixel(Point base, const RenderDomText* node, const RenderCharEl& txtEl);
 	void RenderGlyphsNeeded();
 	void RenderVectorsNeeded();
+	void BatchQuads(int nvertex, const Vx_Uber* v);
+	void AddTriangle(const Vx_Uber* v); // Add a triangle to Geometry, as a degenerate quad
+	void FlushBatch();
+	void Draw(Shaders shader, GPUPrimitiveTypes type, int nvertex, const void* v);
 
-	bool         LoadTexture(Texture* tex, TexUnits texUnit); // Load a texture and reset invalid rectangle
+	bool         LoadTexture(Texture* tex, TexUnits texUnit); // Load a texture and reset invalid rectangle. Flushes the batch if the texture changes.
 	static float CircleFrom3Pt(const Vec2f& a, const Vec2f& b, const Vec2f& c, Vec2f& center, float& radius);
 	static Vec2f PtOnEllipse(float flipX, float flipY, float a, float b, float theta);
 };
@@ -0,0 +1,85 @@
+#include "pch.h"
+#include "StyleCache.h"
+#include "RenderStack.h"
+#include "../Doc.h"
+
+namespace xo {
+
+StyleCache::StyleCache() {
+	NumHits   = 0;
+	NumMisses = 0;
+	Pool.SetChunkSize(64 * 1024, 64 * 1024);
+}
+
+StyleCache::~StyleCache() {
+}
+
+void StyleCache::BeginLayout(const Doc& doc) {
+	uint64_t fingerprint = doc.StyleFingerprint();
+	if (fingerprint != Fingerprint || Map.size() > MaxEntries)
+		Clear();
+	Fingerprint = fingerprint;
+	NumHits     = 0;
+	NumMisses   = 0;
+}
+
+bool StyleCache::Find(uint64_t hash, const cheapvec<uint32_t>& key, RenderStackEl& result) {
+	const Entry* e;
+	{
+		std::lock_guard<std::mutex> lock(Lock);
+		e = FindEntry(hash, key);
+	}
+	if (e == nullptr) {
+		NumMisses++;
+		return false;
+	}
+	// Entries are never modified after they are added, so we don't need to hold the lock while copying
+	e->Styles.CloneFastInto(result.Styles, result.Pool);
+	result.HasHoverStyle   = e->HasHoverStyle;
+	result.HasFocusStyle   = e->HasFocusStyle;
+	result.HasCaptureStyle = e->HasCaptureStyle;
+	NumHits++;
+	return true;
+}
+
+void StyleCache::Add(uint64_t hash, const cheapvec<uint32_t>& key, const RenderStackEl& resolved) {
+	std::lock_guard<std::mutex> lock(Lock);
+	// Another thread might have resolved the same style in the meantime
+	if (FindEntry(hash, key) != nullptr)
+		return;
+
+	Entry* e           = Pool.AllocT<Entry>(false);
+	e->Key             = (const uint32_t*) Pool.Copy(key.data, key.size() * sizeof(uint32_t));
+	e->KeyLen          = key.size();
+	e->HasHoverStyle   = resolved.HasHoverStyle;
+	e->HasFocusStyle   = resolved.HasFocusStyle;
+	e->HasCaptureStyle = resolved.HasCaptureStyle;
+	e->Styles.Reset();
+	resolved.Styles.CloneFastInto(e->Styles, &Pool);
+
+	Entry** head = Map.getp(hash);
+	if (head != nullptr) {
+		e->Next = *head;
+		*head   = e;
+	} else {
+		e->Next = nullptr;
+		Map.insert(hash, e);
+	}
+}
+
+void StyleCache::Clear() {
+	std::lock_guard<std::mutex> lock(Lock);
+	Map.clear();
+	Pool.FreeAll();
+}
+
+const StyleCache::Entry* StyleCache::FindEntry(uint64_t hash, const cheapvec<uint32_t>& key) const {
+	Entry* e = nullptr;
+	Map.get(hash, e);
+	for (; e != nullptr; e = e->Next) {
+		if (e->KeyLen == key.size() && memcmp(e->Key, key.data, key.size() * sizeof(uint32_t)) == 0)
+			return e;
+	}
+	return nullptr;
+}
+} // namespace xo
@@ -0,0 +1,64 @@
+#pragma once
+#include "../Style.h"
+
+namespace xo {
+
+class RenderStackEl;
+
+/* Remembers the resolved style of elements, so that siblings with identical inputs
+are resolved only once.
+
+The resolved style of an element is a pure function of:
+* Its tag, its list of classes, and its own style attributes
+* Whether it is hovered, focused or captured
+* The values that it inherits from its ancestors (see InheritedStyleCategories)
+* Document-wide state: tag styles, class styles and style variables
+
+StyleResolver packs the first three into a key. The last one is reduced to a fingerprint,
+and if that changes, then the whole cache is discarded.
+
+An element that has an explicit 'inherit' attribute can read any category from its ancestors,
+so its resolved style is not added to the cache.
+
+The cache is shared by the worker threads during a parallel layout, so Find and Add are thread safe.
+*/
+class XO_API StyleCache {
+public:
+	static const size_t MaxEntries = 16384; // If we grow beyond this, then we start from scratch at the next layout
+
+	std::atomic<uint32_t> NumHits;   // Number of elements whose style was found in the cache, during the most recent layout
+	std::atomic<uint32_t> NumMisses; // Number of elements whose style was resolved, during the most recent layout
+
+	StyleCache();
+	~StyleCache();
+
+	void BeginLayout(const Doc& doc); // Discard everything if the document-wide styles have changed
+
+	// If there is an entry for 'key', then copy its styles into 'result', and return true
+	bool Find(uint64_t hash, const cheapvec<uint32_t>& key, RenderStackEl& result);
+
+	// Remember the styles that were resolved into 'resolved' for 'key'
+	void Add(uint64_t hash, const cheapvec<uint32_t>& key, const RenderStackEl& resolved);
+
+	size_t Size() const { return Map.size(); }
+	void   Clear();
+
+protected:
+	struct Entry {
+		const uint32_t* Key;
+		size_t          KeyLen;
+		StyleSet        Styles;
+		bool            HasHoverStyle;
+		bool            HasFocusStyle;
+		bool            HasCaptureStyle;
+		Entry*          Next; // Next entry with the same hash
+	};
+
+	std::mutex                   Lock; // Guards Map and Pool
+	ohash::map<uint64_t, Entry*> Map;
+	xo::Pool                     Pool; // Entries, keys and the interned StyleSets live here
+	uint64_t                     Fingerprint = 0;
+
+	const Entry* FindEntry(uint64_t hash, const cheapvec<uint32_t>& key) const;
+};
+} // namespace xo
@@ -1,12 +1,24 @@
 #include "pch.h"
 #include "StyleResolve.h"
 #include "RenderStack.h"
+#include "StyleCache.h"
+#include "../../dependencies/hash/xxhash_xo_wrapper.h"
 
 namespace xo {
 
 void StyleResolver::ResolveAndPush(RenderStack& stack, const DomNode* node) {
+	StyleCache* cache = stack.StyleCache;
+	uint64_t    hash  = 0;
+	if (cache)
+		hash = MakeCacheKey(stack, node, stack.StyleKeyTemp);
+
 	RenderStackEl& result = stack.StackPush();
 
+	if (cache && cache->Find(hash, stack.StyleKeyTemp, result))
+		return;
+
+	stack.ResolvedExplicitInherit = false;
+
 	// 1. Inherited by default
 	for (int i = 0; i < NumInheritedStyleCategories; i++)
 		SetInherited(stack, node, InheritedStyleCategories[i]);
@@ -21,6 +33,47 @@ void StyleResolver::ResolveAndPush(RenderStack& stack, const DomNode* node) {
 
 	// 4. Node Styles
 	Set(stack, node, node->GetStyle());
+
+	if (cache && !stack.ResolvedExplicitInherit)
+		cache->Add(hash, stack.StyleKeyTemp, result);
+}
+
+uint64_t StyleResolver::MakeCacheKey(RenderStack& stack, const DomNode* node, cheapvec<uint32_t>& key) {
+	const DocUI&                  ui      = stack.Doc->UI;
+	InternalID                    id      = node->GetInternalID();
+	const cheapvec<StyleClassID>& classes = node->GetClasses();
+	const Style&                  style   = node->GetStyle();
+	static_assert(sizeof(StyleAttrib) % sizeof(uint32_t) == 0, "StyleAttrib must be a whole number of words");
+	const size_t attribWords = sizeof(StyleAttrib) / sizeof(uint32_t);
+
+	key.clear_noalloc();
+	key += (uint32_t) node->GetTag();
+	key += (ui.IsHovering(id) ? 1 : 0) | (ui.IsFocused(id) ? 2 : 0) | (ui.IsCaptured(id) ? 4 : 0);
+
+	key += (uint32_t) classes.size();
+	for (size_t i = 0; i < classes.size(); i++)
+		key += (uint32_t) classes[i];
+
+	key += (uint32_t) style.Attribs.size();
+	size_t pos = key.size();
+	key.resize(pos + style.Attribs.size() * attribWords);
+	if (style.Attribs.size() != 0)
+		memcpy(&key[pos], &style.Attribs[0], style.Attribs.size() * sizeof(StyleAttrib));
+
+	// The values that SetInherited will find. The new element has not been pushed yet, so our parent is on top.
+	for (int i = 0; i < NumInheritedStyleCategories; i++) {
+		StyleAttrib attrib;
+		for (ssize_t j = stack.StackSize() - 1; j >= 0; j--) {
+			attrib = stack.StackAt(j).Styles.Get(InheritedStyleCategories[i]);
+			if (!attrib.IsNull())
+				break;
+		}
+		pos = key.size();
+		key.resize(pos + attribWords);
+		memcpy(&key[pos], &attrib, sizeof(StyleAttrib));
+	}
+
+	return XXH64(key.data, key.size() * sizeof(uint32_t), 0);
 }
 
 static void RecursiveVariableResolve(const Doc* doc, cheapvec<char>& buf) {
@@ -90,24 +143,24 @@ bool StyleResolver::ExplodeVerbatimAttrib(Doc* doc, const StyleAttrib& attrib, c
 }
 
 void StyleResolver::Set(RenderStack& stack, const DomEl* node, const StyleClass& klass) {
-	Set(stack, node, klass.Default);
+	Set(stack, node, klass.Default());
 
 	if (stack.Doc->UI.IsHovering(node->GetInternalID()))
-		Set(stack, node, klass.Hover);
+		Set(stack, node, klass.Hover());
 
 	if (stack.Doc->UI.IsFocused(node->GetInternalID()))
-		Set(stack, node, klass.Focus);
+		Set(stack, node, klass.Focus());
 
 	if (stack.Doc->UI.IsCaptured(node->GetInternalID()))
-		Set(stack, node, klass.Capture);
+		Set(stack, node, klass.Capture());
 
-	if (!klass.Hover.IsEmpty())
+	if (!klass.Hover().IsEmpty())
 		stack.StackBack().HasHoverStyle = true;
 
-	if (!klass.Focus.IsEmpty())
+	if (!klass.Focus().IsEmpty())
 		stack.StackBack().HasFocusStyle = true;
 
-	if (!klass.Capture.IsEmpty())
+	if (!klass.Capture().IsEmpty())
 		stack.StackBack().HasCaptureStyle = true;
 }
 
@@ -119,10 +172,12 @@ void StyleResolver::Set(RenderStack& stack, const DomEl* node, size_t n, const S
 	RenderStackEl& result = stack.StackBack();
 
 	for (size_t i = 0; i < n; i++) {
-		if (vals[i].IsInherit())
+		if (vals[i].IsInherit()) {
+			stack.ResolvedExplicitInherit = true;
 			SetInherited(stack, node, vals[i].GetCategory());
-		else
+		} else {
 			SetOrExplode(stack, node, result, vals[i]);
+		}
 	}
 }
 
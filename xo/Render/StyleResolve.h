@@ -29,6 +29,9 @@ which nodes to process in your queue. I'm pretty sure that the ideal queue would
 initially of the root node, and then a further N nodes only, where N is your number of
 threads.
 
+If the stack has a StyleCache, then ResolveAndPush first looks for an element that had the same
+inputs, and copies its resolved style instead of merging tag, class and node styles again.
+
 NOTE: All of the protected functions assume that the style busy being resolved is on the top
 of the stack. Our only public function "Resolve" adds this blank style to the top of the stack
 before passing control to the other functions.
@@ -49,6 +52,9 @@ protected:
 	static void SetInherited(RenderStack& stack, const DomEl* node, StyleCategories cat);
 	static void SetOrExplode(RenderStack& stack, const DomEl* node, RenderStackEl& result, StyleAttrib attrib);
 	static void SetFinal(RenderStackEl& result, StyleAttrib attrib);
+
+	// Pack everything that the resolved style of 'node' depends on (other than document-wide state) into 'key', and return its hash
+	static uint64_t MakeCacheKey(RenderStack& stack, const DomNode* node, cheapvec<uint32_t>& key);
 };
 
 /* This is intended for resolving the style of an element, once-off.
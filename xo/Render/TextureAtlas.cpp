@@ -18,9 +18,11 @@ void TextureAtlas::Initialize(uint32_t width, uint32_t height, xo::TexFormat for
 	Stride        = (int) (width * TexFormatBytesPerPixel(format));
 	size_t nbytes = height * Stride;
 	Data          = (uint8_t*) MallocOrDie(nbytes);
-	PosTop        = Padding;
-	PosBottom     = Padding;
-	PosRight      = Padding;
+	Bottom        = Padding;
+	UsedArea      = 0;
+	NumLiveRects  = 0;
+	Shelves.clear();
+	PendingInvalidRect.SetInverted();
 }
 
 void TextureAtlas::Zero() {
@@ -29,26 +31,170 @@ void TextureAtlas::Zero() {
 
 void TextureAtlas::Free() {
 	free(Data);
+	Shelves.clear();
 	memset(this, 0, sizeof(*this));
 	TexID = TextureIDNull;
 }
 
+void TextureAtlas::PublishInvalidRect() {
+	InvalidRect.ExpandToFit(PendingInvalidRect);
+	PendingInvalidRect.SetInverted();
+}
+
 bool TextureAtlas::Alloc(uint16_t width, uint16_t height, uint16_t& x, uint16_t& y) {
-	if (width > Width)
+	// Empty rectangles (eg the glyph of a space) don't need any texels
+	if (width == 0 || height == 0) {
+		x = 0;
+		y = 0;
+		return true;
+	}
+
+	uint32_t cellWidth  = width + Padding;
+	uint32_t cellHeight = height + Padding;
+	if (Padding + cellWidth > Width || Padding + cellHeight > Height)
 		return false;
-	if (PosRight + width > Width) {
-		// move onto next line
-		PosTop   = PosBottom;
-		PosRight = 0;
+
+	// Find the span that fits best. An empty shelf counts as a perfect fit, because we can split it.
+	size_t   bestShelf = -1;
+	size_t   bestSpan  = -1;
+	uint32_t bestWaste = -1;
+	for (size_t i = 0; i < Shelves.size(); i++) {
+		const Shelf& shelf = Shelves[i];
+		if (shelf.Height < cellHeight)
+			continue;
+		uint32_t waste = IsEmpty(shelf) ? 0 : shelf.Height - cellHeight;
+		if (waste >= bestWaste)
+			continue;
+		for (size_t j = 0; j < shelf.FreeSpans.size(); j++) {
+			if (shelf.FreeSpans[j].Width >= cellWidth) {
+				bestShelf = i;
+				bestSpan  = j;
+				bestWaste = waste;
+				break;
+			}
+		}
 	}
-	// can't fit vertically
-	if (PosTop + height + Padding > Height)
+
+	// Rather open a new shelf than waste more than half of our height, unless we're out of space
+	bool canOpen = Bottom + cellHeight <= Height;
+	if (canOpen && (bestShelf == -1 || bestWaste > cellHeight / 2)) {
+		AddShelf(Shelves.size(), Bottom, cellHeight);
+		Bottom += cellHeight;
+		bestShelf = Shelves.size() - 1;
+		bestSpan  = 0;
+	}
+	if (bestShelf == -1)
 		return false;
-	x = PosRight;
-	y = PosTop;
-	PosRight += width + Padding;
-	PosBottom = std::max(PosBottom, PosTop + height + Padding);
-	InvalidRect.ExpandToFit(Box(x, y, x + width, y + height));
+
+	// Split an empty shelf that is taller than we need, so that the remainder can be used by other heights
+	if (IsEmpty(Shelves[bestShelf]) && Shelves[bestShelf].Height > cellHeight) {
+		Shelf& shelf = Shelves[bestShelf];
+		AddShelf(bestShelf + 1, shelf.Y + cellHeight, shelf.Height - cellHeight);
+		Shelves[bestShelf].Height = cellHeight;
+	}
+
+	Shelf& shelf = Shelves[bestShelf];
+	Span&  span  = shelf.FreeSpans[bestSpan];
+	x            = span.X;
+	y            = shelf.Y;
+	span.X += cellWidth;
+	span.Width -= cellWidth;
+	if (span.Width == 0)
+		shelf.FreeSpans.erase(bestSpan);
+
+	UsedArea += width * height;
+	NumLiveRects++;
+	Invalidate(Box(x, y, x + width, y + height));
 	return true;
 }
+
+void TextureAtlas::FreeRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
+	if (width == 0 || height == 0)
+		return;
+
+	size_t i = FindShelf(y);
+	XO_ASSERT(i != -1);
+	if (i == -1)
+		return;
+
+	size_t bpp = BytesPerPixel();
+	for (uint32_t row = y; row < (uint32_t) y + height; row++)
+		memset(DataAt(x, row), 0, width * bpp);
+	Invalidate(Box(x, y, x + width, y + height));
+
+	UsedArea -= width * height;
+	NumLiveRects--;
+
+	// Insert the span in X order, and merge it with its neighbours
+	cheapvec<Span>& spans = Shelves[i].FreeSpans;
+	Span            freed = {x, width + Padding};
+	size_t          pos   = 0;
+	while (pos < spans.size() && spans[pos].X < freed.X)
+		pos++;
+	spans.insert(pos, freed);
+	if (pos + 1 < spans.size() && spans[pos].X + spans[pos].Width == spans[pos + 1].X) {
+		spans[pos].Width += spans[pos + 1].Width;
+		spans.erase(pos + 1);
+	}
+	if (pos > 0 && spans[pos - 1].X + spans[pos - 1].Width == spans[pos].X) {
+		spans[pos - 1].Width += spans[pos].Width;
+		spans.erase(pos);
+	}
+
+	if (IsEmpty(Shelves[i]))
+		CollapseEmptyShelves();
+}
+
+float TextureAtlas::Occupancy() const {
+	if (Width == 0 || Height == 0)
+		return 0;
+	return (float) ((double) UsedArea / ((double) Width * (double) Height));
+}
+
+void TextureAtlas::Invalidate(const Box& rect) {
+	if (DeferInvalidation)
+		PendingInvalidRect.ExpandToFit(rect);
+	else
+		InvalidRect.ExpandToFit(rect);
+}
+
+bool TextureAtlas::IsEmpty(const Shelf& shelf) const {
+	return shelf.FreeSpans.size() == 1 && shelf.FreeSpans[0].X == Padding && shelf.FreeSpans[0].Width == Width - Padding;
+}
+
+void TextureAtlas::AddShelf(size_t pos, uint32_t y, uint32_t height) {
+	Shelf shelf;
+	shelf.Y      = y;
+	shelf.Height = height;
+	shelf.FreeSpans.push({Padding, Width - Padding});
+	Shelves.insert(pos, shelf);
+}
+
+void TextureAtlas::CollapseEmptyShelves() {
+	for (size_t i = Shelves.size() - 1; i != 0 && i != -1; i--) {
+		if (IsEmpty(Shelves[i]) && IsEmpty(Shelves[i - 1])) {
+			Shelves[i - 1].Height += Shelves[i].Height;
+			Shelves.erase(i);
+		}
+	}
+	if (Shelves.size() != 0 && IsEmpty(Shelves.back())) {
+		Bottom = Shelves.back().Y;
+		Shelves.erase(Shelves.size() - 1);
+	}
+}
+
+size_t TextureAtlas::FindShelf(uint32_t y) const {
+	size_t lo = 0;
+	size_t hi = Shelves.size();
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		if (Shelves[mid].Y == y)
+			return mid;
+		else if (Shelves[mid].Y < y)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return -1;
 }
+} // namespace xo
@@ -3,8 +3,26 @@
 
 namespace xo {
 
-// This is brain dead naive. We obviously need a better box packer.
-// The one from freetype-gl looks decent, or maybe stb_rect_pack.
+/* A texture that is divided up into many small rectangles, such as glyphs or vector icons.
+
+Rectangles are packed into shelves. A shelf is a horizontal strip of the texture, as tall
+as the first rectangle that was placed into it. Every shelf keeps a sorted list of the spans
+along its width that are still free. Alloc places a rectangle into the free span whose shelf
+height wastes the least space, and only opens a new shelf if no existing shelf is a reasonable
+fit. This works well for glyphs, because glyphs of the same font size have similar heights.
+
+FreeRect returns a rectangle to its shelf, merging it with its neighbouring free spans.
+When a shelf becomes entirely empty, it is merged with adjacent empty shelves, and an empty
+shelf may later be split to hold rectangles of a different height. Empty shelves at the
+bottom of the texture are returned to the unused space.
+
+Every rectangle is separated from its neighbours, and from the edges of the texture, by
+at least Padding texels.
+
+An atlas that is modified by one thread while the renderer uploads it on another thread sets
+DeferInvalidation. Alloc and FreeRect then accumulate their changes in PendingInvalidRect,
+which the owner moves into InvalidRect with PublishInvalidRect, on the render thread.
+*/
 class XO_API TextureAtlas : public Texture {
 public:
 	TextureAtlas();
@@ -13,12 +31,38 @@ public:
 	void Zero();
 	void Free();
 	bool Alloc(uint16_t width, uint16_t height, uint16_t& x, uint16_t& y);
+	void FreeRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height); // Return a rectangle that was produced by Alloc. Its texels are zeroed.
+
+	uint32_t GetPadding() const { return Padding; }
+	float    Occupancy() const;                         // Fraction of the texture area that is covered by live rectangles (padding not included)
+	uint32_t NumRects() const { return NumLiveRects; } // Number of rectangles that have been allocated and not freed
+
+	bool DeferInvalidation;  // Expand PendingInvalidRect instead of InvalidRect
+	Box  PendingInvalidRect; // Changes that have not yet been published to InvalidRect
+	void PublishInvalidRect();
 
 protected:
-	uint32_t Padding;
+	struct Span {
+		uint32_t X;
+		uint32_t Width; // Includes the padding to the right of a rectangle
+	};
+
+	struct Shelf {
+		uint32_t       Y;
+		uint32_t       Height;    // Includes the padding beneath a rectangle
+		cheapvec<Span> FreeSpans; // Sorted by X
+	};
+
+	uint32_t        Padding;
+	uint32_t        Bottom;       // Start of the space beneath the last shelf
+	uint64_t        UsedArea;     // Sum of the area of all live rectangles
+	uint32_t        NumLiveRects; // Number of live rectangles
+	cheapvec<Shelf> Shelves;      // Sorted by Y
 
-	uint32_t PosTop;
-	uint32_t PosBottom;
-	uint32_t PosRight;
+	void   Invalidate(const Box& rect);
+	bool   IsEmpty(const Shelf& shelf) const;
+	void   AddShelf(size_t pos, uint32_t y, uint32_t height);
+	void   CollapseEmptyShelves();
+	size_t FindShelf(uint32_t y) const;
 };
-}
+} // namespace xo
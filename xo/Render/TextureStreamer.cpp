@@ -0,0 +1,81 @@
+#include "pch.h"
+#include "TextureStreamer.h"
+#include "RenderBase.h"
+#include "../Image/Image.h"
+
+namespace xo {
+
+TextureStreamer::TextureStreamer() {
+	Backlog = false;
+}
+
+void TextureStreamer::Stage(RenderBase* driver, const cheapvec<Image*>& images) {
+	size_t budget  = Global()->ImageUploadBudget;
+	bool   backlog = false;
+	Rects.clear_noalloc();
+	Staging.clear_noalloc();
+
+	for (size_t i = 0; i < images.size(); i++) {
+		Image* img = images[i];
+		if (!driver->PrepareTexture(img)) {
+			XOTRACE_WARNING("Failed to create texture for image\n");
+			continue;
+		}
+
+		Box inv = img->InvalidRect;
+		inv.ClampTo(Box(0, 0, img->Width, img->Height));
+		if (!inv.IsAreaPositive()) {
+			img->ClearInvalidRect();
+			continue;
+		}
+
+		// Every image is prepared, even once the budget is spent, so that every TexID is valid
+		size_t used = Staging.size();
+		if (budget != 0 && used >= budget) {
+			backlog = true;
+			continue;
+		}
+
+		size_t rowBytes = (size_t) inv.Width() * img->BytesPerPixel();
+		int    rows     = inv.Height();
+		if (budget != 0)
+			rows = (int) Min<size_t>(rows, Max<size_t>((budget - used) / rowBytes, 1));
+
+		Rect r;
+		r.Meta        = *img;
+		r.Meta.Data   = nullptr;
+		r.Meta.Stride = 0;
+		r.Region      = Box(inv.Left, inv.Top, inv.Right, inv.Top + rows);
+		r.Offset      = used;
+		Rects += r;
+
+		Staging.resize_uninitialized(used + rowBytes * rows);
+		for (int y = 0; y < rows; y++)
+			memcpy(Staging.data + used + rowBytes * y, img->DataAt(inv.Left, inv.Top + y), rowBytes);
+
+		if (rows == inv.Height()) {
+			img->ClearInvalidRect();
+		} else {
+			img->InvalidRect     = inv;
+			img->InvalidRect.Top = inv.Top + rows;
+			backlog              = true;
+		}
+	}
+
+	Backlog = backlog;
+}
+
+uint32_t TextureStreamer::Upload(RenderBase* driver) {
+	uint32_t bytes = 0;
+	for (size_t i = 0; i < Rects.size(); i++) {
+		const Rect& r = Rects[i];
+		if (driver->UploadTextureRect(&r.Meta, r.Region, Staging.data + r.Offset))
+			bytes += (uint32_t) (r.Region.Width() * r.Region.Height() * r.Meta.BytesPerPixel());
+		else
+			XOTRACE_WARNING("Failed to upload image to GPU\n");
+	}
+	Rects.clear_noalloc();
+	Staging.clear_noalloc();
+	return bytes;
+}
+} // namespace xo
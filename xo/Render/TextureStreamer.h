@@ -0,0 +1,43 @@
+#pragma once
+#include "../Defs.h"
+
+namespace xo {
+
+class RenderBase;
+class Image;
+
+/* Moves the modified texels of the document's images to the GPU, without holding DocLock while they move.
+
+Stage runs under DocLock. It creates the device texture of every new image, so that its TexID is
+valid before the renderer's clone of the document copies it, and then copies the InvalidRect of
+each image into a single staging buffer. Only the invalid rows are copied, not the whole image.
+Once the staging buffer holds Global()->ImageUploadBudget bytes, the remaining rows are left in
+the image's InvalidRect, and are streamed during the following frames. At least one row of the
+first image is always staged, so that a tiny budget still makes progress.
+
+Upload runs after DocLock is released, and hands the staged rectangles to the device through
+RenderBase::UploadTextureRect. RenderGL streams these through a pair of pixel buffer objects, and
+RenderDX through a pair of staging textures.
+
+Until a backlog is drained, the image on screen is a mix of new and old rows. That is the price
+of never stalling a frame on a large upload.
+*/
+class XO_API TextureStreamer {
+public:
+	TextureStreamer();
+
+	void     Stage(RenderBase* driver, const cheapvec<Image*>& images); // Called under DocLock, between BeginRender and EndRender
+	uint32_t Upload(RenderBase* driver);                                // Returns the number of bytes uploaded
+	bool     HasBacklog() const { return Backlog; }                     // True if some images still have rows that were not staged
+
+protected:
+	struct Rect {
+		Texture Meta;   // The image's dimensions, format and TexID, without its texels
+		Box     Region; // Texels of this rectangle
+		size_t  Offset; // Start of the texels in Staging
+	};
+	cheapvec<Rect>    Rects;
+	cheapvec<uint8_t> Staging; // Rows of each Rect, packed tightly together
+	std::atomic<bool> Backlog; // Read by the message loop, to decide whether another frame is needed
+};
+} // namespace xo
@@ -54,13 +54,14 @@ VectorCache::Elem VectorCache::AllocAtlas(int iconID, int width, int height) {
 	}
 	Atlases.push_back(TextureAtlas());
 	TextureAtlas& atlas = Atlases.back();
+	uint32_t      pad   = 2;
 	uint32_t      aw    = 64;
 	uint32_t      ah    = 64;
-	while (aw < (uint32_t) width)
+	while (aw < (uint32_t) width + pad * 2)
 		aw *= 2;
-	while (ah < (uint32_t) height)
+	while (ah < (uint32_t) height + pad * 2)
 		ah *= 2;
-	atlas.Initialize(aw, ah, TexFormatRGBA8, 2);
+	atlas.Initialize(aw, ah, TexFormatRGBA8, pad);
 	XO_VERIFY(atlas.Alloc(width, height, e.X, e.Y));
 	e.Atlas = (int) Atlases.size() - 1;
 	Map.insert(VectorCacheKey::Make(iconID, width, height), e);
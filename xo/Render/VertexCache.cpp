@@ -0,0 +1,107 @@
+#include "pch.h"
+#include "VertexCache.h"
+#include "../Style.h"
+#include "../../dependencies/hash/xxhash_xo_wrapper.h"
+
+namespace xo {
+
+void VertexCache::BeginFrame() {
+	NumHits = 0;
+}
+
+void VertexCache::EndFrame(size_t numIDs) {
+	for (size_t i = numIDs; i < Entries.size(); i++) {
+		if (Entries[i].Count > 0)
+			Garbage += Entries[i].Count;
+	}
+	if (Entries.size() > numIDs)
+		Entries.resize(numIDs);
+
+	if (Garbage > Vertices.size() / 2)
+		Compact();
+}
+
+void VertexCache::Forget(const cheapvec<InternalID>& freed) {
+	for (InternalID id : freed) {
+		if ((size_t) id >= Entries.size())
+			continue;
+		if (Entries[id].Count > 0)
+			Garbage += Entries[id].Count;
+		Entries[id] = Entry();
+	}
+}
+
+int VertexCache::Find(InternalID id, uint64_t hash, const Vx_Uber*& vertices) {
+	if ((size_t) id >= Entries.size())
+		return -1;
+	const Entry& e = Entries[id];
+	if (e.Count == -1 || e.Hash != hash)
+		return -1;
+	vertices = Vertices.data + e.Offset;
+	NumHits++;
+	return e.Count;
+}
+
+void VertexCache::Set(InternalID id, uint64_t hash, int nvertex, const Vx_Uber* vertices) {
+	while (Entries.size() <= (size_t) id)
+		Entries += Entry();
+	Entry& e = Entries[id];
+	e.Hash   = hash;
+
+	// A change of color or position keeps the number of vertices, so it can be overwritten in place
+	if (e.Count == nvertex) {
+		if (nvertex != 0)
+			memcpy(Vertices.data + e.Offset, vertices, nvertex * sizeof(Vx_Uber));
+		return;
+	}
+
+	if (e.Count > 0)
+		Garbage += e.Count;
+	e.Offset = (uint32_t) Vertices.size();
+	e.Count  = nvertex;
+	Vertices.addn(vertices, nvertex);
+}
+
+void VertexCache::Clear() {
+	Entries.clear();
+	Vertices.clear();
+	Garbage = 0;
+}
+
+uint64_t VertexCache::Hash(Box pos, const StyleRender& style, int shaderFlags, Box bgImageRect, const Texture* bgImage) {
+	int32_t ints[] = {
+	    pos.Left,
+	    pos.Top,
+	    pos.Right,
+	    pos.Bottom,
+	    shaderFlags,
+	    bgImageRect.Left,
+	    bgImageRect.Top,
+	    bgImageRect.Right,
+	    bgImageRect.Bottom,
+	    bgImage != nullptr ? (int32_t) bgImage->Width : 0,
+	    bgImage != nullptr ? (int32_t) bgImage->Height : 0,
+	};
+	uint64_t h = XXH64(ints, sizeof(ints), 0);
+	h          = XXH64(&style.BorderSize, sizeof(style.BorderSize), h);
+	h          = XXH64(&style.Padding, sizeof(style.Padding), h);
+	h          = XXH64(&style.BorderRadius, sizeof(style.BorderRadius), h);
+	h          = XXH64(&style.BackgroundColor, sizeof(style.BackgroundColor), h);
+	return XXH64(style.BorderColor, sizeof(style.BorderColor), h);
+}
+
+void VertexCache::Compact() {
+	cheapvec<Vx_Uber> live;
+	live.reserve(Vertices.size() - Garbage);
+	for (size_t i = 0; i < Entries.size(); i++) {
+		Entry& e = Entries[i];
+		if (e.Count <= 0)
+			continue;
+		uint32_t offset = (uint32_t) live.size();
+		live.addn(Vertices.data + e.Offset, e.Count);
+		e.Offset = offset;
+	}
+	std::swap(Vertices, live);
+	Garbage = 0;
+}
+} // namespace xo
@@ -0,0 +1,55 @@
+#pragma once
+#include "../Defs.h"
+#include "VertexTypes.h"
+
+namespace xo {
+
+class StyleRender;
+
+/* Retains the uber shader vertices that Renderer generates for the box of each node
+(the background, the border slivers and the corner arcs).
+
+Generating the geometry of a box with borders and rounded corners is far more work than copying
+it, and in a typical UI almost every box is identical to the one in the previous frame. Entries
+are indexed by InternalID, and validated with a hash of everything that the geometry depends on:
+the absolute content box, the StyleRender, the shader flags and the region of the background
+texture. Because the absolute position is part of the hash, the vertices are stored in their
+final form, and a hit is appended straight onto the frame's batch.
+
+Text is not retained here, because glyphs can move around inside the glyph atlas from one frame
+to the next, and every visible glyph must be marked as used on every frame.
+
+All vertices live in a single array. When an entry changes size, its old range becomes garbage,
+and once more than half of the array is garbage, the live ranges are compacted. The entries of
+deleted elements become garbage when the renderer syncs with the canonical document, because
+most freed IDs are below the end of the InternalID table, and would otherwise be kept forever.
+*/
+class XO_API VertexCache {
+public:
+	uint32_t NumHits = 0; // Number of nodes whose vertices were copied out of the cache, during the most recent frame
+
+	void BeginFrame();
+	void EndFrame(size_t numIDs);                    // Discard entries beyond the end of the document's InternalID table
+	void Forget(const cheapvec<InternalID>& freed); // Discard entries of elements that have been deleted, before their IDs are reused
+
+	// Returns the number of vertices, or -1 if there is no entry for 'id' with the given hash
+	int             Find(InternalID id, uint64_t hash, const Vx_Uber*& vertices);
+	void            Set(InternalID id, uint64_t hash, int nvertex, const Vx_Uber* vertices);
+	void            Clear();
+	size_t          NumLiveVertices() const { return Vertices.size() - Garbage; }
+	static uint64_t Hash(Box pos, const StyleRender& style, int shaderFlags, Box bgImageRect, const Texture* bgImage);
+
+protected:
+	struct Entry {
+		uint64_t Hash   = 0;
+		uint32_t Offset = 0;
+		int32_t  Count  = -1; // -1 if this entry is empty
+	};
+
+	cheapvec<Entry>   Entries;  // Indexed by InternalID
+	cheapvec<Vx_Uber> Vertices; // Storage for all entries
+	size_t            Garbage = 0; // Number of vertices in Vertices that are no longer referenced by any entry
+
+	void Compact();
+};
+} // namespace xo
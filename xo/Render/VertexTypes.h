@@ -1,6 +1,16 @@
 #pragma once
 namespace xo {
 
+// Values of Vx_Uber.Shader. These must match the definitions in the uber shader source.
+const int SHADER_TYPE_MASK         = 15;
+const int SHADER_FLAG_TEXBG        = 16;
+const int SHADER_FLAG_TEXBG_PREMUL = 32;
+
+const int SHADER_ARC           = 1;
+const int SHADER_RECT          = 2;
+const int SHADER_TEXT_SIMPLE   = 3;
+const int SHADER_TEXT_SUBPIXEL = 4;
+
 // Position, UV, Color
 struct XO_API Vx_PTC {
 	// Note that RenderGL::DrawQuad assumes that Vx_PTC and Vx_PTCV4 share their base layout
@@ -4,6 +4,7 @@
 #include "CloneHelpers.h"
 #include "Text/FontStore.h"
 #include "Render/StyleResolve.h"
+#include "../dependencies/hash/xxhash_xo_wrapper.h"
 
 namespace xo {
 
@@ -903,6 +904,14 @@ void Style::CloneSlowInto(Style& c) const {
 	c.Attribs = Attribs;
 }
 
+uint64_t Style::ComputeHash(uint64_t seed) const {
+	return XXH64(Attribs.data, Attribs.size() * sizeof(StyleAttrib), seed);
+}
+
+bool Style::Equals(const Style& b) const {
+	return Attribs.size() == b.Attribs.size() && memcmp(Attribs.data, b.Attribs.data, Attribs.size() * sizeof(StyleAttrib)) == 0;
+}
+
 void Style::CloneFastInto(Style& c, Pool* pool) const {
 	//Name.CloneFastInto( c.Name, pool );
 	ClonePodvecWithMemCopy(c.Attribs, Attribs, pool);
@@ -951,6 +960,19 @@ void StyleSet::Reset() {
 	//GetSlotF = NULL;
 }
 
+void StyleSet::CloneFastInto(StyleSet& c, Pool* pool) const {
+	c.Reset();
+	if (BitsPerSlot == 0)
+		return;
+	// Keep the same capacity, because Grow() assumes that Capacity matches BitsPerSlot
+	c.Lookup      = pool->Copy(Lookup, (BitsPerSlot * CatEND + 7) / 8);
+	c.Attribs     = pool->AllocNT<StyleAttrib>(CapacityAt(BitsPerSlot), false);
+	c.Count       = Count;
+	c.Capacity    = Capacity;
+	c.BitsPerSlot = BitsPerSlot;
+	memcpy(c.Attribs, Attribs, Count * sizeof(StyleAttrib));
+}
+
 void StyleSet::Grow(Pool* pool) {
 	XO_ASSERT(BitsPerSlot != 8);
 	uint32_t     newbits    = BitsPerSlot == 0 ? InitialBitsPerSlot : BitsPerSlot * 2;
@@ -1103,6 +1125,18 @@ void StyleSet::SetSlot8(void* lookup, StyleCategories cat, int32_t slot) { TSetS
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+bool StyleClass::Parse(Pseudos pseudo, const char* t, size_t maxLen, Doc* doc) {
+	Modified = true;
+	return Styles[pseudo].Parse(t, maxLen, doc);
+}
+
+void StyleClass::Set(Pseudos pseudo, StyleAttrib attrib) {
+	Modified = true;
+	Styles[pseudo].Set(attrib);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 StyleTable::StyleTable() {
 }
 
@@ -1134,6 +1168,7 @@ StyleClass* StyleTable::GetOrCreate(const char* name) {
 	Classes.add();
 	Names.add();
 	StyleClass* s = &Classes[index];
+	s->Modified   = true;
 	NameToIndex.insert(n, index);
 	Names[index] = String(name);
 	return s;
@@ -1148,8 +1183,20 @@ StyleClassID StyleTable::GetClassID(const char* name) const {
 		return StyleClassID(0);
 }
 
+uint64_t StyleTable::ComputeHash(uint64_t seed) const {
+	uint64_t h = XXH64(nullptr, 0, seed ^ Classes.size());
+	for (size_t i = 0; i < Classes.size(); i++) {
+		const Style* all = Classes[i].All4PseudoTypes();
+		for (int j = 0; j < StyleClass::PseudoEND; j++)
+			h = all[j].ComputeHash(h);
+	}
+	return h;
+}
+
 void StyleTable::CloneSlowInto(StyleTable& c) const {
 	c.Classes = Classes;
+	for (size_t i = 0; i < c.Classes.size(); i++)
+		c.Classes[i].Modified = true;
 // The renderer doesn't need a Name -> ID table. That lookup table is only for end-user convenience.
 // HOWEVER, it can be useful when debugging
 #ifdef _DEBUG
@@ -1157,6 +1204,36 @@ void StyleTable::CloneSlowInto(StyleTable& c) const {
 #endif
 }
 
+size_t StyleTable::CloneModifiedInto(StyleTable& c) const {
+	// The table has been discarded and rebuilt since the previous sync
+	if (c.Classes.size() > Classes.size()) {
+		CloneSlowInto(c);
+		return Classes.size();
+	}
+
+	size_t orgSize = c.Classes.size();
+	while (c.Classes.size() < Classes.size())
+		c.Classes.add();
+
+	size_t n = 0;
+	for (size_t i = 0; i < Classes.size(); i++) {
+		if (i >= orgSize || Classes[i].Modified) {
+			c.Classes[i]          = Classes[i];
+			c.Classes[i].Modified = true;
+			n++;
+		}
+	}
+#ifdef _DEBUG
+	c.NameToIndex = NameToIndex;
+#endif
+	return n;
+}
+
+void StyleTable::ResetModified() {
+	for (size_t i = 0; i < Classes.size(); i++)
+		Classes[i].Modified = false;
+}
+
 void StyleTable::CloneFastInto(StyleTable& c, Pool* pool) const {
 	// The renderer doesn't need a Name -> ID table. That lookup table is only for end-user convenience.
 	ClonePodvecWithMemCopy(c.Classes, Classes, pool);
@@ -1165,9 +1242,12 @@ void StyleTable::CloneFastInto(StyleTable& c, Pool* pool) const {
 void StyleTable::ExpandVerbatimVariables(Doc* doc) {
 	cheapvec<char> buf;
 
-	for (auto& c : Classes) {
-		Style* pseudoGroup = c.All4PseudoTypes();
-		for (size_t i = 0; i < 4; i++) {
+	for (size_t ic = 0; ic < Classes.size(); ic++) {
+		if (!Classes[ic].Modified)
+			continue;
+		Classes[ic].Modified = false;
+		Style* pseudoGroup   = Classes[ic].Styles;
+		for (size_t i = 0; i < StyleClass::PseudoEND; i++) {
 			Style& pseudo = pseudoGroup[i];
 
 			// Instead of modifying the list of attributes in-place, which can potentially
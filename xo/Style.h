@@ -543,9 +543,11 @@ public:
 		Set(a);
 	}
 
-	void Discard();
-	void CloneSlowInto(Style& c) const;
-	void CloneFastInto(Style& c, Pool* pool) const;
+	void     Discard();
+	void     CloneSlowInto(Style& c) const;
+	void     CloneFastInto(Style& c, Pool* pool) const;
+	uint64_t ComputeHash(uint64_t seed) const; // Hash of all attributes, in order
+	bool     Equals(const Style& b) const;     // True if both have the same attributes, in the same order
 
 	bool IsEmpty() const { return Attribs.size() == 0; }
 
@@ -610,6 +612,7 @@ public:
 	void        EraseOrSetNull(StyleCategories cat) const; // If an item was already set, then Contains() will return true, but Get() will return a null StyleAttrib
 	bool        Contains(StyleCategories cat) const;
 	void        Reset();
+	void        CloneFastInto(StyleSet& c, Pool* pool) const; // Deep copy into 'c', allocating from 'pool'
 
 protected:
 	typedef void (*SetSlotFunc)(void* lookup, StyleCategories cat, int32_t slot);
@@ -647,15 +650,33 @@ protected:
 	static int32_t CapacityAt(uint32_t bitsPerSlot) { return (1 << bitsPerSlot) - 1; }
 };
 
-// This is a style class, such as "xo.controls.button"
+// This is a style class, such as "xo.controls.button".
+// Its styles can only be changed through its own functions, which mark it as modified. A change is
+// therefore seen by the renderer, even if it is made through a pointer that was kept from GetOrCreate.
 class XO_API StyleClass {
 public:
-	Style        Default; // Default styles
-	Style        Hover;   // Styles present when cursor is over node
-	Style        Focus;   // Styles present when object has focus
-	Style        Capture; // Styles present when object has input capture
-	Style*       All4PseudoTypes() { return &Default; }
-	const Style* All4PseudoTypes() const { return &Default; }
+	enum Pseudos {
+		PseudoDefault, // Default styles
+		PseudoHover,   // Styles present when cursor is over node
+		PseudoFocus,   // Styles present when object has focus
+		PseudoCapture, // Styles present when object has input capture
+		PseudoEND,
+	};
+
+	const Style& Default() const { return Styles[PseudoDefault]; }
+	const Style& Hover() const { return Styles[PseudoHover]; }
+	const Style& Focus() const { return Styles[PseudoFocus]; }
+	const Style& Capture() const { return Styles[PseudoCapture]; }
+	const Style* All4PseudoTypes() const { return Styles; }
+	bool         IsModified() const { return Modified; }
+
+	bool Parse(Pseudos pseudo, const char* t, size_t maxLen, Doc* doc); // Marks the class as modified
+	void Set(Pseudos pseudo, StyleAttrib attrib);                       // Marks the class as modified
+
+protected:
+	friend class StyleTable;
+	Style Styles[PseudoEND];
+	bool  Modified = false; // See StyleTable
 };
 
 // The set of style information that is used by the renderer
@@ -678,6 +699,15 @@ public:
 
 /* Store all style classes in one table, that is owned by one document.
 This allows us to reference styles by a 32-bit integer ID instead of by name.
+
+Every class has a modified bit, which is set when the class is created, and by every change to
+its styles. This allows the renderer's copy of the table to be brought up to date with
+CloneModifiedInto, which touches only the classes that have changed since the previous sync,
+instead of copying the entire table every frame.
+
+On the renderer's copy, the modified bit has a different meaning: it is set on every class that was
+copied in, and cleared by ExpandVerbatimVariables, so that style variables are expanded only once
+per copy of a class.
 */
 class XO_API StyleTable {
 public:
@@ -686,12 +716,16 @@ public:
 
 	void              AddDummyStyleZero();
 	void              Discard();
-	StyleClass*       GetOrCreate(const char* name);
+	StyleClass*       GetOrCreate(const char* name); // A new class is marked as modified
 	const StyleClass* GetByID(StyleClassID id) const;
 	StyleClassID      GetClassID(const char* name) const;
 	void              CloneSlowInto(StyleTable& c) const;             // Does not clone NameToIndex
+	size_t            CloneModifiedInto(StyleTable& c) const;         // Clone only new and modified classes. Returns the number of classes cloned. Does not clone NameToIndex.
 	void              CloneFastInto(StyleTable& c, Pool* pool) const; // Does not clone NameToIndex
-	void              ExpandVerbatimVariables(Doc* doc);              // Expand style $variables
+	void              ResetModified();
+	void              ExpandVerbatimVariables(Doc* doc); // Expand style $variables of classes that have been cloned in since the previous expansion
+	uint64_t          ComputeHash(uint64_t seed) const;  // Hash of the styles of all classes
+	size_t            Size() const { return Classes.size(); }
 	void              DebugDump() const;
 
 protected:
@@ -0,0 +1,69 @@
+#include "pch.h"
+#include "SysWnd_headless.h"
+#include "DocGroup.h"
+#include "Doc.h"
+#include "Render/RenderSoft.h"
+
+namespace xo {
+
+// There is no message loop to wake up, because headless documents are only rendered on demand
+class DocGroupHeadless : public DocGroup {
+protected:
+	void InternalTouchedByOtherThread() override {}
+};
+
+SysWndHeadless::SysWndHeadless() {
+}
+
+SysWndHeadless::~SysWndHeadless() {
+	if (Renderer) {
+		Renderer->DestroyDevice(*this);
+		delete Renderer;
+		Renderer = nullptr;
+	}
+}
+
+SysWndHeadless* SysWndHeadless::NewWithDoc(uint32_t width, uint32_t height) {
+	auto wnd           = new SysWndHeadless();
+	wnd->DocGroup      = new DocGroupHeadless();
+	wnd->DocGroup->Wnd = wnd;
+	auto err           = wnd->Create(0);
+	if (!err.OK()) {
+		Trace("Failed to create headless window: %v\n", err.Message());
+		delete wnd->DocGroup;
+		wnd->DocGroup = nullptr;
+		delete wnd;
+		return nullptr;
+	}
+	wnd->Attach(new xo::Doc(wnd->DocGroup), true);
+	Global()->DocAddQueue.Add(wnd->DocGroup);
+	wnd->SetPosition(Box(0, 0, width, height), SetPosition_Size);
+	return wnd;
+}
+
+Error SysWndHeadless::Create(uint32_t createFlags) {
+	Renderer = new RenderSoft();
+	if (!Renderer->InitializeDevice(*this)) {
+		delete Renderer;
+		Renderer = nullptr;
+		return Error("Failed to initialize software renderer");
+	}
+	return Error();
+}
+
+Box SysWndHeadless::GetRelativeClientRect() {
+	return Box(0, 0, Width, Height);
+}
+
+void SysWndHeadless::SetPosition(Box box, uint32_t setPosFlags) {
+	if (!(setPosFlags & SetPosition_Size))
+		return;
+	Width  = box.Width();
+	Height = box.Height();
+	if (DocGroup && DocGroup->Doc) {
+		xo::Event ev;
+		ev.MakeWindowSize(Width, Height);
+		DocGroup->ProcessEvent(ev);
+	}
+}
+} // namespace xo
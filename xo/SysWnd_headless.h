@@ -0,0 +1,31 @@
+#pragma once
+#include "SysWnd.h"
+
+namespace xo {
+
+/* A window that only exists in memory, and renders with RenderSoft.
+
+This has no dependencies on any windowing system or graphics device, so it is safe
+to use on servers and CI machines. There is no message loop behind it. Instead, call
+DocGroup->RenderToImage() whenever you want a frame.
+
+Unlike the platform windows, SetPosition applies immediately, and it sends the
+resulting EventWindowSize straight to the document.
+*/
+class XO_API SysWndHeadless : public SysWnd {
+public:
+	SysWndHeadless();
+	~SysWndHeadless() override;
+
+	// Create a headless window with its own DocGroup and Doc. Returns null on failure.
+	static SysWndHeadless* NewWithDoc(uint32_t width, uint32_t height);
+
+	Error Create(uint32_t createFlags) override;
+	Box   GetRelativeClientRect() override;
+	void  SetPosition(Box box, uint32_t setPosFlags) override;
+
+protected:
+	uint32_t Width  = 0;
+	uint32_t Height = 0;
+};
+} // namespace xo
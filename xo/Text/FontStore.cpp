@@ -1,6 +1,9 @@
 #include "pch.h"
 #include "FontStore.h"
+#include "GlyphCache.h"
 #include "../../dependencies/hash/xxhash_xo_wrapper.h"
+#include FT_TRUETYPE_TABLES_H
+#include FT_TRUETYPE_TAGS_H
 
 namespace xo {
 
@@ -158,27 +161,37 @@ const Font* FontStore::GetByFacename(const char* facename) {
 }
 
 FontID FontStore::InsertByFacename(const char* facename) {
-	std::lock_guard<std::mutex> lock(Lock);
+	const Font* font = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(Lock);
 
-	const Font* existing = GetByFacename_Internal(facename);
-	if (existing)
-		return existing->ID;
+		const Font* existing = GetByFacename_Internal(facename);
+		if (existing)
+			return existing->ID;
 
-	const char* filename = GetFilenameFromFacename(facename);
+		const char* filename = GetFilenameFromFacename(facename);
 
-	if (filename == nullptr) {
-		Trace("Failed to load font (facename=%s) (font not found)\n", facename);
-		return FontIDNull;
-	}
+		if (filename == nullptr) {
+			Trace("Failed to load font (facename=%s) (font not found)\n", facename);
+			return FontIDNull;
+		}
 
-	FT_Face  face;
-	FT_Error e = FT_New_Face(FTLibrary, filename, 0, &face);
-	if (e != 0) {
-		Trace("Failed to load font (facename=%s) (filename=%s)\n", facename, filename);
-		return FontIDNull;
+		FT_Face  face;
+		FT_Error e = FT_New_Face(FTLibrary, filename, 0, &face);
+		if (e != 0) {
+			Trace("Failed to load font (facename=%s) (filename=%s)\n", facename, filename);
+			return FontIDNull;
+		}
+
+		FontID id           = Insert_Internal(facename, face);
+		Fonts[id]->FileHash = HashFile(filename);
+		font                = Fonts[id];
 	}
 
-	return Insert_Internal(facename, face);
+	// Seed the glyph cache once, now that the font is new. The glyph cache calls us while holding its own lock, so we must not hold ours.
+	if (Global()->GlyphCache != nullptr)
+		Global()->GlyphCache->SeedFont(font);
+	return font->ID;
 }
 
 FontID FontStore::GetFallbackFontID() {
@@ -232,6 +245,7 @@ FontID FontStore::Insert_Internal(const char* facename, FT_Face face) {
 	FacenameToFontID.insert(low, font->ID);
 	LoadFontConstants(*font);
 	LoadFontTweaks(*font);
+	LoadKerning(*font);
 	return font->ID;
 }
 
@@ -264,6 +278,7 @@ void FontStore::LoadFontConstants(Font& font) {
 	font.LineHeight_x256 = EM_TO_256(font.FTFace->height);
 	font.Ascender_x256   = EM_TO_256(font.FTFace->ascender);
 	font.Descender_x256  = EM_TO_256(font.FTFace->descender);
+	font.UnitsPerEM      = font.FTFace->units_per_EM != 0 ? font.FTFace->units_per_EM : 1;
 }
 
 void FontStore::LoadFontTweaks(Font& font) {
@@ -294,6 +309,70 @@ void FontStore::LoadFontTweaks(Font& font) {
 	//	font.MaxAutoHinterSize = 50;
 }
 
+// Read the pairs of the TrueType 'kern' table into font.Kerning.Pairs, and then fill in the dense table
+// for Latin-1 characters. We follow the same rules as Freetype's tt_face_get_kerning: only format 0
+// horizontal subtables without the minimum or cross-stream bits are used, and each subtable either adds to,
+// or overrides (coverage bit 3), the previous ones.
+// Faces without a 'kern' table, but which Freetype can kern in some other way (eg AFM files), only
+// get the Latin-1 table, which we fill in by asking Freetype.
+void FontStore::LoadKerning(Font& font) {
+	FT_Face face = font.FTFace;
+	if (!FT_HAS_KERNING(face))
+		return;
+
+	FT_ULong length = 0;
+	if (FT_IS_SFNT(face) && FT_Load_Sfnt_Table(face, TTAG_kern, 0, nullptr, &length) == 0 && length >= 4) {
+		cheapvec<uint8_t> kern;
+		kern.resize(length);
+		FT_Load_Sfnt_Table(face, TTAG_kern, 0, kern.data, &length);
+		auto u16 = [](const uint8_t* p) -> uint32_t { return ((uint32_t) p[0] << 8) | p[1]; };
+
+		const uint8_t* p         = kern.data + 4;
+		const uint8_t* end       = kern.data + length;
+		uint32_t       numTables = Min<uint32_t>(u16(kern.data + 2), 32);
+		for (uint32_t t = 0; t < numTables && p + 6 <= end; t++) {
+			uint32_t       len      = u16(p + 2);
+			uint32_t       coverage = u16(p + 4);
+			const uint8_t* next     = Min(p + len, end);
+			if (len <= 6 + 8)
+				break;
+			if ((coverage & ~8) == 1 && p + 14 <= next) {
+				uint32_t numPairs = Min<uint32_t>(u16(p + 6), (uint32_t) (next - (p + 14)) / 6);
+				for (const uint8_t* pair = p + 14; numPairs != 0; numPairs--, pair += 6) {
+					uint32_t key   = KerningTable::PairKey(u16(pair), u16(pair + 2));
+					int16_t  value = (int16_t) u16(pair + 4);
+					if ((coverage & 8) == 0)
+						value += font.Kerning.Pairs.get(key);
+					font.Kerning.Pairs.set(key, value);
+				}
+			}
+			p = next;
+		}
+	}
+
+	if (FT_IS_SFNT(face) && font.Kerning.Pairs.size() == 0)
+		return;
+
+	FT_UInt glyphs[256];
+	for (int c = 0; c < 256; c++)
+		glyphs[c] = FT_Get_Char_Index(face, c);
+
+	font.Kerning.Latin1.resize(256 * 256);
+	for (int left = 0; left < 256; left++) {
+		for (int right = 0; right < 256; right++) {
+			int16_t value = 0;
+			if (FT_IS_SFNT(face)) {
+				value = font.Kerning.Pairs.get(KerningTable::PairKey(glyphs[left], glyphs[right]));
+			} else {
+				FT_Vector kern;
+				if (FT_Get_Kerning(face, glyphs[left], glyphs[right], FT_KERNING_UNSCALED, &kern) == 0)
+					value = (int16_t) kern.x;
+			}
+			font.Kerning.Latin1[(left << 8) | right] = value;
+		}
+	}
+}
+
 const char* FontStore::GetFilenameFromFacename(const char* facename) {
 	if (!IsFontTableLoaded) {
 		if (!LoadFontTable())
@@ -443,6 +522,13 @@ bool FontStore::LoadFontTable() {
 	return true;
 }
 
+uint64_t FontStore::HashFile(const char* filename) {
+	MappedFile file;
+	if (!file.Open(filename))
+		return 0;
+	return XXH64(file.Data(), file.Size(), 0);
+}
+
 uint64_t FontStore::ComputeFontDirHash() {
 	auto hstate = XXH64_createState();
 	XXH64_reset(hstate, 0);
@@ -20,8 +20,8 @@ inline void SplitFontIDWeightPair(FontIDWeightPair pair, FontID& fontID, uint8_t
 // without having to take any locks. Once a Font object has been created, it is
 // never mutated. The Freetype internals are most definitely mutated as we generate
 // more glyphs, but the info directly stored inside Font is immutable.
-// Of particular importance is LinearHoriAdvance_Space_x256, which is used a lot
-// during layout.
+// Of particular importance is LinearHoriAdvance_Space_x256 and the kerning table,
+// which are used a lot during layout.
 class XO_API FontTableImmutable {
 public:
 	FontTableImmutable();
@@ -30,6 +30,7 @@ public:
 	void        Initialize(const cheapvec<Font*>& fonts, const ohash::map<FontIDWeightPair, FontID>& cacheByWeight);
 	const Font* GetByFontID(FontID fontID) const;                          // Panics if FontID is valid
 	const Font* GetByFontIDAndWeight(FontID fontID, uint8_t weight) const; // Returns null if FontID+weight combo does not exist
+	size_t      Size() const { return Fonts.size(); }                      // One more than the highest FontID
 
 protected:
 	cheapvec<Font*>                      Fonts;
@@ -90,11 +91,13 @@ private:
 	FontID      Insert_Internal(const char* facename, FT_Face face);
 	void        LoadFontConstants(Font& font);
 	void        LoadFontTweaks(Font& font);
+	void        LoadKerning(Font& font);
 	const char* GetFilenameFromFacename(const char* facename);
 	void        BuildAndSaveFontTable();
 	bool        LoadFontTable();
 	uint64_t    ComputeFontDirHash();
 
-	static bool IsFontFilename(const char* filename);
+	static bool     IsFontFilename(const char* filename);
+	static uint64_t HashFile(const char* filename);
 };
 } // namespace xo
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "GlyphCache.h"
 #include "FontStore.h"
+#include "GlyphDiskCache.h"
 #include "Render/TextureAtlas.h"
 
 namespace xo {
@@ -14,52 +15,406 @@ namespace xo {
 static const uint32_t SubPixelHintKillShift      = 0;
 static const uint32_t SubPixelHintKillMultiplier = (1 << SubPixelHintKillShift);
 
-// GCC 4.6 for Android forces us to set the value of this constant in the .cpp file, not in the .h file.
-const uint32_t GlyphCache::NullGlyphIndex = 0; // Our first element in 'Glyphs' is always the null glyph
+const Glyph* GlyphTableImmutable::GetGlyph(const GlyphCacheKey& key) const {
+	GlyphCacheKey face = key;
+	face.Char          = 0;
+	Page* page         = Pages.get(face);
+	if (page == nullptr)
+		return nullptr;
+	if (key.Char < 128)
+		return page->ASCII.Glyphs[key.Char];
+	GlyphCacheEntry* entry = page->Glyphs.get(key.Char);
+	return entry != nullptr ? &entry->Glyph : nullptr;
+}
+
+const GlyphTableImmutable::ASCIIGlyphs* GlyphTableImmutable::GetASCII(const GlyphCacheKey& key) const {
+	GlyphCacheKey face = key;
+	face.Char          = 0;
+	Page* page         = Pages.get(face);
+	return page != nullptr ? &page->ASCII : nullptr;
+}
+
+void GlyphTableImmutable::MarkUsed(const Glyph* glyph) const {
+	const GlyphCacheEntry* entry = reinterpret_cast<const GlyphCacheEntry*>(glyph);
+	const_cast<GlyphCacheEntry*>(entry)->LastUsed.store(Cache->CurrentFrame(), std::memory_order_relaxed);
+}
 
 GlyphCache::GlyphCache() {
-	Initialize();
+	NumAcquiring = 0;
+	Frame        = 0;
+	Current      = nullptr;
+	Disk         = new GlyphDiskCache();
+	Publish();
 }
 
 GlyphCache::~GlyphCache() {
+	FreeAll();
+	delete Disk;
 }
 
 void GlyphCache::Clear() {
+	FreeAll();
+	FontSeeded.clear();
+	Publish();
+}
+
+void GlyphCache::FreeAll() {
+	// An entry belongs to the writer's pages until it is evicted, after which it belongs to OldEntries
+	for (auto& pair : Pages) {
+		for (auto& g : pair.second->Glyphs)
+			delete g.second;
+		ReleasePage(pair.second);
+	}
+	for (size_t i = 0; i < OldEntries.size(); i++)
+		delete OldEntries[i].Entry;
+	for (size_t i = 0; i < Retired.size(); i++)
+		FreeSnapshot(Retired[i]);
+	if (Current.load() != nullptr)
+		FreeSnapshot(Current.load());
 	for (size_t i = 0; i < Atlasses.size(); i++)
 		Atlasses[i]->Free();
 	DeleteAll(Atlasses);
-	Glyphs.clear();
-	Table.clear();
-	Initialize();
+	Current = nullptr;
+	Draining.clear();
+	Pages.clear();
+	DirtyPages.clear();
+	OldEntries.clear();
+	Retired.clear();
+	OldAtlasses.clear();
 }
 
-void GlyphCache::Initialize() {
-	NullGlyph.SetNull();
-	Glyphs += Glyph();
-	Glyphs.back().SetNull();
+const GlyphTableImmutable* GlyphCache::BeginRead() {
+	// The order matters. See "Reclamation" in the header.
+	NumAcquiring++;
+	const GlyphTableImmutable* snapshot = Current.load();
+	snapshot->RefCount++;
+	NumAcquiring--;
+	return snapshot;
 }
 
-const Glyph* GlyphCache::GetGlyph(const GlyphCacheKey& key) const {
-	uint32_t* pos = Table.getp(key);
-	if (pos != nullptr)
-		return &Glyphs[*pos];
-	else
-		return nullptr;
+void GlyphCache::EndRead(const GlyphTableImmutable* snapshot) {
+	// The latest snapshot holds a reference to itself, so if we were the last reader, then it has been replaced
+	if (--snapshot->RefCount == 0) {
+		std::unique_lock<std::mutex> lock(Lock, std::try_to_lock);
+		if (lock.owns_lock())
+			Reclaim();
+	}
+}
+
+void GlyphCache::Publish() {
+	// Only the pages that we have copied since the last Publish need new ASCII tables
+	for (auto key : DirtyPages) {
+		Page* page = Pages.get(key);
+		if (page->Glyphs.size() == 0) {
+			Pages.erase(key);
+			ReleasePage(page);
+			continue;
+		}
+		memset(&page->ASCII, 0, sizeof(page->ASCII));
+		for (auto& g : page->Glyphs) {
+			if (g.first < 128)
+				page->ASCII.Glyphs[g.first] = &g.second->Glyph;
+		}
+	}
+	DirtyPages.clear();
+
+	GlyphTableImmutable* next = new GlyphTableImmutable();
+	next->Cache               = this;
+	next->Epoch               = ++Epoch;
+	next->RefCount            = 1;
+	next->Pages               = Pages;
+	next->Atlasses            = Atlasses;
+	for (auto& pair : Pages)
+		pair.second->RefCount++;
+
+	const GlyphTableImmutable* prev = Current.exchange(next);
+	if (prev != nullptr) {
+		Retired += prev;
+		prev->RefCount--;
+	}
 }
 
-const Glyph* GlyphCache::GetOrRenderGlyph(const GlyphCacheKey& key) {
-	auto g = GetGlyph(key);
-	if (g)
-		return g;
-	RenderGlyph(key);
-	return GetGlyph(key);
+void GlyphCache::Reclaim() {
+	// A reader inside BeginRead may be about to take a reference to a snapshot that has just been replaced
+	if (NumAcquiring.load() != 0)
+		return;
+
+	uint64_t oldest = Epoch; // Epoch of the oldest snapshot that is still alive
+	for (size_t i = 0; i < Retired.size();) {
+		if (Retired[i]->RefCount.load() == 0) {
+			FreeSnapshot(Retired[i]);
+			Retired.erase(i);
+		} else {
+			oldest = Min(oldest, Retired[i]->Epoch);
+			i++;
+		}
+	}
+
+	// Entries must go before atlases, because an atlas is only freed after its glyphs have been moved out of it
+	for (size_t i = 0; i < OldEntries.size();) {
+		if (OldEntries[i].Epoch < oldest) {
+			const Glyph& g = OldEntries[i].Entry->Glyph;
+			if (!g.IsNull())
+				Atlasses[g.AtlasID]->FreeRect(g.X, g.Y, g.Width, g.Height);
+			delete OldEntries[i].Entry;
+			OldEntries.erase(i);
+		} else {
+			i++;
+		}
+	}
+	for (size_t i = 0; i < OldAtlasses.size();) {
+		if (OldAtlasses[i].Epoch < oldest) {
+			// Keep the TextureID, so that the next atlas we create reuses the device texture
+			uint32_t      id    = OldAtlasses[i].AtlasID;
+			TextureAtlas* atlas = Atlasses[id];
+			TextureID     texID = atlas->TexID;
+			atlas->Free();
+			atlas->TexID = texID;
+			Draining[id] = false;
+			OldAtlasses.erase(i);
+		} else {
+			i++;
+		}
+	}
 }
 
-uint32_t GlyphCache::RenderGlyph(const GlyphCacheKey& key) {
-	XOTRACE_FONTS("RenderGlyph %d\n", (int) key.Char);
+void GlyphCache::FreeSnapshot(const GlyphTableImmutable* snapshot) {
+	for (auto& pair : snapshot->Pages)
+		ReleasePage(pair.second);
+	delete snapshot;
+}
+
+void GlyphCache::ReleasePage(Page* page) {
+	if (--page->RefCount == 0)
+		delete page;
+}
+
+// Returns the writer's copy of the page that 'key' belongs to, creating it if necessary.
+// A page that has been published is shared with readers, so we copy it before its first modification.
+GlyphCache::Page* GlyphCache::PageForWrite(const GlyphCacheKey& key) {
+	GlyphCacheKey face = key;
+	face.Char          = 0;
+	Page* page         = Pages.get(face);
+	if (page != nullptr && DirtyPages.contains(face))
+		return page;
+
+	Page* copy     = new Page();
+	copy->RefCount = 1;
+	if (page != nullptr) {
+		copy->Glyphs = page->Glyphs;
+		ReleasePage(page);
+	}
+	Pages.set(face, copy);
+	DirtyPages.insert(face);
+	return copy;
+}
+
+bool GlyphCache::Contains(const GlyphCacheKey& key) const {
+	GlyphCacheKey face = key;
+	face.Char          = 0;
+	Page* page         = Pages.get(face);
+	return page != nullptr && page->Glyphs.contains(key.Char);
+}
+
+void GlyphCache::RenderGlyph(const GlyphCacheKey& key) {
+	std::lock_guard<std::mutex> lock(Lock);
+	if (RenderGlyph_Internal(key)) {
+		Publish();
+		Reclaim();
+	}
+}
+
+void GlyphCache::RenderGlyphs(const ohash::set<GlyphCacheKey>& keys) {
+	std::lock_guard<std::mutex> lock(Lock);
+	bool                        any = false;
+	for (auto it = keys.begin(); it != keys.end(); it++)
+		any |= RenderGlyph_Internal(*it);
+	if (any) {
+		Publish();
+		Reclaim();
+	}
+}
+
+void GlyphCache::PublishInvalidRects() {
+	std::lock_guard<std::mutex> lock(Lock);
+	for (size_t i = 0; i < Atlasses.size(); i++) {
+		if (Atlasses[i]->Data != nullptr)
+			Atlasses[i]->PublishInvalidRect();
+	}
+}
+
+void GlyphCache::EndFrame() {
+	{
+		std::lock_guard<std::mutex> lock(Lock);
+		Reclaim();
+		if (Global()->GlyphCacheMaxBytes != 0 && AtlasBytes() > Global()->GlyphCacheMaxBytes)
+			Trim(Global()->GlyphCacheMaxBytes);
+	}
+	Frame++;
+}
+
+// Assumes that Lock is held
+void GlyphCache::Trim(size_t maxBytes) {
+	const size_t atlasBytes = GlyphAtlasSize * GlyphAtlasSize * TexFormatBytesPerPixel(TexFormatGrey8);
+	size_t       maxAtlases = Max<size_t>(maxBytes / atlasBytes, 1);
+	uint32_t     frame      = CurrentFrame();
+
+	// 1. Evict the least recently used glyphs, until the rest cover no more than half of our budget.
+	// Leaving so much slack means that we don't need to evict again on the very next frame.
+	cheapvec<GlyphCacheEntry*> cold;
+	uint64_t                   liveArea = 0;
+	for (auto& pair : Pages) {
+		for (auto& g : pair.second->Glyphs) {
+			GlyphCacheEntry* e = g.second;
+			liveArea += e->Glyph.Width * e->Glyph.Height;
+			if (e->LastUsed.load(std::memory_order_relaxed) != frame)
+				cold += e;
+		}
+	}
+	std::sort(cold.data, cold.data + cold.size(), [](GlyphCacheEntry* a, GlyphCacheEntry* b) { return a->LastUsed.load() < b->LastUsed.load(); });
+	uint64_t targetArea = (uint64_t) maxAtlases * GlyphAtlasSize * GlyphAtlasSize / 2;
+	for (size_t i = 0; i < cold.size() && liveArea > targetArea; i++) {
+		liveArea -= cold[i]->Glyph.Width * cold[i]->Glyph.Height;
+		Evict(cold[i]);
+	}
+
+	// The space of evicted glyphs can only be reused once readers are done with them.
+	// If nobody is reading right now, then we can compact into that space immediately.
+	Publish();
+	Reclaim();
+
+	// 2. Compact, by moving the glyphs out of the least occupied atlas, until we're within budget
+	while (NumAtlases() > maxAtlases) {
+		uint32_t emptiest = -1;
+		for (uint32_t i = 0; i < (uint32_t) Atlasses.size(); i++) {
+			if (Atlasses[i]->Data != nullptr && !Draining[i] && (emptiest == -1 || Atlasses[i]->Occupancy() < Atlasses[emptiest]->Occupancy()))
+				emptiest = i;
+		}
+		cheapvec<GlyphCacheEntry*> move;
+		for (auto& pair : Pages) {
+			for (auto& g : pair.second->Glyphs) {
+				if (g.second->Glyph.AtlasID == emptiest && g.second->Glyph.Width != 0)
+					move += g.second;
+			}
+		}
+		bool movedAll = true;
+		for (size_t i = 0; i < move.size() && movedAll; i++)
+			movedAll = MoveGlyph(move[i], emptiest);
+		if (!movedAll)
+			break;
+
+		// The atlas is freed once readers are done with the old copies of its glyphs
+		Draining[emptiest] = true;
+		OldAtlasses += OldAtlas{emptiest, Epoch};
+	}
+	Publish();
+	Reclaim();
+}
+
+size_t GlyphCache::AtlasBytes() {
+	size_t total = 0;
+	for (size_t i = 0; i < Atlasses.size(); i++) {
+		if (Atlasses[i]->Data != nullptr)
+			total += Atlasses[i]->Height * std::abs(Atlasses[i]->Stride);
+	}
+	return total;
+}
+
+uint32_t GlyphCache::NumAtlases() {
+	uint32_t n = 0;
+	for (size_t i = 0; i < Atlasses.size(); i++)
+		n += Atlasses[i]->Data != nullptr && !Draining[i] ? 1 : 0;
+	return n;
+}
+
+uint32_t GlyphCache::NumGlyphs() {
+	size_t n = 0;
+	for (auto& pair : Pages)
+		n += pair.second->Glyphs.size();
+	return (uint32_t) n;
+}
+
+TextureAtlas* GlyphCache::AllocAtlas(uint32_t padding, bool isSubPixel) {
+	TextureAtlas* atlas = nullptr;
+	for (size_t i = 0; i < Atlasses.size() && atlas == nullptr; i++) {
+		if (Atlasses[i]->Data == nullptr)
+			atlas = Atlasses[i];
+	}
+	if (atlas == nullptr) {
+		atlas = new TextureAtlas();
+		Atlasses += atlas;
+		Draining += false;
+	}
+	TextureID texID = atlas->TexID;
+	atlas->Initialize(GlyphAtlasSize, GlyphAtlasSize, TexFormatGrey8, padding);
+	atlas->Zero();
+	atlas->TexID              = texID;
+	atlas->DeferInvalidation  = true;
+	atlas->PendingInvalidRect = Box(0, 0, atlas->Width, atlas->Height);
+	if (isSubPixel) {
+		atlas->FilterMin = TexFilterNearest;
+		atlas->FilterMax = TexFilterNearest;
+	} else if (!Global()->SnapHorzText || !Global()->RoundLineHeights) {
+		atlas->FilterMin = TexFilterLinear;
+		atlas->FilterMax = TexFilterLinear;
+	}
+	return atlas;
+}
+
+// Try every live atlas with the same padding, so that space which has been freed inside older atlases gets reused
+bool GlyphCache::AllocInAtlas(uint32_t padding, uint16_t width, uint16_t height, uint32_t excludeAtlas, uint32_t& atlasID, uint16_t& x, uint16_t& y) {
+	for (uint32_t i = 0; i < (uint32_t) Atlasses.size(); i++) {
+		TextureAtlas* atlas = Atlasses[i];
+		if (i == excludeAtlas || atlas->Data == nullptr || Draining[i] || atlas->GetPadding() != padding)
+			continue;
+		if (atlas->Alloc(width, height, x, y)) {
+			atlasID = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+// The entry, and its texels, stay alive until readers of older snapshots are done with them
+void GlyphCache::Evict(GlyphCacheEntry* entry) {
+	PageForWrite(entry->Key)->Glyphs.erase(entry->Key.Char);
+	OldEntries += OldEntry{entry, Epoch};
+}
+
+// Copy the glyph into a new entry, in a different atlas. The old entry is evicted.
+bool GlyphCache::MoveGlyph(GlyphCacheEntry* entry, uint32_t excludeAtlas) {
+	const Glyph&  g   = entry->Glyph;
+	TextureAtlas* src = Atlasses[g.AtlasID];
+	uint32_t      dstID;
+	uint16_t      x, y;
+	if (!AllocInAtlas(src->GetPadding(), g.Width, g.Height, excludeAtlas, dstID, x, y))
+		return false;
+	Atlasses[dstID]->CopyFrom(x, y, src->DataAt(g.X, g.Y), src->Stride, g.Width, g.Height);
+
+	GlyphCacheEntry* moved = new GlyphCacheEntry();
+	moved->Glyph           = g;
+	moved->Glyph.AtlasID   = dstID;
+	moved->Glyph.X         = x;
+	moved->Glyph.Y         = y;
+	moved->Key             = entry->Key;
+	moved->LastUsed        = entry->LastUsed.load();
+	Evict(entry);
+	PageForWrite(moved->Key)->Glyphs.insert(moved->Key.Char, moved);
+	return true;
+}
+
+bool GlyphCache::RenderGlyph_Internal(const GlyphCacheKey& key) {
+	if (Contains(key))
+		return false;
 
 	XO_ASSERT(key.Size != 0);
-	const Font*                 font = Global()->FontStore->GetByFontID(key.FontID);
+	const Font* font = Global()->FontStore->GetByFontID(key.FontID);
+	if (SeedFont_Internal(font) && Contains(key))
+		return true;
+
+	XOTRACE_FONTS("RenderGlyph %d\n", (int) key.Char);
+	DiskDirty = true;
+
 	std::lock_guard<std::mutex> lock(font->FTFace_Lock);
 
 	FT_UInt iFTGlyph = FT_Get_Char_Index(font->FTFace, key.Char);
@@ -86,8 +441,10 @@ uint32_t GlyphCache::RenderGlyph(const GlyphCacheKey& key) {
 	e = FT_Load_Glyph(font->FTFace, iFTGlyph, ftflags);
 	if (e != 0) {
 		Trace("Failed to load glyph for character %d (%d)\n", key.Char, iFTGlyph);
-		Table.insert(key, NullGlyphIndex);
-		return NullGlyphIndex;
+		Glyph null;
+		null.SetNull();
+		AddEntry(key, null, CurrentFrame());
+		return true;
 	}
 
 	int  width        = font->FTFace->glyph->bitmap.width;
@@ -107,34 +464,11 @@ uint32_t GlyphCache::RenderGlyph(const GlyphCacheKey& key) {
 		// of our absolute texel bounds, and when it does so, it must read pure black.
 		horzPad = 1;
 	}
-	uint16_t      atlasX = 0;
-	uint16_t      atlasY = 0;
-	TextureAtlas* atlas  = NULL;
-
-	// The sub-pixel shader does its own clamping, but the whole-pixel shader is naive, and
-	// each glyph needs 3 pixels of padding around it. That could be fixed so that the whole-pixel
-	// shader also clamps itself.
-	int glyphPadding = isSubPixel ? 0 : 3;
-
-	for (int pass = 0; true; pass++) {
-		if (Atlasses.size() == 0 || pass != 0) {
-			TextureAtlas* newAtlas = new TextureAtlas();
-			newAtlas->Initialize(GlyphAtlasSize, GlyphAtlasSize, TexFormatGrey8, glyphPadding);
-			newAtlas->Zero();
-			if (isSubPixel) {
-				newAtlas->FilterMin = TexFilterNearest;
-				newAtlas->FilterMax = TexFilterNearest;
-			} else if (!Global()->SnapHorzText || !Global()->RoundLineHeights) {
-				newAtlas->FilterMin = TexFilterLinear;
-				newAtlas->FilterMax = TexFilterLinear;
-			}
-			Atlasses += newAtlas;
-		}
-		atlas = Atlasses.back();
-		XO_ASSERT(naturalWidth + horzPad * 2 <= GlyphAtlasSize);
-		if (atlas->Alloc(naturalWidth + horzPad * 2, height, atlasX, atlasY))
-			break;
-	}
+	uint16_t atlasX  = 0;
+	uint16_t atlasY  = 0;
+	uint32_t atlasID = 0;
+	AllocGlyph(isSubPixel, naturalWidth + horzPad * 2, height, atlasID, atlasX, atlasY);
+	TextureAtlas* atlas = Atlasses[atlasID];
 
 	if (isSubPixel)
 		FilterAndCopyBitmap(font, atlas->DataAt(atlasX, atlasY), atlas->Stride);
@@ -150,16 +484,151 @@ uint32_t GlyphCache::RenderGlyph(const GlyphCacheKey& key) {
 	g.Height                  = height;
 	g.X                       = atlasX;
 	g.Y                       = atlasY;
-	g.AtlasID                 = (uint32_t) Atlasses.find(atlas);
+	g.AtlasID                 = atlasID;
 	g.MetricLeft              = font->FTFace->glyph->bitmap_left / combinedHorzMultiplier;
 	g.MetricLeftx256          = font->FTFace->glyph->bitmap_left * 256 / combinedHorzMultiplier;
 	g.MetricTop               = font->FTFace->glyph->bitmap_top;
 	g.MetricWidth             = (uint16_t)(font->FTFace->glyph->metrics.width / (64 * combinedHorzMultiplier));
 	g.MetricHoriAdvance       = font->FTFace->glyph->advance.x / (64 * combinedHorzMultiplier);
 	g.MetricLinearHoriAdvance = (font->FTFace->glyph->linearHoriAdvance * (int32_t) pixSize) / (float) font->FTFace->units_per_EM;
-	Table.insert(key, (uint32_t) Glyphs.size());
-	Glyphs += g;
-	return (uint32_t)(Glyphs.size() - 1);
+
+	AddEntry(key, g, CurrentFrame());
+	return true;
+}
+
+// Find space for a glyph, creating a new atlas if necessary
+void GlyphCache::AllocGlyph(bool isSubPixel, uint16_t width, uint16_t height, uint32_t& atlasID, uint16_t& x, uint16_t& y) {
+	// The sub-pixel shader does its own clamping, but the whole-pixel shader is naive, and
+	// each glyph needs 3 pixels of padding around it. That could be fixed so that the whole-pixel
+	// shader also clamps itself.
+	int glyphPadding = isSubPixel ? 0 : 3;
+
+	XO_ASSERT(width + glyphPadding * 2 <= GlyphAtlasSize);
+	XO_ASSERT(height + glyphPadding * 2 <= GlyphAtlasSize);
+
+	if (!AllocInAtlas(glyphPadding, width, height, -1, atlasID, x, y)) {
+		TextureAtlas* fresh = AllocAtlas(glyphPadding, isSubPixel);
+		atlasID             = (uint32_t) Atlasses.find(fresh);
+		XO_VERIFY(fresh->Alloc(width, height, x, y));
+	}
+}
+
+void GlyphCache::AddEntry(const GlyphCacheKey& key, const Glyph& glyph, uint32_t lastUsed) {
+	GlyphCacheEntry* entry = new GlyphCacheEntry();
+	entry->Glyph           = glyph;
+	entry->Key             = key;
+	entry->LastUsed        = lastUsed;
+	PageForWrite(key)->Glyphs.insert(key.Char, entry);
+}
+
+void GlyphCache::SeedFont(const Font* font) {
+	if (!Global()->EnableGlyphDiskCache)
+		return;
+
+	std::lock_guard<std::mutex> lock(Lock);
+	if (SeedFont_Internal(font)) {
+		Publish();
+		Reclaim();
+	}
+}
+
+// Copy every glyph of 'font' out of the disk cache, the first time that we see the font.
+// Seeded glyphs are stamped as never used, so that they are the first to go if we're over budget.
+bool GlyphCache::SeedFont_Internal(const Font* font) {
+	if (!Global()->EnableGlyphDiskCache || font->FileHash == 0)
+		return false;
+	while (FontSeeded.size() <= (size_t) font->ID)
+		FontSeeded += false;
+	if (FontSeeded[font->ID])
+		return false;
+	FontSeeded[font->ID] = true;
+	OpenDisk();
+
+	size_t budget = Global()->GlyphCacheMaxBytes;
+	bool   any    = false;
+	for (uint32_t i = 0; i < Disk->NumRecords(); i++) {
+		const GlyphDiskCache::Record& r = Disk->GetRecord(i);
+		if (r.FontHash != font->FileHash)
+			continue;
+		GlyphCacheKey key(font->ID, r.Char, r.Size, r.Flags);
+		if (Contains(key))
+			continue;
+		if (budget != 0 && AtlasBytes() >= budget)
+			break;
+		Glyph g = r.Glyph;
+		if (!g.IsNull()) {
+			AllocGlyph(GlyphFlag_IsSubPixel(r.Flags), g.Width, g.Height, g.AtlasID, g.X, g.Y);
+			if (g.Width != 0)
+				Atlasses[g.AtlasID]->CopyFrom(g.X, g.Y, Disk->GetTexels(r), g.Width, g.Width, g.Height);
+		}
+		AddEntry(key, g, 0);
+		any = true;
+	}
+	return any;
+}
+
+void GlyphCache::OpenDisk() {
+	if (!DiskOpened) {
+		DiskOpened = true;
+		Disk->Open(GlyphDiskCache::DefaultPath().CStr());
+	}
+}
+
+void GlyphCache::SaveToDisk() {
+	std::lock_guard<std::mutex> lock(Lock);
+	if (!Global()->EnableGlyphDiskCache || !DiskDirty)
+		return;
+
+	// If no font has been seeded, then the file has not been opened yet, but we still need to keep its contents
+	OpenDisk();
+
+	cheapvec<GlyphDiskCache::Record> records;
+	cheapvec<uint8_t>                texels;
+	ohash::map<uint64_t, FontID>     seededFonts; // FileHash to FontID
+	for (size_t i = 0; i < FontSeeded.size(); i++) {
+		if (FontSeeded[i])
+			seededFonts.insert(Global()->FontStore->GetByFontID((FontID) i)->FileHash, (FontID) i);
+	}
+
+	for (auto& pair : Pages) {
+		for (auto& g : pair.second->Glyphs) {
+			const GlyphCacheEntry* e    = g.second;
+			const Font*            font = Global()->FontStore->GetByFontID(e->Key.FontID);
+			if (font->FileHash == 0)
+				continue;
+			GlyphDiskCache::Record r;
+			memset(&r, 0, sizeof(r));
+			r.FontHash    = font->FileHash;
+			r.Char        = e->Key.Char;
+			r.Size        = e->Key.Size;
+			r.Flags       = e->Key.Flags;
+			r.Glyph       = e->Glyph;
+			r.TexelOffset = (uint32_t) texels.size();
+			const TextureAtlas* atlas = Atlasses[e->Glyph.AtlasID];
+			for (uint32_t y = 0; y < e->Glyph.Height && e->Glyph.Width != 0; y++)
+				texels.addn((const uint8_t*) atlas->DataAt(e->Glyph.X, e->Glyph.Y + y), e->Glyph.Width);
+			records += r;
+		}
+	}
+
+	// Keep the glyphs of fonts that we didn't use during this run, and the glyphs of the fonts that we did use,
+	// which were evicted, or which didn't fit into our budget when they were seeded.
+	for (uint32_t i = 0; i < Disk->NumRecords(); i++) {
+		GlyphDiskCache::Record r = Disk->GetRecord(i);
+		FontID                 fontID;
+		if (seededFonts.get(r.FontHash, fontID) && Contains(GlyphCacheKey(fontID, r.Char, r.Size, r.Flags)))
+			continue;
+		const uint8_t* src = Disk->GetTexels(r);
+		r.TexelOffset      = (uint32_t) texels.size();
+		texels.addn(src, r.Glyph.Width * r.Glyph.Height);
+		records += r;
+	}
+
+	// The file can't be replaced while it is mapped
+	Disk->Close();
+	DiskOpened = false;
+	if (GlyphDiskCache::Save(GlyphDiskCache::DefaultPath().CStr(), records, texels))
+		DiskDirty = false;
 }
 
 void GlyphCache::FilterAndCopyBitmap(const Font* font, void* target, int target_stride) {
@@ -5,6 +5,7 @@ namespace xo {
 
 class TextureAtlas;
 class Font;
+class GlyphDiskCache;
 
 enum GlyphFlags {
 	GlyphFlag_SubPixel_RGB = 1,
@@ -49,59 +50,196 @@ struct GlyphCacheKey {
 
 static const int GlyphAtlasSize = 512; // 512 x 512 x 8bit = 256k per atlas
 
+class GlyphCache;
+
+// A glyph, as it is stored inside the cache. Glyph must be the first member, so that MarkUsed can find the entry.
+struct GlyphCacheEntry {
+	xo::Glyph             Glyph;
+	GlyphCacheKey         Key;
+	std::atomic<uint32_t> LastUsed; // Frame in which the glyph was last drawn
+};
+
+/* An immutable snapshot of the glyph cache, which can be read without any locks.
+
+Get one from GlyphCache::BeginRead, and return it with GlyphCache::EndRead. Between those two calls,
+every Glyph and TextureAtlas that it refers to stays alive, even if the glyph is evicted or moved.
+
+The glyphs are divided into pages, one for every font, size and set of flags. A page is never
+modified once it has been published, so consecutive snapshots share all of the pages that did
+not change between them. Most text is ASCII, so every page also has a direct lookup table of
+its ASCII glyphs. Layout fetches that table once per text node, instead of hashing a
+GlyphCacheKey for every character.
+*/
+class XO_API GlyphTableImmutable {
+public:
+	// Glyphs of characters 0..127 of one font, size and set of flags. An element is NULL if that glyph is not in the cache.
+	struct ASCIIGlyphs {
+		const Glyph* Glyphs[128];
+	};
+
+	// The glyphs of one font, size and set of flags
+	struct Page {
+		ohash::map<uint32_t, GlyphCacheEntry*> Glyphs;       // Keyed by character
+		ASCIIGlyphs                            ASCII;        // Built when the page is published
+		int32_t                                RefCount = 0; // Snapshots that share this page, plus one for the writer. Only touched while GlyphCache::Lock is held.
+	};
+
+	// Returns NULL if the glyph is not in the cache. Even if the glyph pointer is not NULL, you must still check
+	// whether it is the logical "null glyph", which is empty. You can detect that with Glyph.IsNull().
+	const Glyph* GetGlyph(const GlyphCacheKey& key) const;
+
+	const TextureAtlas* GetAtlas(uint32_t i) const { return Atlasses[i]; }
+	TextureAtlas*       GetAtlasMutable(uint32_t i) const { return Atlasses[i]; }
+
+	// Returns NULL if none of the glyphs of key's font, size and flags are in the cache. key.Char is ignored.
+	const ASCIIGlyphs* GetASCII(const GlyphCacheKey& key) const;
+
+	void MarkUsed(const Glyph* glyph) const; // Record that 'glyph' was drawn during the current frame
+
+protected:
+	friend class GlyphCache;
+	const GlyphCache*                Cache = nullptr;
+	uint64_t                         Epoch = 0; // Incremented by every Publish
+	mutable std::atomic<int32_t>     RefCount;  // Readers between BeginRead and EndRead, plus one while this is the latest snapshot
+	ohash::map<GlyphCacheKey, Page*> Pages;     // Keyed with Char = 0
+	cheapvec<TextureAtlas*>          Atlasses;
+};
+
 /* Maintains a cache of all information (including textures) that is needed to render text.
 
-During a render, the cache is read-only. After rendering, we go in and resolve all the cache
-misses. On the next render, those glyphs will get rendered.
-
-NOTE: This was initially created for exclusive use by the main xo renderer, which puts text
-onto the screen, via the GPU. Subsequently, I needed something to cache glyphs when rendering
-text to Canvas, so I decided to reuse this cache for that purpose. The design of the main renderer
-is that while rendering, it treats the glyph cache as immutable. This means that if it's
-rendering a scene, and a glyph bitmap is not ready, then it simply proceeds, and skips the
-rendering of that glyph. It does however record the fact that it needs that glyph. At the
-end of the render, it goes back and calls RenderGlyph() for every glyph that it missed.
-This design allows the common case (all glyphs are cached) to be fast, because there is
-zero locking overhead during rendering.
-HOWEVER, the UI runs on a different thread to the renderer, and now that we want to be
-able to use this cache for Canvas rendering (which happens on the UI thread), we need
-to make the cache safe to use from both the renderer and the UI. As a very simple
-first approach, we just add a giant lock over the whole thing. The renderer takes that lock
-at a massively coarse scale, and the Canvas renderer takes it at very fine scales (every
-time it draws a glyph). Since Canvas is the 2nd class citizen here, we're fine with this.
+The cache is shared by the renderer and by Canvas2D. Layout reads glyph metrics from it too,
+on several threads at once. Reads never take a lock: a reader calls BeginRead, which returns
+the most recently published GlyphTableImmutable, and calls EndRead when it is done with it.
+This is the same idea as FontTableImmutable, except that a glyph table is published as a
+pointer, because copying it for every reader would cost far more than the lookups.
+
+Cache misses go to RenderGlyph/RenderGlyphs. These are serialized by Lock. The first time that
+a writer modifies a page after a Publish, it makes its own copy of that page. Publish then
+builds the ASCII tables of the copied pages only, and every other page is shared with the
+previous snapshot. Renderer and Layout collect all of their misses during a pass, and render
+them in a single batch, so that a cold cache doesn't build a new snapshot for every glyph.
+
+Reclamation
+-----------
+Every snapshot has its own reference count, so a snapshot that has been replaced is freed as
+soon as its last reader calls EndRead, no matter how many readers are holding other snapshots.
+A reader takes its reference inside BeginRead, while NumAcquiring is raised. If Reclaim sees
+NumAcquiring == 0, then no reader can be about to take a reference to a replaced snapshot,
+because a reader always loads the snapshot after raising NumAcquiring. That window is a few
+instructions long, and if Reclaim hits it, it simply tries again next time.
+
+Glyphs and atlases that are evicted are tagged with the epoch of the latest snapshot, which is
+the newest snapshot that can still refer to them. They are freed once every snapshot up to and
+including that epoch has been freed. A page is freed when the last snapshot that shares it is.
+Garbage is freed by the writer, or by the last reader of a replaced snapshot, if the writer
+is not busy at the time. Readers never wait for writers, and writers never wait for readers.
+
+Atlases are modified by writers on any thread, while the renderer uploads them on its own thread.
+Our atlases therefore defer their invalidation (see TextureAtlas::DeferInvalidation), and the
+renderer calls PublishInvalidRects after BeginRead, so that every glyph in its snapshot has been
+uploaded before it is drawn. Writers only touch texels that are not referenced by any live snapshot.
 
 If a glyph render fails, then the resulting Glyph will have .IsNull() == true.
+
+Persistence
+-----------
+If Global()->EnableGlyphDiskCache is set, then the glyphs of a font are seeded from a
+GlyphDiskCache file when FontStore loads the font, so that on a warm machine, the first layout
+pass finds every glyph, and neither needs a second pass, nor calls into Freetype. A font that
+was loaded before the cache existed is seeded on its first cache miss. SaveToDisk writes the
+cache back out at shutdown. Glyphs on disk that are not in the cache, because they were evicted,
+or because they didn't fit into our budget when they were seeded, are kept.
+
+Eviction
+--------
+The renderer stamps every glyph that it draws with the current frame number (MarkUsed), and
+calls EndFrame after every frame. If our atlases exceed Global()->GlyphCacheMaxBytes, then
+EndFrame evicts the glyphs that have gone unused for the longest time, until the remaining
+glyphs cover at most half of the budget. It then compacts: the glyphs of the emptiest atlas are
+copied into the other atlases, and once the old copies have been reclaimed, that atlas is freed.
+Glyphs that were drawn during the current frame are never evicted, so the budget is a soft limit.
+
+An atlas that has been freed keeps its TextureID, and is reused by the next atlas that we
+need, so the renderer does not leak device textures. All texel changes go through the
+atlas's invalid rectangle, so only the regions that changed are uploaded again.
 */
 class XO_API GlyphCache {
 public:
-	static const uint32_t NullGlyphIndex; // = 0. Our first element in 'Glyphs' is always the null glyph (GCC 4.6 won't allow us to write =0 here)
-
-	// Giant lock on the entire cache. Guards access to all data in here.
+	// Serializes writers. Readers never take this lock.
 	std::mutex Lock;
 
 	GlyphCache();
 	~GlyphCache();
 
-	void Clear();
-
-	// Returns NULL if the glyph is not in the cache. Even if the glyph pointer is not NULL, you must still check
-	// whether it is the logical "null glyph", which is empty. You can detect that with Glyph.IsNull().
-	const Glyph* GetGlyph(const GlyphCacheKey& key) const;
+	void Clear(); // Not thread safe. There must be no readers.
 
-	const Glyph* GetOrRenderGlyph(const GlyphCacheKey& key);
+	const GlyphTableImmutable* BeginRead();                                  // Returns the latest snapshot. Never blocks.
+	void                       EndRead(const GlyphTableImmutable* snapshot); // Release a snapshot returned by BeginRead
 
-	uint32_t RenderGlyph(const GlyphCacheKey& key);
+	void     RenderGlyph(const GlyphCacheKey& key);               // Render one glyph, if it is not already cached, and publish a new snapshot
+	void     RenderGlyphs(const ohash::set<GlyphCacheKey>& keys); // Render many glyphs, and publish a single new snapshot
+	void     PublishInvalidRects();                               // Make all texel changes visible to the renderer. Call from the render thread.
+	void     SeedFont(const Font* font);                          // Load the glyphs of a newly loaded font from the disk cache
+	void     SaveToDisk();                                        // Write the disk cache, if Freetype rendered any glyphs since it was loaded
+	void     EndFrame();                                          // Advance the frame counter, and evict and compact if we're over budget
+	void     Trim(size_t maxBytes);                               // Evict and compact until our atlases fit into maxBytes, if possible
+	uint32_t CurrentFrame() const { return Frame.load(std::memory_order_relaxed); }
 
-	const TextureAtlas* GetAtlas(uint32_t i) const { return Atlasses[i]; }
-	TextureAtlas*       GetAtlasMutable(uint32_t i) { return Atlasses[i]; }
+	size_t   AtlasBytes(); // Memory consumed by all atlases that have not been freed
+	uint32_t NumAtlases(); // Number of atlases that hold glyphs
+	uint32_t NumGlyphs();  // Number of glyphs in the cache
 
 protected:
-	cheapvec<TextureAtlas*>             Atlasses;
-	cheapvec<Glyph>                     Glyphs;
-	ohash::map<GlyphCacheKey, uint32_t> Table;
-	Glyph                               NullGlyph;
+	typedef GlyphTableImmutable::Page Page;
+
+	// Garbage, tagged with the epoch of the latest snapshot at the time it was evicted
+	struct OldEntry {
+		GlyphCacheEntry* Entry;
+		uint64_t         Epoch;
+	};
+	struct OldAtlas {
+		uint32_t AtlasID;
+		uint64_t Epoch;
+	};
+
+	std::atomic<const GlyphTableImmutable*> Current;      // Latest published snapshot
+	std::atomic<int32_t>                    NumAcquiring; // Number of threads inside BeginRead
+	std::atomic<uint32_t>                   Frame;        // Incremented by EndFrame
+	uint64_t                                Epoch = 0;    // Epoch of the latest snapshot
+	cheapvec<TextureAtlas*>                 Atlasses;     // An atlas whose Data is null has been freed, and can be reused
+	cheapvec<bool>                          Draining;     // True for an atlas whose glyphs have been moved out, but which is not yet freed. Parallel to Atlasses.
+	ohash::map<GlyphCacheKey, Page*>        Pages;        // The writer's pages, which become the next snapshot. Keyed with Char = 0.
+	ohash::set<GlyphCacheKey>               DirtyPages;   // Pages that the writer has copied since the last Publish
+
+	// Persistence
+	GlyphDiskCache* Disk       = nullptr;
+	bool            DiskOpened = false;
+	bool            DiskDirty  = false; // Freetype has rendered a glyph that is not in Disk
+	cheapvec<bool>  FontSeeded;         // Indexed by FontID
+
+	// Garbage that is no longer referenced by the latest snapshot
+	cheapvec<const GlyphTableImmutable*> Retired; // Snapshots that have been replaced, but may still have readers
+	cheapvec<OldEntry>                   OldEntries;
+	cheapvec<OldAtlas>                   OldAtlasses;
+
+	// These functions all assume that Lock is held
+	void          Publish();
+	void          Reclaim();
+	void          FreeSnapshot(const GlyphTableImmutable* snapshot);
+	void          ReleasePage(Page* page);
+	Page*         PageForWrite(const GlyphCacheKey& key);
+	bool          Contains(const GlyphCacheKey& key) const;
+	bool          RenderGlyph_Internal(const GlyphCacheKey& key);
+	bool          SeedFont_Internal(const Font* font);
+	void          OpenDisk();
+	void          AllocGlyph(bool isSubPixel, uint16_t width, uint16_t height, uint32_t& atlasID, uint16_t& x, uint16_t& y);
+	void          AddEntry(const GlyphCacheKey& key, const Glyph& glyph, uint32_t lastUsed);
+	TextureAtlas* AllocAtlas(uint32_t padding, bool isSubPixel);
+	bool          AllocInAtlas(uint32_t padding, uint16_t width, uint16_t height, uint32_t excludeAtlas, uint32_t& atlasID, uint16_t& x, uint16_t& y);
+	void          Evict(GlyphCacheEntry* entry);
+	bool          MoveGlyph(GlyphCacheEntry* entry, uint32_t excludeAtlas);
+	void          FreeAll();
 
-	void Initialize();
 	void FilterAndCopyBitmap(const Font* font, void* target, int target_stride);
 	void CopyBitmap(const Font* font, void* target, int target_stride);
 };
@@ -0,0 +1,93 @@
+#include "pch.h"
+#include "GlyphDiskCache.h"
+#include "../../dependencies/hash/xxhash_xo_wrapper.h"
+
+namespace xo {
+
+static const char     FileMagic[4] = {'x', 'o', 'g', 'c'};
+static const uint32_t FileVersion  = 1;
+
+bool GlyphDiskCache::Open(const char* path) {
+	Close();
+	if (!File.Open(path))
+		return false;
+
+	const uint8_t* base = (const uint8_t*) File.Data();
+	size_t         size = File.Size();
+	const Header*  head = (const Header*) base;
+	if (size < sizeof(Header) ||
+	    memcmp(head->Magic, FileMagic, sizeof(FileMagic)) != 0 ||
+	    head->Version != FileVersion ||
+	    head->SettingsHash != SettingsHash() ||
+	    (size - sizeof(Header)) / sizeof(Record) < head->NumRecords) {
+		File.Close();
+		return false;
+	}
+
+	// Validate every record up front, so that a truncated file can never make us read outside of the mapping
+	const Record*  records    = (const Record*) (base + sizeof(Header));
+	const uint8_t* texels     = base + sizeof(Header) + head->NumRecords * sizeof(Record);
+	size_t         texelBytes = size - (texels - base);
+	for (uint32_t i = 0; i < head->NumRecords; i++) {
+		const Record& r = records[i];
+		if ((size_t) r.TexelOffset + (size_t) r.Glyph.Width * r.Glyph.Height > texelBytes || r.Size == 0) {
+			File.Close();
+			return false;
+		}
+	}
+
+	Records = records;
+	Texels  = texels;
+	Count   = head->NumRecords;
+	return true;
+}
+
+void GlyphDiskCache::Close() {
+	File.Close();
+	Records = nullptr;
+	Texels  = nullptr;
+	Count   = 0;
+}
+
+bool GlyphDiskCache::Save(const char* path, const cheapvec<Record>& records, const cheapvec<uint8_t>& texels) {
+	String tmp  = String(path) + ".tmp";
+	FILE*  file = fopen(tmp.CStr(), "wb");
+	if (file == nullptr) {
+		Trace("Failed to open glyph cache file %s\n", tmp.CStr());
+		return false;
+	}
+
+	Header head;
+	memcpy(head.Magic, FileMagic, sizeof(FileMagic));
+	head.Version      = FileVersion;
+	head.SettingsHash = SettingsHash();
+	head.NumRecords   = (uint32_t) records.size();
+	head.Reserved     = 0;
+	bool ok           = fwrite(&head, sizeof(head), 1, file) == 1;
+	if (ok && records.size() != 0)
+		ok = fwrite(&records[0], sizeof(Record), records.size(), file) == records.size();
+	if (ok && texels.size() != 0)
+		ok = fwrite(&texels[0], 1, texels.size(), file) == texels.size();
+
+	ok = fclose(file) == 0 && ok;
+	if (ok)
+		ok = RenameFileReplace(tmp.CStr(), path);
+	if (!ok) {
+		Trace("Failed to write glyph cache file %s\n", path);
+		remove(tmp.CStr());
+	}
+	return ok;
+}
+
+String GlyphDiskCache::DefaultPath() {
+	return Global()->CacheDir + XO_DIR_SEP_STR + "glyphs";
+}
+
+uint64_t GlyphDiskCache::SettingsHash() {
+	const GlobalStruct* g        = Global();
+	float               gammas[] = {g->SubPixelTextGamma, g->WholePixelTextGamma};
+	uint32_t            flags[]  = {(uint32_t) g->UseFreetypeSubpixel, (uint32_t) sizeof(Record)};
+	uint64_t            h        = XXH64(gammas, sizeof(gammas), 0);
+	return XXH64(flags, sizeof(flags), h);
+}
+} // namespace xo
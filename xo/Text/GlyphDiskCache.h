@@ -0,0 +1,62 @@
+#pragma once
+#include "../Defs.h"
+#include "GlyphCache.h"
+
+namespace xo {
+
+/* A file of rasterized glyphs and their metrics, which outlives the process.
+
+GlyphCache seeds itself from this file, so that on a warm machine, the first frame needs no
+Freetype rasterization at all. Glyphs are keyed by Font::FileHash instead of FontID, because
+FontIDs are assigned in the order that fonts happen to be loaded.
+
+The file is memory mapped, and records are read directly out of the mapping. Anything that
+alters how a glyph is rasterized must be part of SettingsHash, or else bump FileVersion.
+
+Layout:
+	Header
+	Record[NumRecords]
+	Texels of every record, 8 bits per texel, with a stride equal to the glyph's width
+*/
+class XO_API GlyphDiskCache {
+public:
+	struct Record {
+		uint64_t  FontHash;    // Font::FileHash
+		uint32_t  Char;        // These three are the rest of the GlyphCacheKey
+		uint8_t   Size;
+		uint8_t   Flags;
+		uint16_t  Reserved;
+		xo::Glyph Glyph;       // AtlasID, X and Y are meaningless here
+		uint32_t  TexelOffset; // Relative to the start of the texels
+	};
+
+	bool Open(const char* path); // Returns false if the file is missing, damaged, or was written with different settings
+	void Close();
+
+	uint32_t       NumRecords() const { return Count; }
+	const Record&  GetRecord(uint32_t i) const { return Records[i]; }
+	const uint8_t* GetTexels(const Record& r) const { return Texels + r.TexelOffset; }
+
+	// Write a new file. TexelOffset of each record is an offset into 'texels'.
+	// The file is written to a temporary name and then renamed over 'path', so readers never see half of a file.
+	static bool Save(const char* path, const cheapvec<Record>& records, const cheapvec<uint8_t>& texels);
+
+	static String DefaultPath();
+
+private:
+	struct Header {
+		char     Magic[4];
+		uint32_t Version;
+		uint64_t SettingsHash;
+		uint32_t NumRecords;
+		uint32_t Reserved;
+	};
+
+	MappedFile     File;
+	const Record*  Records = nullptr;
+	const uint8_t* Texels  = nullptr;
+	uint32_t       Count   = 0;
+
+	static uint64_t SettingsHash();
+};
+} // namespace xo
@@ -6,11 +6,13 @@ namespace xo {
 Font::Font() {
 	ID                           = FontIDNull;
 	FTFace                       = NULL;
+	FileHash                     = 0;
 	LinearHoriAdvance_Space_x256 = 0;
 	LinearXHeight_x256           = 0;
 	LineHeight_x256              = 0;
 	Ascender_x256                = 0;
 	Descender_x256               = 0;
+	UnitsPerEM                   = 1;
 	// See FontStore::LoadFontTweaks for more details
 	MaxAutoHinterSize = 0;
 }
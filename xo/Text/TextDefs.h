@@ -8,12 +8,30 @@ typedef void* FT_Face;
 typedef void* FT_Library;
 #endif
 
+// Kerning between pairs of glyphs, in font design units. This is filled in by FontStore when a font is loaded,
+// so that layout never needs to ask Freetype for kerning. Pairs of Latin-1 characters are looked up in a
+// dense table. Every other pair is hashed by glyph index.
+class XO_API KerningTable {
+public:
+	cheapvec<int16_t>             Latin1; // Indexed by (left character << 8) | right character. Empty if the font has no kerning.
+	ohash::map<uint32_t, int16_t> Pairs;  // Keyed by PairKey(). Only populated for fonts with a TrueType 'kern' table.
+
+	int32_t Get(int32_t leftChar, int32_t rightChar, uint32_t leftGlyph, uint32_t rightGlyph) const {
+		if ((uint32_t) leftChar < 256 && (uint32_t) rightChar < 256)
+			return Latin1.size() != 0 ? Latin1[(leftChar << 8) | rightChar] : 0;
+		return Pairs.get(PairKey(leftGlyph, rightGlyph));
+	}
+
+	static uint32_t PairKey(uint32_t leftGlyph, uint32_t rightGlyph) { return (leftGlyph << 16) | rightGlyph; }
+};
+
 // Once initialized, all members are immutable, except for the usage
 // of the Freetype FTFace object, which must be accessed while holding the FTFace_Lock mutex.
 class XO_API Font {
 public:
-	FontID ID;
-	String Facename;
+	FontID   ID;
+	String   Facename;
+	uint64_t FileHash; // Hash of the contents of the font file. Identifies the font in caches that outlive the process.
 
 	FT_Face            FTFace;
 	mutable std::mutex FTFace_Lock; // Guards access to FTFace
@@ -23,8 +41,11 @@ public:
 	int32_t  LineHeight_x256;              // Recommended spacing between consecutive lines
 	int32_t  Ascender_x256;                // Ascender
 	int32_t  Descender_x256;               // Descender
+	int32_t  UnitsPerEM;                   // Font design units per EM. Kerning is expressed in these units.
 	uint32_t MaxAutoHinterSize;            // Maximum font size at which we force use of the auto hinter. Heuristic thumb-suck observations. Only applies to sub-pixel rendering.
 
+	KerningTable Kerning;
+
 	Font();
 	~Font();
 };
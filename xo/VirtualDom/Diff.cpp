@@ -1,5 +1,8 @@
 #include "pch.h"
 #include "Diff.h"
+#include "../Dom/DomNode.h"
+#include "../Parse/DocParser.h"
+#include "../../dependencies/hash/xxhash_xo_wrapper.h"
 
 using namespace std;
 
@@ -205,7 +208,231 @@ private:
 	}
 };
 
-void Diff(Node* a, Node* b, std::function<void(PatchOp op, Node* a, Node* b)> apply) {
+// Keyed tree reconciliation, used by Diff and Patch.
+// When Dst is null, we only report operations, and don't touch any DOM elements.
+class Reconciler {
+public:
+	PatchFunc Apply;
+	String    Error;
+
+	void Element(const Node* a, const Node* b, DomEl* dst) {
+		if (a->IsText()) {
+			if (strcmp(a->Val, b->Val) != 0) {
+				Report(PatchOp::UpdateText, a, b);
+				if (dst)
+					dst->SetText(b->Val);
+			}
+			return;
+		}
+
+		const char* styleA = Attrib(a, "style");
+		const char* styleB = Attrib(b, "style");
+		const char* classA = Attrib(a, "class");
+		const char* classB = Attrib(b, "class");
+		bool        style  = strcmp(styleA, styleB) != 0;
+		bool        klass  = strcmp(classA, classB) != 0;
+		DomNode*    node   = dst ? dst->ToNode() : nullptr;
+		if (style || klass) {
+			Report(PatchOp::UpdateAttribs, a, b);
+			if (node && style) {
+				node->HackSetStyle(xo::Style());
+				if (!node->StyleParse(styleB))
+					Error = tsf::fmt("Invalid style '%v'", styleB).c_str();
+			}
+			if (node && klass) {
+				node->GetClassesMutable().clear();
+				if (classB[0] != 0)
+					node->AddClass(classB);
+			}
+		}
+		Children(a, b, node);
+	}
+
+	void Children(const Node* a, const Node* b, DomNode* dst) {
+		XO_ASSERT(dst == nullptr || dst->ChildCount() == a->NChild);
+		size_t na = a->NChild;
+		size_t nb = b->NChild;
+		cheapvec<ChildKey> keysA;
+		cheapvec<ChildKey> keysB;
+		ComputeKeys(a, keysA);
+		ComputeKeys(b, keysB);
+
+		// Skip the common head and tail
+		size_t start = 0;
+		while (start < na && start < nb && Same(a->Children[start], b->Children[start], keysA[start], keysB[start])) {
+			Element(a->Children[start], b->Children[start], dst ? dst->ChildByIndex(start) : nullptr);
+			start++;
+		}
+		size_t endA = na;
+		size_t endB = nb;
+		while (endA > start && endB > start && Same(a->Children[endA - 1], b->Children[endB - 1], keysA[endA - 1], keysB[endB - 1])) {
+			Element(a->Children[endA - 1], b->Children[endB - 1], dst ? dst->ChildByIndex(endA - 1) : nullptr);
+			endA--;
+			endB--;
+		}
+		if (start == endA && start == endB)
+			return;
+
+		// Match up the children in the middle. If a key appears more than once in a, only its first
+		// occurrence can be matched, and only to the first child of b with that key.
+		ohash::map<uint64_t, int32_t> byKey;
+		for (size_t i = start; i < endA; i++)
+			byKey.insert(keysA[i].Hash, (int32_t) i);
+
+		cheapvec<int32_t> source; // For each child of b in the middle, the index of its match in a, or -1
+		cheapvec<bool>    used;   // For each child of a in the middle, true if it was matched
+		source.resize(endB - start);
+		used.resize(endA - start);
+		used.fill(false);
+		for (size_t j = start; j < endB; j++) {
+			int32_t i = -1;
+			if (byKey.get(keysB[j].Hash, i) && (used[i - start] || !Same(a->Children[i], b->Children[j], keysA[i], keysB[j])))
+				i = -1;
+			source[j - start] = i;
+			if (i != -1)
+				used[i - start] = true;
+		}
+
+		for (size_t i = endA; i-- > start;) {
+			if (!used[i - start])
+				Report(PatchOp::Delete, a->Children[i], nullptr);
+		}
+
+		// Rather than moving DOM elements one at a time, which would cost O(n) each, we build the final
+		// order of the middle, and hand it to ReplaceChildren, which also deletes the unmatched elements.
+		// New elements are appended to the end, until ReplaceChildren puts them in place.
+		cheapvec<DomEl*> order;
+		if (dst) {
+			order.resize(endB - start);
+			order.fill(nullptr);
+		}
+
+		cheapvec<bool> stay;
+		LongestIncreasingSubsequence(source, stay);
+
+		for (size_t j = endB; j-- > start;) {
+			int32_t i = source[j - start];
+			if (i == -1) {
+				Report(PatchOp::Insert, nullptr, b->Children[j]);
+				if (dst) {
+					size_t pos = dst->ChildCount();
+					String err = DocParser::InsertVDom(b->Children[j], dst, pos);
+					if (err != "")
+						Error = err;
+					if (dst->ChildCount() != pos)
+						order[j - start] = dst->ChildByIndex(pos);
+				}
+			} else {
+				if (dst)
+					order[j - start] = dst->ChildByIndex(i);
+				Element(a->Children[i], b->Children[j], dst ? order[j - start] : nullptr);
+				if (!stay[j - start])
+					Report(PatchOp::Move, a->Children[i], b->Children[j]);
+			}
+		}
+
+		if (dst) {
+			// Elements that failed to parse were never added
+			size_t n = 0;
+			for (size_t k = 0; k < order.size(); k++) {
+				if (order[k] != nullptr)
+					order[n++] = order[k];
+			}
+			order.resize(n);
+			dst->ReplaceChildren(start, endA, order);
+		}
+	}
+
+private:
+	struct ChildKey {
+		uint64_t    Hash;
+		const char* Key;      // Null if the child has no key
+		uint32_t    Implicit; // Position amongst the unkeyed children
+	};
+
+	void Report(PatchOp op, const Node* a, const Node* b) {
+		if (Apply)
+			Apply(op, a, b);
+	}
+
+	static const char* Attrib(const Node* n, const char* name) {
+		for (size_t i = 0; i < n->NAttrib; i++) {
+			if (strcmp(n->Attribs[i].Name, name) == 0)
+				return n->Attribs[i].Val;
+		}
+		return "";
+	}
+
+	static void ComputeKeys(const Node* n, cheapvec<ChildKey>& keys) {
+		keys.resize(n->NChild);
+		uint32_t implicit = 0;
+		for (size_t i = 0; i < n->NChild; i++) {
+			ChildKey&   k   = keys[i];
+			const Node* c   = n->Children[i];
+			const char* key = c->IsText() ? "" : Attrib(c, "key");
+			if (key[0] != 0) {
+				k.Key      = key;
+				k.Implicit = 0;
+				k.Hash     = XXH64(key, strlen(key), 0);
+			} else {
+				k.Key      = nullptr;
+				k.Implicit = implicit++;
+				k.Hash     = XXH64(&k.Implicit, sizeof(k.Implicit), 1);
+			}
+		}
+	}
+
+	static bool Same(const Node* a, const Node* b, const ChildKey& ka, const ChildKey& kb) {
+		if (a->IsText() != b->IsText())
+			return false;
+		if (!a->IsText() && strcmp(a->Name, b->Name) != 0)
+			return false;
+		if (ka.Key == nullptr || kb.Key == nullptr)
+			return ka.Key == kb.Key && ka.Implicit == kb.Implicit;
+		return strcmp(ka.Key, kb.Key) == 0;
+	}
+
+	// Mark the elements of the longest increasing subsequence of 'seq', ignoring -1
+	static void LongestIncreasingSubsequence(const cheapvec<int32_t>& seq, cheapvec<bool>& inLIS) {
+		cheapvec<int32_t> tails; // Index into seq of the last element of the best subsequence of each length
+		cheapvec<int32_t> prev;  // Index into seq of the previous element of the subsequence ending at i
+		prev.resize(seq.size());
+		inLIS.resize(seq.size());
+		inLIS.fill(false);
+		for (size_t i = 0; i < seq.size(); i++) {
+			if (seq[i] == -1)
+				continue;
+			size_t lo = 0;
+			size_t hi = tails.size();
+			while (lo < hi) {
+				size_t mid = (lo + hi) / 2;
+				if (seq[tails[mid]] < seq[i])
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			prev[i] = lo == 0 ? -1 : tails[lo - 1];
+			if (lo == tails.size())
+				tails += (int32_t) i;
+			else
+				tails[lo] = (int32_t) i;
+		}
+		for (int32_t i = tails.size() == 0 ? -1 : tails.back(); i != -1; i = prev[i])
+			inLIS[i] = true;
+	}
+};
+
+XO_API void Diff(const Node* a, const Node* b, PatchFunc apply) {
+	Reconciler r;
+	r.Apply = apply;
+	r.Children(a, b, nullptr);
+}
+
+XO_API String Patch(const Node* a, const Node* b, DomNode* dst, PatchFunc apply) {
+	Reconciler r;
+	r.Apply = apply;
+	r.Children(a, b, dst);
+	return r.Error;
 }
 
 struct CharHasher {
@@ -1,16 +1,40 @@
 #pragma once
 
+#include "../Base/xoString.h"
 #include "VirtualDom.h"
 
 namespace xo {
+class DomNode;
 namespace vdom {
 
 enum class PatchOp {
-	Delete,
-	Insert,
+	Delete,        // a was removed
+	Insert,        // b was added
+	Move,          // a was moved to the position of b
+	UpdateText,    // The text of a was changed to that of b
+	UpdateAttribs, // The attributes of a were changed to those of b
 };
 
-void   Diff(Node* a, Node* b, std::function<void(PatchOp op, Node* a, Node* b)> apply);
+typedef std::function<void(PatchOp op, const Node* a, const Node* b)> PatchFunc;
+
+/* Reconcile two trees, and report the operations that turn 'a' into 'b'.
+
+Children are matched by their 'key' attribute. Children without a key are matched to the child
+with the same position amongst the unkeyed children of the other tree. A match must also have
+the same tag. Anything that is not matched is deleted or inserted.
+
+Common leading and trailing children are skipped in linear time. For the children that remain,
+the longest increasing subsequence of matched positions stays where it is, and everything else
+is moved, so a typical list edit costs O(n), and reordering costs O(n log n).
+*/
+XO_API void Diff(const Node* a, const Node* b, PatchFunc apply);
+
+// Same as Diff, but also apply the operations to 'dst', which must have been built from 'a'.
+// Only the children of the two roots are reconciled, because the root of a parsed document has no attributes.
+// Elements that don't change are not touched, so their versions stay the same.
+// Returns empty string on success, or an error message.
+XO_API String Patch(const Node* a, const Node* b, DomNode* dst, PatchFunc apply = nullptr);
+
 XO_API std::string DiffTest(const char* a, const char* b, std::vector<int>& ops);
 
 } // namespace vdom
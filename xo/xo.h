@@ -20,10 +20,12 @@
 #include "Image/ImageStore.h"
 #include "Image/Image.h"
 #include "SysWnd.h"
+#include "SysWnd_headless.h"
 #include "Event.h"
 #include "Controls/EditBox.h"
 #include "Controls/Button.h"
 #include "Controls/MsgBox.h"
+#include "Controls/VirtualList.h"
 #include "Reactive/Control.h"
 #include "VirtualDom/Diff.h"
 #include "VirtualDom/VirtualDom.h"
@@ -32,6 +34,7 @@
 // This first became important because X11's headers define a bunch of nasty macros such as Bool and Success,
 // which just mess around with other symbol names. To counter that, we end up doing things like "#undef Bool",
 // but that is certainly not something that we can propagate downstream.
+// SysWnd_headless.h is the exception, because it has no platform dependencies.
 //#include "SysWnd_android.h"
 //#include "SysWnd_linux.h"
 //#include "SysWnd_windows.h"